@@ -0,0 +1,22 @@
+#pragma once
+
+#include "backend/render_backend.hpp"
+
+/// <summary>
+/// 描画バックエンドへ渡すシーン
+/// ジオメトリ, インスタンス, 背景をバックエンドに構築し、カメラと光源を描画パラメーターに設定する
+/// BackendRendererはシーンの読み込み元 (シーン記述ファイル, テスト用のシーンなど) に依存しない
+/// </summary>
+class BackendScene
+{
+public:
+    virtual ~BackendScene() = default;
+
+    // シーンの構築 (パイプラインの作成前に1度だけ呼び出される)
+    virtual void Load(RenderBackend& backend, uint32_t width, uint32_t height, RenderBackend::FrameParam& param) = 0;
+    // 各フレームの描画前の更新 (アニメーションを進め、インスタンスの姿勢, カメラ, 光源を反映する)
+    // 光源の数はLoadから変えないこと (パイプラインの設定に含まれる)
+    virtual void Update(RenderBackend& backend, int frame, int maxFrame, RenderBackend::FrameParam& param) = 0;
+    // 構築したリソースの破棄 (Loadの途中で失敗した場合も呼び出される)
+    virtual void Unload(RenderBackend& backend) = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "backend/render_backend.hpp"
+#include "utils/bvh_util.h"
+
+/// <summary>
+/// CPUのパストレーサー
+/// ジオメトリごとのBVH (BLAS) とインスタンスのBVH (TLAS) の2段で交差判定を行い、
+/// 行単位でスレッドに分割して描画する
+/// シェーディングはDXR側と同じ構成 (拡散反射, 球光源の直接光サンプリング, ロシアンルーレット) だが、
+/// テクスチャは参照せずマテリアルの拡散色のみを使用する
+/// </summary>
+class CpuBackend : public RenderBackend
+{
+public:
+    RenderBackendType GetType() const override { return RenderBackendType::CPU; }
+
+    void OnInit(uint32_t width, uint32_t height) override;
+    void OnDestroy() override;
+
+    BufferHandle CreateBuffer(BufferUsage usage, uint64_t size) override;
+    void WriteBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t size) override;
+    void DestroyBuffer(BufferHandle buffer) override;
+
+    GeometryHandle BuildGeometry(std::span<const GeometryDesc> geometries) override;
+    void BuildScene(std::span<const InstanceDesc> instances) override;
+    // CPUではインスタンスのBVHを作り直す (ジオメトリのBVHはそのまま使う)
+    void UpdateScene(std::span<const InstanceDesc> instances) override { BuildScene(instances); }
+    void SetEnvironment(EnvironmentFunc environment) override { m_environment = environment; }
+
+    void CreatePipeline(const ShaderPermutation& permutation) override { m_permutation = permutation; }
+
+    void Dispatch(const FrameParam& param) override;
+    bool Readback(std::vector<uint8_t>& pixels) override;
+
+private:
+    struct Ray
+    {
+        Float3 origin;
+        Float3 direction;
+        float tMax;
+    };
+    struct Hit
+    {
+        float t;
+        Float3 normal;
+        Float3 diffuse;
+    };
+    // 三角形はジオメトリ空間の頂点を3つずつ展開して保持する
+    struct Geometry
+    {
+        std::vector<Float3> vertices;
+        std::vector<uint32_t> diffuseIndices;
+        std::vector<Float3> diffuses;
+        std::vector<BVHNode> nodes;
+        std::vector<uint32_t> triIndices;
+        BVHBounds bounds;
+    };
+    struct Instance
+    {
+        const Geometry* geometry;
+        Matrix worldMtx;
+        Matrix invWorldMtx;
+    };
+
+    bool Intersect(const Ray& ray, Hit& hit) const;
+    bool IntersectGeometry(const Geometry& geometry, const Ray& ray, Hit& hit) const;
+    bool IsOccluded(const Float3& origin, const Float3& direction, float distance) const;
+
+    template<uint32_t LightCount>
+    Float3 PathTrace(const FrameParam& param, uint32_t maxPathDepth, Ray ray, uint32_t& seed) const;
+    template<uint32_t LightCount>
+    void RenderRows(const FrameParam& param, size_t rowBegin, size_t rowEnd);
+
+private:
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    // ハンドル - 1 -> 内容 (破棄済みは空)
+    std::vector<std::vector<uint8_t>> m_buffers;
+    std::vector<std::unique_ptr<Geometry>> m_geometries;
+    std::vector<Instance> m_instances;
+    // インスタンスのワールド空間のAABBによるBVH
+    std::vector<BVHNode> m_instanceNodes;
+    std::vector<uint32_t> m_instanceIndices;
+    EnvironmentFunc m_environment;
+    ShaderPermutation m_permutation;
+
+    // rgb: 輝度の合計, a: サンプル数
+    std::vector<Float4> m_accumBuffer;
+    std::vector<uint32_t> m_seedBuffer;
+    std::vector<uint8_t> m_output;
+};
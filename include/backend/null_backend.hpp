@@ -0,0 +1,63 @@
+#pragma once
+
+#include "backend/render_backend.hpp"
+
+/// <summary>
+/// 何も描画しないバックエンド
+/// 呼び出しを順に記録し、ハンドルの整合性のみ検証する (GPUのない環境での動作確認用)
+/// Deviceと同じ区分でリソースの作成, 転送, 実行を数える
+/// (バッファとBLAS, TLAS, パイプラインの作成, 構築とディスパッチの実行, 読み戻しのマップ)
+/// </summary>
+class NullBackend : public RenderBackend
+{
+public:
+    struct Call
+    {
+        std::string name;
+        // 呼び出しごとの主な引数 (ハンドル, サイズ, 要素数など)
+        uint64_t arg0 = 0;
+        uint64_t arg1 = 0;
+    };
+
+    RenderBackendType GetType() const override { return RenderBackendType::Null; }
+
+    void OnInit(uint32_t width, uint32_t height) override;
+    void OnDestroy() override;
+
+    BufferHandle CreateBuffer(BufferUsage usage, uint64_t size) override;
+    void WriteBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t size) override;
+    void DestroyBuffer(BufferHandle buffer) override;
+
+    GeometryHandle BuildGeometry(std::span<const GeometryDesc> geometries) override;
+    void BuildScene(std::span<const InstanceDesc> instances) override;
+    void UpdateScene(std::span<const InstanceDesc> instances) override;
+    void SetEnvironment(EnvironmentFunc environment) override;
+
+    void CreatePipeline(const ShaderPermutation& permutation) override;
+
+    void Dispatch(const FrameParam& param) override;
+    bool Readback(std::vector<uint8_t>& pixels) override;
+
+    DeviceRecorder* GetRecorder() override { return &m_recorder; }
+
+    const std::vector<Call>& GetCalls() const { return m_calls; }
+    uint64_t GetDispatchedSampleCount() const { return m_dispatchedSamples; }
+
+private:
+    void Record(const char* name, uint64_t arg0 = 0, uint64_t arg1 = 0);
+    // 生存中のバッファのサイズ (破棄済みの場合はnullptr)
+    const uint64_t* FindBuffer(BufferHandle buffer) const;
+
+private:
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    // ハンドル - 1 -> サイズ (破棄済みはUINT64_MAX)
+    std::vector<uint64_t> m_bufferSizes;
+    uint32_t m_geometryCount = 0;
+    // 直前のBuildSceneのインスタンス (UpdateSceneで構成の一致を検証する)
+    std::vector<GeometryHandle> m_sceneGeometries;
+    bool m_hasPipeline = false;
+    uint64_t m_dispatchedSamples = 0;
+    std::vector<Call> m_calls;
+    DeviceRecorder m_recorder;
+};
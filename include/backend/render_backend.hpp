@@ -0,0 +1,126 @@
+#pragma once
+
+#include "utils/device_recorder.h"
+#include "utils/math_util.h"
+#include "utils/shader_permutation.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+enum class RenderBackendType
+{
+    D3D12,  // DXRによるGPUパストレーサー (Rendererが直接使用する)
+    CPU,    // CPUのパストレーサー
+    Null,   // 呼び出しの記録のみ (描画結果は常に黒)
+};
+
+/// <summary>
+/// 描画バックエンドのインターフェース
+/// バッファ, 加速構造, パイプライン, ディスパッチ, 読み戻しをグラフィックスAPIに依存しない形で扱う
+/// ハンドルはバックエンドごとの1始まりの通し番号 (0は無効)
+/// </summary>
+class RenderBackend
+{
+public:
+    using BufferHandle = uint32_t;
+    using GeometryHandle = uint32_t;
+    static const uint32_t InvalidHandle = 0;
+    // 扱える球光源の最大数 (Scene::MaxLightCountと揃える)
+    static const uint32_t MaxLightCount = 3;
+
+    enum class BufferUsage
+    {
+        Vertex,     // Float3の頂点座標
+        Index,      // uint32_tのインデックス
+        Constant,
+    };
+
+    // BLASを構成する三角形メッシュ (インデックスはvertexOffsetからの相対)
+    struct GeometryDesc
+    {
+        BufferHandle positions = InvalidHandle;
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+        BufferHandle indices = InvalidHandle;
+        uint32_t indexOffset = 0;
+        uint32_t indexCount = 0;
+        // ジオメトリ空間への変換 (BLAS内のノード行列)
+        Mtx3x4 transform;
+        Float3 diffuse = Float3(1.0f, 1.0f, 1.0f);
+    };
+
+    // TLASに配置するインスタンス
+    struct InstanceDesc
+    {
+        GeometryHandle geometry = InvalidHandle;
+        Mtx3x4 transform;
+    };
+
+    struct SphereLight
+    {
+        Float3 center;
+        float radius;
+        Float3 color;
+        float intensity;
+    };
+
+    // 1パス分の描画パラメーター
+    struct FrameParam
+    {
+        Mtx4x4 invViewMtx;
+        Mtx4x4 invProjMtx;
+        uint32_t frame = 0;
+        // [sampleOffset, sampleOffset + sampleCount) のサンプルを蓄積する (0の場合は蓄積をリセット)
+        uint32_t sampleOffset = 0;
+        uint32_t sampleCount = 0;
+        uint32_t maxSPP = 0;
+        uint32_t maxPathDepth = 0;
+        SphereLight lights[MaxLightCount] = {};
+        uint32_t lightCount = 0;
+    };
+
+    // 方向ごとの背景の放射輝度
+    using EnvironmentFunc = std::function<Float3(const Float3&)>;
+
+    virtual ~RenderBackend() = default;
+
+    virtual RenderBackendType GetType() const = 0;
+
+    virtual void OnInit(uint32_t width, uint32_t height) = 0;
+    virtual void OnDestroy() = 0;
+
+    // バッファ
+    virtual BufferHandle CreateBuffer(BufferUsage usage, uint64_t size) = 0;
+    virtual void WriteBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t size) = 0;
+    virtual void DestroyBuffer(BufferHandle buffer) = 0;
+
+    // 加速構造
+    virtual GeometryHandle BuildGeometry(std::span<const GeometryDesc> geometries) = 0;
+    // TLASの構築 (前回の内容は破棄する)
+    virtual void BuildScene(std::span<const InstanceDesc> instances) = 0;
+    // TLASの更新 (直前のBuildSceneと同じ構成のまま姿勢のみを変更する。リソースは作成しない)
+    virtual void UpdateScene(std::span<const InstanceDesc> instances) = 0;
+    virtual void SetEnvironment(EnvironmentFunc environment) = 0;
+
+    // パイプライン (描画全体で固定の設定)
+    virtual void CreatePipeline(const ShaderPermutation& permutation) = 0;
+
+    // 描画と読み戻し
+    virtual void Dispatch(const FrameParam& param) = 0;
+    // 直前のDispatchの結果をRGBA8 (行ピッチはwidth * 4) で取得
+    virtual bool Readback(std::vector<uint8_t>& pixels) = 0;
+
+    // デバイス操作の記録 (記録しないバックエンドはnullptr)
+    // フレームの確定は呼び出し側が各フレームの読み戻し後にEndFrameで行う
+    virtual DeviceRecorder* GetRecorder() { return nullptr; }
+};
+
+// 名前 ("d3d12", "cpu", "null") からの変換
+bool ParseRenderBackendType(const std::string& name, RenderBackendType& type);
+
+// D3D12はRendererがDeviceを直接使用するため、CPUとNullのみ作成できる (それ以外はnullptr)
+std::unique_ptr<RenderBackend> CreateRenderBackend(RenderBackendType type);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "backend/backend_scene.hpp"
+#include "backend/render_backend.hpp"
+
+#include <functional>
+
+/// <summary>
+/// 描画バックエンドを使用するオフライン描画 (ウィンドウ, Deviceを使用しない)
+/// BackendSceneが構築したシーンを0からmaxFrameまで順に描画し、読み戻した画像を出力関数へ渡す
+/// 各フレームの描画前にBackendScene::Updateでアニメーションを進める
+/// (フレーム範囲の分割やファームでの描画はD3D12のRendererを使用すること)
+/// </summary>
+class BackendRenderer
+{
+public:
+    // 描画結果 (RGBA8, 行ピッチはwidth * 4) の出力
+    using FrameOutputFunc = std::function<void(int frame, const uint8_t* pixels, uint32_t width, uint32_t height)>;
+
+    BackendRenderer(uint32_t width, uint32_t height, std::unique_ptr<RenderBackend> backend, std::unique_ptr<BackendScene> scene, int maxFrame);
+    ~BackendRenderer();
+
+    // 1パスあたりのサンプル数 (0の場合は1フレームを1パスで描画)
+    void SetSamplesPerPass(uint32_t samplesPerPass) { m_samplesPerPass = samplesPerPass; }
+    // 読み戻した画像の出力先 (指定しない場合は出力しない)
+    void SetFrameOutput(FrameOutputFunc output) { m_frameOutput = output; }
+
+    // 全フレームを描画する (プロセスの終了コードを返す)
+    int Run();
+
+    RenderBackend* GetBackend() const { return m_pBackend.get(); }
+
+private:
+    void OnInit();
+    void OnDestroy();
+    void RenderFrame(int frame);
+
+private:
+    uint32_t m_width;
+    uint32_t m_height;
+    int m_maxFrame;
+    uint32_t m_samplesPerPass;
+    uint32_t m_maxPathDepth;
+    uint32_t m_maxSPP;
+    std::unique_ptr<RenderBackend> m_pBackend;
+    std::unique_ptr<BackendScene> m_pScene;
+    FrameOutputFunc m_frameOutput;
+    RenderBackend::FrameParam m_frameParam;
+    std::vector<uint8_t> m_pixels;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "backend/backend_scene.hpp"
+#include "scene/scene_animation.hpp"
+#include "scene/scene_desc.hpp"
+
+/// <summary>
+/// シーン記述から構築するバックエンドのシーン
+/// カメラ, 球光源, アクターの姿勢はSceneと同じSceneAnimationで毎フレーム更新する
+/// 光源はバックエンド側で解析的な球として扱うため、光源のモデルは読み込まない
+/// シーン記述, モデル, 背景の読み込み元は派生クラスで決める
+/// </summary>
+class BackendSceneDesc : public BackendScene
+{
+public:
+    BackendSceneDesc();
+
+    void Load(RenderBackend& backend, uint32_t width, uint32_t height, RenderBackend::FrameParam& param) override;
+    void Update(RenderBackend& backend, int frame, int maxFrame, RenderBackend::FrameParam& param) override;
+
+protected:
+    virtual void LoadDesc(SceneDesc& desc) = 0;
+    // モデルのジオメトリをバックエンドへ転送してBLASを構築 (同じモデルはアクター間で共有する)
+    virtual RenderBackend::GeometryHandle LoadModel(RenderBackend& backend, const std::wstring& fileName) = 0;
+    virtual void LoadBackground(RenderBackend& backend, const std::wstring& fileName) = 0;
+
+private:
+    // カメラと光源を描画パラメーターへ設定
+    void WriteFrameParam(const SceneAnimation::State& state, RenderBackend::FrameParam& param) const;
+
+private:
+    SceneAnimation m_animation;
+    std::vector<RenderBackend::InstanceDesc> m_instances;
+    // 演出で動かすアクターのインスタンス番号 (シーンにない場合は-1)
+    int m_targetInstances[SceneAnimation::TargetCount];
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "backend_scene_desc.hpp"
+#include "scene/environment_map.hpp"
+#include "scene/model_cache.hpp"
+
+/// <summary>
+/// シーン記述ファイルから構築するバックエンドのシーン
+/// モデルはGPUへ転送せずに読み込み、ジオメトリをバックエンドへ渡す
+/// </summary>
+class BackendSceneFile : public BackendSceneDesc
+{
+public:
+    explicit BackendSceneFile(const std::wstring& sceneFile);
+
+    void Unload(RenderBackend& backend) override;
+
+protected:
+    void LoadDesc(SceneDesc& desc) override;
+    RenderBackend::GeometryHandle LoadModel(RenderBackend& backend, const std::wstring& fileName) override;
+    void LoadBackground(RenderBackend& backend, const std::wstring& fileName) override;
+
+private:
+    std::wstring m_sceneFile;
+    EnvironmentMap m_envMap;
+    ModelCache m_modelCache;
+    // モデルのファイル名 -> BLAS
+    std::unordered_map<std::wstring, RenderBackend::GeometryHandle> m_geometries;
+    std::vector<RenderBackend::BufferHandle> m_buffers;
+};
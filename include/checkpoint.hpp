@@ -0,0 +1,94 @@
+#pragma once
+
+#include "device.hpp"
+
+#include <future>
+
+/// <summary>
+/// 蓄積バッファのチェックポイント
+/// ピクセルごとの蓄積値 (RGB合計 + サンプル数) と乱数の状態をメモリマップドファイルに保存する
+///
+/// ファイル構成: Header | Slot0 | Slot1
+/// 書き込みは非アクティブなスロットに行い、完了後にヘッダーのアクティブスロットを切り替える
+/// (書き込み途中で終了しても直前のチェックポイントは壊れない)
+/// </summary>
+class Checkpoint
+{
+public:
+    // チェックポイントの内容
+    struct State
+    {
+        int frame;
+        UINT sampleCount;
+        const Float4* accum;
+        const uint32_t* seed;
+    };
+
+    Checkpoint(std::unique_ptr<Device>& device, const std::wstring& path, UINT width, UINT height);
+    ~Checkpoint();
+
+    // ファイルのオープン (resume時は既存ファイルを検証して読み込む)
+    bool Open(bool resume);
+    bool GetLatest(State& state) const;
+
+    // 前回の書き込みが完了していない場合はtrue
+    bool IsBusy() const;
+
+    // Readbackバッファの内容をGPUの完了後に別スレッドで書き込む
+    void WriteAsync(
+        ComPtr<ID3D12Resource> readback,
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& accumFootprint,
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& seedFootprint,
+        ComPtr<ID3D12Fence> fence,
+        UINT64 fenceValue,
+        int frame,
+        UINT sampleCount
+    );
+    void Wait();
+
+private:
+    struct SlotInfo
+    {
+        int32_t frame;
+        uint32_t sampleCount;
+        uint64_t sequence;
+    };
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t activeSlot;
+        uint32_t reserved[3];
+        SlotInfo slots[2];
+    };
+    static const uint32_t Magic = 0x4B435452; // "RTCK"
+    static const uint32_t Version = 1;
+
+    void Write(
+        ComPtr<ID3D12Resource> readback,
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT accumFootprint,
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT seedFootprint,
+        ComPtr<ID3D12Fence> fence,
+        UINT64 fenceValue,
+        int frame,
+        UINT sampleCount
+    );
+    Header* GetHeader() const { return static_cast<Header*>(m_pMapped); }
+    uint8_t* GetSlotData(uint32_t slot) const;
+    size_t GetSlotSize() const;
+    size_t GetFileSize() const;
+    void Close();
+
+private:
+    std::unique_ptr<Device>& m_pDevice;
+    std::wstring m_path;
+    UINT m_width;
+    UINT m_height;
+    HANDLE m_hFile;
+    HANDLE m_hMapping;
+    HANDLE m_waitEvent;
+    void* m_pMapped;
+    std::future<void> m_writeTask;
+};
@@ -1,127 +1,234 @@
-#pragma once
-
-#include <windows.h>
-
-#include <d3d12.h>
-#include <dxgi1_6.h>
-#include <d3dx12.h>
-
-#include <string>
-#include <wrl.h>
-#include <memory>
-#include <vector>
-#include <list>
-#include <array>
-#include <unordered_map>
-#include <stdexcept>
-
-#include "utils/print_util.h"
-#include "utils/math_util.h"
-
-using Microsoft::WRL::ComPtr;
-
-struct DescriptorHeap
-{
-    UINT heapBaseOffset;
-    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle;
-    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle;
-    D3D12_DESCRIPTOR_HEAP_TYPE heapType;
-    DescriptorHeap() :
-        heapBaseOffset(0),
-        cpuHandle(),
-        gpuHandle(),
-        heapType(D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES)
-    {}
-};
-
-struct ASBuffers
-{
-    ComPtr<ID3D12Resource> scratchBuffer;
-    ComPtr<ID3D12Resource> asBuffer;
-    ComPtr<ID3D12Resource> updateBuffer;
-};
-
-class Device
-{
-public:
-    Device();
-    Device(const Device&) = delete;
-    
-    ~Device();
-
-    bool OnInit();
-    void OnDestroy();
-
-    bool CreateSwapChain(UINT width, UINT height, HWND hwnd);
-    ComPtr<ID3D12GraphicsCommandList4> CreateCommandList();
-    ComPtr<ID3D12Fence1> CreateFence();
-    ComPtr<ID3D12Resource> CreateBuffer(size_t size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES initialState, D3D12_HEAP_TYPE heapType, const wchar_t* name = nullptr);
-    ComPtr<ID3D12Resource> CreateTexture2D(UINT width, UINT height, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES initialState, D3D12_HEAP_TYPE heapType);
-    ComPtr<ID3D12Resource> CreateImageBuffer(ComPtr<ID3D12Resource> pSource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState);
-    ComPtr<ID3D12Resource> InitializeBuffer(size_t size, const void* initData, D3D12_RESOURCE_FLAGS flags, D3D12_HEAP_TYPE heapType, const wchar_t* name = nullptr);
-    ComPtr<ID3D12RootSignature> CreateRootSignature(const std::vector<D3D12_ROOT_PARAMETER>& rootParams, const std::vector<D3D12_STATIC_SAMPLER_DESC>& samplerDesc, const wchar_t* name = nullptr, const bool isLocal = false);
-    void WriteBuffer(ComPtr<ID3D12Resource> resource, const void* pData, size_t dataSize);
-    void WriteResource(ComPtr<ID3D12Resource> resource, const void* pData, size_t dataSize);
-    bool CreateConstantBuffer(std::vector<ComPtr<ID3D12Resource>>& resources, UINT size, const wchar_t* name);
-
-    DescriptorHeap AllocateDescriptorHeap();
-    void DeallocateDescriptorHeap(DescriptorHeap& hescHeap);
-    DescriptorHeap CreateSRV(ComPtr<ID3D12Resource> resource, UINT numElements, UINT firstElement, DXGI_FORMAT format);
-    DescriptorHeap CreateSRV(ComPtr<ID3D12Resource> resource, UINT numElements, UINT firstElement, UINT stride);
-    DescriptorHeap CreateSRV(ComPtr<ID3D12Resource> resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc);
-    DescriptorHeap CreateUAV(ComPtr<ID3D12Resource> resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc);
-
-    ComPtr<ID3D12Device5> GetDevice() { return m_pD3D12Device5; }
-    ComPtr<ID3D12CommandAllocator> GetCurrentCommandAllocator() {
-        return m_pCmdAllocatorArr[m_frameIndex];
-    }
-    ComPtr<ID3D12DescriptorHeap> GetDescriptorHeap() { return m_pHeap; }
-    ComPtr<ID3D12DescriptorHeap> GetRTVHeap() { return m_pRtvHeap; }
-    ComPtr<ID3D12Resource> GetRenderTarget() { return m_pRenderTargets[m_frameIndex]; }
-    ComPtr<ID3D12Resource> GetDepthStencil() { return m_pDepthStencil; }
-    UINT GetCurrentFrameIndex() const { return m_frameIndex; }
-    const D3D12_VIEWPORT& GetViewport() const { return m_viewport;  }
-
-    D3D12_CPU_DESCRIPTOR_HANDLE GetCurrentRTVDesc();
-
-    void ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList4> command);
-    void Present(UINT syncInterval);
-    void WaitForGpu() noexcept;
-
-public:
-    static const UINT BackBufferCount = 3;
-    static const UINT FrameBufferCount = 64;
-    static const UINT ShaderResourceViewMax = 1024;
-
-private:
-    ComPtr<ID3D12Device5> m_pD3D12Device5;
-    ComPtr<ID3D12CommandQueue> m_pCmdQueue;
-    ComPtr<IDXGISwapChain3> m_pSwapChain3;
-
-    std::array<ComPtr<ID3D12CommandAllocator>, BackBufferCount> m_pCmdAllocatorArr;
-    std::array<ComPtr<ID3D12Fence1>, BackBufferCount> m_pFrameFence1Arr;
-    std::array<UINT64, BackBufferCount> m_fenceValueArr;
-
-    ComPtr<ID3D12DescriptorHeap> m_pRtvHeap;
-    UINT m_rtvDescSize;
-    ComPtr<ID3D12DescriptorHeap> m_pDsvHeap;
-    UINT m_dsvDescSize;
-    ComPtr<ID3D12DescriptorHeap> m_pHeap;
-    UINT m_heapDescSize;
-    UINT m_heapAllocateIndex;
-    std::unordered_map<UINT, std::list<DescriptorHeap>> m_heapDescMap;
-
-    HANDLE m_fenceEvent = 0;
-    HANDLE m_waitEvent = 0;
-
-    UINT m_frameIndex = 0;
-
-    DXGI_FORMAT m_backBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-    DXGI_FORMAT m_depthFormat = DXGI_FORMAT_D32_FLOAT;
-
-    std::array<ComPtr<ID3D12Resource>, BackBufferCount> m_pRenderTargets;
-    ComPtr<ID3D12Resource> m_pDepthStencil;
-
-    D3D12_VIEWPORT  m_viewport;
-    D3D12_RECT m_scissorRect;
-};
+#pragma once
+
+#include <windows.h>
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <d3dx12.h>
+
+#include <string>
+#include <wrl.h>
+#include <memory>
+#include <vector>
+#include <list>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "gpu_allocator.hpp"
+#include "utils/descriptor_allocator.h"
+#include "utils/device_recorder.h"
+#include "utils/ring_allocator.h"
+#include "utils/print_util.h"
+#include "utils/math_util.h"
+
+using Microsoft::WRL::ComPtr;
+
+struct DescriptorHeap
+{
+    UINT heapBaseOffset;
+    // 連続して確保したディスクリプタの数 (ハンドルは先頭を指す)
+    UINT count;
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle;
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle;
+    D3D12_DESCRIPTOR_HEAP_TYPE heapType;
+    DescriptorHeap() :
+        heapBaseOffset(0),
+        count(0),
+        cpuHandle(),
+        gpuHandle(),
+        heapType(D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES)
+    {}
+    bool IsValid() const { return heapType != D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; }
+};
+
+// フレーム内でのみ有効な動的バッファの領域 (アップロードヒープを直接GPUから参照する)
+struct DynamicBuffer
+{
+    uint8_t* pCpu = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+    ComPtr<ID3D12Resource> resource;
+    UINT64 offset = 0;
+};
+
+struct ASBuffers
+{
+    ComPtr<ID3D12Resource> scratchBuffer;
+    ComPtr<ID3D12Resource> asBuffer;
+    ComPtr<ID3D12Resource> updateBuffer;
+};
+
+class Device
+{
+public:
+    // CommandListPool (utils/command_list_pool.h) から使用する型
+    using CommandAllocatorType = ComPtr<ID3D12CommandAllocator>;
+    using CommandListType = ComPtr<ID3D12GraphicsCommandList4>;
+
+    Device();
+    Device(const Device&) = delete;
+    
+    ~Device();
+
+    bool OnInit();
+    void OnDestroy();
+
+    bool CreateSwapChain(UINT width, UINT height, HWND hwnd);
+    // 現在のフレームのアロケーターを使用したコマンドリスト
+    ComPtr<ID3D12GraphicsCommandList4> CreateCommandList();
+    ComPtr<ID3D12GraphicsCommandList4> CreateCommandList(ComPtr<ID3D12CommandAllocator> allocator);
+    ComPtr<ID3D12CommandAllocator> CreateCommandAllocator();
+    void ResetCommandAllocator(ComPtr<ID3D12CommandAllocator> allocator);
+    void ResetCommandList(ComPtr<ID3D12GraphicsCommandList4> cmdList, ComPtr<ID3D12CommandAllocator> allocator);
+    void CloseCommandList(ComPtr<ID3D12GraphicsCommandList4> cmdList);
+    ComPtr<ID3D12Fence1> CreateFence();
+    ComPtr<ID3D12Resource> CreateBuffer(size_t size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES initialState, D3D12_HEAP_TYPE heapType, const wchar_t* name = nullptr);
+    ComPtr<ID3D12Resource> CreateTexture2D(UINT width, UINT height, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES initialState, D3D12_HEAP_TYPE heapType);
+    ComPtr<ID3D12Resource> InitializeBuffer(size_t size, const void* initData, D3D12_RESOURCE_FLAGS flags, D3D12_HEAP_TYPE heapType, const wchar_t* name = nullptr);
+    ComPtr<ID3D12RootSignature> CreateRootSignature(const std::vector<D3D12_ROOT_PARAMETER>& rootParams, const std::vector<D3D12_STATIC_SAMPLER_DESC>& samplerDesc, const wchar_t* name = nullptr, const bool isLocal = false);
+    void WriteBuffer(ComPtr<ID3D12Resource> resource, const void* pData, size_t dataSize);
+    void WriteResource(ComPtr<ID3D12Resource> resource, const void* pData, size_t dataSize);
+    // フレーム単位の動的データの確保 (ステージングリングから連続して切り出し、フレームの完了後に再利用される)
+    // コマンドの並列記録中に複数のスレッドから呼び出せる
+    // 定数バッファやインスタンス情報など毎フレーム書き換えるデータを、リソースを作らずにオフセットで参照する
+    DynamicBuffer AllocateDynamic(UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    D3D12_GPU_VIRTUAL_ADDRESS WriteDynamic(const void* pData, size_t dataSize, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    // フレームのコマンドリストへの転送 (ステージングリングへのコピーとCopyBufferRegionのみで待機しない)
+    // resourceはコピー可能な状態であること。コマンドリストは次のPresent/EndUploadBatch/WaitForGpuまでに実行すること
+    void WriteResource(ComPtr<ID3D12GraphicsCommandList4> cmdList, ComPtr<ID3D12Resource> resource, UINT64 dstOffset, const void* pData, size_t dataSize);
+    void WriteTexture(ComPtr<ID3D12Resource> resource, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources, D3D12_RESOURCE_STATES afterState);
+    // サブリソース0のマップ (記録に数えるため、CPUから読み書きするリソースはこちらを使用する)
+    // 失敗した場合はnullptr
+    void* Map(ComPtr<ID3D12Resource> resource, const D3D12_RANGE* readRange = nullptr);
+    void Unmap(ComPtr<ID3D12Resource> resource, const D3D12_RANGE* writtenRange = nullptr);
+
+    // アップロードバッチ
+    // Begin～End間のWriteResource/WriteTextureは共通のステージングリングとコマンドリストに積まれ、
+    // 最も外側のEndで一度だけ実行して待機する (入れ子可)
+    void BeginUploadBatch();
+    void EndUploadBatch();
+    bool IsUploadBatching() const { return m_uploadBatch.depth > 0; }
+    // バッチ内で書き込んだバッファを読むコマンドを積むためのコマンドリスト (コピー完了のバリアを発行済み)
+    ComPtr<ID3D12GraphicsCommandList4> GetUploadCommandList();
+    // バッチの実行完了まで保持するリソース (スクラッチバッファ等)
+    void KeepUntilUploaded(ComPtr<ID3D12Resource> resource);
+
+    // ディスクリプタの確保 (count個の連続した範囲、スレッドセーフ)
+    // ヒープが枯渇した場合はエラーとする
+    DescriptorHeap AllocateDescriptorHeap(UINT count = 1);
+    void DeallocateDescriptorHeap(DescriptorHeap& hescHeap);
+    // 連続して確保した範囲のindex番目を指すディスクリプタ (解放は範囲全体で行う)
+    DescriptorHeap GetDescriptorInRange(const DescriptorHeap& range, UINT index) const;
+    UINT GetAllocatedDescriptorCount() const { return m_descriptorAllocator.GetAllocatedCount(); }
+    DescriptorHeap CreateSRV(ComPtr<ID3D12Resource> resource, UINT numElements, UINT firstElement, DXGI_FORMAT format);
+    DescriptorHeap CreateSRV(ComPtr<ID3D12Resource> resource, UINT numElements, UINT firstElement, UINT stride);
+    DescriptorHeap CreateSRV(ComPtr<ID3D12Resource> resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc);
+    DescriptorHeap CreateUAV(ComPtr<ID3D12Resource> resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc);
+
+    ComPtr<ID3D12Device5> GetDevice() { return m_pD3D12Device5; }
+    GpuAllocator::Stats GetAllocatorStats() { return m_pAllocator ? m_pAllocator->GetStats() : GpuAllocator::Stats(); }
+    // フレームごとのリソース作成, 転送, マップ, 実行, 待機の記録 (Presentでフレームを確定する)
+    DeviceRecorder& GetRecorder() { return m_recorder; }
+    ComPtr<ID3D12CommandAllocator> GetCurrentCommandAllocator() {
+        return m_pCmdAllocatorArr[m_frameIndex];
+    }
+    ComPtr<ID3D12DescriptorHeap> GetDescriptorHeap() { return m_pHeap; }
+    ComPtr<ID3D12DescriptorHeap> GetRTVHeap() { return m_pRtvHeap; }
+    ComPtr<ID3D12Resource> GetRenderTarget() { return m_pRenderTargets[m_frameIndex]; }
+    ComPtr<ID3D12Resource> GetDepthStencil() { return m_pDepthStencil; }
+    UINT GetCurrentFrameIndex() const { return m_frameIndex; }
+    const D3D12_VIEWPORT& GetViewport() const { return m_viewport;  }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCurrentRTVDesc();
+
+    void ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList4> command);
+    // 複数のコマンドリストを順に1回で実行
+    void ExecuteCommandLists(const std::vector<ComPtr<ID3D12GraphicsCommandList4>>& commands);
+    void Signal(ComPtr<ID3D12Fence1> fence, UINT64 fenceValue);
+    void Present(UINT syncInterval);
+    void WaitForGpu() noexcept;
+    // キューのタイムラインフェンスへのシグナル (それまでに実行したコマンドの完了を示す値を返す)
+    UINT64 SignalQueue();
+    void WaitForFence(UINT64 fenceValue);
+    // 任意のフェンスの待機 (記録に数えるため、CPUで完了を待つ場合はこちらを使用する)
+    void WaitForFence(ComPtr<ID3D12Fence1> fence, UINT64 fenceValue);
+
+public:
+    static const UINT BackBufferCount = 3;
+    static const UINT FrameBufferCount = 64;
+    static const UINT ShaderResourceViewMax = 65536;
+    static const UINT64 UploadRingSize = 64ull * 1024 * 1024;
+    // これ以下のサイズのバッファはヒープから切り出す (大きなバッファはコミットリソース)
+    static const UINT64 PlacedBufferMaxSize = GpuAllocator::HeapSize / 4;
+
+private:
+    // ステージングリングからの領域確保
+    // 確保先のバッファとオフセット、書き込み先のポインタを返す
+    uint8_t* AllocateUpload(UINT64 size, UINT64 alignment, ComPtr<ID3D12Resource>& page, UINT64& offset);
+    // 完了したフェンスまでのステージング領域を解放
+    void RetireUploads();
+    // バッチの途中までのコマンドを実行して完了を待ち、続きを同じコマンドリストに積めるようにする
+    void FlushUploadBatch();
+
+    struct UploadBatch
+    {
+        UINT depth = 0;
+        ComPtr<ID3D12GraphicsCommandList4> cmdList;
+        // コピー後のバリアが未発行のバッファ
+        std::vector<ComPtr<ID3D12Resource>> pendingBuffers;
+        std::vector<ComPtr<ID3D12Resource>> keepAlive;
+    };
+
+private:
+    ComPtr<ID3D12Device5> m_pD3D12Device5;
+    std::shared_ptr<GpuAllocator> m_pAllocator;
+    ComPtr<ID3D12CommandQueue> m_pCmdQueue;
+    ComPtr<IDXGISwapChain3> m_pSwapChain3;
+
+    std::array<ComPtr<ID3D12CommandAllocator>, BackBufferCount> m_pCmdAllocatorArr;
+    std::array<ComPtr<ID3D12Fence1>, BackBufferCount> m_pFrameFence1Arr;
+    std::array<UINT64, BackBufferCount> m_fenceValueArr;
+
+    ComPtr<ID3D12DescriptorHeap> m_pRtvHeap;
+    UINT m_rtvDescSize;
+    ComPtr<ID3D12DescriptorHeap> m_pDsvHeap;
+    UINT m_dsvDescSize;
+    ComPtr<ID3D12DescriptorHeap> m_pHeap;
+    UINT m_heapDescSize;
+    DescriptorAllocator m_descriptorAllocator;
+
+    HANDLE m_fenceEvent = 0;
+    HANDLE m_waitEvent = 0;
+
+    UINT m_frameIndex = 0;
+
+    DXGI_FORMAT m_backBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    DXGI_FORMAT m_depthFormat = DXGI_FORMAT_D32_FLOAT;
+
+    std::array<ComPtr<ID3D12Resource>, BackBufferCount> m_pRenderTargets;
+    ComPtr<ID3D12Resource> m_pDepthStencil;
+
+    D3D12_VIEWPORT  m_viewport;
+    D3D12_RECT m_scissorRect;
+
+    UploadBatch m_uploadBatch;
+
+    // ステージングリング (永続的にマップしたアップロードヒープ)
+    ComPtr<ID3D12Resource> m_pUploadRing;
+    uint8_t* m_pUploadRingMapped = nullptr;
+    RingAllocator m_uploadRing;
+    // ステージングリングからの確保の排他
+    std::mutex m_uploadMutex;
+    // リングに収まらない転送用のバッファ (フェンス値に到達したら破棄)
+    std::deque<std::pair<UINT64, ComPtr<ID3D12Resource>>> m_retiredUploads;
+
+    // キューのタイムラインフェンス
+    ComPtr<ID3D12Fence1> m_pQueueFence;
+    UINT64 m_queueFenceValue = 0;
+
+    DeviceRecorder m_recorder;
+    // Presentを呼び出した回数 (記録のフレーム番号)
+    int64_t m_presentCount = 0;
+};
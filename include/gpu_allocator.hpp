@@ -0,0 +1,74 @@
+#pragma once
+
+#include <windows.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "utils/tlsf_allocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+/// <summary>
+/// バッファ用のGPUメモリのサブアロケーター
+/// ヒープの種類ごとに大きなID3D12Heapを確保し、TLSFで切り出した領域にPlaced Resourceを作成する
+/// 領域はリソースの破棄時に解放待ちとなり、GPUの待機後 (ReleasePending) に再利用される
+/// </summary>
+class GpuAllocator : public std::enable_shared_from_this<GpuAllocator>
+{
+public:
+    struct Stats
+    {
+        UINT heapCount = 0;
+        UINT64 heapSize = 0;
+        UINT64 usedSize = 0;
+        UINT allocationCount = 0;
+    };
+
+    // 1つのヒープのサイズ (これを超えるバッファはコミットリソースで作成する)
+    static const UINT64 HeapSize = 64ull * 1024 * 1024;
+
+    explicit GpuAllocator(ComPtr<ID3D12Device5> device);
+    GpuAllocator(const GpuAllocator&) = delete;
+    ~GpuAllocator();
+
+    /// <summary>
+    /// Placed Resourceとしてバッファを作成
+    /// </summary>
+    /// <returns>ヒープに収まらない場合はnullptr (呼び出し側でコミットリソースを作成する)</returns>
+    ComPtr<ID3D12Resource> CreateBuffer(const D3D12_RESOURCE_DESC& resDesc, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES initialState);
+
+    // 破棄されたリソースの領域を再利用可能にする (GPUの処理完了後に呼ぶ)
+    void ReleasePending();
+
+    Stats GetStats();
+
+private:
+    class AllocationOwner;
+
+    struct Heap
+    {
+        ComPtr<ID3D12Heap> heap;
+        D3D12_HEAP_TYPE type;
+        TLSFAllocator allocator;
+    };
+
+    struct PendingFree
+    {
+        UINT heapIndex;
+        TLSFAllocator::Allocation allocation;
+    };
+
+    bool Allocate(D3D12_HEAP_TYPE heapType, UINT64 size, UINT64 alignment, UINT& heapIndex, TLSFAllocator::Allocation& allocation);
+    void DeferFree(UINT heapIndex, const TLSFAllocator::Allocation& allocation);
+
+private:
+    ComPtr<ID3D12Device5> m_pDevice;
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Heap>> m_heaps;
+    std::vector<PendingFree> m_pendingFrees;
+};
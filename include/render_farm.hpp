@@ -0,0 +1,63 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// ローカルレンダーファーム
+/// フレーム範囲をチャンクに分割し、ファイルシステム上のキューを介して
+/// 複数のワーカープロセスに割り振る
+///
+/// キューの構成 (OUTPUT_DIR/farm_queue)
+///   pending/{id}.chunk          未処理
+///   running/{id}.{worker}.chunk 処理中 (pendingからのrenameで取得)
+///   done/{id}.{worker}.chunk    完了
+///   failed/{id}.chunk           リトライ上限に到達
+/// チャンクファイルの内容: "{start} {end} {retry}"
+/// </summary>
+class RenderFarm
+{
+public:
+    struct Config
+    {
+        int workerCount = 1;
+        int startFrame = 0;
+        int endFrame = 0;
+        int chunkSize = 10;
+        // チャンクごとのリトライ回数の上限
+        // チャンクを取得せずに続けて終了したワーカーも、この回数を超えると再起動しない
+        int maxRetry = 2;
+        int maxFrame = -1;
+        std::wstring sceneFile;
+        // ワーカーをヘッドレスで実行する
+        bool headless = false;
+        // ワーカーの実行ファイル (空の場合は自身の実行ファイル)
+        std::filesystem::path workerExecutable;
+    };
+
+    // コーディネーターの実行 (プロセスの終了コードを返す)
+    static int RunCoordinator(const Config& config);
+
+    static std::filesystem::path GetQueueDir();
+};
+
+/// <summary>
+/// レンダーファームのワーカー側
+/// シーンを読み込んだまま、キューが空になるまでチャンクを取得し続ける
+/// </summary>
+class RenderFarmWorker
+{
+public:
+    RenderFarmWorker(int workerIndex);
+
+    // 処理中のチャンクを完了として、次のチャンクを取得する
+    // キューが空の場合はfalse
+    bool NextRange(int& startFrame, int& endFrame);
+
+private:
+    std::filesystem::path m_queueDir;
+    std::wstring m_workerName;
+    std::filesystem::path m_currentChunk;
+    std::wstring m_currentChunkId;
+};
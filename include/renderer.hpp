@@ -1,109 +1,186 @@
-#pragma once
-
-#include "device.hpp"
-#include "scene/scene.hpp"
-
-class Renderer
-{
-public:
-    // maxFrameを指定しない限りは描画し続ける
-    Renderer(UINT width, UINT height, const std::wstring& title, int maxFrame = -1);
-
-    void OnInit();
-    void OnUpdate();
-    void OnRender();
-    void OnDestroy();
-
-    bool GetIsRunning() const{ return m_isRunning; }
-    UINT GetWidth() const { return m_width; }
-    UINT GetHeight() const { return m_height; }
-    float GetAspect() const { return float(m_width) / float(m_height); }
-    const wchar_t* GetTitle() const { return m_title.c_str(); }
-
-private:
-    // デバイスの初期化関数
-    bool InitGraphicDevice(HWND hwnd);
-
-    // TLASの構築
-    void BuildTLAS();
-
-    // BLASの更新
-    void UpdateTLAS();
-
-    // グローバルルートシグネチャ生成
-    void CreateGlobalRootSignature();
-
-    // ローカルルートシグネチャ生成
-    void CreateLocalRootSignature();
-
-    // レイトレーシング用のステートオブジェクトの構築
-    void CreateStateObject();
-
-    // レイトレーシング結果の書き込み用バッファの生成
-    void CreateOutputBuffer();
-
-    // シェーダーテーブルの構築
-    void CreateShaderTable();
-
-    // 画像の出力
-    void OutputImage(ComPtr<ID3D12Resource> imageBuffer);
-
-#ifdef _DEBUG
-    void InitImGui();
-    void UpdateImGui();
-    void RenderImGui();
-#endif // _DEBUG
-
-private:
-
-    bool m_isRunning;
-    UINT m_width;
-    UINT m_height;
-    int m_currentFrame;
-    int m_maxFrame;
-    std::wstring m_title;
-    std::unique_ptr<Device> m_pDevice;
-
-    std::shared_ptr<Scene> m_pScene;
-
-    ComPtr<ID3D12Resource> m_pVertexBuffer;
-    std::vector<ComPtr<ID3D12Resource>> m_pRTInstanceBuffers;
-    ComPtr<ID3D12Resource> m_pBLAS;
-    ComPtr<ID3D12Resource> m_pTLAS;
-    ComPtr<ID3D12Resource> m_pTLASUpdate;
-    ComPtr<ID3D12Resource> m_pOutputBuffer;
-    ComPtr<ID3D12Resource> m_pShaderTable;
-
-    ComPtr<ID3D12RootSignature> m_pGlobalRootSignature;
-    ComPtr<ID3D12RootSignature> m_pRayGenLocalRootSignature;
-    ComPtr<ID3D12RootSignature> m_pClosestHitLocalRootSignature;
-    ComPtr<ID3D12StateObject> m_pRTStateObject;
-    ComPtr<ID3D12GraphicsCommandList4> m_pCmdList;
-
-    DescriptorHeap m_imguiDescHeap;
-    DescriptorHeap m_tlasDescHeap;
-    DescriptorHeap m_outputBufferDescHeap;
-
-    D3D12_DISPATCH_RAYS_DESC m_dispatchRayDesc;
-
-    struct HitInfo {
-        Float3 hitPos;
-        Float3 reflectDir;
-        Float3 color;
-        Float3 attenuation;
-        UINT rayDepth;
-        UINT seed;
-    };
-
-    std::chrono::system_clock::time_point m_startTime;
-    std::chrono::system_clock::time_point m_endTime;
-
-#ifdef _DEBUG
-    struct ImGuiParam {
-        Float3 cameraPos;
-        int maxPathDepth;
-        int maxSPP;
-    };
-    ImGuiParam m_imGuiParam;
-#endif // _DEBUG
-};
+#pragma once
+
+#include "device.hpp"
+#include "scene/scene.hpp"
+#include "checkpoint.hpp"
+
+#include <functional>
+
+class Renderer
+{
+public:
+    // maxFrameを指定しない限りは描画し続ける
+    Renderer(UINT width, UINT height, const std::wstring& title, int maxFrame = -1, const std::wstring& sceneFile = L"default.json");
+
+    void OnInit();
+    void OnUpdate();
+    void OnRender();
+    void OnDestroy();
+
+    // 描画するフレーム範囲 [startFrame, endFrame) の指定
+    // 各フレームの結果は範囲によらず同一になる
+    void SetFrameRange(int startFrame, int endFrame);
+    // 範囲の描画完了時に次の範囲を取得する (シーンは読み込んだまま継続)
+    void SetFrameRangeProvider(std::function<bool(int&, int&)> provider) { m_frameRangeProvider = provider; }
+    // 蓄積バッファのチェックポイント (resume時はチェックポイントの状態から描画を再開する)
+    void SetCheckpoint(const std::wstring& fileName, bool resume, double intervalSec);
+    // 1パスあたりのサンプル数 (0の場合は1フレームを1パスで描画)
+    void SetSamplesPerPass(UINT samplesPerPass) { m_samplesPerPass = samplesPerPass; }
+    // ウィンドウとスワップチェインを使用せずに描画する (OnInitより前に指定)
+    // 出力バッファから読み戻し用のリングへ直接コピーし、垂直同期を待たずに次のフレームへ進む
+    void SetHeadless(bool headless) { m_isHeadless = headless; }
+    bool IsHeadless() const { return m_isHeadless; }
+
+    bool GetIsRunning() const{ return m_isRunning; }
+    UINT GetWidth() const { return m_width; }
+    UINT GetHeight() const { return m_height; }
+    float GetAspect() const { return float(m_width) / float(m_height); }
+    const wchar_t* GetTitle() const { return m_title.c_str(); }
+
+private:
+    // デバイスの初期化関数
+    bool InitGraphicDevice(HWND hwnd);
+
+    // TLASの構築
+    void BuildTLAS();
+
+    // BLASの更新
+    void UpdateTLAS();
+
+    // グローバルルートシグネチャ生成
+    void CreateGlobalRootSignature();
+
+    // ローカルルートシグネチャ生成
+    void CreateLocalRootSignature();
+
+    // レイトレーシング用のステートオブジェクトの構築
+    void CreateStateObject();
+
+    // レイトレーシング結果の書き込み用バッファの生成
+    void CreateOutputBuffer();
+
+    // シェーダーテーブルの構築
+    void CreateShaderTable();
+
+    // レイトレース用のパイプライン状態の設定
+    void SetDispatchState();
+
+    // チェックポイント用のリソースの作成と復元
+    void CreateCheckpointResources();
+    void RestoreCheckpoint();
+
+    // パス単位でのコマンドの実行 (必要に応じてチェックポイントを書き込む)
+    void SubmitPass(UINT sampleCount);
+
+    // 画像出力用の読み戻しリングの作成
+    void CreateReadbackResources();
+    // 出力バッファ (COPY_SOURCE) から読み戻しリングの次のスロットへのコピーを記録する
+    void RecordReadback();
+    // 提出したコピーの完了を待たずに次のスロットへ進む (frameが-1の場合は出力しない)
+    void CommitReadback(int frame);
+    // 読み戻しの完了を待って画像を出力する
+    void FlushReadback(UINT slotIndex);
+    // 読み戻し中の全てのフレームを古い順に出力する
+    void FlushReadbacks();
+
+    // 画像の出力
+    void OutputImage(ComPtr<ID3D12Resource> imageBuffer, int frame, UINT rowPitch);
+
+#ifdef _DEBUG
+    void InitImGui();
+    void UpdateImGui();
+    void RenderImGui();
+#endif // _DEBUG
+
+private:
+
+    bool m_isRunning;
+    bool m_isHeadless;
+    UINT m_width;
+    UINT m_height;
+    int m_currentFrame;
+    int m_maxFrame;
+    int m_startFrame;
+    int m_endFrame;
+    std::function<bool(int&, int&)> m_frameRangeProvider;
+    std::wstring m_title;
+    std::wstring m_sceneFile;
+    UINT m_samplesPerPass;
+    UINT m_resumeSampleOffset;
+    std::unique_ptr<Device> m_pDevice;
+
+    std::shared_ptr<Scene> m_pScene;
+
+    ComPtr<ID3D12Resource> m_pVertexBuffer;
+    ComPtr<ID3D12Resource> m_pBLAS;
+    ComPtr<ID3D12Resource> m_pTLAS;
+    ComPtr<ID3D12Resource> m_pTLASUpdate;
+    // TLASに反映済みのシーンの姿勢バージョン
+    uint64_t m_tlasVersion;
+    ComPtr<ID3D12Resource> m_pOutputBuffer;
+    ComPtr<ID3D12Resource> m_pAccumBuffer;
+    ComPtr<ID3D12Resource> m_pSeedBuffer;
+    ComPtr<ID3D12Resource> m_pShaderTable;
+
+    ComPtr<ID3D12RootSignature> m_pGlobalRootSignature;
+    ComPtr<ID3D12RootSignature> m_pRayGenLocalRootSignature;
+    ComPtr<ID3D12RootSignature> m_pClosestHitLocalRootSignature;
+    ComPtr<ID3D12StateObject> m_pRTStateObject;
+    ComPtr<ID3D12GraphicsCommandList4> m_pCmdList;
+    // BLASの更新を並列に記録するコマンドリスト (m_pCmdListより先に提出する)
+    std::unique_ptr<CommandListPool<Device>> m_pCmdListPool;
+
+    DescriptorHeap m_imguiDescHeap;
+    DescriptorHeap m_tlasDescHeap;
+    DescriptorHeap m_outputBufferDescHeap;
+    DescriptorHeap m_accumBufferDescHeap;
+    DescriptorHeap m_seedBufferDescHeap;
+
+    D3D12_DISPATCH_RAYS_DESC m_dispatchRayDesc;
+
+    struct HitInfo {
+        Float3 hitPos;
+        Float3 reflectDir;
+        Float3 color;
+        Float3 attenuation;
+        UINT rayDepth;
+        UINT seed;
+        float coneWidth;
+    };
+
+    std::chrono::system_clock::time_point m_startTime;
+    std::chrono::system_clock::time_point m_endTime;
+
+    // チェックポイント
+    std::wstring m_checkpointFile;
+    bool m_isResume;
+    double m_checkpointInterval;
+    std::unique_ptr<Checkpoint> m_pCheckpoint;
+    ComPtr<ID3D12Resource> m_pCheckpointReadback;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_accumFootprint;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_seedFootprint;
+    ComPtr<ID3D12Fence1> m_pPassFence;
+    UINT64 m_passFenceValue;
+
+    // 画像出力の読み戻しリング (フレームごとに順に使用する)
+    struct ReadbackSlot
+    {
+        ComPtr<ID3D12Resource> buffer;
+        UINT64 fenceValue = 0;
+        // 出力するフレーム番号 (出力しない場合は-1)
+        int frame = -1;
+    };
+    std::array<ReadbackSlot, Device::BackBufferCount> m_readbackSlots;
+    UINT m_readbackIndex;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_outputFootprint;
+    std::chrono::system_clock::time_point m_lastCheckpointTime;
+
+#ifdef _DEBUG
+    struct ImGuiParam {
+        Float3 cameraPos;
+        int maxPathDepth;
+        int maxSPP;
+    };
+    ImGuiParam m_imGuiParam;
+#endif // _DEBUG
+};
@@ -1,179 +1,180 @@
-#pragma once
-
-#include "device.hpp"
-#include "scene/model.hpp"
-#include "utils/texture_util.h"
-
-class Actor
-{
-public:
-    Actor() = delete;
-    ~Actor();
-
-    class ActorNode;
-    class ActorMaterial;
-
-    // ノード情報
-    class ActorNode
-    {
-    public:
-        ActorNode();
-        ~ActorNode();
-
-        void UpdateLocalMatrix();
-        void UpdateWorldMatrix(Matrix parentMtx);
-        void UpdateMatrix(Matrix parentMtx);
-
-        void SetTranslation(Vector trans) { m_trans = trans; }
-        void SetRotation(Vector rot) { m_rot = rot; }
-        void SetScale(Vector scale) { m_scale = scale; }
-
-        const std::wstring GetName() const { return m_name; }
-        Matrix GetLocalMatrix() { return m_localMtx; }
-        Matrix GetWorldMatrix() { return m_worldMtx; }
-        auto GetParent() { return m_parent; }
-    private:
-        std::wstring m_name;
-        Vector m_trans;
-        Vector m_rot;
-        Vector m_scale;
-        Matrix m_localMtx;
-        Matrix m_worldMtx;
-        std::weak_ptr<ActorNode> m_parent;
-        std::vector<std::shared_ptr<ActorNode>> m_children;
-        std::vector<UINT> m_meshes;
-        int m_meshGroupIndex = -1;
-        
-        friend class Model;
-        friend class Actor;
-    };
-
-    // マテリアル情報
-    class ActorMaterial
-    {
-    public:
-        ActorMaterial(std::unique_ptr<Device>& device, const Model::Material& srcMat);
-        ~ActorMaterial();
-
-        void SetHitGroupStr(const std::wstring& hitGroupStr) { m_hitGroupStr = hitGroupStr; }
-        void SetTexture(TextureResource& texRes);
-
-        std::wstring GetName() const { return m_name; }
-        std::wstring GetHitGroupStr() const { return m_hitGroupStr; }
-        DescriptorHeap GetTextureDescriptor() const { return m_texture.srv; }
-        DescriptorHeap GetMaterialDescriptor() const { return m_cbv[m_pDevice->GetCurrentFrameIndex()]; }
-    private:
-        std::wstring m_name;
-        std::wstring m_hitGroupStr;
-        std::vector<ComPtr<ID3D12Resource>> m_pMatrialCB;
-        std::vector<DescriptorHeap> m_cbv;
-        TextureResource m_texture;
-        struct MaterialParam
-        {
-            Float4 diffuse;
-        };
-        MaterialParam m_materialParam;
-
-        std::unique_ptr<Device>& m_pDevice;
-        friend class Model;
-    };
-
-    // メッシュ情報
-    class ActorMesh
-    {
-    public:
-        UINT GetIndexStart() const { return m_indexStart; }
-        UINT GetIndexCount() const { return m_indexCount; }
-        UINT GetVertexStart() const { return m_vertexStart; }
-        UINT GetVertexCount() const { return m_vertexCount; }
-        DescriptorHeap GetPosition() const { return m_vbAttrPos; }
-        DescriptorHeap GetNormal() const { return m_vbAttrNorm; }
-        DescriptorHeap GetTexcoord() const { return m_vbAttrTexCoord; }
-        DescriptorHeap GetIndexBuffer() const { return m_indexBuffer; }
-        std::shared_ptr<ActorMaterial> GetMaterial() const { return m_material; }
-        ComPtr<ID3D12Resource> GetMeshParamCB() const { return m_pMeshParamCB; }
-    private:
-        UINT m_indexStart;
-        UINT m_indexCount;
-        UINT m_vertexStart;
-        UINT m_vertexCount;
-        DescriptorHeap m_vbAttrPos;
-        DescriptorHeap m_vbAttrNorm;
-        DescriptorHeap m_vbAttrTexCoord;
-        DescriptorHeap m_indexBuffer;
-        std::shared_ptr<ActorMaterial> m_material;
-        struct MeshParam
-        {
-            Float4 diffuse;
-            UINT matrixBuffStride;
-            UINT meshGroupIndex;
-        };
-        ComPtr<ID3D12Resource> m_pMeshParamCB;
-
-        friend class Model;
-    };
-
-    // メッシュグループ情報
-    class ActorMeshGroup
-    {
-    public:
-        const std::shared_ptr<ActorNode> GetNode() const { return m_node; }
-        UINT GetMeshCount() const { return UINT(m_meshes.size()); }
-        const ActorMesh& GetMesh(int index) const { return m_meshes[index]; }
-    private:
-        std::shared_ptr<ActorNode> m_node;
-        std::vector<ActorMesh> m_meshes;
-        friend class Model;
-        friend class Actor;
-    };
-
-    void Translate(Float3 trans);
-    void Rotate(float speed, float startDeg, Float3 up);
-    // void RotateAroundAxis(float degree, Float3 center, Float3 axis, float raduis);
-    void MoveAnimInCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos);
-
-    void SetRotation(float degree, Float3 up);
-    void SetWorldPos(Float3 worldPos);
-    void SetWorldMatrix(Matrix worldMtx) { m_worldMtx = worldMtx; }
-    void SetMaterialHitGroup(const std::wstring& hitGroupName);
-    // 各ノードの行列を更新
-    void UpdateMatrices();
-    void UpdateBLAS(ComPtr<ID3D12GraphicsCommandList4> cmdList);
-    void UpdateTransform();
-    uint8_t* WriteHitGroupShaderRecord(uint8_t* dst, UINT hitGroupRecordSize, ComPtr<ID3D12StateObjectProperties> rtStateObjectProps);
-
-    Matrix GetWorldMatrix()const { return m_worldMtx; }
-    Float3 GetWorldPos() const { return m_worldPos; }
-    const Model* GetModel() { return m_modelRef; }
-    UINT GetMeshGroupCount() const; 
-    UINT GetMeshCount(int groupIndex) const;
-    const ActorMesh& GetMesh(int groupIndex, int meshIndex) const;
-    UINT GetTotalMeshCount() const;
-    UINT GetMaterialCount() const;
-    std::shared_ptr<ActorMaterial> GetMaterial(UINT idx) const;
-    ComPtr<ID3D12Resource> GetBLAS() const { return m_pBLAS; }
-    ComPtr<ID3D12Resource> GetBLASMatrices() const { return m_pBLASMatrices; }
-    DescriptorHeap GetBLASMatrixDescriptor() { return m_blasMatrixDescriptor; }
-
-
-private:
-    Actor(std::unique_ptr<Device>& device, const Model* model);
-    void CreateMatrixBufferBLAS(UINT mtxCount);
-    void CreateBLAS();
-    void CreateRTGeoDesc(std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& rtGeoDesc);
-    
-    Float3 m_worldPos;
-    Matrix m_worldMtx;
-    const Model* m_modelRef;
-    std::vector<std::shared_ptr<ActorNode>> m_nodes;
-    std::vector<std::shared_ptr<ActorMaterial>> m_materials;
-    std::vector<ActorMeshGroup> m_meshGroups;
-
-    ComPtr<ID3D12Resource> m_pBLAS;
-    ComPtr<ID3D12Resource> m_pBLASUpdateBuffer;
-    ComPtr<ID3D12Resource> m_pBLASMatrices;
-
-    DescriptorHeap m_blasMatrixDescriptor;
-    std::unique_ptr<Device>& m_pDevice;
-    friend class Model;
+#pragma once
+
+#include "device.hpp"
+#include "scene/actor_transform.hpp"
+#include "scene/model.hpp"
+#include "utils/texture_util.h"
+
+class Actor
+{
+public:
+    Actor() = delete;
+    ~Actor();
+
+    class ActorMaterial;
+
+    // マテリアル情報
+    class ActorMaterial
+    {
+    public:
+        ActorMaterial(std::unique_ptr<Device>& device, const Model::Material& srcMat);
+        ~ActorMaterial();
+
+        void SetHitGroupStr(const std::wstring& hitGroupStr) { m_hitGroupStr = hitGroupStr; }
+        void SetTexture(TextureResource& texRes);
+
+        std::wstring GetName() const { return m_name; }
+        std::wstring GetHitGroupStr() const { return m_hitGroupStr; }
+        DescriptorHeap GetTextureDescriptor() const { return m_texture.srv; }
+        DescriptorHeap GetMaterialDescriptor() const { return m_cbv; }
+    private:
+        std::wstring m_name;
+        std::wstring m_hitGroupStr;
+        // 作成後は変更しないのでバックバッファ間で共有する
+        ComPtr<ID3D12Resource> m_pMatrialCB;
+        DescriptorHeap m_cbv;
+        TextureResource m_texture;
+        struct MaterialParam
+        {
+            Float4 diffuse;
+        };
+        MaterialParam m_materialParam;
+
+        std::unique_ptr<Device>& m_pDevice;
+        friend class Model;
+    };
+
+    // メッシュ情報
+    class ActorMesh
+    {
+    public:
+        UINT GetIndexStart() const { return m_indexStart; }
+        UINT GetIndexCount() const { return m_indexCount; }
+        UINT GetVertexStart() const { return m_vertexStart; }
+        UINT GetVertexCount() const { return m_vertexCount; }
+        DescriptorHeap GetPosition() const { return m_vbAttrPos; }
+        DescriptorHeap GetNormal() const { return m_vbAttrNorm; }
+        DescriptorHeap GetTexcoord() const { return m_vbAttrTexCoord; }
+        DescriptorHeap GetIndexBuffer() const { return m_indexBuffer; }
+        std::shared_ptr<ActorMaterial> GetMaterial() const { return m_material; }
+        ComPtr<ID3D12Resource> GetMeshParamCB() const { return m_pMeshParamCB; }
+    private:
+        UINT m_indexStart;
+        UINT m_indexCount;
+        UINT m_vertexStart;
+        UINT m_vertexCount;
+        DescriptorHeap m_vbAttrPos;
+        DescriptorHeap m_vbAttrNorm;
+        DescriptorHeap m_vbAttrTexCoord;
+        DescriptorHeap m_indexBuffer;
+        std::shared_ptr<ActorMaterial> m_material;
+        ComPtr<ID3D12Resource> m_pMeshParamCB;
+
+        friend class Model;
+        friend class Actor;
+    };
+
+    // メッシュグループ情報
+    class ActorMeshGroup
+    {
+    public:
+        // TransformHierarchy上のノードインデックス
+        int GetNodeIndex() const { return m_nodeIndex; }
+        UINT GetMeshCount() const { return UINT(m_meshes.size()); }
+        const ActorMesh& GetMesh(int index) const { return m_meshes[index]; }
+    private:
+        int m_nodeIndex = -1;
+        std::vector<ActorMesh> m_meshes;
+        friend class Model;
+        friend class Actor;
+    };
+
+    // アクターの姿勢 (演出の状態の適用用)
+    using TransformState = ActorTransform;
+
+    void Translate(Float3 trans);
+    void Rotate(float speed, float startDeg, Float3 up);
+    // void RotateAroundAxis(float degree, Float3 center, Float3 axis, float raduis);
+    void MoveAnimInCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos);
+
+    void SetRotation(float degree, Float3 up);
+    void SetWorldPos(Float3 worldPos);
+    void SetWorldMatrix(Matrix worldMtx) { m_transform.worldMtx = worldMtx; m_isDirty = true; }
+    void SetMaterialHitGroup(const std::wstring& hitGroupName);
+    void SetInstanceID(UINT instanceID) { m_instanceID = instanceID; }
+    void SetInstanceMask(UINT instanceMask) { m_instanceMask = instanceMask; }
+    // 前回の更新から姿勢が変化している場合のみ各ノードの行列を更新
+    // 更新した場合はtrueを返す
+    bool UpdateMatrices();
+
+    // glTFアニメーションの再生
+    bool SetAnimation(const std::wstring& name);
+    // 指定時刻 (秒) の姿勢をノードに適用 (ループ再生)
+    void SetAnimationTime(float time);
+    bool IsSkinned() const { return m_pSkinning != nullptr; }
+    // ノードの姿勢が変化した場合のみ、CPUスキニングの結果をアップロードしBLASをリフィット
+    void UpdateSkinning(ComPtr<ID3D12GraphicsCommandList4> cmdList);
+    uint8_t* WriteHitGroupShaderRecord(uint8_t* dst, UINT hitGroupRecordSize, ComPtr<ID3D12StateObjectProperties> rtStateObjectProps);
+
+    Matrix GetWorldMatrix()const { return m_transform.worldMtx; }
+    Float3 GetWorldPos() const { return m_transform.worldPos; }
+    const TransformState& GetTransformState() const { return m_transform; }
+    void SetTransformState(const TransformState& state) { m_transform = state; m_isDirty = true; }
+    UINT GetInstanceID() const { return m_instanceID; }
+    UINT GetInstanceMask() const { return m_instanceMask; }
+    // 姿勢が変化するたびに加算される
+    uint64_t GetTransformVersion() const { return m_transformVersion; }
+    std::shared_ptr<const Model> GetModel() const { return m_modelRef; }
+    // ノードのTRSを変更する場合はこちらから (変更はUpdateMatricesで反映)
+    TransformHierarchy& GetHierarchy() { return m_hierarchy; }
+    const TransformHierarchy& GetHierarchy() const { return m_hierarchy; }
+    UINT GetMeshGroupCount() const; 
+    UINT GetMeshCount(int groupIndex) const;
+    const ActorMesh& GetMesh(int groupIndex, int meshIndex) const;
+    UINT GetTotalMeshCount() const;
+    UINT GetMaterialCount() const;
+    std::shared_ptr<ActorMaterial> GetMaterial(UINT idx) const;
+    // BLASは同一モデルのアクター間で共有 (スキニングするアクターのみ固有のBLASを持つ)
+    ComPtr<ID3D12Resource> GetBLAS() const { return m_pSkinning ? m_pSkinning->blas : m_modelRef->GetBLAS(); }
+    DescriptorHeap GetBLASMatrixDescriptor() const { return m_pSkinning ? m_pSkinning->blasMatrixDescriptor : m_modelRef->GetBLASMatrixDescriptor(); }
+
+private:
+    Actor(std::unique_ptr<Device>& device, std::shared_ptr<const Model> model);
+    void CreateSkinningResources();
+
+    // スキニング用のアクター固有リソース
+    struct SkinningResources
+    {
+        // CPU側のスキニング結果 (モデル空間)
+        std::vector<Float3> positions;
+        std::vector<Float3> normals;
+        std::vector<Mtx3x4> blasMatrices;
+        ComPtr<ID3D12Resource> position;
+        ComPtr<ID3D12Resource> normal;
+        ComPtr<ID3D12Resource> blasMatrixBuffer;
+        ComPtr<ID3D12Resource> blas;
+        ComPtr<ID3D12Resource> blasUpdate;
+        DescriptorHeap blasMatrixDescriptor;
+        std::vector<DescriptorHeap> descriptors;
+    };
+
+    ActorTransform m_transform;
+    UINT m_instanceID = 0;
+    UINT m_instanceMask = 0xFF;
+    // 変更の追跡
+    // 再生中に同じ姿勢が再設定された場合は変更なしとして扱う
+    bool m_isDirty = true;
+    Matrix m_committedMtx;
+    uint64_t m_transformVersion = 0;
+    std::shared_ptr<const Model> m_modelRef;
+    // ノード階層 (モデル空間、アクターの姿勢はTLAS側で適用)
+    TransformHierarchy m_hierarchy;
+    int m_animationIndex = -1;
+    bool m_isPoseDirty = false;
+    std::unique_ptr<SkinningResources> m_pSkinning;
+    std::vector<std::shared_ptr<ActorMaterial>> m_materials;
+    std::vector<ActorMeshGroup> m_meshGroups;
+
+    std::unique_ptr<Device>& m_pDevice;
+    friend class Model;
 };
\ No newline at end of file
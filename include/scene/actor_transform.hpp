@@ -0,0 +1,19 @@
+#pragma once
+
+#include "utils/math_util.h"
+
+/// <summary>
+/// アクターのワールド空間での姿勢
+/// Deviceに依存しないため、演出 (SceneAnimation) からはアクターを介さずに扱う
+/// </summary>
+struct ActorTransform
+{
+    Float3 worldPos = Float3(0.0f, 0.0f, 0.0f);
+    Matrix worldMtx = IdentityMtx();
+
+    void Translate(Float3 trans);
+    void Rotate(float speed, float startDeg, Float3 up);
+    void MoveAnimInCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos);
+    void SetRotation(float degree, Float3 up);
+    void SetWorldPos(Float3 pos);
+};
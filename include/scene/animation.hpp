@@ -0,0 +1,92 @@
+#pragma once
+
+#include "scene/transform_hierarchy.hpp"
+
+#include <array>
+
+/// <summary>
+/// glTFアニメーションのサンプラー
+/// </summary>
+struct AnimationSampler
+{
+    enum class Interpolation
+    {
+        Linear,
+        Step,
+        CubicSpline,
+    };
+    Interpolation interpolation = Interpolation::Linear;
+    std::vector<float> times;
+    // CubicSplineの場合は (in-tangent, value, out-tangent) の順に並ぶ
+    std::vector<Float4> values;
+
+    Vector Sample(float time, bool isRotation) const;
+};
+
+/// <summary>
+/// glTFアニメーションのチャンネル (ノードのTRSのいずれか1つを対象とする)
+/// </summary>
+struct AnimationChannel
+{
+    enum class Path
+    {
+        Translation,
+        Rotation,
+        Scale,
+    };
+    int nodeIndex = -1;   // TransformHierarchy上のインデックス
+    int samplerIndex = -1;
+    Path path = Path::Translation;
+};
+
+/// <summary>
+/// アニメーションクリップ
+/// </summary>
+struct AnimationClip
+{
+    std::wstring name;
+    float duration = 0.0f;
+    std::vector<AnimationSampler> samplers;
+    std::vector<AnimationChannel> channels;
+
+    // 指定時刻 (秒) の姿勢を階層に適用する
+    void Apply(float time, TransformHierarchy& hierarchy) const;
+};
+
+/// <summary>
+/// スキン (ジョイントと逆バインド行列)
+/// </summary>
+struct Skin
+{
+    std::vector<int> joints;  // TransformHierarchy上のインデックス
+    std::vector<Matrix> inverseBindMatrices;
+};
+
+/// <summary>
+/// CPUスキニング用の頂点データ (モデル全体の頂点バッファと同じ並び)
+/// </summary>
+struct SkinningData
+{
+    // スキニング対象の頂点範囲
+    struct Range
+    {
+        UINT vertexStart;
+        UINT vertexCount;
+        int skinIndex;
+    };
+    std::vector<Float3> bindPositions;
+    std::vector<Float3> bindNormals;
+    std::vector<std::array<uint16_t, 4>> joints;
+    std::vector<Float4> weights;
+    std::vector<Range> ranges;
+};
+
+// 線形ブレンドスキニング
+// 対象範囲の頂点をバッチに分割して並列に変換し、dstPositions/dstNormalsへ書き込む (モデル空間)
+void SkinVertices(
+    const SkinningData& data,
+    const std::vector<Skin>& skins,
+    const TransformHierarchy& hierarchy,
+    Float3* dstPositions,
+    Float3* dstNormals
+);
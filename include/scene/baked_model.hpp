@@ -0,0 +1,149 @@
+#pragma once
+
+#include "device.hpp"
+#include "utils/bvh_util.h"
+#include "utils/mapped_file.h"
+
+#include <span>
+
+/// <summary>
+/// ベイク済みモデル
+/// glTFを展開した結果 (頂点属性, プリミティブ範囲, ノード, マテリアル, テクスチャ) と
+/// 任意でCPU用のBVHをそのまま格納したバイナリ形式
+/// 読み込み時はファイルをメモリマップし、各セクションをコピーせずに直接参照する
+///
+/// ファイル構成: Header | Section 0 | Section 1 | ...
+/// 各セクションはSectionAlignment境界に配置する
+/// </summary>
+class BakedModel
+{
+public:
+    enum class Section : uint32_t
+    {
+        Index,          // UINT
+        Position,       // Float3
+        Normal,         // VertexFormatRecord::normalFormat
+        Texcoord,       // VertexFormatRecord::texcoordFormat
+        Mesh,           // MeshRecord
+        Primitive,      // PrimitiveRecord
+        Node,           // NodeRecord (親が子より前に並ぶ順)
+        Material,       // MaterialRecord
+        Texture,        // TextureRecord
+        ImageData,      // エンコード済みの画像データ
+        String,         // wchar_t
+        BVHNode,        // BVHNode (モデル空間)
+        BVHTriangle,    // uint32_t (モデル全体での三角形インデックス)
+        VertexFormat,   // VertexFormatRecord (1要素)
+        Count
+    };
+
+    // 文字列セクション内の位置 (wchar_t単位)
+    struct StringRef
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+    struct MeshRecord
+    {
+        int32_t nodeIndex;
+        uint32_t primitiveStart;
+        uint32_t primitiveCount;
+        uint32_t reserved;
+    };
+    struct PrimitiveRecord
+    {
+        uint32_t indexStart;
+        uint32_t vertexStart;
+        uint32_t indexCount;
+        uint32_t vertexCount;
+        uint32_t materialIndex;
+        uint32_t reserved[3];
+    };
+    struct NodeRecord
+    {
+        StringRef name;
+        int32_t parent;
+        uint32_t reserved;
+        Float4 translation;
+        Float4 rotation;
+        Float4 scale;
+    };
+    struct MaterialRecord
+    {
+        StringRef name;
+        int32_t textureIndex;
+        Float3 diffuse;
+    };
+    // 法線とUVの格納形式 (量子化された形式のまま格納する場合がある)
+    struct VertexFormatRecord
+    {
+        uint32_t normalFormat;      // DXGI_FORMAT
+        uint32_t normalStride;
+        uint32_t texcoordFormat;    // DXGI_FORMAT
+        uint32_t texcoordStride;
+    };
+    struct TextureRecord
+    {
+        StringRef name;
+        // ImageDataセクション内の範囲
+        uint64_t dataOffset;
+        uint64_t dataSize;
+    };
+
+    // 変換元のファイル情報 (変換元が更新された場合はベイクし直す)
+    struct SourceInfo
+    {
+        uint64_t hash;
+        uint64_t size;
+        uint64_t writeTime;
+    };
+
+    BakedModel() = default;
+    BakedModel(const BakedModel&) = delete;
+    ~BakedModel();
+
+    bool Open(const std::wstring& path);
+    void Close();
+
+    const SourceInfo& GetSourceInfo() const { return GetHeader()->source; }
+    bool HasSection(Section section) const { return GetHeader()->sections[UINT(section)].size > 0; }
+
+    template<typename T>
+    std::span<const T> GetSection(Section section) const
+    {
+        const auto& info = GetHeader()->sections[UINT(section)];
+        return std::span<const T>(reinterpret_cast<const T*>(m_pMapped + info.offset), size_t(info.size / sizeof(T)));
+    }
+    std::wstring GetString(const StringRef& ref) const;
+
+    // sectionsはSection順に並んだ各セクションの内容
+    static bool Write(const std::wstring& path, const SourceInfo& source, const std::array<std::span<const uint8_t>, size_t(Section::Count)>& sections);
+
+    // 変換元ファイル名からベイク済みファイルのパスを取得
+    static std::wstring GetBakedPath(const std::wstring& fileName);
+
+private:
+    struct SectionInfo
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        SourceInfo source;
+        uint32_t sectionCount;
+        uint32_t reserved;
+        SectionInfo sections[size_t(Section::Count)];
+    };
+    static const uint32_t Magic = 0x4B425452; // "RTBK"
+    static const uint32_t Version = 2;
+    static const uint64_t SectionAlignment = 64;
+
+    const Header* GetHeader() const { return reinterpret_cast<const Header*>(m_pMapped); }
+
+private:
+    MappedFile m_file;
+    const uint8_t* m_pMapped = nullptr;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "device.hpp"
+#include "utils/mapped_file.h"
+#include "utils/texture_util.h"
+
+#include <span>
+
+/// <summary>
+/// 前処理済みの環境マップ
+/// 正距円筒図法のHDR画像を八面体マッピング (+Yが天頂) に変換し、
+/// RGB9E5のミップマップと重点サンプリング用の累積分布をキャッシュファイルに格納する
+/// 読み込み時はファイルをメモリマップし、コピーせずにGPUへ転送する
+///
+/// ファイル構成: Header | Mip 0 | Mip 1 | ... | 周辺分布 | 条件付き分布
+/// 累積分布はミップ0のテクセル単位で、各行がN+1要素 (先頭0, 末尾1)
+/// </summary>
+class EnvironmentMap
+{
+public:
+    // 変換元のファイル情報 (変換元が更新された場合は作成し直す)
+    struct SourceInfo
+    {
+        uint64_t size;
+        uint64_t writeTime;
+    };
+
+    EnvironmentMap() = default;
+    EnvironmentMap(const EnvironmentMap&) = delete;
+    ~EnvironmentMap();
+
+    // キャッシュを開き、存在しないか古い場合は変換してから開く
+    bool Load(const std::wstring& fileName);
+    bool Open(const std::wstring& path);
+    void Close();
+
+    TextureResource Upload(std::unique_ptr<Device>& device) const;
+
+    // 方向の放射輝度 (ミップ0の最近傍)
+    Float3 Evaluate(const Float3& dir) const;
+    // 輝度に比例した方向のサンプリング (pdfは立体角あたり)
+    Float3 Sample(float u1, float u2, float& pdf) const;
+    float Pdf(const Float3& dir) const;
+
+    UINT GetResolution() const { return GetHeader()->resolution; }
+
+    // 変換元 (RESOURCE_DIR/texture/fileName) からキャッシュを作成
+    static bool Build(const std::wstring& fileName, const std::wstring& path);
+    static std::wstring GetCachePath(const std::wstring& fileName);
+
+private:
+    struct MipInfo
+    {
+        uint64_t offset;
+        uint32_t resolution;
+        uint32_t reserved;
+    };
+    static const uint32_t MaxMipLevels = 16;
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        SourceInfo source;
+        uint32_t resolution;
+        uint32_t mipLevels;
+        MipInfo mips[MaxMipLevels];
+        uint64_t marginalOffset;
+        uint64_t conditionalOffset;
+    };
+    static const uint32_t Magic = 0x564E4552; // "RENV"
+    static const uint32_t Version = 1;
+    static const uint64_t SectionAlignment = 64;
+
+    const Header* GetHeader() const { return reinterpret_cast<const Header*>(m_pMapped); }
+    std::span<const float> GetMarginalCDF() const;
+    std::span<const float> GetConditionalCDF(UINT row) const;
+    float GetTexelPdf(UINT row, UINT column) const;
+
+    static bool GetSourceStat(const std::wstring& fileName, SourceInfo& source);
+
+private:
+    MappedFile m_file;
+    const uint8_t* m_pMapped = nullptr;
+};
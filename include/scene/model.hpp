@@ -1,114 +1,214 @@
-#pragma once
-
-#include "device.hpp"
-#include "utils/texture_util.h"
-
-namespace tinygltf {
-    class Model;
-}
-
-class Actor;
-
-class Model
-{
-public:
-    Model();
-    Model(const std::wstring& name, std::unique_ptr<Device>& device);
-    ~Model();
-
-    std::shared_ptr<Actor> InstantiateActor(std::unique_ptr<Device>& device);
-    void Destroy(std::unique_ptr<Device>& device);
-
-    std::wstring GetName() const { return m_name; }
-
-    // ノード情報
-    class Node
-    {
-    public:
-        Node();
-        ~Node();
-    private:
-        std::wstring m_name;
-        Vector m_trans;
-        Vector m_rot;
-        Vector m_scale;
-        Matrix m_localMtx;
-        Matrix m_worldMtx;
-        Node* m_parent;
-        std::vector<int> m_childIndices;
-        int m_meshIndex = -1;
-        friend class Model;
-    };
-
-    // ポリゴン情報
-    class Primitive
-    {
-    private:
-        UINT m_indexStart;
-        UINT m_vertexStart;
-        UINT m_indexCount;
-        UINT m_vertexCount;
-        UINT m_materialIndex;
-        friend class Model;
-    };
-
-    // ポリゴンメッシュのグループ
-    class Mesh
-    {
-    private:
-        std::vector<Primitive> m_primitives;
-        int m_nodeIndex;
-        friend class Model;
-    };
-
-    // マテリアル情報
-    class Material
-    {
-    public:
-        Material() : m_name(), m_textureIndex(-1), m_diffuseColor(1, 1, 1) {}
-        std::wstring GetName() const { return m_name; }
-        int GetTextureIndex() const { return m_textureIndex; }
-        Float3 GetDiffuseColor() const { return m_diffuseColor; }
-    private:
-        std::wstring m_name;
-        int m_textureIndex;
-        // TODO: BRDF用の情報をセット
-        Float3 m_diffuseColor;
-        friend class Model;
-    };
-
-    ComPtr<ID3D12Resource> GetPositionBuffer() const { return m_vertexAtrrib.position; }
-    ComPtr<ID3D12Resource> GetNormalBuffer() const { return m_vertexAtrrib.normal; }
-    ComPtr<ID3D12Resource> GetIndexBuffer() const { return m_pIndexBuffer; }
-
-private:
-    struct VertexAttributeVisitor
-    {
-        std::vector<UINT> indexBuffer;
-        std::vector<Float3> positionBuffer;
-        std::vector<Float3> normalBuffer;
-        std::vector<Float2> texcoordBuffer;
-    };
-    bool LoadModel(const tinygltf::Model& srcModel, std::unique_ptr<Device>& device);
-    void LoadNode(const tinygltf::Model& srcModel);
-    void LoadMesh(const tinygltf::Model& srcModel, VertexAttributeVisitor& visitor);
-    void LoadMaterial(const tinygltf::Model& srcModel);
-
-    struct VertexAttrib
-    {
-        ComPtr<ID3D12Resource> position;
-        ComPtr<ID3D12Resource> normal;
-        ComPtr<ID3D12Resource> texcoord;
-    };
-    std::wstring m_name;
-    VertexAttrib m_vertexAtrrib;
-    ComPtr<ID3D12Resource> m_pIndexBuffer;
-    std::vector<TextureResource> m_textures;
-    std::vector<Mesh> m_meshes;
-    std::vector<Material> m_materials;
-    std::vector<std::shared_ptr<Node>> m_nodes;
-    std::vector<int> m_rootNodeIndices;
-    TextureResource m_dummyTexture;
-
-    friend class Actor;
+#pragma once
+
+#include "device.hpp"
+#include "scene/transform_hierarchy.hpp"
+#include "scene/animation.hpp"
+#include "scene/baked_model.hpp"
+#include "utils/texture_util.h"
+
+namespace tinygltf {
+    class Model;
+}
+struct GLTFDocument;
+class MappedFile;
+
+class Actor;
+
+class Model : public std::enable_shared_from_this<Model>
+{
+public:
+    Model();
+    // CPU側の解析のみを行う (スレッドセーフ)
+    // バッファと画像はメモリマップしたファイルを直接参照するため、Upload完了までfileを保持する
+    Model(const std::wstring& name, std::shared_ptr<const MappedFile> file);
+    // ベイク済みファイルから構築 (頂点属性と画像はマップされたファイルを直接参照する)
+    Model(const std::wstring& name, std::shared_ptr<const BakedModel> baked);
+    ~Model();
+
+    // 画像のデコード (CPUのみ、スレッドセーフ)
+    void DecodeImages();
+    // 展開済みの内容をベイク済みファイルとして書き出す (Upload前のみ)
+    bool Bake(const std::wstring& path, const BakedModel::SourceInfo& source, bool buildBVH) const;
+
+    // GPUリソースの作成 (メインスレッドから呼び出す)
+    void Upload(std::unique_ptr<Device>& device);
+    bool IsUploaded() const { return m_pBLAS != nullptr; }
+
+    std::shared_ptr<Actor> InstantiateActor(std::unique_ptr<Device>& device);
+    void Destroy(std::unique_ptr<Device>& device);
+
+    std::wstring GetName() const { return m_name; }
+
+    // ポリゴン情報
+    // 頂点属性のSRVとMeshParamは全アクターで共有
+    class Primitive
+    {
+    private:
+        UINT m_indexStart;
+        UINT m_vertexStart;
+        UINT m_indexCount;
+        UINT m_vertexCount;
+        UINT m_materialIndex;
+        DescriptorHeap m_vbAttrPos;
+        DescriptorHeap m_vbAttrNorm;
+        DescriptorHeap m_vbAttrTexCoord;
+        DescriptorHeap m_indexBuffer;
+        ComPtr<ID3D12Resource> m_pMeshParamCB;
+        friend class Model;
+    };
+
+    // ポリゴンメッシュのグループ
+    class Mesh
+    {
+    private:
+        std::vector<Primitive> m_primitives;
+        // TransformHierarchy上のインデックス
+        int m_nodeIndex = -1;
+        // スキニングする場合のスキンインデックス
+        int m_skinIndex = -1;
+        friend class Model;
+    };
+
+    // マテリアル情報
+    class Material
+    {
+    public:
+        Material() : m_name(), m_textureIndex(-1), m_diffuseColor(1, 1, 1) {}
+        std::wstring GetName() const { return m_name; }
+        int GetTextureIndex() const { return m_textureIndex; }
+        Float3 GetDiffuseColor() const { return m_diffuseColor; }
+    private:
+        std::wstring m_name;
+        int m_textureIndex;
+        // TODO: BRDF用の情報をセット
+        Float3 m_diffuseColor;
+        friend class Model;
+    };
+
+    ComPtr<ID3D12Resource> GetPositionBuffer() const { return m_vertexAtrrib.position; }
+    ComPtr<ID3D12Resource> GetNormalBuffer() const { return m_vertexAtrrib.normal; }
+    ComPtr<ID3D12Resource> GetIndexBuffer() const { return m_pIndexBuffer; }
+    ComPtr<ID3D12Resource> GetBLAS() const { return m_pBLAS; }
+    DescriptorHeap GetBLASMatrixDescriptor() const { return m_blasMatrixDescriptor; }
+    // GPUを使用しない描画バックエンド向けのジオメトリ (Upload前のみ有効)
+    // インデックスはvertexStartからの相対、行列はメッシュのノード行列 (モデル空間)
+    struct PrimitiveInfo
+    {
+        UINT indexStart;
+        UINT indexCount;
+        UINT vertexStart;
+        UINT vertexCount;
+        Mtx3x4 nodeMtx;
+        Float3 diffuse;
+    };
+    std::span<const UINT> GetIndices() const { return m_geometry.indices; }
+    std::span<const Float3> GetPositions() const { return m_geometry.positions; }
+    void GetPrimitiveInfos(std::vector<PrimitiveInfo>& infos) const;
+    // ベイク済みファイルに含まれるCPU用のBVH (モデル空間、存在しない場合は空)
+    std::span<const BVHNode> GetBVHNodes() const;
+    std::span<const uint32_t> GetBVHTriangles() const;
+
+    // アニメーションとスキニング
+    const std::vector<AnimationClip>& GetAnimations() const { return m_animations; }
+    int FindAnimation(const std::wstring& name) const;
+    bool HasSkin() const { return !m_skinningData.ranges.empty(); }
+    const std::vector<Skin>& GetSkins() const { return m_skins; }
+    const SkinningData& GetSkinningData() const { return m_skinningData; }
+    bool IsSkinnedMeshGroup(UINT groupIndex) const { return m_meshes[groupIndex].m_skinIndex >= 0; }
+    // 指定した頂点バッファと行列バッファを参照するジオメトリ情報 (アクター固有のBLAS用)
+    void CreateRTGeoDesc(
+        std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& rtGeoDesc,
+        D3D12_GPU_VIRTUAL_ADDRESS positionAddress,
+        D3D12_GPU_VIRTUAL_ADDRESS matrixAddress
+    ) const;
+
+private:
+    // 法線とUVの格納形式
+    // KHR_mesh_quantizationの正規化整数はfloatへ変換せず、SNORM/UNORMの型付きバッファとして参照する
+    struct VertexFormat
+    {
+        DXGI_FORMAT normal = DXGI_FORMAT_R32G32B32_FLOAT;
+        UINT normalStride = sizeof(Float3);
+        DXGI_FORMAT texcoord = DXGI_FORMAT_R32G32_FLOAT;
+        UINT texcoordStride = sizeof(Float2);
+    };
+    struct VertexAttributeVisitor
+    {
+        std::vector<UINT> indexBuffer;
+        std::vector<Float3> positionBuffer;
+        // VertexFormatの形式で詰めたバイト列
+        std::vector<uint8_t> normalBuffer;
+        std::vector<uint8_t> texcoordBuffer;
+    };
+    bool ParseModel(const GLTFDocument& src);
+    void CreateResources(std::unique_ptr<Device>& device);
+    void LoadNode(const tinygltf::Model& srcModel);
+    void LoadMesh(const GLTFDocument& src, VertexAttributeVisitor& visitor);
+    void LoadMaterial(const tinygltf::Model& srcModel);
+    void LoadSkin(const GLTFDocument& src);
+    void LoadAnimation(const GLTFDocument& src);
+    void LoadTextureSource(const GLTFDocument& src);
+    void CreatePrimitiveResources(std::unique_ptr<Device>& device);
+    void CreateMatrixBufferBLAS(std::unique_ptr<Device>& device);
+    void CreateBLAS(std::unique_ptr<Device>& device);
+    void CreateRTGeoDesc(std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& rtGeoDesc) const;
+
+    struct MeshParam
+    {
+        Float4 diffuse;
+        UINT matrixBuffStride;
+        UINT meshGroupIndex;
+    };
+
+    // GPUへ転送する頂点属性 (glTFの展開結果またはベイク済みファイルを参照)
+    struct GeometryView
+    {
+        std::span<const UINT> indices;
+        std::span<const Float3> positions;
+        std::span<const uint8_t> normals;
+        std::span<const uint8_t> texcoords;
+    };
+
+    struct VertexAttrib
+    {
+        ComPtr<ID3D12Resource> position;
+        ComPtr<ID3D12Resource> normal;
+        ComPtr<ID3D12Resource> texcoord;
+    };
+    std::wstring m_name;
+    VertexAttrib m_vertexAtrrib;
+    ComPtr<ID3D12Resource> m_pIndexBuffer;
+    std::vector<TextureResource> m_textures;
+    std::vector<Mesh> m_meshes;
+    std::vector<Material> m_materials;
+    // モデル空間のノード階層 (アクターは複製して使用)
+    TransformHierarchy m_hierarchy;
+    // glTFのノードインデックス -> TransformHierarchyのインデックス
+    std::vector<int> m_nodeRemap;
+    std::vector<Skin> m_skins;
+    std::vector<AnimationClip> m_animations;
+    SkinningData m_skinningData;
+    TextureResource m_dummyTexture;
+
+    // Upload完了まで保持する解析結果
+    std::unique_ptr<GLTFDocument> m_pSrcModel;
+    std::unique_ptr<VertexAttributeVisitor> m_pVisitor;
+    GeometryView m_geometry;
+    VertexFormat m_vertexFormat;
+    // テクスチャごとの画像インデックスと名前
+    std::vector<int> m_textureImages;
+    std::vector<std::wstring> m_textureNames;
+    // 画像インデックスごとのエンコード済みデータとデコード結果
+    std::vector<std::span<const uint8_t>> m_encodedImages;
+    std::vector<DecodedImage> m_decodedImages;
+    DecodedImage m_dummyImage;
+    // ベイク済みファイル (BVHを参照するためモデルの破棄まで保持)
+    std::shared_ptr<const BakedModel> m_pBaked;
+
+    // 全アクターで共有するBLAS
+    ComPtr<ID3D12Resource> m_pBLAS;
+    ComPtr<ID3D12Resource> m_pBLASMatrices;
+    DescriptorHeap m_blasMatrixDescriptor;
+
+    friend class Actor;
 };
\ No newline at end of file
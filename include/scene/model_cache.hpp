@@ -0,0 +1,50 @@
+#pragma once
+
+#include "device.hpp"
+#include "scene/model.hpp"
+
+#include <mutex>
+
+/// <summary>
+/// モデルアセットのキャッシュ
+/// 同一のglTFファイルは一度だけ読み込み、アクター間でGPUリソースを共有する
+/// </summary>
+class ModelCache
+{
+public:
+    ModelCache() = default;
+    ~ModelCache();
+
+    std::shared_ptr<Model> Load(const std::wstring& fileName, std::unique_ptr<Device>& device);
+    // 複数ファイルの読み込みと解析を並列に行い、GPUリソースの作成のみ直列に行う
+    void Preload(const std::vector<std::wstring>& fileNames, std::unique_ptr<Device>& device);
+    void Clear(std::unique_ptr<Device>& device);
+    // 解析のみ行い、GPUリソースは作成しない (GPUを使用しない描画バックエンド向け、Loadと混在させない)
+    std::shared_ptr<Model> LoadWithoutUpload(const std::wstring& fileName);
+    // glTFを展開してベイク済みファイルを作成する (以降の読み込みではベイク済みファイルを優先)
+    bool Bake(const std::wstring& fileName, bool buildBVH) const;
+
+    UINT GetModelCount() const { return UINT(m_models.size()); }
+
+private:
+    struct ParsedModel
+    {
+        std::wstring fileName;
+        uint64_t hash;
+        std::shared_ptr<Model> model;
+    };
+    ParsedModel Parse(const std::wstring& fileName) const;
+    std::shared_ptr<Model> Register(ParsedModel& parsed, std::unique_ptr<Device>& device);
+    std::shared_ptr<const MappedFile> MapFile(const std::wstring& fileName) const;
+    uint64_t ComputeHash(const std::wstring& fileName, std::span<const uint8_t> data) const;
+    // 変換元のファイルサイズと更新日時 (変換元が存在しない場合はfalse)
+    bool GetSourceStat(const std::wstring& fileName, uint64_t& size, uint64_t& writeTime) const;
+    std::shared_ptr<BakedModel> OpenBaked(const std::wstring& fileName) const;
+
+private:
+    // ファイルパス -> コンテンツハッシュ
+    std::unordered_map<std::wstring, uint64_t> m_pathToHash;
+    // コンテンツハッシュ -> モデル
+    std::unordered_map<uint64_t, std::shared_ptr<Model>> m_models;
+    mutable std::mutex m_mutex;
+};
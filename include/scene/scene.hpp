@@ -1,86 +1,119 @@
-#pragma once
-
-#include "device.hpp"
-#include "scene/camera.hpp"
-#include "scene/actor.hpp"
-
-class Scene
-{
-public:
-    Scene(std::unique_ptr<Device>& device);
-    ~Scene();
-
-    void OnInit(float aspect);
-    void OnUpdate(int currentFrame, int maxFrame);
-    void OnDestroy();
-
-    void CreateRTInstanceDesc(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs);
-    void UpdateSceneParam(UINT currentFrame);
-    uint8_t* WriteHitGroupShaderRecord(uint8_t* dst, UINT hitGroupRecordSize, ComPtr<ID3D12StateObject>& rtStateObject);
-    void UpdateBLAS(ComPtr<ID3D12GraphicsCommandList4> cmdList);
-
-    void SetMaxPathDepth(UINT maxPathDepth) { m_maxPathDepth = maxPathDepth;  }
-    void SetMaxSPP(UINT maxSPP) { m_maxSPP = maxSPP; }
-
-    UINT GetMaxPathDepth() { return m_maxPathDepth; }
-    UINT GetMaxSPP() { return m_maxSPP; }
-    Camera::CameraParam GetCameraParam() { return m_camera->GetParam(); }
-    std::shared_ptr<Camera> GetCamera() { return m_camera; }
-    ComPtr<ID3D12Resource> GetConstantBuffer();
-    TextureResource GetBackgroundTex() { return m_bgTex; }
-    UINT GetTotalHitGroupCount() { return m_totalHitGroupCount; }
-
-    struct SphereLightParam
-    {
-        Float3 center;
-        float radius;
-        Float3 color;
-        float intensity;
-    };
-
-    struct SceneParam
-    {
-        Matrix viewMtx;
-        Matrix projMtx;
-        Matrix invViewMtx;
-        Matrix invProjMtx;
-        UINT frameIndex;
-        UINT currentFrameNum;
-        UINT maxPathDepth;
-        UINT maxSPP;
-        SphereLightParam light1;
-        SphereLightParam light2;
-        SphereLightParam light3;
-    };
-
-private:
-    void InitializeActors();
-    void InstantiateActor(std::shared_ptr<Actor>& actor, const std::wstring name, const std::wstring hitGroup, Float3 pos);
-    void SetTotalHitGroupCount();
-
-private:
-    SceneParam m_param;
-    UINT m_maxPathDepth;
-    UINT m_maxSPP;
-    UINT m_totalHitGroupCount;
-
-    std::shared_ptr<Camera> m_camera;
-    std::shared_ptr<Actor> m_sphereLight1;
-    std::shared_ptr<Actor> m_sphereLight2;
-    std::shared_ptr<Actor> m_sphereLight3;
-    std::shared_ptr<Actor> m_planeBottom;
-    std::shared_ptr<Actor> m_planeTop;
-    std::shared_ptr<Actor> m_planeRight;
-    std::shared_ptr<Actor> m_planeLeft;
-    std::shared_ptr<Actor> m_planeFront;
-    std::shared_ptr<Actor> m_planeBack;
-    std::shared_ptr<Actor> m_modelActor;
-    std::shared_ptr<Actor> m_tableActor;
-    std::unique_ptr<Device>& m_pDevice;
-
-    std::vector<std::shared_ptr<Actor>> m_actors;
-
-    TextureResource m_bgTex;
-
-    std::vector<ComPtr<ID3D12Resource>> m_pConstantBuffers;
-};
+#pragma once
+
+#include "device.hpp"
+#include "scene/camera.hpp"
+#include "scene/actor.hpp"
+#include "scene/environment_map.hpp"
+#include "scene/model_cache.hpp"
+#include "scene/scene_animation.hpp"
+#include "scene/scene_desc.hpp"
+#include "utils/command_list_pool.h"
+
+class Scene
+{
+public:
+    Scene(std::unique_ptr<Device>& device);
+    ~Scene();
+
+    void OnInit(float aspect, const std::wstring& sceneFile);
+    void OnUpdate(int currentFrame, int maxFrame);
+    void OnDestroy();
+
+    // TLASのインスタンス情報をdst[0, GetActorCount()) へ並列に書き込む
+    void WriteRTInstanceDescs(D3D12_RAYTRACING_INSTANCE_DESC* dst) const;
+    UINT GetActorCount() const { return UINT(m_actors.size()); }
+    void UpdateSceneParam(UINT currentFrame);
+    uint8_t* WriteHitGroupShaderRecord(uint8_t* dst, UINT hitGroupRecordSize, ComPtr<ID3D12StateObject>& rtStateObject);
+    // アクターの範囲ごとにプールのコマンドリストへ並列に記録する (提出はプールのSubmitで行う)
+    void UpdateBLAS(CommandListPool<Device>& cmdListPool);
+
+    void SetMaxPathDepth(UINT maxPathDepth) { m_maxPathDepth = maxPathDepth;  }
+    void SetMaxSPP(UINT maxSPP) { m_maxSPP = maxSPP; }
+
+    UINT GetMaxPathDepth() { return m_maxPathDepth; }
+    UINT GetMaxSPP() { return m_maxSPP; }
+    UINT GetLightCount() const { return UINT(m_lightActors.size()); }
+    Camera::CameraParam GetCameraParam() { return m_camera->GetParam(); }
+    std::shared_ptr<Camera> GetCamera() { return m_camera; }
+    // 現在のフレームのシーン定数バッファ (OnUpdateで書き込み)
+    D3D12_GPU_VIRTUAL_ADDRESS GetConstantBufferAddress() const { return m_sceneCBAddress; }
+    TextureResource GetBackgroundTex() { return m_bgTex; }
+    const EnvironmentMap& GetEnvironmentMap() const { return m_envMap; }
+    UINT GetTotalHitGroupCount() { return m_totalHitGroupCount; }
+    std::shared_ptr<Actor> FindActor(const std::wstring& name) const;
+    // 直近のUpdateBLASで姿勢が更新されたアクター数
+    UINT GetUpdatedActorCount() const { return m_updatedActorCount; }
+    // いずれかのアクターの姿勢が変化するたびに加算される
+    uint64_t GetTransformVersion() const { return m_transformVersion; }
+
+    // シェーダー側で扱える球光源の最大数
+    static const UINT MaxLightCount = 3;
+    // 並列処理で1スレッドが受け持つ最小のアクター数
+    static const UINT ActorBatchSize = 64;
+
+    struct SphereLightParam
+    {
+        Float3 center;
+        float radius;
+        Float3 color;
+        float intensity;
+    };
+
+    struct SceneParam
+    {
+        Matrix viewMtx;
+        Matrix projMtx;
+        Matrix invViewMtx;
+        Matrix invProjMtx;
+        UINT frameIndex;
+        UINT currentFrameNum;
+        UINT maxPathDepth;
+        UINT maxSPP;
+        SphereLightParam lights[MaxLightCount];
+        UINT lightCount;
+    };
+    // glTFアニメーションの再生レート (Animateと揃える)
+    static constexpr float AnimationFrameRate = 60.0f;
+
+private:
+    // 演出の状態をカメラ, 光源, アクターへ反映
+    void ApplyAnimationState(const SceneAnimation::State& state);
+    void InitializeActors(const SceneDesc& desc);
+    void InstantiateActor(std::shared_ptr<Actor>& actor, const std::wstring name, const std::wstring hitGroup, Float3 pos);
+    void RegisterActor(const std::wstring& name, std::shared_ptr<Actor>& actor);
+    SphereLightParam& GetLightParam(UINT index);
+    void SetTotalHitGroupCount();
+
+private:
+    SceneParam m_param;
+    UINT m_maxPathDepth;
+    UINT m_maxSPP;
+    UINT m_totalHitGroupCount;
+    // アクターごとのHitGroupのオフセット (m_actorsの順)
+    std::vector<UINT> m_hitGroupOffsets;
+    UINT m_updatedActorCount;
+    uint64_t m_transformVersion;
+
+    std::shared_ptr<Camera> m_camera;
+    std::vector<std::shared_ptr<Actor>> m_lightActors;
+    std::shared_ptr<Actor> m_planeBottom;
+    std::shared_ptr<Actor> m_planeRight;
+    std::shared_ptr<Actor> m_planeFront;
+    // 演出で動かすアクター (SceneAnimation::Targetの順)
+    std::shared_ptr<Actor> m_targetActors[SceneAnimation::TargetCount];
+    std::shared_ptr<Actor> m_tableActor;
+    std::unique_ptr<Device>& m_pDevice;
+
+    std::vector<std::shared_ptr<Actor>> m_actors;
+    std::vector<std::shared_ptr<Actor>> m_animatedActors;
+    std::unordered_map<std::wstring, std::shared_ptr<Actor>> m_actorMap;
+    ModelCache m_modelCache;
+
+    EnvironmentMap m_envMap;
+    TextureResource m_bgTex;
+
+    // 演出 (任意のフレームから描画する際の再生もこちらで行う)
+    SceneAnimation m_animation;
+
+    D3D12_GPU_VIRTUAL_ADDRESS m_sceneCBAddress = 0;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "scene/actor_transform.hpp"
+#include "scene/camera.hpp"
+#include "scene/scene_desc.hpp"
+
+#include <optional>
+#include <vector>
+
+/// <summary>
+/// シーンの演出 (カメラ, モデル, 背景の展開, 球光源)
+/// CPU側の状態のみを扱うため、Scene (D3D12) とBackendSceneDesc (描画バックエンド) で同じ演出を再生する
+/// 演出は直前の状態を引き継ぐため、フレームの状態は0フレーム目から順に再生した結果として決まる
+/// </summary>
+class SceneAnimation
+{
+public:
+    // 演出で動かすアクター (シーン記述のアクター名で対応付ける)
+    enum class Target : uint32_t
+    {
+        Model,      // "model"
+        PlaneTop,   // "planeTop"
+        PlaneBack,  // "planeBack"
+        PlaneLeft,  // "planeLeft"
+        Count,
+    };
+    static const uint32_t TargetCount = uint32_t(Target::Count);
+    // 光源の演出は3灯のシーンのみ
+    static const uint32_t AnimatedLightCount = 3;
+
+    struct SphereLight
+    {
+        Float3 center;
+        float radius;
+        Float3 color;
+        float intensity;
+    };
+
+    struct State
+    {
+        Camera camera;
+        std::vector<SphereLight> lights;
+        // シーンにないアクターはnullopt
+        std::optional<ActorTransform> targets[TargetCount];
+    };
+
+    // シーン記述の初期配置から0フレーム目の前の状態を作成
+    void OnInit(const SceneDesc& desc, float aspect);
+    // 指定フレームの状態まで再生する
+    // 巻き戻す場合は初期状態から、先に飛ぶ場合は途中のフレームを順に再生する
+    const State& Seek(int currentFrame, int maxFrame);
+    const State& GetState() const { return m_state; }
+
+    static const wchar_t* GetTargetName(Target target);
+    // シーン記述の配置 (回転してから平行移動する)
+    static ActorTransform MakeTransform(const SceneDesc::TransformDesc& desc);
+
+private:
+    // 指定フレームのアニメーション (結果は直前のフレームの状態と currentFrame のみで決まる)
+    void Animate(int currentFrame, int maxFrame);
+    ActorTransform* GetTarget(Target target);
+
+private:
+    State m_initialState;
+    State m_state;
+    // 最後にアニメーションを適用したフレーム (-1: 初期状態)
+    int m_lastAnimatedFrame = -1;
+};
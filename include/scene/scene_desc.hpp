@@ -0,0 +1,59 @@
+#pragma once
+
+#include "utils/math_util.h"
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// シーン記述ファイルの内容
+/// resources/scene/*.json から読み込む
+/// </summary>
+struct SceneDesc
+{
+    struct CameraDesc
+    {
+        Float3 position = Float3(-9.0f, 0.36f, 5.8f);
+        Float3 target = Float3(0.0f, 5.0f, 0.0f);
+        float fovY = XM_PIDIV4;
+        float nearZ = 0.1f;
+        float farZ = 100.0f;
+    };
+
+    struct TransformDesc
+    {
+        Float3 position = Float3(0.0f, 0.0f, 0.0f);
+        // 軸回転 (度数)
+        float rotationDeg = 0.0f;
+        Float3 rotationAxis = Float3(0.0f, 1.0f, 0.0f);
+    };
+
+    struct ActorDesc
+    {
+        std::wstring name;
+        std::wstring model;
+        std::wstring hitGroup = L"Actor";
+        // 再生するglTFアニメーション名 (空の場合は再生しない)
+        std::wstring animation;
+        // 複数指定した場合は同一モデルのアクターを配置数分生成する
+        std::vector<TransformDesc> instances;
+    };
+
+    struct LightDesc
+    {
+        std::wstring name;
+        std::wstring model = L"sphere.glb";
+        Float3 position = Float3(0.0f, 0.0f, 0.0f);
+        float radius = 0.2f;
+        Float3 color = Float3(1.0f, 1.0f, 1.0f);
+        float intensity = 50.0f;
+    };
+
+    CameraDesc camera;
+    std::wstring background = L"rogland_clear_night_4k.hdr";
+    std::vector<LightDesc> lights;
+    std::vector<ActorDesc> actors;
+};
+
+// シーン記述ファイルの読み込み
+bool LoadSceneDesc(const std::wstring& fileName, SceneDesc& desc);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "device.hpp"
+
+/// <summary>
+/// ノードの階層構造 (SoA)
+/// ノードは親が必ず子より前に並ぶ順 (トポロジカル順) で格納し、
+/// 先頭から1回走査するだけで全ノードのワールド行列を更新する
+/// </summary>
+class TransformHierarchy
+{
+public:
+    TransformHierarchy() = default;
+
+    void Reserve(UINT nodeCount);
+    // 親ノードは追加済みである必要がある (ルートの場合は-1)
+    int AddNode(const std::wstring& name, int parentIndex, Vector trans, Vector rot, Vector scale);
+    // 変更されたノードと、その子孫のみ行列を再計算する (更新があった場合はtrue)
+    bool Update(Matrix rootMtx, bool isRootDirty);
+
+    // 同じ値が設定された場合は変更なしとして扱う
+    void SetTranslation(int index, Vector trans) { SetValue(m_translations, index, trans); }
+    void SetRotation(int index, Vector rot) { SetValue(m_rotations, index, rot); }
+    void SetScale(int index, Vector scale) { SetValue(m_scales, index, scale); }
+
+    UINT GetNodeCount() const { return UINT(m_parents.size()); }
+    int FindNode(const std::wstring& name) const;
+    const std::wstring& GetName(int index) const { return m_names[index]; }
+    int GetParent(int index) const { return m_parents[index]; }
+    Vector GetTranslation(int index) const { return m_translations[index]; }
+    Vector GetRotation(int index) const { return m_rotations[index]; }
+    Vector GetScale(int index) const { return m_scales[index]; }
+    const Matrix& GetLocalMatrix(int index) const { return m_localMtx[index]; }
+    const Matrix& GetWorldMatrix(int index) const { return m_worldMtx[index]; }
+
+private:
+    void SetValue(std::vector<Vector>& values, int index, Vector value)
+    {
+        if (XMVector4Equal(values[index], value))
+        {
+            return;
+        }
+        values[index] = value;
+        m_flags[index] |= LocalDirty;
+        m_isDirty = true;
+    }
+
+    enum Flag : uint8_t
+    {
+        LocalDirty = 1 << 0,   // TRSが変更された
+        WorldChanged = 1 << 1, // 直近のUpdateでワールド行列が変化した
+    };
+
+    std::vector<std::wstring> m_names;
+    std::vector<int> m_parents;
+    std::vector<Vector> m_translations;
+    std::vector<Vector> m_rotations;
+    std::vector<Vector> m_scales;
+    std::vector<Matrix> m_localMtx;
+    std::vector<Matrix> m_worldMtx;
+    std::vector<uint8_t> m_flags;
+    // いずれかのノードが変更されたか
+    bool m_isDirty = false;
+};
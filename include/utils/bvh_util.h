@@ -0,0 +1,185 @@
+#pragma once
+
+#include "utils/math_util.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+// CPU側のBVH
+// 内部ノードはleftFirstに左の子のインデックスを持ち、右の子はleftFirst + 1
+// 葉ノード (triCount > 0) はleftFirstから始まるtriCount個の三角形を参照する
+struct BVHNode
+{
+    Float3 boundsMin;
+    uint32_t leftFirst;
+    Float3 boundsMax;
+    uint32_t triCount;
+};
+
+struct BVHBounds
+{
+    Float3 boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+    Float3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    void Grow(const Float3& p)
+    {
+        boundsMin = { (std::min)(boundsMin.x, p.x), (std::min)(boundsMin.y, p.y), (std::min)(boundsMin.z, p.z) };
+        boundsMax = { (std::max)(boundsMax.x, p.x), (std::max)(boundsMax.y, p.y), (std::max)(boundsMax.z, p.z) };
+    }
+    void Grow(const BVHBounds& b)
+    {
+        Grow(b.boundsMin);
+        Grow(b.boundsMax);
+    }
+    float Area() const
+    {
+        float dx = boundsMax.x - boundsMin.x;
+        float dy = boundsMax.y - boundsMin.y;
+        float dz = boundsMax.z - boundsMin.z;
+        return dx < 0.0f ? 0.0f : 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+namespace bvh_detail
+{
+    const int BinCount = 16;
+    const uint32_t MaxLeafTriangles = 4;
+
+    inline float Axis(const Float3& v, int axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+}
+
+/// <summary>
+/// 三角形のAABBからBVHを構築 (ビン分割によるSAH)
+/// </summary>
+/// <param name="triBounds">三角形ごとのAABB</param>
+/// <param name="nodes">構築結果のノード (先頭がルート)</param>
+/// <param name="triIndices">葉ノードが参照する三角形インデックスの並び</param>
+inline void BuildBVH(const std::vector<BVHBounds>& triBounds, std::vector<BVHNode>& nodes, std::vector<uint32_t>& triIndices)
+{
+    using namespace bvh_detail;
+    nodes.clear();
+    triIndices.resize(triBounds.size());
+    for (uint32_t i = 0; i < uint32_t(triBounds.size()); ++i)
+    {
+        triIndices[i] = i;
+    }
+    if (triBounds.empty())
+    {
+        return;
+    }
+
+    std::vector<Float3> centroids(triBounds.size());
+    for (size_t i = 0; i < triBounds.size(); ++i)
+    {
+        const auto& b = triBounds[i];
+        centroids[i] = {
+            (b.boundsMin.x + b.boundsMax.x) * 0.5f,
+            (b.boundsMin.y + b.boundsMax.y) * 0.5f,
+            (b.boundsMin.z + b.boundsMax.z) * 0.5f
+        };
+    }
+
+    nodes.reserve(triBounds.size() * 2);
+    nodes.push_back({ {}, 0, {}, uint32_t(triBounds.size()) });
+    std::vector<uint32_t> stack{ 0 };
+    while (!stack.empty())
+    {
+        auto nodeIndex = stack.back();
+        stack.pop_back();
+        uint32_t first = nodes[nodeIndex].leftFirst;
+        uint32_t count = nodes[nodeIndex].triCount;
+
+        BVHBounds bounds;
+        BVHBounds centroidBounds;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            bounds.Grow(triBounds[triIndices[i]]);
+            centroidBounds.Grow(centroids[triIndices[i]]);
+        }
+        nodes[nodeIndex].boundsMin = bounds.boundsMin;
+        nodes[nodeIndex].boundsMax = bounds.boundsMax;
+        if (count <= MaxLeafTriangles)
+        {
+            continue;
+        }
+
+        // 各軸でビンごとのSAHを評価し、最小コストの分割を選ぶ
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = bounds.Area() * float(count);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float axisMin = Axis(centroidBounds.boundsMin, axis);
+            float axisMax = Axis(centroidBounds.boundsMax, axis);
+            if (axisMax <= axisMin)
+            {
+                continue;
+            }
+            BVHBounds binBounds[BinCount];
+            uint32_t binCounts[BinCount] = {};
+            float scale = float(BinCount) / (axisMax - axisMin);
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                auto tri = triIndices[i];
+                int bin = (std::min)(BinCount - 1, int((Axis(centroids[tri], axis) - axisMin) * scale));
+                binBounds[bin].Grow(triBounds[tri]);
+                binCounts[bin]++;
+            }
+
+            // 左右からの累積
+            float leftArea[BinCount - 1];
+            uint32_t leftCount[BinCount - 1];
+            BVHBounds accum;
+            uint32_t accumCount = 0;
+            for (int i = 0; i < BinCount - 1; ++i)
+            {
+                accum.Grow(binBounds[i]);
+                accumCount += binCounts[i];
+                leftArea[i] = accum.Area();
+                leftCount[i] = accumCount;
+            }
+            accum = BVHBounds();
+            accumCount = 0;
+            for (int i = BinCount - 1; i > 0; --i)
+            {
+                accum.Grow(binBounds[i]);
+                accumCount += binCounts[i];
+                float cost = leftArea[i - 1] * float(leftCount[i - 1]) + accum.Area() * float(accumCount);
+                if (leftCount[i - 1] > 0 && accumCount > 0 && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+        if (bestAxis < 0)
+        {
+            // 分割しても改善しない場合は葉とする
+            continue;
+        }
+
+        float axisMin = Axis(centroidBounds.boundsMin, bestAxis);
+        float scale = float(BinCount) / (Axis(centroidBounds.boundsMax, bestAxis) - axisMin);
+        auto middle = std::partition(triIndices.begin() + first, triIndices.begin() + first + count, [&](uint32_t tri)
+        {
+            int bin = (std::min)(BinCount - 1, int((Axis(centroids[tri], bestAxis) - axisMin) * scale));
+            return bin < bestSplit;
+        });
+        auto leftCount = uint32_t(middle - (triIndices.begin() + first));
+
+        auto leftIndex = uint32_t(nodes.size());
+        nodes.push_back({ {}, first, {}, leftCount });
+        nodes.push_back({ {}, first + leftCount, {}, count - leftCount });
+        nodes[nodeIndex].leftFirst = leftIndex;
+        nodes[nodeIndex].triCount = 0;
+        stack.push_back(leftIndex + 1);
+        stack.push_back(leftIndex);
+    }
+    nodes.shrink_to_fit();
+}
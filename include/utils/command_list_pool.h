@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "parallel_util.h"
+
+/// <summary>
+/// フレームスロットごと, スレッドごとのコマンドアロケーターとコマンドリストのプール
+/// 範囲を連続したチャンクに分けて別々のコマンドリストへWorkerPoolで並列に記録し、Submitでチャンクの順に提出する
+/// アロケーターはチャンクごとに専用のものを使うため、記録中のスレッド間で共有されない
+/// 作成済みのアロケーターとリストは同じスロットで再利用し、定常状態では作成を行わない
+///
+/// TDeviceは以下を持つこと (Deviceと記録用のモックで差し替えられる)
+///   CommandAllocatorType, CommandListType
+///   CommandAllocatorType CreateCommandAllocator()
+///   CommandListType CreateCommandList(CommandAllocatorType)  (記録可能な状態で作成する)
+///   void ResetCommandAllocator(CommandAllocatorType)
+///   void ResetCommandList(CommandListType, CommandAllocatorType)
+///   void CloseCommandList(CommandListType)
+///   void ExecuteCommandLists(const std::vector<CommandListType>&)
+/// </summary>
+template<typename TDevice>
+class CommandListPool
+{
+public:
+    using CommandAllocator = typename TDevice::CommandAllocatorType;
+    using CommandList = typename TDevice::CommandListType;
+    using RecordFunc = std::function<void(CommandList, size_t, size_t)>;
+
+    /// <param name="frameCount">フレームスロットの数 (GPUで同時に実行中になりうるフレーム数)</param>
+    /// <param name="threadCount">1回の並列記録で使用する最大スレッド数 (0の場合はWorkerPoolのスレッド数)</param>
+    CommandListPool(TDevice& device, uint32_t frameCount, uint32_t threadCount = 0) :
+        m_device(device),
+        m_slots((std::max)(frameCount, 1u)),
+        m_threadCount(threadCount > 0 ? threadCount : WorkerPool::Get().GetThreadCount())
+    {
+    }
+
+    CommandListPool(const CommandListPool&) = delete;
+    CommandListPool& operator=(const CommandListPool&) = delete;
+
+    uint32_t GetThreadCount() const { return m_threadCount; }
+    uint32_t GetFrameCount() const { return uint32_t(m_slots.size()); }
+    // スロットに作成済みのコマンドリストの数
+    size_t GetContextCount(uint32_t frameSlot) const { return m_slots[frameSlot % m_slots.size()].contexts.size(); }
+
+    /// <summary>
+    /// フレームの開始
+    /// 前回このスロットで使用したアロケーターをリセットする (GPUでの実行が完了していること)
+    /// </summary>
+    void BeginFrame(uint32_t frameSlot)
+    {
+        m_frameSlot = frameSlot % uint32_t(m_slots.size());
+        auto& slot = m_slots[m_frameSlot];
+        for (size_t i = 0; i < slot.usedCount; ++i)
+        {
+            m_device.ResetCommandAllocator(slot.contexts[i].allocator);
+        }
+        slot.usedCount = 0;
+        m_recorded.clear();
+    }
+
+    /// <summary>
+    /// [0, count) を連続したチャンクに分割し、チャンクごとのコマンドリストへ並列に記録する
+    /// func(cmdList, begin, end) は各チャンクのスレッドで呼び出され、終了後 (例外の場合も) にリストを閉じる
+    /// チャンクはminBatchSize以上の大きさで、最大でスレッド数まで分割する
+    /// 並列処理の中から呼び出された場合は、呼び出したスレッドでチャンクを順に記録する
+    /// 記録したリストはチャンクの順 (呼び出しの順) に次のSubmitで提出される
+    /// </summary>
+    void RecordParallel(size_t count, size_t minBatchSize, const RecordFunc& func)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        minBatchSize = (std::max)(minBatchSize, size_t(1));
+        size_t chunkCount = (std::min)(size_t(m_threadCount), (count + minBatchSize - 1) / minBatchSize);
+
+        // コマンドリストの準備は記録の開始前に行う (プールの状態は記録中に変更しない)
+        for (size_t i = 0; i < chunkCount; ++i)
+        {
+            m_recorded.push_back(AcquireContext());
+        }
+        const CommandList* lists = m_recorded.data() + (m_recorded.size() - chunkCount);
+
+        // 例外は全てのチャンクの終了後に呼び出し元へ送出される
+        WorkerPool::Get().Run(chunkCount, chunkCount, [&](size_t chunk)
+        {
+            size_t begin = count * chunk / chunkCount;
+            size_t end = count * (chunk + 1) / chunkCount;
+            try
+            {
+                func(lists[chunk], begin, end);
+            }
+            catch (...)
+            {
+                m_device.CloseCommandList(lists[chunk]);
+                throw;
+            }
+            m_device.CloseCommandList(lists[chunk]);
+        });
+    }
+
+    /// <summary>
+    /// 記録済みのコマンドリストと、続けて実行するリスト (閉じた状態であること) を順に1回で提出する
+    /// </summary>
+    void Submit(CommandList last)
+    {
+        m_recorded.push_back(last);
+        Submit();
+    }
+
+    void Submit()
+    {
+        if (!m_recorded.empty())
+        {
+            m_device.ExecuteCommandLists(m_recorded);
+        }
+        m_recorded.clear();
+    }
+
+private:
+    struct Context
+    {
+        CommandAllocator allocator;
+        CommandList cmdList;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<Context> contexts;
+        // 現在のフレームで使用中のコンテキストの数
+        size_t usedCount = 0;
+    };
+
+    // スロットの未使用のコンテキストを記録可能な状態で取得する (不足する場合のみ作成)
+    CommandList AcquireContext()
+    {
+        auto& slot = m_slots[m_frameSlot];
+        if (slot.usedCount < slot.contexts.size())
+        {
+            auto& context = slot.contexts[slot.usedCount++];
+            m_device.ResetCommandList(context.cmdList, context.allocator);
+            return context.cmdList;
+        }
+        Context context{};
+        context.allocator = m_device.CreateCommandAllocator();
+        context.cmdList = m_device.CreateCommandList(context.allocator);
+        slot.contexts.push_back(context);
+        slot.usedCount++;
+        return context.cmdList;
+    }
+
+private:
+    TDevice& m_device;
+    std::vector<FrameSlot> m_slots;
+    uint32_t m_threadCount;
+    uint32_t m_frameSlot = 0;
+    // 次のSubmitで提出するリスト (記録の順)
+    std::vector<CommandList> m_recorded;
+};
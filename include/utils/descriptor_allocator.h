@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+/// <summary>
+/// ディスクリプタヒープのインデックスの割り当て
+/// 使用中のインデックスをビットマップで管理し、ワード単位のCASで確保/解放する (ロックフリー)
+/// 連続したN個の確保はワード内の空きの連続から探し、64個を超える場合はワード単位で確保する
+/// </summary>
+class DescriptorAllocator
+{
+public:
+    static const uint32_t InvalidIndex = UINT32_MAX;
+    static const uint32_t WordBits = 64;
+
+    DescriptorAllocator() = default;
+    explicit DescriptorAllocator(uint32_t capacity) { Reset(capacity); }
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+
+    // 全ての割り当てを破棄する (他のスレッドから使用されていないこと)
+    void Reset(uint32_t capacity)
+    {
+        m_capacity = capacity;
+        m_wordCount = (capacity + WordBits - 1) / WordBits;
+        m_words = std::make_unique<std::atomic<uint64_t>[]>(m_wordCount);
+        for (uint32_t i = 0; i < m_wordCount; ++i)
+        {
+            m_words[i].store(0, std::memory_order_relaxed);
+        }
+        // 容量外の末尾のビットは使用中にしておく
+        if (capacity % WordBits != 0)
+        {
+            m_words[m_wordCount - 1].store(~0ull << (capacity % WordBits), std::memory_order_relaxed);
+        }
+        m_searchStart.store(0, std::memory_order_relaxed);
+        m_allocatedCount.store(0, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// 連続したcount個のインデックスを確保
+    /// </summary>
+    /// <returns>先頭のインデックス (空きがない場合はInvalidIndex)</returns>
+    uint32_t Allocate(uint32_t count = 1)
+    {
+        if (count == 0 || count > m_capacity)
+        {
+            return InvalidIndex;
+        }
+        uint32_t index = count <= WordBits ? AllocateInWord(count) : AllocateWords((count + WordBits - 1) / WordBits);
+        if (index != InvalidIndex)
+        {
+            m_allocatedCount.fetch_add(count, std::memory_order_relaxed);
+        }
+        return index;
+    }
+
+    // Allocateで確保した範囲の解放
+    void Free(uint32_t index, uint32_t count = 1)
+    {
+        if (index == InvalidIndex || count == 0)
+        {
+            return;
+        }
+        // 64個を超える確保はワード単位なので、ワード全体を解放する
+        const uint32_t end = count <= WordBits ? index + count : index + (count + WordBits - 1) / WordBits * WordBits;
+        for (uint32_t i = index; i < end;)
+        {
+            const uint32_t word = i / WordBits;
+            const uint32_t bit = i % WordBits;
+            const uint32_t n = (std::min)(WordBits - bit, end - i);
+            m_words[word].fetch_and(~RangeMask(bit, n), std::memory_order_release);
+            i += n;
+        }
+        m_allocatedCount.fetch_sub(count, std::memory_order_relaxed);
+        // 解放した位置から探索すると直後の確保で見つかりやすい
+        m_searchStart.store(index / WordBits, std::memory_order_relaxed);
+    }
+
+    uint32_t GetCapacity() const { return m_capacity; }
+    uint32_t GetAllocatedCount() const { return m_allocatedCount.load(std::memory_order_relaxed); }
+
+private:
+    static uint64_t RangeMask(uint32_t bit, uint32_t count)
+    {
+        return (count >= WordBits ? ~0ull : ((1ull << count) - 1)) << bit;
+    }
+
+    // 空きビット (1) がcount個連続する位置のマスク (各ビットは連続の先頭を示す)
+    static uint64_t FindRun(uint64_t freeBits, uint32_t count)
+    {
+        uint32_t length = 1;
+        while (length < count && freeBits != 0)
+        {
+            const uint32_t shift = (std::min)(length, count - length);
+            freeBits &= freeBits >> shift;
+            length += shift;
+        }
+        return freeBits;
+    }
+
+    uint32_t AllocateInWord(uint32_t count)
+    {
+        const uint32_t start = m_searchStart.load(std::memory_order_relaxed);
+        for (uint32_t n = 0; n < m_wordCount; ++n)
+        {
+            const uint32_t word = (start + n) % m_wordCount;
+            uint64_t value = m_words[word].load(std::memory_order_relaxed);
+            while (true)
+            {
+                uint64_t run = FindRun(~value, count);
+                if (run == 0)
+                {
+                    break;
+                }
+                const uint32_t bit = uint32_t(std::countr_zero(run));
+                if (m_words[word].compare_exchange_weak(value, value | RangeMask(bit, count), std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    m_searchStart.store(word, std::memory_order_relaxed);
+                    return word * WordBits + bit;
+                }
+                // 失敗時はvalueが最新の値に更新されているので探し直す
+            }
+        }
+        return InvalidIndex;
+    }
+
+    // 連続したwordCount個の空きワードを確保 (途中で競合した場合は巻き戻して次を探す)
+    uint32_t AllocateWords(uint32_t wordCount)
+    {
+        for (uint32_t first = 0; first + wordCount <= m_wordCount; ++first)
+        {
+            uint32_t claimed = 0;
+            for (; claimed < wordCount; ++claimed)
+            {
+                uint64_t expected = 0;
+                if (!m_words[first + claimed].compare_exchange_strong(expected, ~0ull, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            if (claimed == wordCount)
+            {
+                return first * WordBits;
+            }
+            for (uint32_t i = 0; i < claimed; ++i)
+            {
+                m_words[first + i].store(0, std::memory_order_release);
+            }
+            first += claimed;
+        }
+        return InvalidIndex;
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> m_words;
+    uint32_t m_capacity = 0;
+    uint32_t m_wordCount = 0;
+    std::atomic<uint32_t> m_searchStart = 0;
+    std::atomic<uint32_t> m_allocatedCount = 0;
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// デバイス操作のフレームごとの記録
+/// リソースの作成, 転送量, マップ, コマンドの実行, CPUの待機の回数を数え、EndFrameでフレームの値を確定する
+/// 定常状態のフレームでリソースの作成や待機が発生していないことの確認に使用する (GPUやAPIには依存しない)
+/// 加算はスレッドセーフ。EndFrame, Reset, 参照は記録するスレッドと同期して呼び出すこと
+/// </summary>
+class DeviceRecorder
+{
+public:
+    enum class Counter : uint32_t
+    {
+        ResourceCreate,     // リソースの作成 (コマンドリスト, フェンスを含む)
+        ResourceBytes,      // 作成したバッファのバイト数
+        UploadBytes,        // CPUからGPUへ書き込んだバイト数
+        Map,
+        Unmap,
+        Submit,             // コマンドリストの実行
+        Wait,               // GPUの完了を待機した回数 (到達済みのフェンスは数えない)
+        FrameWait,          // フレームの切り替えでの待機 (GPUが律速の場合は定常的に発生する)
+        Count,
+    };
+    static const uint32_t CounterCount = uint32_t(Counter::Count);
+
+    struct FrameStats
+    {
+        int64_t frame = -1;
+        uint64_t values[CounterCount] = {};
+
+        uint64_t operator[](Counter counter) const { return values[uint32_t(counter)]; }
+        // 定常状態で発生してはならない操作 (リソースの作成と待機) を含むか
+        bool HasStall() const { return (*this)[Counter::ResourceCreate] > 0 || (*this)[Counter::Wait] > 0; }
+    };
+
+    static const char* GetCounterName(Counter counter)
+    {
+        switch (counter)
+        {
+        case Counter::ResourceCreate:   return "Create";
+        case Counter::ResourceBytes:    return "CreateBytes";
+        case Counter::UploadBytes:      return "UploadBytes";
+        case Counter::Map:              return "Map";
+        case Counter::Unmap:            return "Unmap";
+        case Counter::Submit:           return "Submit";
+        case Counter::Wait:             return "Wait";
+        case Counter::FrameWait:        return "FrameWait";
+        default:                        return "";
+        }
+    }
+
+    void Add(Counter counter, uint64_t value = 1)
+    {
+        m_current[uint32_t(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+    void OnCreate(uint64_t bytes = 0)
+    {
+        Add(Counter::ResourceCreate);
+        Add(Counter::ResourceBytes, bytes);
+    }
+
+    // 確定していない (現在のフレームの) 値
+    uint64_t GetCurrent(Counter counter) const
+    {
+        return m_current[uint32_t(counter)].load(std::memory_order_relaxed);
+    }
+
+    // 現在のフレームの値を確定して次のフレームを開始する
+    const FrameStats& EndFrame(int64_t frame)
+    {
+        FrameStats stats{};
+        stats.frame = frame;
+        for (uint32_t i = 0; i < CounterCount; ++i)
+        {
+            stats.values[i] = m_current[i].exchange(0, std::memory_order_relaxed);
+        }
+        m_frames.push_back(stats);
+        return m_frames.back();
+    }
+
+    // 記録の破棄 (初期化処理の記録を除外する場合など)
+    void Reset()
+    {
+        for (auto& value : m_current)
+        {
+            value.store(0, std::memory_order_relaxed);
+        }
+        m_frames.clear();
+    }
+
+    const std::vector<FrameStats>& GetFrames() const { return m_frames; }
+
+    // 先頭のwarmupFrames個を除いたフレームのうち、リソースの作成か待機が発生したフレームの数
+    uint32_t GetStallFrameCount(uint32_t warmupFrames) const
+    {
+        uint32_t count = 0;
+        for (size_t i = warmupFrames; i < m_frames.size(); ++i)
+        {
+            count += m_frames[i].HasStall() ? 1 : 0;
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// 記録の集計
+    /// 全体の合計と、先頭のwarmupFrames個を除いたフレームの最大値, リソースの作成か待機が発生したフレームを出力する
+    /// </summary>
+    std::string GetReport(uint32_t warmupFrames = 1, uint32_t maxListedFrames = 8) const
+    {
+        FrameStats total{};
+        FrameStats steadyMax{};
+        for (size_t i = 0; i < m_frames.size(); ++i)
+        {
+            for (uint32_t c = 0; c < CounterCount; ++c)
+            {
+                total.values[c] += m_frames[i].values[c];
+                if (i >= warmupFrames && m_frames[i].values[c] > steadyMax.values[c])
+                {
+                    steadyMax.values[c] = m_frames[i].values[c];
+                }
+            }
+        }
+
+        std::ostringstream oss;
+        oss << "Device report: " << m_frames.size() << " frames (warmup " << warmupFrames << ")\n";
+        auto writeRow = [&](const char* label, const FrameStats& stats)
+        {
+            oss << "  " << std::left << std::setw(10) << label << std::right;
+            for (uint32_t c = 0; c < CounterCount; ++c)
+            {
+                oss << " " << GetCounterName(Counter(c)) << "=" << stats.values[c];
+            }
+            oss << "\n";
+        };
+        writeRow("total", total);
+        writeRow("steady max", steadyMax);
+
+        auto stallFrames = GetStallFrameCount(warmupFrames);
+        oss << "  stalled frames: " << stallFrames;
+        uint32_t listed = 0;
+        for (size_t i = warmupFrames; i < m_frames.size() && listed < maxListedFrames; ++i)
+        {
+            const auto& stats = m_frames[i];
+            if (!stats.HasStall())
+            {
+                continue;
+            }
+            oss << "\n    frame " << stats.frame
+                << ": Create=" << stats[Counter::ResourceCreate]
+                << " Wait=" << stats[Counter::Wait];
+            ++listed;
+        }
+        if (stallFrames > listed)
+        {
+            oss << "\n    ...";
+        }
+        return oss.str();
+    }
+
+private:
+    std::atomic<uint64_t> m_current[CounterCount] = {};
+    std::vector<FrameStats> m_frames;
+};
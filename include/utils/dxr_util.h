@@ -97,6 +97,17 @@ inline D3D12_ROOT_PARAMETER& CreateRootParam(D3D12_ROOT_PARAMETER_TYPE paramType
     return *rootParam;
 }
 
+inline D3D12_ROOT_PARAMETER& CreateRootConstants(UINT num32BitValues, UINT shaderRegister, UINT registerSpace = 0)
+{
+    auto rootParam = new D3D12_ROOT_PARAMETER{};
+    rootParam->ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    rootParam->ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParam->Constants.Num32BitValues = num32BitValues;
+    rootParam->Constants.ShaderRegister = shaderRegister;
+    rootParam->Constants.RegisterSpace = registerSpace;
+    return *rootParam;
+}
+
 inline CD3DX12_STATIC_SAMPLER_DESC& CreateStaticSamplerDesc(D3D12_FILTER filter, UINT shaderRegister, UINT registerSpace = 0)
 {
     auto staticSamplerDesc = new CD3DX12_STATIC_SAMPLER_DESC{};
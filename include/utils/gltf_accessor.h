@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "utils/gltf_document.h"
+
+// glTFアクセサーの展開
+// byteStride, 正規化整数, 量子化された成分型 (KHR_mesh_quantization), スパースアクセサーに対応し、
+// 出力先の型 (float, uint16_t, uint32_t) へ変換しながら連続した配列に書き出す
+namespace gltf_accessor_detail
+{
+    template<typename Dst, typename Src>
+    inline Dst ConvertValue(Src value, bool normalized)
+    {
+        if constexpr (std::is_floating_point_v<Dst> && std::is_integral_v<Src>)
+        {
+            if (normalized)
+            {
+                // glTF仕様の正規化整数の変換式 (符号付きは-1で打ち切る)
+                const float maxValue = float((std::numeric_limits<Src>::max)());
+                if constexpr (std::is_signed_v<Src>)
+                {
+                    return (std::max)(float(value) / maxValue, -1.0f);
+                }
+                else
+                {
+                    return float(value) / maxValue;
+                }
+            }
+        }
+        return static_cast<Dst>(value);
+    }
+
+    // 成分数が一致し詰めて並んでいる場合は一括コピー、それ以外は要素単位で変換する
+    // 変換ループは型ごとに展開されるため、コンパイラによるベクトル化が効く
+    template<typename Dst, typename Src>
+    inline void Convert(const uint8_t* src, size_t stride, size_t count, int srcComponents, Dst* dst, int dstComponents, bool normalized)
+    {
+        const int components = (std::min)(srcComponents, dstComponents);
+        if constexpr (std::is_same_v<Dst, Src>)
+        {
+            if (srcComponents == dstComponents)
+            {
+                const size_t elementSize = sizeof(Src) * srcComponents;
+                if (stride == elementSize)
+                {
+                    memcpy(dst, src, elementSize * count);
+                    return;
+                }
+                for (size_t i = 0; i < count; ++i)
+                {
+                    memcpy(dst + i * dstComponents, src + i * stride, elementSize);
+                }
+                return;
+            }
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Src* s = reinterpret_cast<const Src*>(src + i * stride);
+            Dst* d = dst + i * dstComponents;
+            for (int c = 0; c < components; ++c)
+            {
+                d[c] = ConvertValue<Dst>(s[c], normalized);
+            }
+            for (int c = components; c < dstComponents; ++c)
+            {
+                d[c] = Dst(0);
+            }
+        }
+    }
+
+    template<typename Dst>
+    inline bool ConvertComponents(int componentType, const uint8_t* src, size_t stride, size_t count, int srcComponents, Dst* dst, int dstComponents, bool normalized)
+    {
+        switch (componentType)
+        {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            Convert<Dst, float>(src, stride, count, srcComponents, dst, dstComponents, normalized);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            Convert<Dst, uint32_t>(src, stride, count, srcComponents, dst, dstComponents, normalized);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            Convert<Dst, uint16_t>(src, stride, count, srcComponents, dst, dstComponents, normalized);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+            Convert<Dst, int16_t>(src, stride, count, srcComponents, dst, dstComponents, normalized);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            Convert<Dst, uint8_t>(src, stride, count, srcComponents, dst, dstComponents, normalized);
+            return true;
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+            Convert<Dst, int8_t>(src, stride, count, srcComponents, dst, dstComponents, normalized);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // bufferViewの範囲に収まっているか
+    inline bool IsInRange(const GLTFDocument& doc, int bufferViewIndex, size_t byteOffset, size_t stride, size_t count, size_t elementSize)
+    {
+        const auto& model = doc.model;
+        if (bufferViewIndex < 0 || bufferViewIndex >= int(model.bufferViews.size()))
+        {
+            return false;
+        }
+        const auto& view = model.bufferViews[bufferViewIndex];
+        if (view.buffer < 0 || view.buffer >= int(doc.buffers.size()))
+        {
+            return false;
+        }
+        if (count == 0)
+        {
+            return true;
+        }
+        const size_t required = byteOffset + stride * (count - 1) + elementSize;
+        return required <= view.byteLength && view.byteOffset + view.byteLength <= doc.buffers[view.buffer].size();
+    }
+
+    inline const uint8_t* GetViewData(const GLTFDocument& doc, int bufferViewIndex, size_t byteOffset)
+    {
+        const auto& view = doc.model.bufferViews[bufferViewIndex];
+        return doc.buffers[view.buffer].data() + view.byteOffset + byteOffset;
+    }
+}
+
+// アクセサーの成分数 (SCALAR = 1, VEC3 = 3, MAT4 = 16 ...)
+inline int GetAccessorComponentCount(const tinygltf::Accessor& acc)
+{
+    return tinygltf::GetNumComponentsInType(uint32_t(acc.type));
+}
+
+/// <summary>
+/// アクセサーの展開
+/// dstにはacc.count * dstComponents個の領域が必要
+/// 成分数がdstComponentsより少ない場合は0で埋め、多い場合は切り捨てる
+/// </summary>
+/// <returns>成分型が未対応、または範囲外を参照している場合はfalse</returns>
+template<typename Dst>
+inline bool ReadAccessor(const GLTFDocument& doc, const tinygltf::Accessor& acc, Dst* dst, int dstComponents)
+{
+    using namespace gltf_accessor_detail;
+    const int srcComponents = GetAccessorComponentCount(acc);
+    const int componentSize = tinygltf::GetComponentSizeInBytes(uint32_t(acc.componentType));
+    if (srcComponents <= 0 || componentSize <= 0)
+    {
+        return false;
+    }
+    const size_t count = size_t(acc.count);
+    const size_t elementSize = size_t(srcComponents) * componentSize;
+
+    if (acc.bufferView < 0)
+    {
+        // bufferViewがない場合は0で初期化 (スパースで上書きされる)
+        std::fill(dst, dst + count * dstComponents, Dst(0));
+    }
+    else
+    {
+        const auto& view = doc.model.bufferViews[acc.bufferView];
+        const int byteStride = acc.ByteStride(view);
+        if (byteStride <= 0)
+        {
+            return false;
+        }
+        const size_t stride = size_t(byteStride);
+        if (!IsInRange(doc, acc.bufferView, acc.byteOffset, stride, count, elementSize))
+        {
+            return false;
+        }
+        auto src = GetViewData(doc, acc.bufferView, acc.byteOffset);
+        if (!ConvertComponents(acc.componentType, src, stride, count, srcComponents, dst, dstComponents, acc.normalized))
+        {
+            return false;
+        }
+    }
+
+    // スパースアクセサー: 指定されたインデックスの要素のみ置き換える
+    if (acc.sparse.isSparse)
+    {
+        const auto& sparse = acc.sparse;
+        const size_t sparseCount = size_t(sparse.count);
+        std::vector<uint32_t> indices(sparseCount);
+        const int indexSize = tinygltf::GetComponentSizeInBytes(uint32_t(sparse.indices.componentType));
+        if (indexSize <= 0 ||
+            !IsInRange(doc, sparse.indices.bufferView, sparse.indices.byteOffset, indexSize, sparseCount, indexSize) ||
+            !IsInRange(doc, sparse.values.bufferView, sparse.values.byteOffset, elementSize, sparseCount, elementSize))
+        {
+            return false;
+        }
+        auto indexSrc = GetViewData(doc, sparse.indices.bufferView, sparse.indices.byteOffset);
+        if (!ConvertComponents(sparse.indices.componentType, indexSrc, indexSize, sparseCount, 1, indices.data(), 1, false))
+        {
+            return false;
+        }
+        std::vector<Dst> values(sparseCount * dstComponents);
+        auto valueSrc = GetViewData(doc, sparse.values.bufferView, sparse.values.byteOffset);
+        if (!ConvertComponents(acc.componentType, valueSrc, elementSize, sparseCount, srcComponents, values.data(), dstComponents, acc.normalized))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < sparseCount; ++i)
+        {
+            if (indices[i] < count)
+            {
+                std::copy_n(values.data() + i * dstComponents, dstComponents, dst + size_t(indices[i]) * dstComponents);
+            }
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// アクセサーを配列の末尾に追加して展開
+/// </summary>
+template<typename T, typename Dst>
+inline bool AppendAccessor(const GLTFDocument& doc, const tinygltf::Accessor& acc, std::vector<T>& dst, int dstComponents)
+{
+    static_assert(sizeof(T) % sizeof(Dst) == 0);
+    const size_t start = dst.size();
+    dst.resize(start + size_t(acc.count));
+    return ReadAccessor(doc, acc, reinterpret_cast<Dst*>(dst.data() + start), dstComponents);
+}
+
+/// <summary>
+/// アクセサーの要素を変換せずにバイト列のままコピー (量子化された頂点属性を詰めたまま保持する場合)
+/// dstにはacc.count * dstStrideバイトの領域が必要で、要素の後ろの余りは0で埋める
+/// </summary>
+/// <returns>bufferViewを持たない、スパース、または範囲外を参照している場合はfalse</returns>
+inline bool CopyAccessorElements(const GLTFDocument& doc, const tinygltf::Accessor& acc, uint8_t* dst, size_t dstStride)
+{
+    using namespace gltf_accessor_detail;
+    const int components = GetAccessorComponentCount(acc);
+    const int componentSize = tinygltf::GetComponentSizeInBytes(uint32_t(acc.componentType));
+    if (components <= 0 || componentSize <= 0 || acc.bufferView < 0 || acc.sparse.isSparse)
+    {
+        return false;
+    }
+    const size_t count = size_t(acc.count);
+    const size_t elementSize = size_t(components) * componentSize;
+    const int byteStride = acc.ByteStride(doc.model.bufferViews[acc.bufferView]);
+    if (byteStride <= 0 || elementSize > dstStride ||
+        !IsInRange(doc, acc.bufferView, acc.byteOffset, size_t(byteStride), count, elementSize))
+    {
+        return false;
+    }
+    auto src = GetViewData(doc, acc.bufferView, acc.byteOffset);
+    if (size_t(byteStride) == dstStride && elementSize == dstStride)
+    {
+        memcpy(dst, src, dstStride * count);
+        return true;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        memcpy(dst + i * dstStride, src + i * byteStride, elementSize);
+        memset(dst + i * dstStride + elementSize, 0, dstStride - elementSize);
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "tiny_gltf.h"
+#include "utils/mapped_file.h"
+
+/// <summary>
+/// glTFの解析結果
+/// バッファと画像の内容はコピーせず、メモリマップしたファイル (GLBのBINチャンク, 外部ファイル) を参照する
+/// データURIやEXT_meshopt_compressionの展開結果のみmodel側に保持する
+/// </summary>
+struct GLTFDocument
+{
+    tinygltf::Model model;
+    // model.buffersと同じ並びのバッファの内容
+    std::vector<std::span<const uint8_t>> buffers;
+    // model.imagesと同じ並びのエンコード済み画像
+    std::vector<std::span<const uint8_t>> images;
+    // 参照しているファイル (glTF本体と外部バッファ, 外部画像)
+    std::vector<std::shared_ptr<const MappedFile>> files;
+};
+
+// GLBコンテナ: Header (12バイト) | JSONチャンク | BINチャンク (任意)
+namespace glb
+{
+    const uint32_t Magic = 0x46546C67;      // "glTF"
+    const uint32_t ChunkJSON = 0x4E4F534A;  // "JSON"
+    const uint32_t ChunkBIN = 0x004E4942;   // "BIN"
+    const size_t HeaderSize = 12;
+    const size_t ChunkHeaderSize = 8;
+
+    struct Chunks
+    {
+        std::span<const uint8_t> json;
+        std::span<const uint8_t> bin;
+        // JSONチャンクより後ろの全て (BINチャンクのヘッダーを含む)
+        std::span<const uint8_t> rest;
+    };
+
+    inline bool Split(std::span<const uint8_t> data, Chunks& chunks)
+    {
+        uint32_t header[3];
+        uint32_t chunkHeader[2];
+        if (data.size() < HeaderSize + ChunkHeaderSize)
+        {
+            return false;
+        }
+        memcpy(header, data.data(), sizeof(header));
+        memcpy(chunkHeader, data.data() + HeaderSize, sizeof(chunkHeader));
+        const size_t jsonStart = HeaderSize + ChunkHeaderSize;
+        if (header[0] != Magic || chunkHeader[1] != ChunkJSON || chunkHeader[0] > data.size() - jsonStart)
+        {
+            return false;
+        }
+        chunks.json = data.subspan(jsonStart, chunkHeader[0]);
+        chunks.rest = data.subspan(jsonStart + chunkHeader[0]);
+        chunks.bin = {};
+        if (chunks.rest.size() >= ChunkHeaderSize)
+        {
+            memcpy(chunkHeader, chunks.rest.data(), sizeof(chunkHeader));
+            if (chunkHeader[1] == ChunkBIN && chunkHeader[0] <= chunks.rest.size() - ChunkHeaderSize)
+            {
+                chunks.bin = chunks.rest.subspan(ChunkHeaderSize, chunkHeader[0]);
+            }
+        }
+        return true;
+    }
+}
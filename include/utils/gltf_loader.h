@@ -11,30 +11,326 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #endif 
 #include "tiny_gltf.h"
+// tinygltfに同梱されているnlohmann/json
+#include "json.hpp"
+#include "utils/gltf_document.h"
+#include "utils/gltf_stream_parser.h"
+#include "utils/math_util.h"
+#include "utils/meshopt_decoder.h"
+#include "utils/parallel_util.h"
 #include "utils/print_util.h"
 
 
 namespace fs = std::filesystem;
 
-bool inline LoadGLTF(const std::wstring& fileName, tinygltf::Model& model)
+// 画像はデコードせず、エンコードされたままimage.imageに保持する
+// デコードはモデル側でスレッドプールを使って行う
+bool inline KeepEncodedImage(tinygltf::Image* image, const int, std::string*, std::string*, int, int, const unsigned char* bytes, int size, void*)
+{
+    image->image.assign(bytes, bytes + size);
+    image->as_is = true;
+    return true;
+}
+
+namespace gltf_loader_detail
+{
+    // フォールバック用バッファの代わりに与える4バイトのダミーデータ
+    const char* const EmptyBufferURI = "data:application/octet-stream;base64,AAAAAA==";
+    const int EmptyBufferSize = 4;
+
+    inline const tinygltf::Value* FindMeshoptExtension(const tinygltf::ExtensionMap& extensions)
+    {
+        for (const char* name : { "EXT_meshopt_compression", "KHR_meshopt_compression" })
+        {
+            auto it = extensions.find(name);
+            if (it != extensions.end() && it->second.IsObject())
+            {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    inline size_t GetSize(const tinygltf::Value& obj, const char* key, size_t defaultValue = 0)
+    {
+        if (!obj.Has(key) || !obj.Get(key).IsNumber())
+        {
+            return defaultValue;
+        }
+        return size_t((std::max)(0.0, obj.Get(key).GetNumberAsDouble()));
+    }
+
+    inline std::string GetString(const tinygltf::Value& obj, const char* key, const char* defaultValue)
+    {
+        if (!obj.Has(key) || !obj.Get(key).IsString())
+        {
+            return defaultValue;
+        }
+        return obj.Get(key).Get<std::string>();
+    }
+
+    /// <summary>
+    /// EXT_meshopt_compressionのフォールバック用バッファ (uriを持たない) をダミーのデータURIに置き換える
+    /// tinygltfはuriのないバッファを読み込みエラーとするため、読み込み前にJSONを書き換える
+    /// 圧縮されたbufferViewは読み込み後に展開され、フォールバック用バッファは参照されなくなる
+    /// </summary>
+    /// <param name="doc">glTFのJSON</param>
+    /// <param name="hasBinChunk">GLBのBINチャンクを持つ (バッファ0はBINチャンクを指す)</param>
+    /// <returns>書き換えた場合true</returns>
+    inline bool PatchMeshoptFallbackBuffers(nlohmann::json& doc, bool hasBinChunk)
+    {
+        auto buffers = doc.find("buffers");
+        if (buffers == doc.end() || !buffers->is_array())
+        {
+            return false;
+        }
+        bool patched = false;
+        for (size_t i = 0; i < buffers->size(); ++i)
+        {
+            auto& buffer = (*buffers)[i];
+            if (buffer.contains("uri") || (hasBinChunk && i == 0))
+            {
+                continue;
+            }
+            auto extensions = buffer.find("extensions");
+            if (extensions == buffer.end() || !extensions->is_object())
+            {
+                continue;
+            }
+            for (const char* name : { "EXT_meshopt_compression", "KHR_meshopt_compression" })
+            {
+                auto ext = extensions->find(name);
+                if (ext != extensions->end() && ext->is_object() && ext->value("fallback", false))
+                {
+                    buffer["uri"] = EmptyBufferURI;
+                    buffer["byteLength"] = EmptyBufferSize;
+                    patched = true;
+                    break;
+                }
+            }
+        }
+        return patched;
+    }
+
+    /// <summary>
+    /// フォールバック用バッファを含む場合のみ、書き換えたファイルの内容をpatchedに出力
+    /// </summary>
+    inline bool PatchGLTF(std::span<const uint8_t> data, bool isBinary, std::vector<uint8_t>& patched)
+    {
+        if (!isBinary)
+        {
+            auto doc = nlohmann::json::parse(data.begin(), data.end(), nullptr, false);
+            if (doc.is_discarded() || !PatchMeshoptFallbackBuffers(doc, false))
+            {
+                return false;
+            }
+            auto text = doc.dump();
+            patched.assign(text.begin(), text.end());
+            return true;
+        }
+
+        glb::Chunks chunks;
+        if (!glb::Split(data, chunks))
+        {
+            return false;
+        }
+        auto doc = nlohmann::json::parse(chunks.json.begin(), chunks.json.end(), nullptr, false);
+        if (doc.is_discarded() || !PatchMeshoptFallbackBuffers(doc, !chunks.bin.empty()))
+        {
+            return false;
+        }
+
+        // チャンクは4バイト境界に揃える (JSONは空白で埋める)
+        uint32_t header[3];
+        memcpy(header, data.data(), sizeof(header));
+        auto text = doc.dump();
+        text.resize(ROUND_UP(text.size(), size_t(4)), ' ');
+        const uint32_t newChunkHeader[2] = { uint32_t(text.size()), glb::ChunkJSON };
+        const uint32_t newHeader[3] = { header[0], header[1], uint32_t(glb::HeaderSize + glb::ChunkHeaderSize + text.size() + chunks.rest.size()) };
+        patched.clear();
+        patched.reserve(newHeader[2]);
+        auto append = [&patched](const void* src, size_t size) {
+            auto bytes = static_cast<const uint8_t*>(src);
+            patched.insert(patched.end(), bytes, bytes + size);
+        };
+        append(newHeader, sizeof(newHeader));
+        append(newChunkHeader, sizeof(newChunkHeader));
+        append(text.data(), text.size());
+        append(chunks.rest.data(), chunks.rest.size());
+        return true;
+    }
+
+    /// <summary>
+    /// tinygltfによる読み込み (軽量パーサーで読み込めない場合のフォールバック)
+    /// バッファと画像はtinygltfが展開したデータを参照する
+    /// </summary>
+    inline bool LoadWithTinyGLTF(const fs::path& gltfPath, std::span<const uint8_t> data, GLTFDocument& doc, std::string& err, std::string& warn)
+    {
+        tinygltf::TinyGLTF loader;
+        loader.SetImageLoader(KeepEncodedImage, nullptr);
+        const std::string baseDir = gltfPath.parent_path().string();
+        const bool isBinary = gltfPath.extension() == L".glb";
+        // EXT_meshopt_compressionのフォールバック用バッファを含む場合は書き換えた内容を読み込む
+        std::vector<uint8_t> patched;
+        if (PatchGLTF(data, isBinary, patched))
+        {
+            data = patched;
+        }
+        auto& model = doc.model;
+        bool result = isBinary ?
+            loader.LoadBinaryFromMemory(&model, &err, &warn, data.data(), static_cast<unsigned int>(data.size()), baseDir) :
+            loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char*>(data.data()), static_cast<unsigned int>(data.size()), baseDir);
+        if (!result)
+        {
+            return false;
+        }
+        for (const auto& buffer : model.buffers)
+        {
+            doc.buffers.emplace_back(buffer.data);
+        }
+        for (const auto& image : model.images)
+        {
+            doc.images.emplace_back(image.image);
+        }
+        return true;
+    }
+}
+
+/// <summary>
+/// EXT_meshopt_compressionで圧縮されたbufferViewを展開
+/// 展開結果は新しいバッファとして追加し、bufferViewの参照先を置き換える
+/// bufferViewごとに並列で展開する
+/// </summary>
+/// <param name="doc"></param>
+/// <param name="err">失敗したbufferViewの情報</param>
+/// <returns></returns>
+inline bool DecodeMeshoptBufferViews(GLTFDocument& doc, std::string& err)
+{
+    using namespace gltf_loader_detail;
+    auto& model = doc.model;
+    struct DecodeJob
+    {
+        int viewIndex;
+        const uint8_t* src;
+        size_t srcSize;
+        size_t count;
+        size_t stride;
+        std::string mode;
+        std::string filter;
+        std::vector<uint8_t> data;
+        bool succeeded;
+    };
+    std::vector<DecodeJob> jobs;
+    for (int i = 0; i < int(model.bufferViews.size()); ++i)
+    {
+        auto ext = FindMeshoptExtension(model.bufferViews[i].extensions);
+        if (!ext)
+        {
+            continue;
+        }
+        DecodeJob job{};
+        job.viewIndex = i;
+        const int bufferIndex = int(GetSize(*ext, "buffer", size_t(-1)));
+        const size_t byteOffset = GetSize(*ext, "byteOffset");
+        job.srcSize = GetSize(*ext, "byteLength");
+        job.count = GetSize(*ext, "count");
+        job.stride = GetSize(*ext, "byteStride");
+        job.mode = GetString(*ext, "mode", "");
+        job.filter = GetString(*ext, "filter", "NONE");
+        if (bufferIndex < 0 || bufferIndex >= int(doc.buffers.size()) ||
+            byteOffset > doc.buffers[bufferIndex].size() ||
+            job.srcSize > doc.buffers[bufferIndex].size() - byteOffset ||
+            job.stride == 0 || job.count > (SIZE_MAX / job.stride))
+        {
+            err += "EXT_meshopt_compression: invalid source range in bufferView " + std::to_string(i) + "\n";
+            return false;
+        }
+        job.src = doc.buffers[bufferIndex].data() + byteOffset;
+        jobs.push_back(std::move(job));
+    }
+    if (jobs.empty())
+    {
+        return true;
+    }
+
+    ParallelFor(jobs.size(), 1, [&jobs](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& job = jobs[i];
+            job.data.resize(job.count * job.stride);
+            if (job.mode == "ATTRIBUTES")
+            {
+                job.succeeded =
+                    MeshoptDecodeVertexBuffer(job.data.data(), job.count, job.stride, job.src, job.srcSize) &&
+                    MeshoptDecodeFilter(job.filter, job.data.data(), job.count, job.stride);
+            }
+            else if (job.mode == "TRIANGLES")
+            {
+                job.succeeded = MeshoptDecodeIndexBuffer(job.data.data(), job.count, job.stride, job.src, job.srcSize);
+            }
+            else if (job.mode == "INDICES")
+            {
+                job.succeeded = MeshoptDecodeIndexSequence(job.data.data(), job.count, job.stride, job.src, job.srcSize);
+            }
+        }
+    });
+
+    for (auto& job : jobs)
+    {
+        if (!job.succeeded)
+        {
+            err += "EXT_meshopt_compression: failed to decode bufferView " + std::to_string(job.viewIndex) + " (" + job.mode + ")\n";
+            return false;
+        }
+    }
+    // 全て成功してからバッファを差し替える (展開元のバッファはjobが参照しているため)
+    // バッファの移動では内容の領域は移動しないため、既存のspanは有効なまま
+    for (auto& job : jobs)
+    {
+        auto& view = model.bufferViews[job.viewIndex];
+        tinygltf::Buffer buffer;
+        buffer.data = std::move(job.data);
+        view.buffer = int(model.buffers.size());
+        view.byteOffset = 0;
+        view.byteLength = buffer.data.size();
+        view.extensions.erase("EXT_meshopt_compression");
+        view.extensions.erase("KHR_meshopt_compression");
+        model.buffers.push_back(std::move(buffer));
+        doc.buffers.emplace_back(model.buffers.back().data);
+    }
+    return true;
+}
+
+/// <summary>
+/// glTFの読み込み
+/// 軽量パーサーで読み込み、読み込めない場合のみtinygltfで読み込む
+/// </summary>
+/// <param name="fileName">ファイル名 (拡張子と外部リソースの解決に使用)</param>
+/// <param name="file">メモリマップしたファイル (docが参照し続ける)</param>
+/// <param name="doc">読み込み先</param>
+bool inline LoadGLTF(const std::wstring& fileName, std::shared_ptr<const MappedFile> file, GLTFDocument& doc)
 {
-    tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
     const fs::path gltfPath{ RESOURCE_DIR L"/scene/" + fileName };
-    bool result = false;
-    if (gltfPath.extension() == L".gltf")
+    if (gltfPath.extension() != L".gltf" && gltfPath.extension() != L".glb")
     {
-        result = loader.LoadASCIIFromFile(&model, &err, &warn, gltfPath.string());
+        std::wstring errWStr = L"ファイル形式が対応していません：" + gltfPath.extension().wstring();
+        Error(PrintInfoType::RTCAMP10, errWStr);
     }
-    else if (gltfPath.extension() == L".glb")
+    doc = GLTFDocument();
+    doc.files.push_back(file);
+    bool result = ParseGLTFStream(gltfPath, file->GetSpan(), doc);
+    if (!result)
     {
-        result = loader.LoadBinaryFromFile(&model, &err, &warn, gltfPath.string());
+        Print(PrintInfoType::RTCAMP10, L"軽量パーサーで読み込めないため、tinygltfで読み込みます: " + fileName);
+        doc = GLTFDocument();
+        doc.files.push_back(file);
+        result = gltf_loader_detail::LoadWithTinyGLTF(gltfPath, file->GetSpan(), doc, err, warn);
     }
-    else
+    if (result)
     {
-        std::wstring errWStr = L"ファイル形式が対応していません：" + std::wstring(gltfPath.extension().c_str());
-        Error(PrintInfoType::RTCAMP10, errWStr);
+        result = DecodeMeshoptBufferViews(doc, err);
     }
     if (!warn.empty())
     {
@@ -47,4 +343,4 @@ bool inline LoadGLTF(const std::wstring& fileName, tinygltf::Model& model)
         Error(PrintInfoType::RTCAMP10, errWStr);
     }
     return result;
-}
\ No newline at end of file
+}
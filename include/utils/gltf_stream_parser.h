@@ -0,0 +1,663 @@
+#pragma once
+
+#include <cctype>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "utils/gltf_document.h"
+#include "utils/json_reader.h"
+
+// tinygltfを介さない軽量なglTFの読み込み
+// JSONはDOMを構築せずに逐次読み出し、Modelの読み込みで使用するプロパティのみをtinygltf::Modelへ格納する
+// バッファと画像はGLBのBINチャンクまたは外部ファイルをメモリマップして参照する
+namespace gltf_stream_detail
+{
+    namespace fs = std::filesystem;
+
+    // tinygltfのバージョンによって型が異なるフィールド用
+    template<typename T>
+    inline bool ReadNumberAs(JsonReader& r, T& out)
+    {
+        double value;
+        if (!r.ReadNumber(value))
+        {
+            return false;
+        }
+        out = static_cast<T>(value);
+        return true;
+    }
+
+    inline bool ReadIntArray(JsonReader& r, std::vector<int>& out)
+    {
+        out.clear();
+        return r.ForEachElement([&](size_t) {
+            int value;
+            if (!r.ReadInt(value))
+            {
+                return false;
+            }
+            out.push_back(value);
+            return true;
+        });
+    }
+
+    inline bool ReadDoubleArray(JsonReader& r, std::vector<double>& out)
+    {
+        out.clear();
+        return r.ForEachElement([&](size_t) {
+            double value;
+            if (!r.ReadNumber(value))
+            {
+                return false;
+            }
+            out.push_back(value);
+            return true;
+        });
+    }
+
+    inline bool ReadStringArray(JsonReader& r, std::vector<std::string>& out)
+    {
+        out.clear();
+        return r.ForEachElement([&](size_t) {
+            out.emplace_back();
+            return r.ReadString(out.back());
+        });
+    }
+
+    // 任意の値 (拡張のみ、通常のプロパティには使用しない)
+    inline bool ReadValue(JsonReader& r, tinygltf::Value& out)
+    {
+        switch (r.Peek())
+        {
+        case '{':
+        {
+            tinygltf::Value::Object obj;
+            bool isValid = r.ForEachMember([&](std::string_view key) {
+                return ReadValue(r, obj[std::string(key)]);
+            });
+            out = tinygltf::Value(std::move(obj));
+            return isValid;
+        }
+        case '[':
+        {
+            tinygltf::Value::Array arr;
+            bool isValid = r.ForEachElement([&](size_t) {
+                arr.emplace_back();
+                return ReadValue(r, arr.back());
+            });
+            out = tinygltf::Value(std::move(arr));
+            return isValid;
+        }
+        case '"':
+        {
+            std::string str;
+            if (!r.ReadString(str))
+            {
+                return false;
+            }
+            out = tinygltf::Value(std::move(str));
+            return true;
+        }
+        case 't':
+        case 'f':
+        {
+            bool value;
+            if (!r.ReadBool(value))
+            {
+                return false;
+            }
+            out = tinygltf::Value(value);
+            return true;
+        }
+        case 'n':
+            out = tinygltf::Value();
+            return r.Skip();
+        default:
+        {
+            double value;
+            if (!r.ReadNumber(value))
+            {
+                return false;
+            }
+            // 整数で表せる値はtinygltfと同様にintとして格納する
+            if (value == double(int(value)) && value >= -2147483648.0 && value <= 2147483647.0)
+            {
+                out = tinygltf::Value(int(value));
+            }
+            else
+            {
+                out = tinygltf::Value(value);
+            }
+            return true;
+        }
+        }
+    }
+
+    inline bool ReadExtensions(JsonReader& r, tinygltf::ExtensionMap& out)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            return ReadValue(r, out[std::string(key)]);
+        });
+    }
+
+    // オブジェクトの配列を読み、要素ごとにparseで展開する
+    template<typename T, typename F>
+    inline bool ReadObjectArray(JsonReader& r, std::vector<T>& out, F&& parse)
+    {
+        out.clear();
+        return r.ForEachElement([&](size_t) {
+            out.emplace_back();
+            return parse(r, out.back());
+        });
+    }
+
+    inline int ToAccessorType(const std::string& type)
+    {
+        if (type == "SCALAR") return TINYGLTF_TYPE_SCALAR;
+        if (type == "VEC2") return TINYGLTF_TYPE_VEC2;
+        if (type == "VEC3") return TINYGLTF_TYPE_VEC3;
+        if (type == "VEC4") return TINYGLTF_TYPE_VEC4;
+        if (type == "MAT2") return TINYGLTF_TYPE_MAT2;
+        if (type == "MAT3") return TINYGLTF_TYPE_MAT3;
+        if (type == "MAT4") return TINYGLTF_TYPE_MAT4;
+        return -1;
+    }
+
+    inline bool ParseNode(JsonReader& r, tinygltf::Node& node)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(node.name);
+            if (key == "children") return ReadIntArray(r, node.children);
+            if (key == "mesh") return r.ReadInt(node.mesh);
+            if (key == "skin") return r.ReadInt(node.skin);
+            if (key == "translation") return ReadDoubleArray(r, node.translation);
+            if (key == "rotation") return ReadDoubleArray(r, node.rotation);
+            if (key == "scale") return ReadDoubleArray(r, node.scale);
+            if (key == "matrix") return ReadDoubleArray(r, node.matrix);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParsePrimitive(JsonReader& r, tinygltf::Primitive& primitive)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "attributes")
+            {
+                return r.ForEachMember([&](std::string_view name) {
+                    return r.ReadInt(primitive.attributes[std::string(name)]);
+                });
+            }
+            if (key == "indices") return r.ReadInt(primitive.indices);
+            if (key == "material") return r.ReadInt(primitive.material);
+            if (key == "mode") return r.ReadInt(primitive.mode);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseMesh(JsonReader& r, tinygltf::Mesh& mesh)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(mesh.name);
+            if (key == "primitives") return ReadObjectArray(r, mesh.primitives, ParsePrimitive);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseAccessor(JsonReader& r, tinygltf::Accessor& acc)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(acc.name);
+            if (key == "bufferView") return r.ReadInt(acc.bufferView);
+            if (key == "byteOffset") return r.ReadSize(acc.byteOffset);
+            if (key == "componentType") return r.ReadInt(acc.componentType);
+            if (key == "normalized") return r.ReadBool(acc.normalized);
+            if (key == "count") return r.ReadSize(acc.count);
+            if (key == "type")
+            {
+                std::string type;
+                if (!r.ReadString(type))
+                {
+                    return false;
+                }
+                acc.type = ToAccessorType(type);
+                return acc.type >= 0;
+            }
+            if (key == "sparse")
+            {
+                acc.sparse.isSparse = true;
+                return r.ForEachMember([&](std::string_view sparseKey) {
+                    if (sparseKey == "count") return ReadNumberAs(r, acc.sparse.count);
+                    if (sparseKey == "indices")
+                    {
+                        return r.ForEachMember([&](std::string_view indexKey) {
+                            if (indexKey == "bufferView") return r.ReadInt(acc.sparse.indices.bufferView);
+                            if (indexKey == "byteOffset") return ReadNumberAs(r, acc.sparse.indices.byteOffset);
+                            if (indexKey == "componentType") return r.ReadInt(acc.sparse.indices.componentType);
+                            return r.Skip();
+                        });
+                    }
+                    if (sparseKey == "values")
+                    {
+                        return r.ForEachMember([&](std::string_view valueKey) {
+                            if (valueKey == "bufferView") return r.ReadInt(acc.sparse.values.bufferView);
+                            if (valueKey == "byteOffset") return ReadNumberAs(r, acc.sparse.values.byteOffset);
+                            return r.Skip();
+                        });
+                    }
+                    return r.Skip();
+                });
+            }
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseBufferView(JsonReader& r, tinygltf::BufferView& view)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(view.name);
+            if (key == "buffer") return r.ReadInt(view.buffer);
+            if (key == "byteOffset") return r.ReadSize(view.byteOffset);
+            if (key == "byteLength") return r.ReadSize(view.byteLength);
+            if (key == "byteStride") return r.ReadSize(view.byteStride);
+            if (key == "target") return r.ReadInt(view.target);
+            if (key == "extensions") return ReadExtensions(r, view.extensions);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseBuffer(JsonReader& r, tinygltf::Buffer& buffer)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(buffer.name);
+            if (key == "uri") return r.ReadString(buffer.uri);
+            if (key == "extensions") return ReadExtensions(r, buffer.extensions);
+            return r.Skip();
+        });
+    }
+
+    // Model::LoadMaterialが参照するpbrMetallicRoughnessの値のみ
+    inline bool ParseMaterial(JsonReader& r, tinygltf::Material& mat)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(mat.name);
+            if (key != "pbrMetallicRoughness") return r.Skip();
+            return r.ForEachMember([&](std::string_view pbrKey) {
+                if (pbrKey == "baseColorFactor")
+                {
+                    return ReadDoubleArray(r, mat.values["baseColorFactor"].number_array);
+                }
+                if (pbrKey == "baseColorTexture")
+                {
+                    auto& param = mat.values["baseColorTexture"];
+                    return r.ForEachMember([&](std::string_view texKey) {
+                        if (texKey == "index" || texKey == "texCoord")
+                        {
+                            return r.ReadNumber(param.json_double_value[std::string(texKey)]);
+                        }
+                        return r.Skip();
+                    });
+                }
+                return r.Skip();
+            });
+        });
+    }
+
+    inline bool ParseTexture(JsonReader& r, tinygltf::Texture& tex)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(tex.name);
+            if (key == "source") return r.ReadInt(tex.source);
+            if (key == "sampler") return r.ReadInt(tex.sampler);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseImage(JsonReader& r, tinygltf::Image& image)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(image.name);
+            if (key == "uri") return r.ReadString(image.uri);
+            if (key == "mimeType") return r.ReadString(image.mimeType);
+            if (key == "bufferView") return r.ReadInt(image.bufferView);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseSkin(JsonReader& r, tinygltf::Skin& skin)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(skin.name);
+            if (key == "joints") return ReadIntArray(r, skin.joints);
+            if (key == "inverseBindMatrices") return r.ReadInt(skin.inverseBindMatrices);
+            if (key == "skeleton") return r.ReadInt(skin.skeleton);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseAnimation(JsonReader& r, tinygltf::Animation& anim)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(anim.name);
+            if (key == "samplers")
+            {
+                return ReadObjectArray(r, anim.samplers, [](JsonReader& r, tinygltf::AnimationSampler& sampler) {
+                    return r.ForEachMember([&](std::string_view samplerKey) {
+                        if (samplerKey == "input") return r.ReadInt(sampler.input);
+                        if (samplerKey == "output") return r.ReadInt(sampler.output);
+                        if (samplerKey == "interpolation") return r.ReadString(sampler.interpolation);
+                        return r.Skip();
+                    });
+                });
+            }
+            if (key == "channels")
+            {
+                return ReadObjectArray(r, anim.channels, [](JsonReader& r, tinygltf::AnimationChannel& channel) {
+                    return r.ForEachMember([&](std::string_view channelKey) {
+                        if (channelKey == "sampler") return r.ReadInt(channel.sampler);
+                        if (channelKey != "target") return r.Skip();
+                        return r.ForEachMember([&](std::string_view targetKey) {
+                            if (targetKey == "node") return r.ReadInt(channel.target_node);
+                            if (targetKey == "path") return r.ReadString(channel.target_path);
+                            return r.Skip();
+                        });
+                    });
+                });
+            }
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseScene(JsonReader& r, tinygltf::Scene& scene)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "name") return r.ReadString(scene.name);
+            if (key == "nodes") return ReadIntArray(r, scene.nodes);
+            return r.Skip();
+        });
+    }
+
+    inline bool ParseRoot(JsonReader& r, tinygltf::Model& model)
+    {
+        return r.ForEachMember([&](std::string_view key) {
+            if (key == "nodes") return ReadObjectArray(r, model.nodes, ParseNode);
+            if (key == "meshes") return ReadObjectArray(r, model.meshes, ParseMesh);
+            if (key == "accessors") return ReadObjectArray(r, model.accessors, ParseAccessor);
+            if (key == "bufferViews") return ReadObjectArray(r, model.bufferViews, ParseBufferView);
+            if (key == "buffers") return ReadObjectArray(r, model.buffers, ParseBuffer);
+            if (key == "materials") return ReadObjectArray(r, model.materials, ParseMaterial);
+            if (key == "textures") return ReadObjectArray(r, model.textures, ParseTexture);
+            if (key == "images") return ReadObjectArray(r, model.images, ParseImage);
+            if (key == "skins") return ReadObjectArray(r, model.skins, ParseSkin);
+            if (key == "animations") return ReadObjectArray(r, model.animations, ParseAnimation);
+            if (key == "scenes") return ReadObjectArray(r, model.scenes, ParseScene);
+            if (key == "scene") return r.ReadInt(model.defaultScene);
+            if (key == "extensionsUsed") return ReadStringArray(r, model.extensionsUsed);
+            if (key == "extensionsRequired") return ReadStringArray(r, model.extensionsRequired);
+            return r.Skip();
+        });
+    }
+
+    // インデックスの範囲検証 (以降の読み込みは範囲内であることを前提とする)
+    inline bool Validate(const tinygltf::Model& model)
+    {
+        auto inRange = [](int index, size_t size, bool optional) {
+            return (optional && index == -1) || (index >= 0 && size_t(index) < size);
+        };
+        for (const auto& node : model.nodes)
+        {
+            for (auto child : node.children)
+            {
+                if (!inRange(child, model.nodes.size(), false)) return false;
+            }
+            if (!inRange(node.mesh, model.meshes.size(), true) || !inRange(node.skin, model.skins.size(), true)) return false;
+        }
+        for (const auto& mesh : model.meshes)
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                for (const auto& [name, accessor] : primitive.attributes)
+                {
+                    if (!inRange(accessor, model.accessors.size(), false)) return false;
+                }
+                if (!inRange(primitive.indices, model.accessors.size(), true)) return false;
+            }
+        }
+        for (const auto& acc : model.accessors)
+        {
+            if (!inRange(acc.bufferView, model.bufferViews.size(), true) || acc.componentType < 0 || acc.type < 0) return false;
+        }
+        for (const auto& view : model.bufferViews)
+        {
+            if (!inRange(view.buffer, model.buffers.size(), false)) return false;
+        }
+        for (const auto& tex : model.textures)
+        {
+            if (!inRange(tex.source, model.images.size(), false)) return false;
+        }
+        for (const auto& image : model.images)
+        {
+            if (!inRange(image.bufferView, model.bufferViews.size(), true)) return false;
+        }
+        for (const auto& skin : model.skins)
+        {
+            for (auto joint : skin.joints)
+            {
+                if (!inRange(joint, model.nodes.size(), false)) return false;
+            }
+            if (!inRange(skin.inverseBindMatrices, model.accessors.size(), true)) return false;
+        }
+        for (const auto& anim : model.animations)
+        {
+            for (const auto& sampler : anim.samplers)
+            {
+                if (!inRange(sampler.input, model.accessors.size(), false) || !inRange(sampler.output, model.accessors.size(), false)) return false;
+            }
+        }
+        return true;
+    }
+
+    inline bool DecodeBase64(std::string_view src, std::vector<unsigned char>& dst)
+    {
+        auto decodeChar = [](char c) -> int {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+' || c == '-') return 62;
+            if (c == '/' || c == '_') return 63;
+            return -1;
+        };
+        dst.clear();
+        dst.reserve(src.size() / 4 * 3);
+        uint32_t bits = 0;
+        int bitCount = 0;
+        for (char c : src)
+        {
+            if (c == '=')
+            {
+                break;
+            }
+            int value = decodeChar(c);
+            if (value < 0)
+            {
+                return false;
+            }
+            bits = (bits << 6) | uint32_t(value);
+            bitCount += 6;
+            if (bitCount >= 8)
+            {
+                bitCount -= 8;
+                dst.push_back(uint8_t(bits >> bitCount));
+            }
+        }
+        return true;
+    }
+
+    // "data:[mime];base64,..." 形式のみ対応
+    inline bool IsDataURI(const std::string& uri)
+    {
+        return uri.compare(0, 5, "data:") == 0;
+    }
+
+    inline bool DecodeDataURI(const std::string& uri, std::vector<unsigned char>& dst)
+    {
+        auto comma = uri.find(',');
+        if (comma == std::string::npos || std::string_view(uri).substr(0, comma).ends_with(";base64") == false)
+        {
+            return false;
+        }
+        return DecodeBase64(std::string_view(uri).substr(comma + 1), dst);
+    }
+
+    // パーセントエンコードを展開した相対パス (UTF-8)
+    inline fs::path DecodeURIPath(const fs::path& baseDir, const std::string& uri)
+    {
+        std::u8string decoded;
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(uint8_t(uri[i + 1])) && isxdigit(uint8_t(uri[i + 2])))
+            {
+                decoded += char8_t(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            }
+            else
+            {
+                decoded += char8_t(uri[i]);
+            }
+        }
+        return baseDir / fs::path(decoded);
+    }
+
+    inline std::shared_ptr<const MappedFile> MapExternalFile(const fs::path& baseDir, const std::string& uri, GLTFDocument& doc)
+    {
+        auto file = std::make_shared<MappedFile>();
+        if (!file->Open(DecodeURIPath(baseDir, uri).wstring()))
+        {
+            return nullptr;
+        }
+        doc.files.push_back(file);
+        return file;
+    }
+
+    inline bool IsMeshoptFallback(const tinygltf::Buffer& buffer)
+    {
+        for (const char* name : { "EXT_meshopt_compression", "KHR_meshopt_compression" })
+        {
+            auto it = buffer.extensions.find(name);
+            if (it != buffer.extensions.end() && it->second.IsObject() &&
+                it->second.Has("fallback") && it->second.Get("fallback").IsBool() && it->second.Get("fallback").Get<bool>())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// バッファと画像の内容を解決
+    /// データURIのみmodel側へ展開し、それ以外はメモリマップした領域を参照する
+    /// </summary>
+    inline bool ResolveResources(const fs::path& baseDir, std::span<const uint8_t> binChunk, bool isBinary, GLTFDocument& doc)
+    {
+        auto& model = doc.model;
+        doc.buffers.assign(model.buffers.size(), {});
+        for (size_t i = 0; i < model.buffers.size(); ++i)
+        {
+            auto& buffer = model.buffers[i];
+            if (buffer.uri.empty())
+            {
+                if (isBinary && i == 0)
+                {
+                    doc.buffers[i] = binChunk;
+                }
+                else if (!IsMeshoptFallback(buffer))
+                {
+                    return false;
+                }
+                // フォールバック用バッファは圧縮されたbufferViewの展開後は参照されない
+            }
+            else if (IsDataURI(buffer.uri))
+            {
+                if (!DecodeDataURI(buffer.uri, buffer.data))
+                {
+                    return false;
+                }
+                doc.buffers[i] = buffer.data;
+            }
+            else
+            {
+                auto file = MapExternalFile(baseDir, buffer.uri, doc);
+                if (!file)
+                {
+                    return false;
+                }
+                doc.buffers[i] = file->GetSpan();
+            }
+        }
+
+        doc.images.assign(model.images.size(), {});
+        for (size_t i = 0; i < model.images.size(); ++i)
+        {
+            auto& image = model.images[i];
+            if (image.bufferView >= 0)
+            {
+                const auto& view = model.bufferViews[image.bufferView];
+                const auto& data = doc.buffers[view.buffer];
+                if (view.byteOffset > data.size() || view.byteLength > data.size() - view.byteOffset)
+                {
+                    return false;
+                }
+                doc.images[i] = data.subspan(view.byteOffset, view.byteLength);
+            }
+            else if (IsDataURI(image.uri))
+            {
+                if (!DecodeDataURI(image.uri, image.image))
+                {
+                    return false;
+                }
+                image.as_is = true;
+                doc.images[i] = image.image;
+            }
+            else
+            {
+                auto file = MapExternalFile(baseDir, image.uri, doc);
+                if (!file)
+                {
+                    return false;
+                }
+                doc.images[i] = file->GetSpan();
+            }
+        }
+        return true;
+    }
+}
+
+/// <summary>
+/// 軽量パーサーによるglTFの読み込み
+/// </summary>
+/// <param name="gltfPath">ファイルのパス (外部リソースの解決に使用)</param>
+/// <param name="data">ファイルの内容</param>
+/// <param name="doc">読み込み先</param>
+/// <returns>形式が不正、またはリソースを解決できない場合はfalse (tinygltfで読み込み直す)</returns>
+inline bool ParseGLTFStream(const std::filesystem::path& gltfPath, std::span<const uint8_t> data, GLTFDocument& doc)
+{
+    using namespace gltf_stream_detail;
+    const bool isBinary = gltfPath.extension() == L".glb";
+    auto json = data;
+    glb::Chunks chunks;
+    if (isBinary)
+    {
+        if (!glb::Split(data, chunks))
+        {
+            return false;
+        }
+        json = chunks.json;
+    }
+
+    JsonReader reader(reinterpret_cast<const char*>(json.data()), reinterpret_cast<const char*>(json.data() + json.size()));
+    if (!ParseRoot(reader, doc.model) || !reader.IsValid() || !Validate(doc.model))
+    {
+        return false;
+    }
+    return ResolveResources(gltfPath.parent_path(), chunks.bin, isBinary, doc);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// FNV-1a (64bit)
+// http://www.isthe.com/chongo/tech/comp/fnv/
+static const uint64_t FNV1A64_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static const uint64_t FNV1A64_PRIME = 0x100000001b3ull;
+
+inline uint64_t HashFNV1a64(const void* data, size_t size, uint64_t hash = FNV1A64_OFFSET_BASIS)
+{
+    auto p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= p[i];
+        hash *= FNV1A64_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t HashFNV1a64(const std::wstring& str, uint64_t hash = FNV1A64_OFFSET_BASIS)
+{
+    return HashFNV1a64(str.data(), str.size() * sizeof(wchar_t), hash);
+}
+
+inline uint64_t HashFNV1a64(const std::string& str, uint64_t hash = FNV1A64_OFFSET_BASIS)
+{
+    return HashFNV1a64(str.data(), str.size(), hash);
+}
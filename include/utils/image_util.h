@@ -0,0 +1,34 @@
+#pragma once
+
+#include <fpng.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// フレームの描画結果をPNGとして出力 (OUTPUT_DIR/{frame:03}.png)
+/// 行ピッチにアライメントの余白がある場合は詰めてから書き込む
+/// </summary>
+/// <param name="pixels">RGBA8の画素</param>
+/// <param name="rowPitch">1行のバイト数 (width * 4以上)</param>
+inline bool WriteFrameImage(int frame, const void* pixels, uint32_t width, uint32_t height, uint32_t rowPitch)
+{
+    std::ostringstream sout;
+    sout << std::setw(3) << std::setfill('0') << frame;
+    std::string filename = OUTPUT_DIR + sout.str() + ".png";
+    const uint32_t rowSize = width * 4;
+    if (rowPitch == rowSize)
+    {
+        return fpng::fpng_encode_image_to_file(filename.c_str(), pixels, width, height, 4, 0);
+    }
+    std::vector<uint8_t> packed(size_t(rowSize) * height);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        memcpy(packed.data() + size_t(rowSize) * y, static_cast<const uint8_t*>(pixels) + size_t(rowPitch) * y, rowSize);
+    }
+    return fpng::fpng_encode_image_to_file(filename.c_str(), packed.data(), width, height, 4, 0);
+}
@@ -0,0 +1,413 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// <summary>
+/// 逐次読み出し型のJSONリーダー
+/// DOMを構築せず、呼び出し側が必要なメンバーのみを読み、不要な値は読み飛ばす
+/// 文字列の走査はSSE2で16バイトずつ行う
+/// 入力が不正な場合は以降の読み出しが全て失敗し、IsValid()がfalseになる
+/// </summary>
+class JsonReader
+{
+public:
+    JsonReader(const char* begin, const char* end) : m_pCur(begin), m_pEnd(end) {}
+
+    bool IsValid() const { return !m_failed; }
+
+    // 次の値の先頭の文字 (空白を読み飛ばす)
+    char Peek()
+    {
+        SkipWhitespace();
+        return m_pCur < m_pEnd ? *m_pCur : '\0';
+    }
+
+    /// <summary>
+    /// オブジェクトのメンバーを順に処理
+    /// onMember(key)はメンバーの値を読むか読み飛ばし、失敗した場合はfalseを返す
+    /// </summary>
+    template<typename F>
+    bool ForEachMember(F&& onMember)
+    {
+        if (!Consume('{') || !EnterNest())
+        {
+            return Fail();
+        }
+        if (Peek() == '}')
+        {
+            ++m_pCur;
+            --m_depth;
+            return true;
+        }
+        std::string key;
+        while (true)
+        {
+            if (!ReadString(key) || !Consume(':') || !onMember(std::string_view(key)) || m_failed)
+            {
+                return Fail();
+            }
+            char c = Peek();
+            if (c == '}')
+            {
+                ++m_pCur;
+                break;
+            }
+            if (c != ',')
+            {
+                return Fail();
+            }
+            ++m_pCur;
+        }
+        --m_depth;
+        return true;
+    }
+
+    /// <summary>
+    /// 配列の要素を順に処理
+    /// onElement(index)は要素を読むか読み飛ばし、失敗した場合はfalseを返す
+    /// </summary>
+    template<typename F>
+    bool ForEachElement(F&& onElement)
+    {
+        if (!Consume('[') || !EnterNest())
+        {
+            return Fail();
+        }
+        if (Peek() == ']')
+        {
+            ++m_pCur;
+            --m_depth;
+            return true;
+        }
+        for (size_t index = 0;; ++index)
+        {
+            if (!onElement(index) || m_failed)
+            {
+                return Fail();
+            }
+            char c = Peek();
+            if (c == ']')
+            {
+                ++m_pCur;
+                break;
+            }
+            if (c != ',')
+            {
+                return Fail();
+            }
+            ++m_pCur;
+        }
+        --m_depth;
+        return true;
+    }
+
+    bool ReadNumber(double& value)
+    {
+        SkipWhitespace();
+        auto result = std::from_chars(m_pCur, m_pEnd, value);
+        if (result.ec != std::errc())
+        {
+            return Fail();
+        }
+        m_pCur = result.ptr;
+        return true;
+    }
+
+    bool ReadInt(int& value)
+    {
+        double number = 0.0;
+        if (!ReadNumber(number))
+        {
+            return false;
+        }
+        if (number < -2147483648.0 || number > 2147483647.0)
+        {
+            return Fail();
+        }
+        value = int(number);
+        return true;
+    }
+
+    bool ReadSize(size_t& value)
+    {
+        double number = 0.0;
+        if (!ReadNumber(number) || number < 0.0 || number >= 18446744073709551616.0)
+        {
+            return Fail();
+        }
+        value = size_t(number);
+        return true;
+    }
+
+    bool ReadBool(bool& value)
+    {
+        SkipWhitespace();
+        if (MatchLiteral("true"))
+        {
+            value = true;
+            return true;
+        }
+        if (MatchLiteral("false"))
+        {
+            value = false;
+            return true;
+        }
+        return Fail();
+    }
+
+    // 文字列の読み出し (エスケープを展開し、UTF-8で格納する)
+    bool ReadString(std::string& value)
+    {
+        if (!Consume('"'))
+        {
+            return Fail();
+        }
+        value.clear();
+        while (true)
+        {
+            auto p = FindQuoteOrEscape(m_pCur);
+            if (p >= m_pEnd)
+            {
+                return Fail();
+            }
+            value.append(m_pCur, p);
+            m_pCur = p + 1;
+            if (*p == '"')
+            {
+                return true;
+            }
+            if (!ReadEscape(value))
+            {
+                return Fail();
+            }
+        }
+    }
+
+    // 任意の値を読み飛ばす
+    bool Skip()
+    {
+        switch (Peek())
+        {
+        case '{':
+            return ForEachMember([this](std::string_view) { return Skip(); });
+        case '[':
+            return ForEachElement([this](size_t) { return Skip(); });
+        case '"':
+        {
+            ++m_pCur;
+            while (true)
+            {
+                auto p = FindQuoteOrEscape(m_pCur);
+                if (p >= m_pEnd)
+                {
+                    return Fail();
+                }
+                m_pCur = p + 1;
+                if (*p == '"')
+                {
+                    return true;
+                }
+                // エスケープされた1文字を読み飛ばす (\uXXXXの残りは通常の文字として走査される)
+                if (m_pCur >= m_pEnd)
+                {
+                    return Fail();
+                }
+                ++m_pCur;
+            }
+        }
+        case 't':
+        case 'f':
+        {
+            bool value;
+            return ReadBool(value);
+        }
+        case 'n':
+            return MatchLiteral("null") || Fail();
+        default:
+        {
+            double value;
+            return ReadNumber(value);
+        }
+        }
+    }
+
+private:
+    static const int MaxDepth = 256;
+
+    bool Fail()
+    {
+        m_failed = true;
+        m_pCur = m_pEnd;
+        return false;
+    }
+
+    bool EnterNest()
+    {
+        return ++m_depth <= MaxDepth;
+    }
+
+    void SkipWhitespace()
+    {
+        while (m_pCur < m_pEnd && (*m_pCur == ' ' || *m_pCur == '\n' || *m_pCur == '\r' || *m_pCur == '\t'))
+        {
+            ++m_pCur;
+        }
+    }
+
+    bool Consume(char c)
+    {
+        if (Peek() != c)
+        {
+            return false;
+        }
+        ++m_pCur;
+        return true;
+    }
+
+    bool MatchLiteral(const char* literal)
+    {
+        const size_t length = strlen(literal);
+        if (size_t(m_pEnd - m_pCur) < length || memcmp(m_pCur, literal, length) != 0)
+        {
+            return false;
+        }
+        m_pCur += length;
+        return true;
+    }
+
+    // '"'または'\\'の位置を探す (見つからない場合はm_pEnd)
+    const char* FindQuoteOrEscape(const char* p) const
+    {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i escape = _mm_set1_epi8('\\');
+        while (m_pEnd - p >= 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, escape)));
+            if (mask != 0)
+            {
+#ifdef _MSC_VER
+                unsigned long bit;
+                _BitScanForward(&bit, static_cast<unsigned long>(mask));
+#else
+                int bit = __builtin_ctz(static_cast<unsigned int>(mask));
+#endif
+                return p + bit;
+            }
+            p += 16;
+        }
+        while (p < m_pEnd && *p != '"' && *p != '\\')
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    bool ReadHex4(uint32_t& code)
+    {
+        if (m_pEnd - m_pCur < 4)
+        {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            char c = *m_pCur++;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= uint32_t(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= uint32_t(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= uint32_t(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    static void AppendUTF8(std::string& dst, uint32_t code)
+    {
+        if (code < 0x80)
+        {
+            dst += char(code);
+        }
+        else if (code < 0x800)
+        {
+            dst += char(0xC0 | (code >> 6));
+            dst += char(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            dst += char(0xE0 | (code >> 12));
+            dst += char(0x80 | ((code >> 6) & 0x3F));
+            dst += char(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            dst += char(0xF0 | (code >> 18));
+            dst += char(0x80 | ((code >> 12) & 0x3F));
+            dst += char(0x80 | ((code >> 6) & 0x3F));
+            dst += char(0x80 | (code & 0x3F));
+        }
+    }
+
+    // '\\'の直後から1つのエスケープを展開
+    bool ReadEscape(std::string& dst)
+    {
+        if (m_pCur >= m_pEnd)
+        {
+            return false;
+        }
+        char c = *m_pCur++;
+        switch (c)
+        {
+        case '"': dst += '"'; return true;
+        case '\\': dst += '\\'; return true;
+        case '/': dst += '/'; return true;
+        case 'b': dst += '\b'; return true;
+        case 'f': dst += '\f'; return true;
+        case 'n': dst += '\n'; return true;
+        case 'r': dst += '\r'; return true;
+        case 't': dst += '\t'; return true;
+        case 'u':
+        {
+            uint32_t code;
+            if (!ReadHex4(code))
+            {
+                return false;
+            }
+            // サロゲートペア
+            if (code >= 0xD800 && code < 0xDC00)
+            {
+                uint32_t low;
+                if (m_pEnd - m_pCur < 2 || m_pCur[0] != '\\' || m_pCur[1] != 'u')
+                {
+                    return false;
+                }
+                m_pCur += 2;
+                if (!ReadHex4(low) || low < 0xDC00 || low >= 0xE000)
+                {
+                    return false;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            AppendUTF8(dst, code);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+private:
+    const char* m_pCur;
+    const char* m_pEnd;
+    int m_depth = 0;
+    bool m_failed = false;
+};
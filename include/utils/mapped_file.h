@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/print_util.h"
+#endif
+
+/// <summary>
+/// 読み取り専用でメモリマップしたファイル
+/// 内容はコピーせず、マップした領域をspanとして参照する
+/// </summary>
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::wstring& path)
+    {
+        Close();
+#ifdef _WIN32
+        m_hFile = CreateFileW(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,
+            nullptr
+        );
+        if (m_hFile == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(m_hFile, &fileSize))
+        {
+            Close();
+            return false;
+        }
+        m_size = size_t(fileSize.QuadPart);
+        // 空のファイルはマップできないため、開けた時点で成功とする
+        if (m_size == 0)
+        {
+            return true;
+        }
+        m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_hMapping == nullptr)
+        {
+            Close();
+            return false;
+        }
+        m_pMapped = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_pMapped == nullptr)
+        {
+            Close();
+            return false;
+        }
+        return true;
+#else
+        m_fd = open(WStrToStr(path).c_str(), O_RDONLY);
+        if (m_fd < 0)
+        {
+            return false;
+        }
+        struct stat fileStat{};
+        if (fstat(m_fd, &fileStat) != 0)
+        {
+            Close();
+            return false;
+        }
+        m_size = size_t(fileStat.st_size);
+        if (m_size == 0)
+        {
+            return true;
+        }
+        void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+        m_pMapped = static_cast<const uint8_t*>(mapped);
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (m_pMapped)
+        {
+            UnmapViewOfFile(m_pMapped);
+            m_pMapped = nullptr;
+        }
+        if (m_hMapping)
+        {
+            CloseHandle(m_hMapping);
+            m_hMapping = nullptr;
+        }
+        if (m_hFile != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_hFile);
+            m_hFile = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_pMapped)
+        {
+            munmap(const_cast<uint8_t*>(m_pMapped), m_size);
+            m_pMapped = nullptr;
+        }
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+#endif
+        m_size = 0;
+    }
+
+    const uint8_t* GetData() const { return m_pMapped; }
+    size_t GetSize() const { return m_size; }
+    std::span<const uint8_t> GetSpan() const { return std::span<const uint8_t>(m_pMapped, m_size); }
+
+private:
+#ifdef _WIN32
+    HANDLE m_hFile = INVALID_HANDLE_VALUE;
+    HANDLE m_hMapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    const uint8_t* m_pMapped = nullptr;
+    size_t m_size = 0;
+};
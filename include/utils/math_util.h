@@ -13,22 +13,22 @@ using Mtx4x3 = DirectX::XMFLOAT4X3;
 using Mtx4x4 = DirectX::XMFLOAT4X4;
 using Vector = DirectX::XMVECTOR;
 
-static Vector ZeroVector()
+inline Vector ZeroVector()
 {
     return XMVectorZero();
 }
 
-static Vector IdentityQuat()
+inline Vector IdentityQuat()
 {
     return XMQuaternionIdentity();
 }
 
-static Vector Vector4(float x, float y, float z, float w)
+inline Vector Vector4(float x, float y, float z, float w)
 {
     return XMVectorSet(x, y, z, w);
 }
 
-static Vector DoubleToVector3(const double* v)
+inline Vector DoubleToVector3(const double* v)
 {
     Float3 vec3;
     vec3.x = static_cast<float>(v[0]);
@@ -37,7 +37,7 @@ static Vector DoubleToVector3(const double* v)
     return XMLoadFloat3(&vec3);
 }
 
-static Vector DoubleToVector4(const double* v)
+inline Vector DoubleToVector4(const double* v)
 {
     Float4 vec4;
     vec4.x = static_cast<float>(v[0]);
@@ -47,11 +47,19 @@ static Vector DoubleToVector4(const double* v)
     return XMLoadFloat4(&vec4);
 }
 
-static Matrix IdentityMtx()
+inline Matrix IdentityMtx()
 {
     return XMMatrixIdentity();
 }
 
+inline bool MatrixEqual(const Matrix& a, const Matrix& b)
+{
+    return XMVector4Equal(a.r[0], b.r[0]) &&
+        XMVector4Equal(a.r[1], b.r[1]) &&
+        XMVector4Equal(a.r[2], b.r[2]) &&
+        XMVector4Equal(a.r[3], b.r[3]);
+}
+
 #ifndef ROUND_UP
 #define ROUND_UP(size, align) (((size) + (align) - 1) & ~((align) - 1))
 #endif
@@ -0,0 +1,569 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+// EXT_meshopt_compression のデコーダー
+// https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Vendor/EXT_meshopt_compression
+// バイトグループの展開はSSSE3 (pshufb)、指数フィルタはSSE2で処理する
+namespace meshopt_detail
+{
+    const size_t VertexBlockSizeBytes = 8192;
+    const size_t VertexBlockMaxSize = 256;
+    const size_t ByteGroupSize = 16;
+    const size_t ByteGroupDecodeLimit = 24;
+    const size_t TailMaxSize = 32;
+
+    const uint8_t VertexHeader = 0xa0;
+    const uint8_t IndexHeader = 0xe0;
+    const uint8_t SequenceHeader = 0xd0;
+
+    // ビットマスク (8レーン分) に対応するシャッフルと、読み進めるバイト数
+    struct ShuffleTable
+    {
+        alignas(16) uint8_t shuffle[256][8];
+        uint8_t count[256];
+
+        ShuffleTable()
+        {
+            for (int mask = 0; mask < 256; ++mask)
+            {
+                uint8_t next = 0;
+                for (int lane = 0; lane < 8; ++lane)
+                {
+                    // 値が上限 (エスケープ) のレーンのみ後続のバイトを順に読む
+                    shuffle[mask][lane] = (mask & (1 << lane)) ? next++ : 0x80;
+                }
+                count[mask] = next;
+            }
+        }
+    };
+
+    inline const ShuffleTable& GetShuffleTable()
+    {
+        static const ShuffleTable table;
+        return table;
+    }
+
+    inline uint8_t Unzigzag8(uint8_t v)
+    {
+        return uint8_t((0 - (v & 1)) ^ (v >> 1));
+    }
+
+    // 16バイト分のグループを展開
+    // 呼び出し側でByteGroupDecodeLimitバイト以上読めることを保証する
+    inline const uint8_t* DecodeBytesGroup(const uint8_t* data, uint8_t* buffer, int bitslog2)
+    {
+        const auto& table = GetShuffleTable();
+        __m128i sel;
+        __m128i rest;
+        uint8_t limit;
+        size_t headerSize;
+        switch (bitslog2)
+        {
+        case 0:
+            memset(buffer, 0, ByteGroupSize);
+            return data;
+        case 1:
+        {
+            // 1バイトに2bit x 4 (上位ビットから順)
+            int sel4;
+            memcpy(&sel4, data, 4);
+            __m128i sel2 = _mm_cvtsi32_si128(sel4);
+            __m128i sel22 = _mm_unpacklo_epi8(_mm_srli_epi16(sel2, 4), sel2);
+            __m128i sel2222 = _mm_unpacklo_epi8(_mm_srli_epi16(sel22, 2), sel22);
+            sel = _mm_and_si128(sel2222, _mm_set1_epi8(3));
+            limit = 3;
+            headerSize = 4;
+            break;
+        }
+        case 2:
+        {
+            // 1バイトに4bit x 2 (上位ビットから順)
+            __m128i sel4 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+            __m128i sel44 = _mm_unpacklo_epi8(_mm_srli_epi16(sel4, 4), sel4);
+            sel = _mm_and_si128(sel44, _mm_set1_epi8(15));
+            limit = 15;
+            headerSize = 8;
+            break;
+        }
+        default:
+            memcpy(buffer, data, ByteGroupSize);
+            return data + ByteGroupSize;
+        }
+
+        // 上限値のレーンは後続のバイトをそのまま使う
+        rest = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + headerSize));
+        __m128i mask = _mm_cmpeq_epi8(sel, _mm_set1_epi8(char(limit)));
+        int mask16 = _mm_movemask_epi8(mask);
+        int mask0 = mask16 & 255;
+        int mask1 = mask16 >> 8;
+        __m128i shuffle0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(table.shuffle[mask0]));
+        __m128i shuffle1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(table.shuffle[mask1]));
+        shuffle1 = _mm_add_epi8(shuffle1, _mm_set1_epi8(char(table.count[mask0])));
+        __m128i shuffle = _mm_unpacklo_epi64(shuffle0, shuffle1);
+        __m128i result = _mm_or_si128(_mm_shuffle_epi8(rest, shuffle), _mm_andnot_si128(mask, sel));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), result);
+        return data + headerSize + table.count[mask0] + table.count[mask1];
+    }
+
+    inline const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* dataEnd, uint8_t* buffer, size_t bufferSize)
+    {
+        // 2bitのヘッダーがグループごとに並ぶ
+        const uint8_t* header = data;
+        size_t headerSize = (bufferSize / ByteGroupSize + 3) / 4;
+        if (size_t(dataEnd - data) < headerSize)
+        {
+            return nullptr;
+        }
+        data += headerSize;
+        for (size_t i = 0; i < bufferSize; i += ByteGroupSize)
+        {
+            if (size_t(dataEnd - data) < ByteGroupDecodeLimit)
+            {
+                return nullptr;
+            }
+            size_t headerOffset = i / ByteGroupSize;
+            int bitslog2 = (header[headerOffset / 4] >> ((headerOffset % 4) * 2)) & 3;
+            data = DecodeBytesGroup(data, buffer + i, bitslog2);
+        }
+        return data;
+    }
+
+    inline const uint8_t* DecodeVertexBlock(const uint8_t* data, const uint8_t* dataEnd, uint8_t* vertexData, size_t vertexCount, size_t vertexSize, uint8_t lastVertex[256])
+    {
+        alignas(16) uint8_t buffer[VertexBlockMaxSize];
+        alignas(16) uint8_t transposed[VertexBlockSizeBytes];
+        size_t vertexCountAligned = (vertexCount + ByteGroupSize - 1) & ~(ByteGroupSize - 1);
+        for (size_t k = 0; k < vertexSize; ++k)
+        {
+            data = DecodeBytes(data, dataEnd, buffer, vertexCountAligned);
+            if (!data)
+            {
+                return nullptr;
+            }
+            // 直前の頂点からの差分 (zigzag) を復元
+            size_t vertexOffset = k;
+            uint8_t p = lastVertex[k];
+            for (size_t i = 0; i < vertexCount; ++i)
+            {
+                uint8_t v = uint8_t(Unzigzag8(buffer[i]) + p);
+                transposed[vertexOffset] = v;
+                p = v;
+                vertexOffset += vertexSize;
+            }
+        }
+        memcpy(vertexData, transposed, vertexCount * vertexSize);
+        memcpy(lastVertex, &transposed[vertexSize * (vertexCount - 1)], vertexSize);
+        return data;
+    }
+
+    inline uint32_t DecodeVByte(const uint8_t*& data)
+    {
+        uint8_t lead = *data++;
+        if (lead < 128)
+        {
+            return lead;
+        }
+        // 最大4バイトまで (不正なデータでも必ず終了する)
+        uint32_t result = lead & 127;
+        uint32_t shift = 7;
+        for (int i = 0; i < 4; ++i)
+        {
+            uint8_t group = *data++;
+            result |= uint32_t(group & 127) << shift;
+            shift += 7;
+            if (group < 128)
+            {
+                break;
+            }
+        }
+        return result;
+    }
+
+    inline uint32_t DecodeIndex(const uint8_t*& data, uint32_t last)
+    {
+        uint32_t v = DecodeVByte(data);
+        uint32_t d = (v >> 1) ^ uint32_t(-int32_t(v & 1));
+        return last + d;
+    }
+
+    inline void WriteIndex(void* destination, size_t offset, size_t indexSize, uint32_t value)
+    {
+        if (indexSize == 2)
+        {
+            static_cast<uint16_t*>(destination)[offset] = uint16_t(value);
+        }
+        else
+        {
+            static_cast<uint32_t*>(destination)[offset] = value;
+        }
+    }
+
+    inline void WriteTriangle(void* destination, size_t offset, size_t indexSize, uint32_t a, uint32_t b, uint32_t c)
+    {
+        WriteIndex(destination, offset + 0, indexSize, a);
+        WriteIndex(destination, offset + 1, indexSize, b);
+        WriteIndex(destination, offset + 2, indexSize, c);
+    }
+
+    struct IndexFifo
+    {
+        uint32_t edges[16][2];
+        uint32_t vertices[16];
+        size_t edgeOffset = 0;
+        size_t vertexOffset = 0;
+
+        IndexFifo()
+        {
+            memset(edges, -1, sizeof(edges));
+            memset(vertices, -1, sizeof(vertices));
+        }
+        void PushEdge(uint32_t a, uint32_t b)
+        {
+            edges[edgeOffset][0] = a;
+            edges[edgeOffset][1] = b;
+            edgeOffset = (edgeOffset + 1) & 15;
+        }
+        void PushVertex(uint32_t v, bool cond = true)
+        {
+            vertices[vertexOffset] = v;
+            vertexOffset = (vertexOffset + (cond ? 1 : 0)) & 15;
+        }
+    };
+
+    template<typename T>
+    inline void DecodeFilterOct(T* data, size_t count)
+    {
+        const float maxValue = float((1 << (sizeof(T) * 8 - 1)) - 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // x, yからzを復元 (zには1.0に相当する値が格納されている)
+            float x = float(data[i * 4 + 0]);
+            float y = float(data[i * 4 + 1]);
+            float z = float(data[i * 4 + 2]) - fabsf(x) - fabsf(y);
+            // z < 0 の場合の八面体の折り返し
+            float t = (z < 0.0f) ? z : 0.0f;
+            x += (x >= 0.0f) ? t : -t;
+            y += (y >= 0.0f) ? t : -t;
+            float s = maxValue / sqrtf(x * x + y * y + z * z);
+            data[i * 4 + 0] = T(int(x * s + (x >= 0.0f ? 0.5f : -0.5f)));
+            data[i * 4 + 1] = T(int(y * s + (y >= 0.0f ? 0.5f : -0.5f)));
+            data[i * 4 + 2] = T(int(z * s + (z >= 0.0f ? 0.5f : -0.5f)));
+        }
+    }
+
+    inline void DecodeFilterQuat(int16_t* data, size_t count)
+    {
+        const float scale = 1.0f / sqrtf(2.0f);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // 下位2bitは省略された成分のインデックス、残りはスケール
+            int sf = data[i * 4 + 3] | 3;
+            float ss = scale / float(sf);
+            float x = float(data[i * 4 + 0]) * ss;
+            float y = float(data[i * 4 + 1]) * ss;
+            float z = float(data[i * 4 + 2]) * ss;
+            float ww = 1.0f - x * x - y * y - z * z;
+            float w = sqrtf(ww >= 0.0f ? ww : 0.0f);
+            int xf = int(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+            int yf = int(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+            int zf = int(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+            int wf = int(w * 32767.0f + 0.5f);
+            int qc = data[i * 4 + 3] & 3;
+            data[i * 4 + ((qc + 1) & 3)] = int16_t(xf);
+            data[i * 4 + ((qc + 2) & 3)] = int16_t(yf);
+            data[i * 4 + ((qc + 3) & 3)] = int16_t(zf);
+            data[i * 4 + ((qc + 0) & 3)] = int16_t(wf);
+        }
+    }
+
+    inline void DecodeFilterExp(uint32_t* data, size_t count)
+    {
+        // 上位8bitが指数、下位24bitが仮数 (いずれも符号付き)
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i m = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+            __m128i e = _mm_srai_epi32(v, 24);
+            __m128 s = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23));
+            __m128 r = _mm_mul_ps(s, _mm_cvtepi32_ps(m));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_castps_si128(r));
+        }
+        for (; i < count; ++i)
+        {
+            int32_t m = int32_t(data[i] << 8) >> 8;
+            int32_t e = int32_t(data[i]) >> 24;
+            uint32_t bits = uint32_t(e + 127) << 23;
+            float s;
+            memcpy(&s, &bits, 4);
+            float r = s * float(m);
+            memcpy(&data[i], &r, 4);
+        }
+    }
+}
+
+/// <summary>
+/// 頂点バッファのデコード (mode: ATTRIBUTES)
+/// </summary>
+inline bool MeshoptDecodeVertexBuffer(void* destination, size_t vertexCount, size_t vertexSize, const uint8_t* buffer, size_t bufferSize)
+{
+    using namespace meshopt_detail;
+    if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0)
+    {
+        return false;
+    }
+    const uint8_t* data = buffer;
+    const uint8_t* dataEnd = buffer + bufferSize;
+    if (bufferSize < 1 + vertexSize)
+    {
+        return false;
+    }
+    uint8_t header = *data++;
+    if ((header & 0xf0) != VertexHeader || (header & 0x0f) > 0)
+    {
+        return false;
+    }
+
+    // 末尾に最初のブロックの基準となる頂点が格納されている
+    uint8_t lastVertex[256];
+    memcpy(lastVertex, dataEnd - vertexSize, vertexSize);
+
+    size_t blockSize = (VertexBlockSizeBytes / vertexSize) & ~(ByteGroupSize - 1);
+    blockSize = blockSize < VertexBlockMaxSize ? blockSize : VertexBlockMaxSize;
+    auto vertexData = static_cast<uint8_t*>(destination);
+    for (size_t offset = 0; offset < vertexCount; offset += blockSize)
+    {
+        size_t count = (offset + blockSize < vertexCount) ? blockSize : vertexCount - offset;
+        data = DecodeVertexBlock(data, dataEnd, vertexData + offset * vertexSize, count, vertexSize, lastVertex);
+        if (!data)
+        {
+            return false;
+        }
+    }
+    size_t tailSize = vertexSize < TailMaxSize ? TailMaxSize : vertexSize;
+    return size_t(dataEnd - data) == tailSize;
+}
+
+/// <summary>
+/// 三角形リストのインデックスバッファのデコード (mode: TRIANGLES)
+/// </summary>
+inline bool MeshoptDecodeIndexBuffer(void* destination, size_t indexCount, size_t indexSize, const uint8_t* buffer, size_t bufferSize)
+{
+    using namespace meshopt_detail;
+    if (indexCount % 3 != 0 || (indexSize != 2 && indexSize != 4))
+    {
+        return false;
+    }
+    // ヘッダー, 三角形ごとに1バイト, 末尾の16バイトのテーブルが最小
+    if (bufferSize < 1 + indexCount / 3 + 16)
+    {
+        return false;
+    }
+    if ((buffer[0] & 0xf0) != IndexHeader)
+    {
+        return false;
+    }
+    int version = buffer[0] & 0x0f;
+    if (version > 1)
+    {
+        return false;
+    }
+
+    IndexFifo fifo;
+    uint32_t next = 0;
+    uint32_t last = 0;
+    int fecmax = version >= 1 ? 13 : 15;
+    const uint8_t* code = buffer + 1;
+    const uint8_t* data = code + indexCount / 3;
+    const uint8_t* dataSafeEnd = buffer + bufferSize - 16;
+    const uint8_t* codeauxTable = dataSafeEnd;
+
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        // 1三角形あたり最大16バイトしか読まないため、以降の境界チェックは不要
+        if (data > dataSafeEnd)
+        {
+            return false;
+        }
+        uint8_t codetri = *code++;
+        if (codetri < 0xf0)
+        {
+            // 辺のFIFOを参照
+            int fe = codetri >> 4;
+            uint32_t a = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][0];
+            uint32_t b = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][1];
+            int fec = codetri & 15;
+            if (fec < fecmax)
+            {
+                uint32_t cf = fifo.vertices[(fifo.vertexOffset - 1 - fec) & 15];
+                uint32_t c = (fec == 0) ? next : cf;
+                bool fec0 = fec == 0;
+                next += fec0 ? 1 : 0;
+                WriteTriangle(destination, i, indexSize, a, b, c);
+                fifo.PushVertex(c, fec0);
+                fifo.PushEdge(c, b);
+                fifo.PushEdge(a, c);
+            }
+            else
+            {
+                // 13, 14は直前の自由インデックスからの-1, +1
+                uint32_t c = (fec != 15) ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+                last = c;
+                WriteTriangle(destination, i, indexSize, a, b, c);
+                fifo.PushVertex(c);
+                fifo.PushEdge(c, b);
+                fifo.PushEdge(a, c);
+            }
+        }
+        else if (codetri < 0xfe)
+        {
+            // テーブルからの補助コード
+            uint8_t codeaux = codeauxTable[codetri & 15];
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+            uint32_t a = next++;
+            uint32_t bf = fifo.vertices[(fifo.vertexOffset - feb) & 15];
+            uint32_t b = (feb == 0) ? next : bf;
+            bool feb0 = feb == 0;
+            next += feb0 ? 1 : 0;
+            uint32_t cf = fifo.vertices[(fifo.vertexOffset - fec) & 15];
+            uint32_t c = (fec == 0) ? next : cf;
+            bool fec0 = fec == 0;
+            next += fec0 ? 1 : 0;
+            WriteTriangle(destination, i, indexSize, a, b, c);
+            fifo.PushVertex(a);
+            fifo.PushVertex(b, feb0);
+            fifo.PushVertex(c, fec0);
+            fifo.PushEdge(b, a);
+            fifo.PushEdge(c, b);
+            fifo.PushEdge(a, c);
+        }
+        else
+        {
+            // 補助コードを1バイト読む
+            uint8_t codeaux = *data++;
+            int fea = codetri == 0xfe ? 0 : 15;
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+            if (codeaux == 0)
+            {
+                next = 0;
+            }
+            uint32_t a = (fea == 0) ? next++ : 0;
+            uint32_t b = (feb == 0) ? next++ : fifo.vertices[(fifo.vertexOffset - feb) & 15];
+            uint32_t c = (fec == 0) ? next++ : fifo.vertices[(fifo.vertexOffset - fec) & 15];
+            if (fea == 15)
+            {
+                last = a = DecodeIndex(data, last);
+            }
+            if (feb == 15)
+            {
+                last = b = DecodeIndex(data, last);
+            }
+            if (fec == 15)
+            {
+                last = c = DecodeIndex(data, last);
+            }
+            WriteTriangle(destination, i, indexSize, a, b, c);
+            fifo.PushVertex(a);
+            fifo.PushVertex(b, (feb == 0) || (feb == 15));
+            fifo.PushVertex(c, (fec == 0) || (fec == 15));
+            fifo.PushEdge(b, a);
+            fifo.PushEdge(c, b);
+            fifo.PushEdge(a, c);
+        }
+    }
+    return data == dataSafeEnd;
+}
+
+/// <summary>
+/// インデックス列のデコード (mode: INDICES)
+/// </summary>
+inline bool MeshoptDecodeIndexSequence(void* destination, size_t indexCount, size_t indexSize, const uint8_t* buffer, size_t bufferSize)
+{
+    using namespace meshopt_detail;
+    if (indexSize != 2 && indexSize != 4)
+    {
+        return false;
+    }
+    // ヘッダー, インデックスごとに1バイト, 末尾の4バイトが最小
+    if (bufferSize < 1 + indexCount + 4)
+    {
+        return false;
+    }
+    if ((buffer[0] & 0xf0) != SequenceHeader || (buffer[0] & 0x0f) > 1)
+    {
+        return false;
+    }
+    const uint8_t* data = buffer + 1;
+    const uint8_t* dataSafeEnd = buffer + bufferSize - 4;
+    uint32_t last[2] = {};
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        if (data >= dataSafeEnd)
+        {
+            return false;
+        }
+        uint32_t v = DecodeVByte(data);
+        // 最下位ビットで2つの基準値のどちらからの差分かを選ぶ
+        uint32_t current = v & 1;
+        v >>= 1;
+        uint32_t d = (v >> 1) ^ uint32_t(-int32_t(v & 1));
+        uint32_t index = last[current] + d;
+        last[current] = index;
+        WriteIndex(destination, i, indexSize, index);
+    }
+    return data == dataSafeEnd;
+}
+
+/// <summary>
+/// デコード後のフィルタ (OCTAHEDRAL, QUATERNION, EXPONENTIAL)
+/// </summary>
+inline bool MeshoptDecodeFilter(const std::string& filter, void* data, size_t count, size_t stride)
+{
+    using namespace meshopt_detail;
+    if (filter.empty() || filter == "NONE")
+    {
+        return true;
+    }
+    if (filter == "OCTAHEDRAL")
+    {
+        if (stride == 4)
+        {
+            DecodeFilterOct(static_cast<int8_t*>(data), count);
+            return true;
+        }
+        if (stride == 8)
+        {
+            DecodeFilterOct(static_cast<int16_t*>(data), count);
+            return true;
+        }
+        return false;
+    }
+    if (filter == "QUATERNION")
+    {
+        if (stride != 8)
+        {
+            return false;
+        }
+        DecodeFilterQuat(static_cast<int16_t*>(data), count);
+        return true;
+    }
+    if (filter == "EXPONENTIAL")
+    {
+        if (stride % 4 != 0)
+        {
+            return false;
+        }
+        DecodeFilterExp(static_cast<uint32_t*>(data), count * (stride / 4));
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// 常駐するワーカースレッドのプール
+/// ParallelForとCommandListPool::RecordParallelで共有し、呼び出しごとにスレッドを起動しない
+/// 並列処理の中 (ワーカーまたは実行中の呼び出し元) から呼び出された並列処理は、呼び出したスレッドでそのまま実行する
+/// 別のスレッドの並列処理を実行中の場合も、待たずに呼び出したスレッドで実行する
+/// </summary>
+class WorkerPool
+{
+public:
+    // プロセス全体で共有するプール (ハードウェアスレッド数 - 1 個のワーカー)
+    static WorkerPool& Get()
+    {
+        static WorkerPool pool((std::max)(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+
+    explicit WorkerPool(uint32_t workerCount)
+    {
+        m_threads.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            m_threads.emplace_back(&WorkerPool::WorkerLoop, this, i);
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeCondition.notify_all();
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // 並列に実行できるスレッド数 (呼び出し元を含む)
+    uint32_t GetThreadCount() const { return uint32_t(m_threads.size()) + 1; }
+
+    /// <summary>
+    /// task(index) を [0, taskCount) について呼び出し元とワーカーで並列に実行し、全ての完了を待つ
+    /// 例外が発生しても残りのタスクは全て実行し、最初の例外を呼び出し元へ送出する
+    /// </summary>
+    /// <param name="maxThreadCount">使用する最大スレッド数 (呼び出し元を含む、0の場合は制限しない)</param>
+    void Run(size_t taskCount, size_t maxThreadCount, const std::function<void(size_t)>& task)
+    {
+        size_t threadCount = (std::min)(size_t(GetThreadCount()), taskCount);
+        if (maxThreadCount > 0)
+        {
+            threadCount = (std::min)(threadCount, maxThreadCount);
+        }
+        Job job;
+        job.task = &task;
+        job.count = taskCount;
+        std::unique_lock<std::mutex> runLock(m_runMutex, std::defer_lock);
+        if (threadCount <= 1 || IsInParallel() || !runLock.try_lock())
+        {
+            // 呼び出したスレッドで順に実行する (例外の扱いは並列の場合と同じ)
+            Execute(job);
+            if (job.error)
+            {
+                std::rethrow_exception(job.error);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = &job;
+            m_participantCount = uint32_t(threadCount - 1);
+            m_pendingCount = m_participantCount;
+            ++m_generation;
+        }
+        m_wakeCondition.notify_all();
+
+        IsInParallel() = true;
+        Execute(job);
+        IsInParallel() = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_doneCondition.wait(lock, [this]() { return m_pendingCount == 0; });
+            m_job = nullptr;
+        }
+        if (job.error)
+        {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+private:
+    struct Job
+    {
+        const std::function<void(size_t)>* task = nullptr;
+        size_t count = 0;
+        std::atomic<size_t> next{ 0 };
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    // 並列処理を実行中のスレッドか (ワーカーは常にtrue)
+    static bool& IsInParallel()
+    {
+        thread_local bool inParallel = false;
+        return inParallel;
+    }
+
+    static void Execute(Job& job)
+    {
+        for (;;)
+        {
+            size_t index = job.next.fetch_add(1);
+            if (index >= job.count)
+            {
+                break;
+            }
+            try
+            {
+                (*job.task)(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(job.errorMutex);
+                if (!job.error)
+                {
+                    job.error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void WorkerLoop(uint32_t workerIndex)
+    {
+        IsInParallel() = true;
+        uint64_t generation = 0;
+        for (;;)
+        {
+            Job* job = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeCondition.wait(lock, [&]() { return m_stop || m_generation != generation; });
+                if (m_stop)
+                {
+                    return;
+                }
+                generation = m_generation;
+                // スレッド数を制限した実行では一部のワーカーのみ参加する
+                if (workerIndex >= m_participantCount)
+                {
+                    continue;
+                }
+                job = m_job;
+            }
+            Execute(*job);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_pendingCount;
+            }
+            m_doneCondition.notify_one();
+        }
+    }
+
+private:
+    std::vector<std::thread> m_threads;
+    // 同時に実行する並列処理は1つのみ
+    std::mutex m_runMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+    Job* m_job = nullptr;
+    uint64_t m_generation = 0;
+    uint32_t m_participantCount = 0;
+    // 実行中のジョブを処理しているワーカーの数
+    uint32_t m_pendingCount = 0;
+    bool m_stop = false;
+};
+
+// [0, count) をbatchSize単位に分割し、WorkerPoolで並列に処理する
+// func(begin, end) は各バッチごとに呼び出される (例外は全てのバッチの終了後に呼び出し元へ送出する)
+inline void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    batchSize = (std::max)(batchSize, size_t(1));
+    size_t batchCount = (count + batchSize - 1) / batchSize;
+    WorkerPool::Get().Run(batchCount, 0, [&](size_t batch)
+    {
+        size_t begin = batch * batchSize;
+        func(begin, (std::min)(begin + batchSize, count));
+    });
+}
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#ifdef _WIN32
 #include <windows.h>
 
 #define CURRENT_CP GetConsoleOutputCP()
+#endif
 
 enum class PrintInfoType {
     D3D12,
@@ -22,6 +26,7 @@ std::string inline GetInfoTypeStr(PrintInfoType info_type) {
     }
 }
 
+#ifdef _WIN32
 std::string inline WStrToStr(const std::wstring& wstr) {
     int size_needed = WideCharToMultiByte(CURRENT_CP, 0, wstr.c_str(), (int)wstr.size(), nullptr, 0, nullptr, nullptr);
     std::string str(size_needed, 0);
@@ -35,6 +40,51 @@ std::wstring inline StrToWStr(const std::string& str) {
     MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), &wstr[0], size_needed);
     return wstr;
 }
+#else
+// Windows以外ではwchar_tをUTF-32、出力をUTF-8として変換する
+std::string inline WStrToStr(const std::wstring& wstr) {
+    std::string str;
+    str.reserve(wstr.size());
+    for (wchar_t wc : wstr) {
+        auto c = uint32_t(wc);
+        if (c < 0x80) {
+            str += char(c);
+        }
+        else if (c < 0x800) {
+            str += char(0xC0 | (c >> 6));
+            str += char(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000) {
+            str += char(0xE0 | (c >> 12));
+            str += char(0x80 | ((c >> 6) & 0x3F));
+            str += char(0x80 | (c & 0x3F));
+        }
+        else {
+            str += char(0xF0 | (c >> 18));
+            str += char(0x80 | ((c >> 12) & 0x3F));
+            str += char(0x80 | ((c >> 6) & 0x3F));
+            str += char(0x80 | (c & 0x3F));
+        }
+    }
+    return str;
+}
+
+std::wstring inline StrToWStr(const std::string& str) {
+    std::wstring wstr;
+    wstr.reserve(str.size());
+    for (size_t i = 0; i < str.size();) {
+        auto c = uint8_t(str[i]);
+        int length = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        uint32_t code = length == 1 ? c : c & (0x3F >> (length - 1));
+        for (int k = 1; k < length && i + k < str.size(); ++k) {
+            code = (code << 6) | (uint8_t(str[i + k]) & 0x3F);
+        }
+        wstr += wchar_t(code);
+        i += length;
+    }
+    return wstr;
+}
+#endif
 
 void inline Print(const PrintInfoType info_type, const char* message) {
     std::cout << "[" << GetInfoTypeStr(info_type) << "] " << message << std::endl;
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+/// <summary>
+/// フェンスによる解放を行うリングバッファの領域割り当て
+/// [0, capacity) の範囲をオフセットとして先頭から順に切り出すのみで、メモリには触れない
+/// FinishFrameで直前までの確保にフェンス値を対応付け、GPUがその値に到達したらRetireで再利用可能にする
+/// </summary>
+class RingAllocator
+{
+public:
+    static const uint64_t InvalidOffset = UINT64_MAX;
+
+    RingAllocator() = default;
+    explicit RingAllocator(uint64_t capacity) { Reset(capacity); }
+
+    // 全ての確保を破棄する
+    void Reset(uint64_t capacity)
+    {
+        m_capacity = capacity;
+        m_head = 0;
+        m_tail = 0;
+        m_frames.clear();
+    }
+
+    /// <summary>
+    /// 領域の確保
+    /// 末尾に収まらない場合は先頭に折り返す (末尾の余りは解放まで使用しない)
+    /// </summary>
+    /// <param name="alignment">オフセットのアライメント (2のべき乗、capacityの約数)</param>
+    /// <returns>オフセット (空きがない場合はInvalidOffset)</returns>
+    uint64_t Allocate(uint64_t size, uint64_t alignment)
+    {
+        if (size == 0 || size > m_capacity)
+        {
+            return InvalidOffset;
+        }
+        alignment = alignment > 0 ? alignment : 1;
+        const uint64_t physical = m_head % m_capacity;
+        uint64_t offset = (physical + alignment - 1) & ~(alignment - 1);
+        uint64_t newHead = m_head + (offset - physical) + size;
+        if (offset + size > m_capacity)
+        {
+            offset = 0;
+            newHead = m_head + (m_capacity - physical) + size;
+        }
+        if (newHead - m_tail > m_capacity)
+        {
+            return InvalidOffset;
+        }
+        m_head = newHead;
+        return offset;
+    }
+
+    // 前回のFinishFrame以降の確保を、GPUがfenceValueに到達した時点で解放する
+    void FinishFrame(uint64_t fenceValue)
+    {
+        if (!m_frames.empty() && m_frames.back().head == m_head)
+        {
+            return;
+        }
+        if (m_frames.empty() && m_tail == m_head)
+        {
+            return;
+        }
+        m_frames.push_back({ fenceValue, m_head });
+    }
+
+    // completedFenceValueまでに完了したフレームの領域を解放する
+    void Retire(uint64_t completedFenceValue)
+    {
+        while (!m_frames.empty() && m_frames.front().fenceValue <= completedFenceValue)
+        {
+            m_tail = m_frames.front().head;
+            m_frames.pop_front();
+        }
+    }
+
+    // 解放待ちのフレームのうち最も古いもののフェンス値 (なければ0)
+    uint64_t GetOldestPendingFence() const { return m_frames.empty() ? 0 : m_frames.front().fenceValue; }
+
+    uint64_t GetCapacity() const { return m_capacity; }
+    uint64_t GetUsedSize() const { return m_head - m_tail; }
+
+private:
+    struct Frame
+    {
+        uint64_t fenceValue;
+        uint64_t head;
+    };
+
+    uint64_t m_capacity = 0;
+    // 確保の累積位置 (先頭と末尾、m_head - m_tailが使用中のサイズ)
+    uint64_t m_head = 0;
+    uint64_t m_tail = 0;
+    std::deque<Frame> m_frames;
+};
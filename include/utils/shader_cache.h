@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hash_util.h"
+#include "print_util.h"
+
+// シェーダーキャッシュの形式やコンパイル処理を変更した場合は更新する
+static const uint32_t ShaderCacheVersion = 1;
+
+/// <summary>
+/// シェーダーキャッシュのキー
+/// ソースとインクルード以外でコンパイル結果を変えるもの全て
+/// </summary>
+struct ShaderCacheKey
+{
+    std::wstring entryPoint;
+    std::wstring target;
+    std::vector<std::wstring> args;
+    // プリプロセッサ定義 (名前, 値)
+    std::vector<std::pair<std::wstring, std::wstring>> defines;
+    // コンパイラのバージョン (取得できない場合は0)
+    uint64_t compilerVersion = 0;
+};
+
+/// <summary>
+/// ファイル全体の読み込み
+/// </summary>
+bool inline ReadShaderFile(const std::filesystem::path& path, std::string& content)
+{
+    std::ifstream file(path, std::ifstream::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::stringstream strStream;
+    strStream << file.rdbuf();
+    content = strStream.str();
+    return true;
+}
+
+/// <summary>
+/// #includeで参照されるファイルを再帰的にたどり、内容をハッシュに加える
+/// 解決順はDXCと同じく、インクルード元のディレクトリ -> インクルードパス
+/// </summary>
+/// <param name="source">インクルード元のソース</param>
+/// <param name="dir">インクルード元のディレクトリ</param>
+/// <param name="includeDir">インクルードパス</param>
+/// <param name="visited">処理済みのファイル</param>
+/// <param name="hash"></param>
+void inline HashShaderIncludes(const std::string& source, const std::filesystem::path& dir, const std::filesystem::path& includeDir,
+    std::vector<std::filesystem::path>& visited, uint64_t& hash)
+{
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        auto pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line.compare(pos, 8, "#include") != 0)
+        {
+            continue;
+        }
+        auto begin = line.find_first_of("\"<", pos + 8);
+        auto end = begin == std::string::npos ? begin : line.find_first_of("\">", begin + 1);
+        if (end == std::string::npos)
+        {
+            continue;
+        }
+        const std::filesystem::path includeName = StrToWStr(line.substr(begin + 1, end - begin - 1));
+        std::filesystem::path includePath = dir / includeName;
+        if (!std::filesystem::exists(includePath))
+        {
+            includePath = includeDir / includeName;
+        }
+        includePath = includePath.lexically_normal();
+        if (std::find(visited.begin(), visited.end(), includePath) != visited.end())
+        {
+            continue;
+        }
+        visited.push_back(includePath);
+
+        // 見つからないファイルも名前をハッシュに含め、コンパイル時のエラーに任せる
+        std::string content;
+        hash = HashFNV1a64(includePath.wstring(), hash);
+        if (ReadShaderFile(includePath, content))
+        {
+            hash = HashFNV1a64(content, hash);
+            HashShaderIncludes(content, includePath.parent_path(), includeDir, visited, hash);
+        }
+    }
+}
+
+/// <summary>
+/// シェーダーキャッシュのハッシュ
+/// キャッシュの形式, ファイル名, ソース, 参照する全てのインクルード, キーの全ての値から計算する
+/// </summary>
+/// <param name="sourcePath">ソースのファイルパス (インクルードの解決に使用する)</param>
+/// <param name="source">ソース</param>
+/// <param name="includeDir">インクルードパス</param>
+uint64_t inline HashShaderSource(const std::filesystem::path& sourcePath, const std::string& source, const std::filesystem::path& includeDir, const ShaderCacheKey& key)
+{
+    uint64_t hash = HashFNV1a64(&ShaderCacheVersion, sizeof(ShaderCacheVersion));
+    hash = HashFNV1a64(sourcePath.filename().wstring(), hash);
+    hash = HashFNV1a64(source, hash);
+    std::vector<std::filesystem::path> visited;
+    HashShaderIncludes(source, sourcePath.parent_path(), includeDir, visited, hash);
+    hash = HashFNV1a64(key.entryPoint, hash);
+    hash = HashFNV1a64(key.target, hash);
+    for (const auto& arg : key.args)
+    {
+        hash = HashFNV1a64(arg, hash);
+    }
+    for (const auto& [name, value] : key.defines)
+    {
+        hash = HashFNV1a64(name + L"=" + value, hash);
+    }
+    return HashFNV1a64(&key.compilerVersion, sizeof(key.compilerVersion), hash);
+}
+
+/// <summary>
+/// キャッシュのファイルパス (cacheDir/<ソース名>_<ハッシュ>.dxlib)
+/// </summary>
+std::filesystem::path inline GetShaderCachePath(const std::filesystem::path& cacheDir, const std::filesystem::path& sourcePath, uint64_t hash)
+{
+    char hashStr[17];
+    std::snprintf(hashStr, sizeof(hashStr), "%016llx", static_cast<unsigned long long>(hash));
+    return cacheDir / (sourcePath.stem().wstring() + L"_" + StrToWStr(hashStr) + L".dxlib");
+}
+
+/// <summary>
+/// キャッシュの読み込み
+/// </summary>
+/// <returns>キャッシュがない (空の) 場合はfalse</returns>
+bool inline LoadShaderCache(const std::filesystem::path& cachePath, std::vector<char>& binary)
+{
+    std::string cached;
+    if (!ReadShaderFile(cachePath, cached) || cached.empty())
+    {
+        return false;
+    }
+    binary.assign(cached.begin(), cached.end());
+    return true;
+}
+
+/// <summary>
+/// キャッシュの書き込み
+/// 一時ファイルに書き込んでから置き換えるため、同時に読み込まれても途中の内容は見えない
+/// </summary>
+/// <returns>失敗した場合はfalse (コンパイル結果はそのまま使用する)</returns>
+bool inline StoreShaderCache(const std::filesystem::path& cachePath, const std::vector<char>& binary)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(cachePath.parent_path(), ec);
+    auto tmpPath = cachePath;
+    tmpPath += L".tmp";
+    {
+        std::ofstream dst(tmpPath, std::ios::binary | std::ios::trunc);
+        dst.write(binary.data(), std::streamsize(binary.size()));
+        if (!dst)
+        {
+            return false;
+        }
+    }
+    std::filesystem::rename(tmpPath, cachePath, ec);
+    return !ec;
+}
@@ -2,7 +2,7 @@
 
 #include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <future>
 #include <string>
 #include <vector>
 #include <wrl.h>
@@ -10,6 +10,8 @@
 #include <dxcapi.h>
 
 #include "print_util.h"
+#include "shader_cache.h"
+#include "shader_permutation.h"
 
 using Microsoft::WRL::ComPtr;
 namespace fs = std::filesystem;
@@ -17,28 +19,62 @@ namespace fs = std::filesystem;
 #ifdef _DEBUG
 /// <summary>
 ///  シェーダーコンパイル
+///  ソース, 参照する全てのインクルード, ターゲット, 引数, DXCのバージョンのハッシュをキーとして
+///  コンパイル結果をRESOURCE_DIR/shader/cache/に保存し、変更がなければ再利用する
+///  DXCのインスタンスは呼び出しごとに作成するため、複数のスレッドから同時に呼び出せる
 /// </summary>
 /// <param name="hlslFilePath">HLSLのファイルパス</param>
+/// <param name="defines">プリプロセッサ定義 (名前, 値)</param>
 /// <returns>コンパイル結果</returns>
-std::vector<char> inline CompileShaderLibrary(const fs::path& hlslFilePath)
+std::vector<char> inline CompileShaderLibrary(const fs::path& hlslFilePath, const std::vector<std::pair<std::wstring, std::wstring>>& defines = {})
 {
-    Print(PrintInfoType::RTCAMP10, "シェーダーコンパイル 開始");
     // シェーダーロード
-    std::ifstream file(hlslFilePath, std::ifstream::binary);
-    if (!file.is_open()) {
+    std::string shaderSource;
+    if (!ReadShaderFile(hlslFilePath, shaderSource)) {
         Error(PrintInfoType::RTCAMP10, "シェーダーの読み込みに失敗しました :", hlslFilePath);
     }
-
     std::wstring fileName = hlslFilePath.filename().wstring();
-    std::stringstream strStream;
-    strStream << file.rdbuf();
-    std::string shaderSource = strStream.str();
 
     ComPtr<IDxcLibrary> pDxcLibrary;
     DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&pDxcLibrary));
     ComPtr<IDxcCompiler> pDxcCompiler;
     DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pDxcCompiler));
 
+    // コンパイル時引数
+    ShaderCacheKey key;
+    key.args = { L"/0d", L"-I", RESOURCE_DIR L"/shader/" };
+    key.entryPoint = L"";
+    key.target = L"lib_6_4";
+    key.defines = defines;
+    std::vector<LPCWSTR> args;
+    for (const auto& arg : key.args)
+    {
+        args.push_back(arg.c_str());
+    }
+    std::vector<DxcDefine> dxcDefines;
+    for (const auto& [name, value] : defines)
+    {
+        dxcDefines.push_back({ name.c_str(), value.c_str() });
+    }
+
+    // キャッシュの検索
+    ComPtr<IDxcVersionInfo> pVersionInfo;
+    if (SUCCEEDED(pDxcCompiler.As(&pVersionInfo)))
+    {
+        UINT32 version[2] = {};
+        pVersionInfo->GetVersion(&version[0], &version[1]);
+        key.compilerVersion = (uint64_t(version[0]) << 32) | version[1];
+    }
+    const uint64_t hash = HashShaderSource(hlslFilePath, shaderSource, RESOURCE_DIR L"/shader/", key);
+    const fs::path cachePath = GetShaderCachePath(RESOURCE_DIR L"/shader/cache/", hlslFilePath, hash);
+    std::vector<char> cached;
+    if (LoadShaderCache(cachePath, cached))
+    {
+        Print(PrintInfoType::RTCAMP10, L"シェーダーキャッシュ使用: " + fileName);
+        return cached;
+    }
+
+    Print(PrintInfoType::RTCAMP10, L"シェーダーコンパイル 開始: " + fileName);
     ComPtr<IDxcBlobEncoding> pShaderBlob;
     pDxcLibrary->CreateBlobWithEncodingFromPinned(
         (LPBYTE)shaderSource.c_str(), (UINT32)shaderSource.size(), CP_UTF8, &pShaderBlob
@@ -46,21 +82,14 @@ std::vector<char> inline CompileShaderLibrary(const fs::path& hlslFilePath)
     ComPtr<IDxcIncludeHandler> pIncludeHandler;
     pDxcLibrary->CreateIncludeHandler(&pIncludeHandler);
 
-    // コンパイル時引数
-    std::vector<LPCWSTR> args;
-    args.emplace_back(L"/0d");
-    args.emplace_back(L"-I");
-    args.emplace_back(RESOURCE_DIR L"/shader/");
     // シェーダーコンパイル
-    const auto entryPoint = L"";
-    const auto target = L"lib_6_4";
     ComPtr<IDxcOperationResult> pDxcResult;
     HRESULT hr;
     hr = pDxcCompiler->Compile(
         pShaderBlob.Get(), fileName.c_str(),
-        entryPoint, target,
+        key.entryPoint.c_str(), key.target.c_str(),
         args.data(), UINT(args.size()),
-        nullptr, 0,
+        dxcDefines.data(), UINT(dxcDefines.size()),
         pIncludeHandler.Get(), &pDxcResult
     );
     if (FAILED(hr))
@@ -94,6 +123,9 @@ std::vector<char> inline CompileShaderLibrary(const fs::path& hlslFilePath)
     auto blobSize = pBlob->GetBufferSize();
     result.resize(blobSize);
     memcpy(result.data(), pBlob->GetBufferPointer(), blobSize);
+
+    // キャッシュの書き込み (失敗してもコンパイル結果はそのまま使用する)
+    StoreShaderCache(cachePath, result);
     return result;
 }
 #endif // _DEBUG
@@ -122,18 +154,47 @@ std::vector<char> inline LoadPreCompiledShaderLibrary(const fs::path& shaderLibP
 /// シェーダーセットアップ
 /// </summary>
 /// <param name="shaderName">シェーダー名</param>
+/// <param name="permutation">特殊化する設定</param>
 /// <returns></returns>
-std::vector<char> inline SetupShader(const std::wstring& shaderName)
+std::vector<char> inline SetupShader(const std::wstring& shaderName, const ShaderPermutation& permutation)
 {
     std::vector<char> shaderBin;
     // シェーダーロード
 #if _DEBUG
     const fs::path shaderPath{ RESOURCE_DIR L"/shader/" + shaderName + L".hlsl" };
     // シェーダーのランタイムコンパイル
-    shaderBin = CompileShaderLibrary(shaderPath);
+    shaderBin = CompileShaderLibrary(shaderPath, permutation.GetDefines());
 #else
-    const fs::path shaderPath{ RESOURCE_DIR L"/shader/" + shaderName + L".dxlib" };
+    // 特殊化されたライブラリがなければ、設定を実行時に参照する汎用のライブラリを使用
+    fs::path shaderPath{ RESOURCE_DIR L"/shader/" + shaderName + permutation.GetSuffix() + L".dxlib" };
+    if (!fs::exists(shaderPath))
+    {
+        shaderPath = RESOURCE_DIR L"/shader/" + shaderName + L".dxlib";
+    }
     shaderBin = LoadPreCompiledShaderLibrary(shaderPath);
 #endif
     return shaderBin;
-}
\ No newline at end of file
+}
+
+/// <summary>
+/// 複数のシェーダーのセットアップ
+/// ランタイムコンパイル時はワーカースレッドで並列にコンパイルする
+/// </summary>
+/// <param name="shaderNames">シェーダー名</param>
+/// <param name="permutation">特殊化する設定</param>
+/// <returns>shaderNamesと同じ並びのシェーダーライブラリ</returns>
+std::vector<std::vector<char>> inline SetupShaders(const std::vector<std::wstring>& shaderNames, const ShaderPermutation& permutation)
+{
+    std::vector<std::future<std::vector<char>>> tasks;
+    for (const auto& shaderName : shaderNames)
+    {
+        tasks.push_back(std::async(std::launch::async, [&shaderName, &permutation]() { return SetupShader(shaderName, permutation); }));
+    }
+    // 例外 (コンパイルエラー) は取得時に呼び出し元へ伝わる
+    std::vector<std::vector<char>> shaderBins;
+    for (auto& task : tasks)
+    {
+        shaderBins.push_back(task.get());
+    }
+    return shaderBins;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// シェーダーのパーミュテーション
+/// 描画全体で固定の設定をコンパイル時定数として与え、使用しない機能の分岐を取り除く
+/// GPU側はHLSLのdefine (common.hlsliを参照)、CPU側はテンプレート引数として渡す
+/// </summary>
+struct ShaderPermutation
+{
+    // 球光源の数 (0の場合は光源のサンプリングを行わない)
+    uint32_t lightCount = 0;
+    // 最大反射回数 (0の場合は実行時にシーンパラメーターを参照する)
+    uint32_t maxPathDepth = 0;
+
+    std::vector<std::pair<std::wstring, std::wstring>> GetDefines() const
+    {
+        std::vector<std::pair<std::wstring, std::wstring>> defines;
+        defines.emplace_back(L"LIGHT_COUNT", std::to_wstring(lightCount));
+        if (maxPathDepth > 0)
+        {
+            defines.emplace_back(L"MAX_PATH_DEPTH", std::to_wstring(maxPathDepth));
+        }
+        return defines;
+    }
+
+    // プリコンパイル済みライブラリのファイル名の接尾辞 (例: _L3_D8)
+    std::wstring GetSuffix() const
+    {
+        std::wstring suffix = L"_L" + std::to_wstring(lightCount);
+        if (maxPathDepth > 0)
+        {
+            suffix += L"_D" + std::to_wstring(maxPathDepth);
+        }
+        return suffix;
+    }
+};
+
+/// <summary>
+/// CPU側の実装向け: ライト数をテンプレート引数 (std::integral_constant) に変換して呼び出す
+/// func(std::integral_constant<uint32_t, N>)は [0, MaxLightCount] の各Nで同じ型を返す必要がある
+/// </summary>
+template<uint32_t MaxLightCount, uint32_t N = 0, typename F>
+decltype(auto) DispatchLightCount(uint32_t lightCount, F&& func)
+{
+    if constexpr (N < MaxLightCount)
+    {
+        if (lightCount != N)
+        {
+            return DispatchLightCount<MaxLightCount, N + 1>(lightCount, std::forward<F>(func));
+        }
+    }
+    return func(std::integral_constant<uint32_t, N>{});
+}
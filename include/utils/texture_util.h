@@ -1,9 +1,11 @@
 #pragma once
 
 #include "device.hpp"
+#include "utils/hash_util.h"
 
 #include <filesystem>
 #include <fstream>
+#include <thread>
 
 #include <DirectXTex.h>
 
@@ -13,140 +15,226 @@ struct TextureResource
     DescriptorHeap srv;
 };
 
-inline TextureResource LoadTexture(const void* data, UINT64 size, std::unique_ptr<Device>& device)
+// デコード済みの画像 (CPU側のみ)
+// デバイスに依存しないため、ワーカースレッドで作成できる
+struct DecodedImage
 {
-    using namespace DirectX;
-    DirectX::TexMetadata metadata;
+    DirectX::TexMetadata metadata{};
     DirectX::ScratchImage image;
+    bool IsValid() const { return image.GetImageCount() > 0; }
+};
 
-    HRESULT hr = E_FAIL;
-    TextureResource res{};
-    hr = LoadFromDDSMemory(data, size, DDS_FLAGS_NONE, &metadata, image);
-    if (FAILED(hr)) {
-        hr = LoadFromWICMemory(data, size, WIC_FLAGS_NONE/*WIC_FLAGS_FORCE_RGB*/, &metadata, image);
-        if (FAILED(hr)) {
-            std::wstring err = L"テクスチャのロードに失敗しました: " + (int)hr;
-            Error(PrintInfoType::D3D12, err);
-            return res;
-        }
-    }
-    CreateTexture(device->GetDevice().Get(), metadata, &res.resource);
-
-    ComPtr<ID3D12Resource> srcBuffer;
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-    PrepareUpload(device->GetDevice().Get(), image.GetImages(), image.GetImageCount(), metadata, subresources);
-    const auto totalBytes = GetRequiredIntermediateSize(res.resource.Get(), 0, UINT(subresources.size()));
-
-    auto stagingBuffer = device->CreateBuffer(
-        totalBytes,
-        D3D12_RESOURCE_FLAG_NONE,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        D3D12_HEAP_TYPE_UPLOAD
-    );
-    if (stagingBuffer)
+/// <summary>
+/// 画像のデコード (DDS, WIC対応形式)
+/// COMはDevice側でマルチスレッドアパートメントとして初期化済みのため、任意のスレッドから呼び出せる
+/// </summary>
+inline bool DecodeImage(const void* data, size_t size, DecodedImage& decoded)
+{
+    using namespace DirectX;
+    HRESULT hr = LoadFromDDSMemory(data, size, DDS_FLAGS_NONE, &decoded.metadata, decoded.image);
+    if (FAILED(hr))
     {
-        stagingBuffer->SetName(L"Tex-Staging");
+        hr = LoadFromWICMemory(data, size, WIC_FLAGS_NONE/*WIC_FLAGS_FORCE_RGB*/, &decoded.metadata, decoded.image);
     }
-
-    auto cmd = device->CreateCommandList();
-    UpdateSubresources(cmd.Get(), res.resource.Get(), stagingBuffer.Get(), 0, 0, UINT(subresources.size()), subresources.data());
-    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(res.resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    cmd->ResourceBarrier(1, &barrier);
-    cmd->Close();
-
-    // 転送
-    device->ExecuteCommandList(cmd);
-
-    // シェーダーリソースビューの作成
-    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-    srvDesc.Format = metadata.format;
-    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.ViewDimension = metadata.IsCubemap() ? D3D12_SRV_DIMENSION_TEXTURECUBE : D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
-    srvDesc.Texture2D.MostDetailedMip = 0;
-    srvDesc.Texture2D.ResourceMinLODClamp = 0;
-    res.srv = device->CreateSRV(res.resource.Get(), &srvDesc);
-
-    // 待機
-    device->WaitForGpu();
-    return res;
+    return SUCCEEDED(hr);
 }
 
-inline TextureResource LoadTexture(const std::wstring& fileName, std::unique_ptr<Device>& device)
+inline bool DecodeImage(const std::wstring& fileName, DecodedImage& decoded)
 {
     namespace fs = std::filesystem;
     const fs::path path{ RESOURCE_DIR L"/texture/" + fileName };
     std::ifstream srcFile(path, std::ios::binary);
     if (!srcFile)
     {
-        std::wstring err = L"テクスチャのロードに失敗しました: " + path.wstring();
-        Error(PrintInfoType::D3D12, err);
-        return TextureResource();
+        return false;
     }
     std::vector<char> buf;
     buf.resize(srcFile.seekg(0, std::ios::end).tellg());
     srcFile.seekg(0, std::ios::beg).read(buf.data(), buf.size());
-    return LoadTexture(buf.data(), buf.size(), device);
+    return DecodeImage(buf.data(), buf.size(), decoded);
 }
 
-inline TextureResource LoadHDRTexture(const std::wstring& fileName, std::unique_ptr<Device>& device)
+// GPU用テクスチャの圧縮形式
+enum class TextureCompression
 {
-    namespace fs = std::filesystem;
-    const fs::path path{ RESOURCE_DIR L"/texture/" + fileName };
-    std::ifstream srcFile(path, std::ios::binary);
-    if (!srcFile)
+    None,
+    BC1,    // 4bpp, アルファなし
+    BC7,    // 8bpp
+    Auto,   // 不透明であればBC1, アルファを含む場合はBC7
+};
+
+// キャッシュの形式を変更した場合は更新する
+static const uint32_t TextureCacheVersion = 1;
+
+/// <summary>
+/// ミップマップの生成とBC圧縮
+/// 既にミップマップを持つ画像や圧縮済みの画像 (DDS) はそのまま使用する
+/// </summary>
+inline bool ProcessImage(DecodedImage& decoded, TextureCompression compression)
+{
+    using namespace DirectX;
+    if (IsCompressed(decoded.metadata.format))
     {
-        std::wstring err = L"テクスチャのロードに失敗しました: " + path.wstring();
-        Error(PrintInfoType::D3D12, err);
-        return TextureResource();
+        return true;
     }
-    DirectX::ScratchImage image;
-    DirectX::TexMetadata metadata;
-    TextureResource res{};
-    HRESULT hr = LoadFromHDRFile(path.c_str(), &metadata, image);
+    if (decoded.metadata.mipLevels == 1 && (decoded.metadata.width > 1 || decoded.metadata.height > 1))
+    {
+        ScratchImage mipChain;
+        HRESULT hr = GenerateMipMaps(decoded.image.GetImages(), decoded.image.GetImageCount(), decoded.metadata, TEX_FILTER_DEFAULT, 0, mipChain);
+        if (FAILED(hr))
+        {
+            return false;
+        }
+        decoded.image = std::move(mipChain);
+        decoded.metadata = decoded.image.GetMetadata();
+    }
+    // BC圧縮テクスチャは最上位のサイズが4の倍数である必要がある
+    if (compression == TextureCompression::None || decoded.metadata.width % 4 != 0 || decoded.metadata.height % 4 != 0)
+    {
+        return true;
+    }
+    if (compression == TextureCompression::Auto)
+    {
+        compression = decoded.image.IsAlphaAllOpaque() ? TextureCompression::BC1 : TextureCompression::BC7;
+    }
+    DXGI_FORMAT format = compression == TextureCompression::BC1 ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC7_UNORM;
+    if (IsSRGB(decoded.metadata.format))
+    {
+        format = MakeSRGB(format);
+    }
+    ScratchImage compressed;
+    HRESULT hr = Compress(decoded.image.GetImages(), decoded.image.GetImageCount(), decoded.metadata, format,
+        TEX_COMPRESS_BC7_QUICK | TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, compressed);
     if (FAILED(hr))
     {
-        std::wstring err = L"HDRテクスチャのロードに失敗しました: " + path.wstring();
-        Error(PrintInfoType::D3D12, err);
+        return false;
     }
-    // TODO: 下記の処理はLoadTextureと同様なのでまとめたい
-    DirectX::CreateTexture(device->GetDevice().Get(), metadata, &res.resource);
-    ComPtr<ID3D12Resource> srcBuffer;
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-    PrepareUpload(device->GetDevice().Get(), image.GetImages(), image.GetImageCount(), metadata, subresources);
-    const auto totalBytes = GetRequiredIntermediateSize(res.resource.Get(), 0, UINT(subresources.size()));
+    decoded.image = std::move(compressed);
+    decoded.metadata = decoded.image.GetMetadata();
+    return true;
+}
+
+inline std::wstring GetTextureCachePath(uint64_t hash)
+{
+    wchar_t name[17];
+    swprintf_s(name, L"%016llx", static_cast<unsigned long long>(hash));
+    return RESOURCE_DIR L"/texture/cache/" + std::wstring(name) + L".dds";
+}
 
-    auto stagingBuffer = device->CreateBuffer(
-        totalBytes,
-        D3D12_RESOURCE_FLAG_NONE,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        D3D12_HEAP_TYPE_UPLOAD
-    );
-    if (stagingBuffer)
+/// <summary>
+/// エンコード済み画像からGPU用のテクスチャ (ミップマップ, BC圧縮) を作成
+/// 結果は画像の内容のハッシュごとにDDSとしてキャッシュし、2回目以降はデコードと圧縮を省略する
+/// </summary>
+inline bool PrepareTexture(const void* data, size_t size, DecodedImage& decoded, TextureCompression compression = TextureCompression::Auto)
+{
+    namespace fs = std::filesystem;
+    using namespace DirectX;
+    auto hash = HashFNV1a64(data, size);
+    hash = HashFNV1a64(&TextureCacheVersion, sizeof(TextureCacheVersion), hash);
+    hash = HashFNV1a64(&compression, sizeof(compression), hash);
+    const auto cachePath = GetTextureCachePath(hash);
+    if (SUCCEEDED(LoadFromDDSFile(cachePath.c_str(), DDS_FLAGS_NONE, &decoded.metadata, decoded.image)))
     {
-        stagingBuffer->SetName(L"Tex-Staging");
+        return true;
+    }
+    if (!DecodeImage(data, size, decoded) || !ProcessImage(decoded, compression))
+    {
+        return false;
     }
 
-    auto cmd = device->CreateCommandList();
-    UpdateSubresources(cmd.Get(), res.resource.Get(), stagingBuffer.Get(), 0, 0, UINT(subresources.size()), subresources.data());
-    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(res.resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    cmd->ResourceBarrier(1, &barrier);
-    cmd->Close();
+    // キャッシュの書き込みに失敗しても処理は続行する
+    // 同じ画像を複数のスレッドが同時に書き込む場合があるため、一時ファイルに書いてから置き換える
+    std::error_code ec;
+    fs::create_directories(fs::path(cachePath).parent_path(), ec);
+    const auto tempPath = cachePath + L"." + std::to_wstring(std::hash<std::thread::id>()(std::this_thread::get_id())) + L".tmp";
+    HRESULT hr = SaveToDDSFile(decoded.image.GetImages(), decoded.image.GetImageCount(), decoded.metadata, DDS_FLAGS_NONE, tempPath.c_str());
+    if (SUCCEEDED(hr))
+    {
+        fs::rename(tempPath, cachePath, ec);
+    }
+    if (FAILED(hr) || ec)
+    {
+        fs::remove(tempPath, ec);
+    }
+    return true;
+}
 
-    // 転送
-    device->ExecuteCommandList(cmd);
+inline bool DecodeHDRImage(const std::wstring& fileName, DecodedImage& decoded)
+{
+    namespace fs = std::filesystem;
+    const fs::path path{ RESOURCE_DIR L"/texture/" + fileName };
+    HRESULT hr = DirectX::LoadFromHDRFile(path.c_str(), &decoded.metadata, decoded.image);
+    return SUCCEEDED(hr);
+}
+
+/// <summary>
+/// テクスチャの作成と転送
+/// 転送はデバイスのアップロードバッチに積まれ、バッチ外であれば即座に実行される
+/// subresourcesの内容は呼び出し中にコピーされる
+/// </summary>
+inline TextureResource CreateTextureResource(const DirectX::TexMetadata& metadata, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources, std::unique_ptr<Device>& device)
+{
+    TextureResource res{};
+    HRESULT hr = DirectX::CreateTexture(device->GetDevice().Get(), metadata, &res.resource);
+    if (FAILED(hr))
+    {
+        Error(PrintInfoType::D3D12, L"テクスチャの作成に失敗しました");
+    }
+    device->WriteTexture(res.resource, subresources, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
     // シェーダーリソースビューの作成
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
     srvDesc.Format = metadata.format;
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.ViewDimension = metadata.IsCubemap() ? D3D12_SRV_DIMENSION_TEXTURECUBE : D3D12_SRV_DIMENSION_TEXTURE2D;
     srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
     srvDesc.Texture2D.MostDetailedMip = 0;
     srvDesc.Texture2D.ResourceMinLODClamp = 0;
     res.srv = device->CreateSRV(res.resource.Get(), &srvDesc);
-
-    // 待機
-    device->WaitForGpu();
     return res;
 }
+
+/// <summary>
+/// デコード済み画像からテクスチャを作成
+/// </summary>
+inline TextureResource UploadTexture(const DecodedImage& decoded, std::unique_ptr<Device>& device)
+{
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+    DirectX::PrepareUpload(device->GetDevice().Get(), decoded.image.GetImages(), decoded.image.GetImageCount(), decoded.metadata, subresources);
+    return CreateTextureResource(decoded.metadata, subresources, device);
+}
+
+inline TextureResource LoadTexture(const void* data, UINT64 size, std::unique_ptr<Device>& device)
+{
+    DecodedImage decoded;
+    if (!DecodeImage(data, size_t(size), decoded))
+    {
+        Error(PrintInfoType::D3D12, L"テクスチャのロードに失敗しました");
+        return TextureResource();
+    }
+    return UploadTexture(decoded, device);
+}
+
+inline TextureResource LoadTexture(const std::wstring& fileName, std::unique_ptr<Device>& device)
+{
+    DecodedImage decoded;
+    if (!DecodeImage(fileName, decoded))
+    {
+        std::wstring err = L"テクスチャのロードに失敗しました: " + fileName;
+        Error(PrintInfoType::D3D12, err);
+        return TextureResource();
+    }
+    return UploadTexture(decoded, device);
+}
+
+inline TextureResource LoadHDRTexture(const std::wstring& fileName, std::unique_ptr<Device>& device)
+{
+    DecodedImage decoded;
+    if (!DecodeHDRImage(fileName, decoded))
+    {
+        std::wstring err = L"HDRテクスチャのロードに失敗しました: " + fileName;
+        Error(PrintInfoType::D3D12, err);
+        return TextureResource();
+    }
+    return UploadTexture(decoded, device);
+}
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// TLSF (Two-Level Segregated Fit) による領域の割り当て
+/// [0, size) の範囲をオフセットとして管理するのみで、メモリには触れない
+/// 空きブロックをサイズの区分 (上位ビット位置 x 下位SLBitsビット) ごとのリストで管理し、
+/// 確保と解放 (隣接する空きブロックとの結合) はいずれも定数時間で行う
+/// </summary>
+class TLSFAllocator
+{
+public:
+    static const uint32_t InvalidBlock = UINT32_MAX;
+
+    struct Allocation
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t block = InvalidBlock;
+        bool IsValid() const { return block != InvalidBlock; }
+    };
+
+    TLSFAllocator() { Reset(0); }
+    explicit TLSFAllocator(uint64_t size) { Reset(size); }
+
+    // 全ての割り当てを破棄し、[0, size) を1つの空きブロックにする
+    void Reset(uint64_t size)
+    {
+        m_blocks.clear();
+        m_unusedBlocks.clear();
+        m_flBitmap = 0;
+        for (uint32_t fl = 0; fl < FLCount; ++fl)
+        {
+            m_slBitmap[fl] = 0;
+            for (uint32_t sl = 0; sl < SLCount; ++sl)
+            {
+                m_freeHeads[fl][sl] = InvalidBlock;
+            }
+        }
+        m_size = size;
+        m_usedSize = 0;
+        m_allocationCount = 0;
+        if (size > 0)
+        {
+            auto block = NewBlock();
+            m_blocks[block].offset = 0;
+            m_blocks[block].size = size;
+            InsertFreeBlock(block);
+        }
+    }
+
+    /// <summary>
+    /// 領域の確保
+    /// </summary>
+    /// <param name="size">サイズ (0より大きい)</param>
+    /// <param name="alignment">オフセットのアライメント (2のべき乗)</param>
+    /// <param name="allocation">確保した領域 (sizeは端数を含む実際のサイズ)</param>
+    /// <returns>十分な空きがない場合はfalse</returns>
+    bool Allocate(uint64_t size, uint64_t alignment, Allocation& allocation)
+    {
+        if (size == 0 || size > m_size)
+        {
+            return false;
+        }
+        alignment = alignment > 0 ? alignment : 1;
+        // まず要求サイズの区分で探し、アライメントが合わなければ余白分を含めて探し直す
+        uint32_t block = FindFreeBlock(size);
+        if (block == InvalidBlock || AlignUp(m_blocks[block].offset, alignment) + size > m_blocks[block].offset + m_blocks[block].size)
+        {
+            if (alignment - 1 > UINT64_MAX - size)
+            {
+                return false;
+            }
+            block = FindFreeBlock(size + alignment - 1);
+            if (block == InvalidBlock)
+            {
+                return false;
+            }
+        }
+        RemoveFreeBlock(block);
+
+        // 先頭の余白は空きブロックとして切り離す
+        const uint64_t alignedOffset = AlignUp(m_blocks[block].offset, alignment);
+        const uint64_t padding = alignedOffset - m_blocks[block].offset;
+        if (padding > 0)
+        {
+            auto aligned = SplitBlock(block, padding);
+            InsertFreeBlock(block);
+            block = aligned;
+        }
+        // 後方の残りが十分に大きければ空きブロックとして返す
+        if (m_blocks[block].size - size >= MinBlockSize)
+        {
+            auto rest = SplitBlock(block, size);
+            InsertFreeBlock(rest);
+        }
+
+        m_blocks[block].isFree = false;
+        m_usedSize += m_blocks[block].size;
+        ++m_allocationCount;
+        allocation.offset = m_blocks[block].offset;
+        allocation.size = m_blocks[block].size;
+        allocation.block = block;
+        return true;
+    }
+
+    // 領域の解放 (物理的に隣接する空きブロックと結合する)
+    void Free(const Allocation& allocation)
+    {
+        uint32_t block = allocation.block;
+        if (block >= m_blocks.size() || m_blocks[block].isFree)
+        {
+            return;
+        }
+        m_usedSize -= m_blocks[block].size;
+        --m_allocationCount;
+
+        auto prev = m_blocks[block].prevPhys;
+        if (prev != InvalidBlock && m_blocks[prev].isFree)
+        {
+            RemoveFreeBlock(prev);
+            MergeBlock(prev, block);
+            block = prev;
+        }
+        auto next = m_blocks[block].nextPhys;
+        if (next != InvalidBlock && m_blocks[next].isFree)
+        {
+            RemoveFreeBlock(next);
+            MergeBlock(block, next);
+        }
+        InsertFreeBlock(block);
+    }
+
+    uint64_t GetSize() const { return m_size; }
+    uint64_t GetUsedSize() const { return m_usedSize; }
+    uint32_t GetAllocationCount() const { return m_allocationCount; }
+    bool IsEmpty() const { return m_allocationCount == 0; }
+
+private:
+    // 第2レベルの分割数 (2^SLBits)
+    static const uint32_t SLBits = 4;
+    static const uint32_t SLCount = 1u << SLBits;
+    // SmallBlockSize未満は第1レベル0に線形に割り当てる
+    static const uint64_t SmallBlockSize = 256;
+    static const uint32_t FLShift = 7; // Msb(SmallBlockSize) - 1
+    static const uint32_t FLCount = 64 - FLShift;
+    // これより小さい端数は切り離さない
+    static const uint64_t MinBlockSize = SmallBlockSize / SLCount;
+
+    struct Block
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        // 物理的に隣接するブロック
+        uint32_t prevPhys = InvalidBlock;
+        uint32_t nextPhys = InvalidBlock;
+        // 同じ区分の空きリスト
+        uint32_t prevFree = InvalidBlock;
+        uint32_t nextFree = InvalidBlock;
+        bool isFree = false;
+    };
+
+    static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    static uint32_t Msb(uint64_t value)
+    {
+        uint32_t bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+    }
+
+    static uint32_t Lsb(uint64_t value)
+    {
+        uint32_t bit = 0;
+        while ((value & 1) == 0)
+        {
+            value >>= 1;
+            ++bit;
+        }
+        return bit;
+    }
+
+    // サイズが属する区分
+    static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+    {
+        if (size < SmallBlockSize)
+        {
+            fl = 0;
+            sl = uint32_t(size / MinBlockSize);
+            return;
+        }
+        uint32_t msb = Msb(size);
+        sl = uint32_t(size >> (msb - SLBits)) ^ SLCount;
+        fl = msb - FLShift;
+    }
+
+    // size以上が保証される最小の区分から空きブロックを探す
+    uint32_t FindFreeBlock(uint64_t size) const
+    {
+        // 区分内の全てのブロックが収まるよう切り上げる
+        if (size < SmallBlockSize)
+        {
+            size = AlignUp(size, MinBlockSize);
+        }
+        else
+        {
+            uint64_t round = (uint64_t(1) << (Msb(size) - SLBits)) - 1;
+            if (size > UINT64_MAX - round)
+            {
+                return InvalidBlock;
+            }
+            size += round;
+        }
+        uint32_t fl, sl;
+        Mapping(size, fl, sl);
+        if (fl >= FLCount)
+        {
+            return InvalidBlock;
+        }
+        uint32_t slMap = m_slBitmap[fl] & (~0u << sl);
+        if (slMap == 0)
+        {
+            uint64_t flMap = fl + 1 < 64 ? m_flBitmap & (~0ull << (fl + 1)) : 0;
+            if (flMap == 0)
+            {
+                return InvalidBlock;
+            }
+            fl = Lsb(flMap);
+            slMap = m_slBitmap[fl];
+        }
+        sl = Lsb(slMap);
+        return m_freeHeads[fl][sl];
+    }
+
+    void InsertFreeBlock(uint32_t block)
+    {
+        uint32_t fl, sl;
+        Mapping(m_blocks[block].size, fl, sl);
+        auto& head = m_freeHeads[fl][sl];
+        m_blocks[block].isFree = true;
+        m_blocks[block].prevFree = InvalidBlock;
+        m_blocks[block].nextFree = head;
+        if (head != InvalidBlock)
+        {
+            m_blocks[head].prevFree = block;
+        }
+        head = block;
+        m_flBitmap |= 1ull << fl;
+        m_slBitmap[fl] |= 1u << sl;
+    }
+
+    void RemoveFreeBlock(uint32_t block)
+    {
+        uint32_t fl, sl;
+        Mapping(m_blocks[block].size, fl, sl);
+        auto& b = m_blocks[block];
+        if (b.prevFree != InvalidBlock)
+        {
+            m_blocks[b.prevFree].nextFree = b.nextFree;
+        }
+        else
+        {
+            m_freeHeads[fl][sl] = b.nextFree;
+        }
+        if (b.nextFree != InvalidBlock)
+        {
+            m_blocks[b.nextFree].prevFree = b.prevFree;
+        }
+        b.prevFree = InvalidBlock;
+        b.nextFree = InvalidBlock;
+        b.isFree = false;
+        if (m_freeHeads[fl][sl] == InvalidBlock)
+        {
+            m_slBitmap[fl] &= ~(1u << sl);
+            if (m_slBitmap[fl] == 0)
+            {
+                m_flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+
+    // blockの先頭sizeバイトを残し、後ろを新しいブロックとして返す
+    uint32_t SplitBlock(uint32_t block, uint64_t size)
+    {
+        auto rest = NewBlock();
+        auto& b = m_blocks[block];
+        auto& r = m_blocks[rest];
+        r.offset = b.offset + size;
+        r.size = b.size - size;
+        r.prevPhys = block;
+        r.nextPhys = b.nextPhys;
+        if (b.nextPhys != InvalidBlock)
+        {
+            m_blocks[b.nextPhys].prevPhys = rest;
+        }
+        b.size = size;
+        b.nextPhys = rest;
+        return rest;
+    }
+
+    // nextをblockに結合し、nextを破棄する
+    void MergeBlock(uint32_t block, uint32_t next)
+    {
+        auto& b = m_blocks[block];
+        auto& n = m_blocks[next];
+        b.size += n.size;
+        b.nextPhys = n.nextPhys;
+        if (n.nextPhys != InvalidBlock)
+        {
+            m_blocks[n.nextPhys].prevPhys = block;
+        }
+        n = Block();
+        // 破棄したブロックは解放済みとして扱う (古い割り当てを再度Freeしても無視される)
+        n.isFree = true;
+        m_unusedBlocks.push_back(next);
+    }
+
+    uint32_t NewBlock()
+    {
+        if (!m_unusedBlocks.empty())
+        {
+            auto block = m_unusedBlocks.back();
+            m_unusedBlocks.pop_back();
+            return block;
+        }
+        m_blocks.emplace_back();
+        return uint32_t(m_blocks.size() - 1);
+    }
+
+private:
+    std::vector<Block> m_blocks;
+    std::vector<uint32_t> m_unusedBlocks;
+    uint64_t m_flBitmap = 0;
+    uint32_t m_slBitmap[FLCount] = {};
+    uint32_t m_freeHeads[FLCount][SLCount] = {};
+    uint64_t m_size = 0;
+    uint64_t m_usedSize = 0;
+    uint32_t m_allocationCount = 0;
+};
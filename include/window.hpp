@@ -1,21 +1,23 @@
-#pragma once
-
-#include "device.hpp"
-
-class Renderer;
-
-class Window
-{
-public:
-    static int Run(Renderer* renderer, HINSTANCE hInstance);
-
-    static LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
-    static HWND GetHWND() { return m_hWnd; }
-
-private:
-    static HWND m_hWnd;
-};
-
-#ifdef _DEBUG
-extern LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
-#endif
+#pragma once
+
+#include "device.hpp"
+
+class Renderer;
+
+class Window
+{
+public:
+    static int Run(Renderer* renderer, HINSTANCE hInstance);
+    // ウィンドウとメッセージループを使用せずに描画を実行 (ヘッドレス)
+    static int RunHeadless(Renderer* renderer);
+
+    static LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+    static HWND GetHWND() { return m_hWnd; }
+
+private:
+    static HWND m_hWnd;
+};
+
+#ifdef _DEBUG
+extern LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+#endif
@@ -1,19 +1,22 @@
-#include "common.hlsli"
-
-[shader("miss")]
-void Miss(inout HitInfo payload)
-{
-    float2 uv = CalcSphereUV(WorldRayDirection());
-    // TODO: IBLのためのNEE実装
-    float3 bgCol = gBgTex.SampleLevel(gSampler, uv, 0).rgb;
-    bgCol /= (bgCol + 1.0f);
-    bgCol = pow(bgCol, 1.0f / 2.2f);
-    payload.color =  bgCol * payload.attenuation;
-    payload.pathDepth = gSceneParam.maxPathDepth;
-}
-
-[shader("miss")]
-void ShadowMiss(inout ShadowRayHitInfo payload)
-{
-    payload.occluded = false;
-}
+#include "common.hlsli"
+
+[shader("miss")]
+void Miss(inout HitInfo payload)
+{
+    // 外周の折り返しは隣接テクセルと連続しないため、バイリニアが反対側を参照しないよう内側に寄せる
+    uint width, height;
+    gBgTex.GetDimensions(width, height);
+    float2 uv = clamp(CalcOctahedralUV(WorldRayDirection()), 0.5 / width, 1.0 - 0.5 / width);
+    // TODO: IBLのためのNEE実装
+    float3 bgCol = gBgTex.SampleLevel(gSampler, uv, 0).rgb;
+    bgCol /= (bgCol + 1.0f);
+    bgCol = pow(bgCol, 1.0f / 2.2f);
+    payload.color =  bgCol * payload.attenuation;
+    payload.pathDepth = SCENE_MAX_PATH_DEPTH;
+}
+
+[shader("miss")]
+void ShadowMiss(inout ShadowRayHitInfo payload)
+{
+    payload.occluded = false;
+}
@@ -0,0 +1,591 @@
+#include "backend/cpu_backend.hpp"
+
+#include "utils/parallel_util.h"
+#include "utils/print_util.h"
+
+#include <cstring>
+
+namespace
+{
+    const float RayTMax = 10000.0f;
+    // 自己交差を避けるためのレイの始点のずらし幅
+    const float RayOffset = 1e-4f;
+    const uint32_t TraversalStackSize = 64;
+
+    // シェーダー (common.hlsli) と同じxorshift
+    float Rand(uint32_t& seed)
+    {
+        uint32_t rnd = seed;
+        rnd ^= rnd << 13;
+        rnd ^= rnd >> 7;
+        rnd ^= rnd << 5;
+        seed = rnd;
+        return float(rnd & 0x00FFFFFF) / float(0x01000000);
+    }
+
+    Vector ApplyZToN(Vector dir, Vector norm)
+    {
+        Vector up = std::abs(XMVectorGetZ(norm)) < 0.999f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+        Vector tangent = XMVector3Normalize(XMVector3Cross(up, norm));
+        Vector bitangent = XMVector3Cross(norm, tangent);
+        return XMVectorGetX(dir) * tangent + XMVectorGetY(dir) * bitangent + XMVectorGetZ(dir) * norm;
+    }
+
+    Vector SampleHemisphereCos(uint32_t& seed)
+    {
+        float r1 = Rand(seed);
+        float r2 = Rand(seed);
+        float phi = XM_2PI * r1;
+        return XMVectorSet(std::cos(phi) * std::sqrt(r2), std::sin(phi) * std::sqrt(r2), std::sqrt((std::max)(0.0f, 1.0f - r2)), 0.0f);
+    }
+
+    Vector SampleSphere(uint32_t& seed, const RenderBackend::SphereLight& light)
+    {
+        float r1 = Rand(seed);
+        float r2 = Rand(seed);
+        float theta = XM_2PI * r1;
+        float phi = std::acos(1.0f - 2.0f * r2);
+        Vector dir = XMVectorSet(std::sin(phi) * std::cos(theta), std::sin(phi) * std::sin(theta), std::cos(phi), 0.0f);
+        return XMLoadFloat3(&light.center) + light.radius * dir;
+    }
+
+    // 球との交差距離 (交差しない場合はFLT_MAX)
+    float IntersectSphere(Vector origin, Vector dir, const RenderBackend::SphereLight& light, float tMax)
+    {
+        Vector oc = origin - XMLoadFloat3(&light.center);
+        float b = XMVectorGetX(XMVector3Dot(oc, dir));
+        float c = XMVectorGetX(XMVector3LengthSq(oc)) - light.radius * light.radius;
+        float disc = b * b - c;
+        if (disc < 0.0f)
+        {
+            return FLT_MAX;
+        }
+        float sq = std::sqrt(disc);
+        float t = -b - sq > RayOffset ? -b - sq : -b + sq;
+        return t > RayOffset && t < tMax ? t : FLT_MAX;
+    }
+
+    // AABBとの交差 (交差する場合は入射距離、しない場合はFLT_MAX)
+    float IntersectAABB(const BVHNode& node, const Float3& origin, const Float3& invDir, float tMax)
+    {
+        float tx1 = (node.boundsMin.x - origin.x) * invDir.x;
+        float tx2 = (node.boundsMax.x - origin.x) * invDir.x;
+        float tNear = (std::min)(tx1, tx2);
+        float tFar = (std::max)(tx1, tx2);
+        float ty1 = (node.boundsMin.y - origin.y) * invDir.y;
+        float ty2 = (node.boundsMax.y - origin.y) * invDir.y;
+        tNear = (std::max)(tNear, (std::min)(ty1, ty2));
+        tFar = (std::min)(tFar, (std::max)(ty1, ty2));
+        float tz1 = (node.boundsMin.z - origin.z) * invDir.z;
+        float tz2 = (node.boundsMax.z - origin.z) * invDir.z;
+        tNear = (std::max)(tNear, (std::min)(tz1, tz2));
+        tFar = (std::min)(tFar, (std::max)(tz1, tz2));
+        return tFar >= tNear && tFar > 0.0f && tNear < tMax ? tNear : FLT_MAX;
+    }
+
+    /// <summary>
+    /// BVHの走査 (近い子から順に辿る)
+    /// leaf(first, count)は葉ノードごとに呼ばれ、より近い交差を見つけた場合はtMaxを縮める
+    /// </summary>
+    template<typename LeafFunc>
+    void TraverseBVH(const std::vector<BVHNode>& nodes, const Float3& origin, const Float3& dir, float& tMax, LeafFunc&& leaf)
+    {
+        if (nodes.empty())
+        {
+            return;
+        }
+        Float3 invDir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+        if (IntersectAABB(nodes[0], origin, invDir, tMax) == FLT_MAX)
+        {
+            return;
+        }
+        uint32_t stack[TraversalStackSize];
+        uint32_t stackSize = 0;
+        uint32_t nodeIndex = 0;
+        while (true)
+        {
+            const auto& node = nodes[nodeIndex];
+            if (node.triCount > 0)
+            {
+                leaf(node.leftFirst, node.triCount);
+            }
+            else
+            {
+                // windows.hのnear/farマクロと衝突しない名前にする
+                uint32_t nearChild = node.leftFirst;
+                uint32_t farChild = node.leftFirst + 1;
+                float tNear = IntersectAABB(nodes[nearChild], origin, invDir, tMax);
+                float tFar = IntersectAABB(nodes[farChild], origin, invDir, tMax);
+                if (tFar < tNear)
+                {
+                    std::swap(nearChild, farChild);
+                    std::swap(tNear, tFar);
+                }
+                if (tNear != FLT_MAX)
+                {
+                    if (tFar != FLT_MAX && stackSize < TraversalStackSize)
+                    {
+                        stack[stackSize++] = farChild;
+                    }
+                    nodeIndex = nearChild;
+                    continue;
+                }
+            }
+            // 積まれたノードのうち、縮んだtMaxより遠いものは飛ばす
+            bool found = false;
+            while (stackSize > 0)
+            {
+                nodeIndex = stack[--stackSize];
+                if (IntersectAABB(nodes[nodeIndex], origin, invDir, tMax) != FLT_MAX)
+                {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                return;
+            }
+        }
+    }
+}
+
+void CpuBackend::OnInit(uint32_t width, uint32_t height)
+{
+    m_width = width;
+    m_height = height;
+    m_accumBuffer.assign(size_t(width) * height, Float4(0.0f, 0.0f, 0.0f, 0.0f));
+    m_seedBuffer.assign(size_t(width) * height, 0);
+    m_output.assign(size_t(width) * height * 4, 0);
+}
+
+void CpuBackend::OnDestroy()
+{
+    m_buffers.clear();
+    m_geometries.clear();
+    m_instances.clear();
+    m_instanceNodes.clear();
+    m_instanceIndices.clear();
+    m_environment = nullptr;
+    m_accumBuffer.clear();
+    m_seedBuffer.clear();
+    m_output.clear();
+}
+
+RenderBackend::BufferHandle CpuBackend::CreateBuffer(BufferUsage, uint64_t size)
+{
+    m_buffers.emplace_back(size_t(size));
+    return BufferHandle(m_buffers.size());
+}
+
+void CpuBackend::WriteBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t size)
+{
+    if (buffer == InvalidHandle || buffer > m_buffers.size() ||
+        offset > m_buffers[buffer - 1].size() || size > m_buffers[buffer - 1].size() - offset)
+    {
+        Error(PrintInfoType::RTCAMP10, "バッファの書き込み範囲が不正です: ", buffer);
+    }
+    memcpy(m_buffers[buffer - 1].data() + offset, data, size_t(size));
+}
+
+void CpuBackend::DestroyBuffer(BufferHandle buffer)
+{
+    if (buffer != InvalidHandle && buffer <= m_buffers.size())
+    {
+        m_buffers[buffer - 1] = std::vector<uint8_t>();
+    }
+}
+
+/// <summary>
+/// BLASの構築
+/// 頂点をジオメトリ空間へ変換して三角形ごとに展開し、SAHでBVHを構築する
+/// 構築後はバッファを参照しないため、呼び出し側で破棄してよい
+/// </summary>
+RenderBackend::GeometryHandle CpuBackend::BuildGeometry(std::span<const GeometryDesc> geometries)
+{
+    auto geometry = std::make_unique<Geometry>();
+    for (const auto& desc : geometries)
+    {
+        if (desc.positions == InvalidHandle || desc.positions > m_buffers.size() ||
+            desc.indices == InvalidHandle || desc.indices > m_buffers.size())
+        {
+            Error(PrintInfoType::RTCAMP10, "ジオメトリのバッファが不正です");
+        }
+        const auto& positionBuffer = m_buffers[desc.positions - 1];
+        const auto& indexBuffer = m_buffers[desc.indices - 1];
+        if ((uint64_t(desc.vertexOffset) + desc.vertexCount) * sizeof(Float3) > positionBuffer.size() ||
+            (uint64_t(desc.indexOffset) + desc.indexCount) * sizeof(uint32_t) > indexBuffer.size())
+        {
+            Error(PrintInfoType::RTCAMP10, "ジオメトリの範囲がバッファを超えています");
+        }
+        auto positions = reinterpret_cast<const Float3*>(positionBuffer.data()) + desc.vertexOffset;
+        auto indices = reinterpret_cast<const uint32_t*>(indexBuffer.data()) + desc.indexOffset;
+
+        Matrix mtx = XMLoadFloat3x4(&desc.transform);
+        auto diffuseIndex = uint32_t(geometry->diffuses.size());
+        geometry->diffuses.push_back(desc.diffuse);
+        for (uint32_t i = 0; i + 2 < desc.indexCount; i += 3)
+        {
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                auto index = indices[i + k];
+                if (index >= desc.vertexCount)
+                {
+                    Error(PrintInfoType::RTCAMP10, "インデックスが頂点数を超えています: ", index);
+                }
+                Float3 v;
+                XMStoreFloat3(&v, XMVector3TransformCoord(XMLoadFloat3(&positions[index]), mtx));
+                geometry->vertices.push_back(v);
+            }
+            geometry->diffuseIndices.push_back(diffuseIndex);
+        }
+    }
+
+    auto triCount = geometry->diffuseIndices.size();
+    std::vector<BVHBounds> triBounds(triCount);
+    for (size_t i = 0; i < triCount; ++i)
+    {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            triBounds[i].Grow(geometry->vertices[i * 3 + k]);
+        }
+        geometry->bounds.Grow(triBounds[i]);
+    }
+    BuildBVH(triBounds, geometry->nodes, geometry->triIndices);
+
+    m_geometries.push_back(std::move(geometry));
+    return GeometryHandle(m_geometries.size());
+}
+
+/// <summary>
+/// TLASの構築
+/// インスタンスのワールド空間のAABBからBVHを構築する
+/// </summary>
+void CpuBackend::BuildScene(std::span<const InstanceDesc> instances)
+{
+    m_instances.clear();
+    std::vector<BVHBounds> instanceBounds;
+    for (const auto& desc : instances)
+    {
+        if (desc.geometry == InvalidHandle || desc.geometry > m_geometries.size())
+        {
+            Error(PrintInfoType::RTCAMP10, "インスタンスのジオメトリが不正です: ", desc.geometry);
+        }
+        const auto* geometry = m_geometries[desc.geometry - 1].get();
+        if (geometry->diffuseIndices.empty())
+        {
+            continue;
+        }
+        Instance instance{};
+        instance.geometry = geometry;
+        instance.worldMtx = XMLoadFloat3x4(&desc.transform);
+        instance.invWorldMtx = XMMatrixInverse(nullptr, instance.worldMtx);
+        m_instances.push_back(instance);
+
+        // AABBの8頂点を変換して包含する
+        BVHBounds bounds;
+        const auto& lo = geometry->bounds.boundsMin;
+        const auto& hi = geometry->bounds.boundsMax;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            Vector p = XMVectorSet(corner & 1 ? hi.x : lo.x, corner & 2 ? hi.y : lo.y, corner & 4 ? hi.z : lo.z, 1.0f);
+            Float3 world;
+            XMStoreFloat3(&world, XMVector3TransformCoord(p, instance.worldMtx));
+            bounds.Grow(world);
+        }
+        instanceBounds.push_back(bounds);
+    }
+    BuildBVH(instanceBounds, m_instanceNodes, m_instanceIndices);
+}
+
+/// <summary>
+/// 1パス分の描画
+/// 光源の数はパイプラインの設定をテンプレート引数として渡し、シェーダーのパーミュテーションと揃える
+/// </summary>
+void CpuBackend::Dispatch(const FrameParam& param)
+{
+    if (m_accumBuffer.empty())
+    {
+        Error(PrintInfoType::RTCAMP10, "CPUバックエンドが初期化されていません");
+    }
+    if (param.lightCount != m_permutation.lightCount || param.lightCount > MaxLightCount)
+    {
+        Error(PrintInfoType::RTCAMP10, "光源の数がパイプラインの設定と一致しません: ", param.lightCount);
+    }
+    DispatchLightCount<MaxLightCount>(m_permutation.lightCount, [&](auto lightCount)
+    {
+        constexpr uint32_t LightCount = decltype(lightCount)::value;
+        ParallelFor(m_height, 4, [&](size_t begin, size_t end)
+        {
+            RenderRows<LightCount>(param, begin, end);
+        });
+    });
+}
+
+bool CpuBackend::Readback(std::vector<uint8_t>& pixels)
+{
+    if (m_output.empty())
+    {
+        return false;
+    }
+    pixels = m_output;
+    return true;
+}
+
+template<uint32_t LightCount>
+void CpuBackend::RenderRows(const FrameParam& param, size_t rowBegin, size_t rowEnd)
+{
+    const uint32_t maxPathDepth = m_permutation.maxPathDepth > 0 ? m_permutation.maxPathDepth : param.maxPathDepth;
+    const Matrix invViewMtx = XMLoadFloat4x4(&param.invViewMtx);
+    const Matrix invProjMtx = XMLoadFloat4x4(&param.invProjMtx);
+    Float3 origin;
+    XMStoreFloat3(&origin, XMVector3TransformCoord(XMVectorZero(), invViewMtx));
+    const uint32_t sampleEnd = (std::min)(param.sampleOffset + param.sampleCount, param.maxSPP);
+
+    for (size_t y = rowBegin; y < rowEnd; ++y)
+    {
+        for (uint32_t x = 0; x < m_width; ++x)
+        {
+            // 乱数と蓄積値の初期化 (2パス目以降は前のパスの状態から継続する)
+            const size_t bufferOffset = x + y * m_width;
+            uint32_t seed = uint32_t(bufferOffset) * (param.frame + 1);
+            Float4 accum(0.0f, 0.0f, 0.0f, 0.0f);
+            if (param.sampleOffset > 0)
+            {
+                seed = m_seedBuffer[bufferOffset];
+                accum = m_accumBuffer[bufferOffset];
+            }
+
+            for (uint32_t i = param.sampleOffset; i < sampleEnd; ++i)
+            {
+                float u = (float(x) + Rand(seed) + 0.5f) / float(m_width) * 2.0f - 1.0f;
+                float v = (float(y) + Rand(seed) + 0.5f) / float(m_height) * 2.0f - 1.0f;
+                Vector target = XMVector4Transform(XMVectorSet(u, -v, 1.0f, 1.0f), invProjMtx);
+                Ray ray{};
+                ray.origin = origin;
+                XMStoreFloat3(&ray.direction, XMVector3Normalize(XMVector3TransformNormal(target, invViewMtx)));
+                ray.tMax = RayTMax;
+                Float3 color = PathTrace<LightCount>(param, maxPathDepth, ray, seed);
+                accum.x += (std::max)(color.x, 0.0f);
+                accum.y += (std::max)(color.y, 0.0f);
+                accum.z += (std::max)(color.z, 0.0f);
+                accum.w += 1.0f;
+            }
+            m_accumBuffer[bufferOffset] = accum;
+            m_seedBuffer[bufferOffset] = seed;
+
+            // シェーダーの出力 (pow(col, 2.2) をUNORMへ変換) と揃える
+            float invCount = 1.0f / (std::max)(accum.w, 1.0f);
+            const float col[3] = { accum.x * invCount, accum.y * invCount, accum.z * invCount };
+            auto dst = &m_output[bufferOffset * 4];
+            for (int c = 0; c < 3; ++c)
+            {
+                dst[c] = uint8_t(std::clamp(std::pow(col[c], 2.2f), 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            dst[3] = 255;
+        }
+    }
+}
+
+template<uint32_t LightCount>
+Float3 CpuBackend::PathTrace(const FrameParam& param, uint32_t maxPathDepth, Ray ray, uint32_t& seed) const
+{
+    Vector color = XMVectorZero();
+    Vector attenuation = XMVectorSplatOne();
+    for (uint32_t depth = 0; depth < maxPathDepth; ++depth)
+    {
+        // ロシアンルーレット
+        float p = (std::min)((std::max)((std::max)(XMVectorGetX(attenuation), XMVectorGetY(attenuation)), XMVectorGetZ(attenuation)), 1.0f);
+        if (p <= 0.0f || Rand(seed) > p)
+        {
+            break;
+        }
+        attenuation /= p;
+
+        Hit hit{};
+        bool isHit = Intersect(ray, hit);
+        Vector origin = XMLoadFloat3(&ray.origin);
+        Vector dir = XMLoadFloat3(&ray.direction);
+
+        // 光源 (解析的な球) にヒットした場合はトレースを終了 (直接光は光源サンプリングで加算済み)
+        if constexpr (LightCount > 0)
+        {
+            float lightT = isHit ? hit.t : ray.tMax;
+            int hitLight = -1;
+            for (uint32_t i = 0; i < LightCount; ++i)
+            {
+                float t = IntersectSphere(origin, dir, param.lights[i], lightT);
+                if (t < lightT)
+                {
+                    lightT = t;
+                    hitLight = int(i);
+                }
+            }
+            if (hitLight >= 0)
+            {
+                if (depth == 0)
+                {
+                    color = XMLoadFloat3(&param.lights[hitLight].color);
+                }
+                break;
+            }
+        }
+
+        if (!isHit)
+        {
+            // 背景 (missシェーダーと同じトーンマップ)
+            if (m_environment)
+            {
+                Float3 radiance = m_environment(ray.direction);
+                Vector bg = XMLoadFloat3(&radiance);
+                bg = bg / (bg + XMVectorSplatOne());
+                bg = XMVectorPow(bg, XMVectorReplicate(1.0f / 2.2f));
+                color += bg * attenuation;
+            }
+            break;
+        }
+
+        Vector pos = origin + dir * hit.t;
+        Vector norm = XMLoadFloat3(&hit.normal);
+        if (XMVectorGetX(XMVector3Dot(norm, dir)) > 0.0f)
+        {
+            norm = -norm;
+        }
+        Vector diffuse = XMLoadFloat3(&hit.diffuse);
+        Vector offsetPos = pos + norm * RayOffset;
+
+        // 光源サンプリング
+        if constexpr (LightCount > 0)
+        {
+            uint32_t index = (std::min)(uint32_t(Rand(seed) * LightCount), LightCount - 1);
+            const auto& light = param.lights[index];
+            Vector lightPos = SampleSphere(seed, light);
+            Vector lightNorm = XMVector3Normalize(lightPos - XMLoadFloat3(&light.center));
+            Vector toLight = lightPos - offsetPos;
+            float lightDist = XMVectorGetX(XMVector3Length(toLight));
+            Vector lightDir = toLight / lightDist;
+            float cos1 = XMVectorGetX(XMVector3Dot(norm, lightDir));
+            Float3 lightDirF;
+            XMStoreFloat3(&lightDirF, lightDir);
+            Float3 offsetPosF;
+            XMStoreFloat3(&offsetPosF, offsetPos);
+            if (cos1 > 0.0f && !IsOccluded(offsetPosF, lightDirF, lightDist - RayOffset))
+            {
+                float cos2 = std::abs(XMVectorGetX(XMVector3Dot(lightNorm, -lightDir)));
+                float G = cos1 * cos2 / (lightDist * lightDist);
+                // 球の表面積に対する一様サンプリングを光源数で割った確率密度
+                float pdf = 1.0f / (4.0f * XM_PI * light.radius * light.radius) / float(LightCount);
+                Vector intensity = XMLoadFloat3(&light.color) * light.intensity;
+                color += attenuation * diffuse * (XM_1DIVPI * G / pdf) * intensity;
+            }
+        }
+
+        // 余弦に比例した方向のサンプリング (拡散反射の係数は余弦とpdfで打ち消し合う)
+        Vector reflectDir = XMVector3Normalize(ApplyZToN(SampleHemisphereCos(seed), norm));
+        attenuation *= diffuse;
+        XMStoreFloat3(&ray.origin, offsetPos);
+        XMStoreFloat3(&ray.direction, reflectDir);
+        ray.tMax = RayTMax;
+    }
+    Float3 result;
+    XMStoreFloat3(&result, color);
+    return result;
+}
+
+/// <summary>
+/// 最も近い交差の取得
+/// インスタンスのBVHを辿り、各インスタンスではレイをジオメトリ空間へ変換して判定する
+/// 方向は正規化しないため、距離はワールド空間と共通になる
+/// </summary>
+bool CpuBackend::Intersect(const Ray& ray, Hit& hit) const
+{
+    float tMax = ray.tMax;
+    bool isHit = false;
+    Vector worldOrigin = XMLoadFloat3(&ray.origin);
+    Vector worldDir = XMLoadFloat3(&ray.direction);
+    TraverseBVH(m_instanceNodes, ray.origin, ray.direction, tMax, [&](uint32_t first, uint32_t count)
+    {
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            const auto& instance = m_instances[m_instanceIndices[i]];
+            Ray local{};
+            XMStoreFloat3(&local.origin, XMVector3TransformCoord(worldOrigin, instance.invWorldMtx));
+            XMStoreFloat3(&local.direction, XMVector3TransformNormal(worldDir, instance.invWorldMtx));
+            local.tMax = tMax;
+            Hit localHit{};
+            if (IntersectGeometry(*instance.geometry, local, localHit))
+            {
+                tMax = localHit.t;
+                // 法線は逆転置行列で変換する
+                Vector norm = XMVector3TransformNormal(XMLoadFloat3(&localHit.normal), XMMatrixTranspose(instance.invWorldMtx));
+                XMStoreFloat3(&hit.normal, XMVector3Normalize(norm));
+                hit.diffuse = localHit.diffuse;
+                hit.t = tMax;
+                isHit = true;
+            }
+        }
+    });
+    return isHit;
+}
+
+// 三角形との交差 (Möller-Trumbore)
+bool CpuBackend::IntersectGeometry(const Geometry& geometry, const Ray& ray, Hit& hit) const
+{
+    float tMax = ray.tMax;
+    uint32_t hitTri = UINT32_MAX;
+    Vector origin = XMLoadFloat3(&ray.origin);
+    Vector dir = XMLoadFloat3(&ray.direction);
+    TraverseBVH(geometry.nodes, ray.origin, ray.direction, tMax, [&](uint32_t first, uint32_t count)
+    {
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            auto tri = geometry.triIndices[i];
+            Vector v0 = XMLoadFloat3(&geometry.vertices[tri * 3 + 0]);
+            Vector e1 = XMLoadFloat3(&geometry.vertices[tri * 3 + 1]) - v0;
+            Vector e2 = XMLoadFloat3(&geometry.vertices[tri * 3 + 2]) - v0;
+            Vector pv = XMVector3Cross(dir, e2);
+            float det = XMVectorGetX(XMVector3Dot(e1, pv));
+            if (std::abs(det) < 1e-12f)
+            {
+                continue;
+            }
+            float invDet = 1.0f / det;
+            Vector tv = origin - v0;
+            float u = XMVectorGetX(XMVector3Dot(tv, pv)) * invDet;
+            if (u < 0.0f || u > 1.0f)
+            {
+                continue;
+            }
+            Vector qv = XMVector3Cross(tv, e1);
+            float v = XMVectorGetX(XMVector3Dot(dir, qv)) * invDet;
+            if (v < 0.0f || u + v > 1.0f)
+            {
+                continue;
+            }
+            float t = XMVectorGetX(XMVector3Dot(e2, qv)) * invDet;
+            if (t > RayOffset && t < tMax)
+            {
+                tMax = t;
+                hitTri = tri;
+            }
+        }
+    });
+    if (hitTri == UINT32_MAX)
+    {
+        return false;
+    }
+    Vector v0 = XMLoadFloat3(&geometry.vertices[hitTri * 3 + 0]);
+    Vector e1 = XMLoadFloat3(&geometry.vertices[hitTri * 3 + 1]) - v0;
+    Vector e2 = XMLoadFloat3(&geometry.vertices[hitTri * 3 + 2]) - v0;
+    XMStoreFloat3(&hit.normal, XMVector3Normalize(XMVector3Cross(e1, e2)));
+    hit.diffuse = geometry.diffuses[geometry.diffuseIndices[hitTri]];
+    hit.t = tMax;
+    return true;
+}
+
+bool CpuBackend::IsOccluded(const Float3& origin, const Float3& direction, float distance) const
+{
+    Ray ray{ origin, direction, distance };
+    Hit hit{};
+    return Intersect(ray, hit);
+}
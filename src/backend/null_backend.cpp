@@ -0,0 +1,161 @@
+#include "backend/null_backend.hpp"
+
+#include "utils/print_util.h"
+
+void NullBackend::OnInit(uint32_t width, uint32_t height)
+{
+    m_width = width;
+    m_height = height;
+    Record("OnInit", width, height);
+}
+
+void NullBackend::OnDestroy()
+{
+    Record("OnDestroy");
+    m_bufferSizes.clear();
+    m_geometryCount = 0;
+    m_sceneGeometries.clear();
+    m_hasPipeline = false;
+}
+
+RenderBackend::BufferHandle NullBackend::CreateBuffer(BufferUsage usage, uint64_t size)
+{
+    if (size == 0)
+    {
+        Error(PrintInfoType::RTCAMP10, "サイズ0のバッファは作成できません");
+    }
+    m_bufferSizes.push_back(size);
+    BufferHandle handle = BufferHandle(m_bufferSizes.size());
+    Record("CreateBuffer", uint64_t(usage), size);
+    m_recorder.OnCreate(size);
+    return handle;
+}
+
+void NullBackend::WriteBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t size)
+{
+    auto bufferSize = FindBuffer(buffer);
+    if (!bufferSize || data == nullptr || offset > *bufferSize || size > *bufferSize - offset)
+    {
+        Error(PrintInfoType::RTCAMP10, "バッファの書き込み範囲が不正です: ", buffer);
+    }
+    Record("WriteBuffer", buffer, size);
+    m_recorder.Add(DeviceRecorder::Counter::UploadBytes, size);
+}
+
+void NullBackend::DestroyBuffer(BufferHandle buffer)
+{
+    if (!FindBuffer(buffer))
+    {
+        Error(PrintInfoType::RTCAMP10, "破棄済みまたは無効なバッファです: ", buffer);
+    }
+    m_bufferSizes[buffer - 1] = UINT64_MAX;
+    Record("DestroyBuffer", buffer);
+}
+
+RenderBackend::GeometryHandle NullBackend::BuildGeometry(std::span<const GeometryDesc> geometries)
+{
+    for (const auto& geometry : geometries)
+    {
+        auto positionSize = FindBuffer(geometry.positions);
+        auto indexSize = FindBuffer(geometry.indices);
+        if (!positionSize || !indexSize ||
+            (uint64_t(geometry.vertexOffset) + geometry.vertexCount) * sizeof(Float3) > *positionSize ||
+            (uint64_t(geometry.indexOffset) + geometry.indexCount) * sizeof(uint32_t) > *indexSize ||
+            geometry.indexCount % 3 != 0)
+        {
+            Error(PrintInfoType::RTCAMP10, "ジオメトリの範囲が不正です");
+        }
+    }
+    Record("BuildGeometry", geometries.size());
+    // BLASの作成と構築の実行
+    m_recorder.OnCreate();
+    m_recorder.Add(DeviceRecorder::Counter::Submit);
+    return ++m_geometryCount;
+}
+
+void NullBackend::BuildScene(std::span<const InstanceDesc> instances)
+{
+    for (const auto& instance : instances)
+    {
+        if (instance.geometry == InvalidHandle || instance.geometry > m_geometryCount)
+        {
+            Error(PrintInfoType::RTCAMP10, "インスタンスのジオメトリが不正です: ", instance.geometry);
+        }
+    }
+    m_sceneGeometries.clear();
+    for (const auto& instance : instances)
+    {
+        m_sceneGeometries.push_back(instance.geometry);
+    }
+    Record("BuildScene", instances.size());
+    m_recorder.OnCreate();
+    m_recorder.Add(DeviceRecorder::Counter::Submit);
+}
+
+void NullBackend::UpdateScene(std::span<const InstanceDesc> instances)
+{
+    bool isSameLayout = instances.size() == m_sceneGeometries.size();
+    for (size_t i = 0; isSameLayout && i < instances.size(); ++i)
+    {
+        isSameLayout = instances[i].geometry == m_sceneGeometries[i];
+    }
+    if (!isSameLayout)
+    {
+        Error(PrintInfoType::RTCAMP10, "インスタンスの構成がBuildSceneと一致しません: ", instances.size());
+    }
+    Record("UpdateScene", instances.size());
+    // インスタンスの転送と構築済みのTLASの更新
+    m_recorder.Add(DeviceRecorder::Counter::UploadBytes, instances.size_bytes());
+    m_recorder.Add(DeviceRecorder::Counter::Submit);
+}
+
+void NullBackend::SetEnvironment(EnvironmentFunc environment)
+{
+    Record("SetEnvironment", environment ? 1 : 0);
+}
+
+void NullBackend::CreatePipeline(const ShaderPermutation& permutation)
+{
+    m_hasPipeline = true;
+    Record("CreatePipeline", permutation.lightCount, permutation.maxPathDepth);
+    m_recorder.OnCreate();
+}
+
+void NullBackend::Dispatch(const FrameParam& param)
+{
+    if (!m_hasPipeline)
+    {
+        Error(PrintInfoType::RTCAMP10, "パイプラインが作成されていません");
+    }
+    if (param.lightCount > MaxLightCount)
+    {
+        Error(PrintInfoType::RTCAMP10, "光源の数が上限を超えています: ", param.lightCount);
+    }
+    m_dispatchedSamples += uint64_t(param.sampleCount) * m_width * m_height;
+    Record("Dispatch", param.frame, param.sampleCount);
+    m_recorder.Add(DeviceRecorder::Counter::Submit);
+}
+
+bool NullBackend::Readback(std::vector<uint8_t>& pixels)
+{
+    pixels.assign(size_t(m_width) * m_height * 4, 0);
+    Record("Readback", m_width, m_height);
+    // 読み戻しバッファは保持したものを使う想定で、マップのみを数える
+    m_recorder.Add(DeviceRecorder::Counter::Map);
+    m_recorder.Add(DeviceRecorder::Counter::Unmap);
+    return true;
+}
+
+void NullBackend::Record(const char* name, uint64_t arg0, uint64_t arg1)
+{
+    m_calls.push_back({ name, arg0, arg1 });
+}
+
+const uint64_t* NullBackend::FindBuffer(BufferHandle buffer) const
+{
+    if (buffer == InvalidHandle || buffer > m_bufferSizes.size() || m_bufferSizes[buffer - 1] == UINT64_MAX)
+    {
+        return nullptr;
+    }
+    return &m_bufferSizes[buffer - 1];
+}
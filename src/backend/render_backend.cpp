@@ -0,0 +1,37 @@
+#include "backend/render_backend.hpp"
+#include "backend/cpu_backend.hpp"
+#include "backend/null_backend.hpp"
+
+bool ParseRenderBackendType(const std::string& name, RenderBackendType& type)
+{
+    if (name == "d3d12")
+    {
+        type = RenderBackendType::D3D12;
+    }
+    else if (name == "cpu")
+    {
+        type = RenderBackendType::CPU;
+    }
+    else if (name == "null")
+    {
+        type = RenderBackendType::Null;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<RenderBackend> CreateRenderBackend(RenderBackendType type)
+{
+    switch (type)
+    {
+    case RenderBackendType::CPU:
+        return std::make_unique<CpuBackend>();
+    case RenderBackendType::Null:
+        return std::make_unique<NullBackend>();
+    default:
+        return nullptr;
+    }
+}
@@ -0,0 +1,120 @@
+#include "backend_renderer.hpp"
+
+#include "utils/print_util.h"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+BackendRenderer::BackendRenderer(uint32_t width, uint32_t height, std::unique_ptr<RenderBackend> backend, std::unique_ptr<BackendScene> scene, int maxFrame) :
+    m_width(width),
+    m_height(height),
+    m_maxFrame(maxFrame),
+    m_samplesPerPass(0),
+    // Sceneの既定値と揃える
+    m_maxPathDepth(8),
+    m_maxSPP(80),
+    m_pBackend(std::move(backend)),
+    m_pScene(std::move(scene)),
+    m_frameParam()
+{
+}
+
+BackendRenderer::~BackendRenderer()
+{
+}
+
+int BackendRenderer::Run()
+{
+    if (!m_pBackend || !m_pScene)
+    {
+        return EXIT_FAILURE;
+    }
+    try
+    {
+        OnInit();
+        auto startTime = std::chrono::system_clock::now();
+        for (int frame = 0; frame < m_maxFrame; ++frame)
+        {
+            RenderFrame(frame);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startTime).count();
+        Print(PrintInfoType::RTCAMP10, "描画時間 (sec): ", elapsed * 0.001);
+        if (auto recorder = m_pBackend->GetRecorder())
+        {
+            Print(PrintInfoType::RTCAMP10, recorder->GetReport(0).c_str());
+        }
+        OnDestroy();
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception& e)
+    {
+        OnDestroy();
+        Print(PrintInfoType::RTCAMP10, "エラー終了: ", e.what());
+        return EXIT_FAILURE;
+    }
+}
+
+void BackendRenderer::OnInit()
+{
+    m_pBackend->OnInit(m_width, m_height);
+    m_pScene->Load(*m_pBackend, m_width, m_height, m_frameParam);
+
+    ShaderPermutation permutation{};
+    permutation.lightCount = m_frameParam.lightCount;
+    permutation.maxPathDepth = m_maxPathDepth;
+    m_pBackend->CreatePipeline(permutation);
+
+    // シーン構築の記録は除外し、フレームの描画のみを集計する
+    if (auto recorder = m_pBackend->GetRecorder())
+    {
+        recorder->Reset();
+    }
+    Print(PrintInfoType::RTCAMP10, L"シーン構築 完了");
+}
+
+void BackendRenderer::OnDestroy()
+{
+    m_pScene->Unload(*m_pBackend);
+    m_pBackend->OnDestroy();
+}
+
+/// <summary>
+/// 1フレームの更新, 描画と出力
+/// パス分割の指定がある場合はsamplesPerPassごとに蓄積する
+/// </summary>
+/// <param name="frame"></param>
+void BackendRenderer::RenderFrame(int frame)
+{
+    auto startTime = std::chrono::system_clock::now();
+    m_pScene->Update(*m_pBackend, frame, m_maxFrame, m_frameParam);
+    m_frameParam.frame = uint32_t(frame);
+    m_frameParam.maxSPP = m_maxSPP;
+    m_frameParam.maxPathDepth = m_maxPathDepth;
+    uint32_t samplesPerPass = m_samplesPerPass > 0 ? m_samplesPerPass : m_maxSPP;
+    for (uint32_t sampleOffset = 0; sampleOffset < m_maxSPP; sampleOffset += samplesPerPass)
+    {
+        m_frameParam.sampleOffset = sampleOffset;
+        m_frameParam.sampleCount = (std::min)(samplesPerPass, m_maxSPP - sampleOffset);
+        m_pBackend->Dispatch(m_frameParam);
+    }
+
+    // 読み戻し先はフレーム間で使い回す
+    if (!m_pBackend->Readback(m_pixels))
+    {
+        Error(PrintInfoType::RTCAMP10, "描画結果の読み戻しに失敗しました: ", frame);
+    }
+    if (m_frameOutput)
+    {
+        m_frameOutput(frame, m_pixels.data(), m_width, m_height);
+    }
+    if (auto recorder = m_pBackend->GetRecorder())
+    {
+        recorder->EndFrame(frame);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startTime).count();
+    std::ostringstream timeOSS;
+    timeOSS << "Frame: " << std::setw(3) << std::setfill('0') << frame << " | " << elapsed * 0.001 << "(sec)";
+    Print(PrintInfoType::RTCAMP10, timeOSS.str().c_str());
+}
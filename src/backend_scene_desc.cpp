@@ -0,0 +1,100 @@
+#include "backend_scene_desc.hpp"
+#include "utils/print_util.h"
+
+#include <algorithm>
+#include <cstring>
+
+BackendSceneDesc::BackendSceneDesc()
+{
+    std::fill(std::begin(m_targetInstances), std::end(m_targetInstances), -1);
+}
+
+/// <summary>
+/// シーンの構築
+/// アクターはシーン記述の初期配置 (Sceneと同じ変換) でTLASに配置する
+/// </summary>
+void BackendSceneDesc::Load(RenderBackend& backend, uint32_t width, uint32_t height, RenderBackend::FrameParam& param)
+{
+    SceneDesc desc{};
+    LoadDesc(desc);
+    if (desc.lights.size() > RenderBackend::MaxLightCount)
+    {
+        Error(PrintInfoType::RTCAMP10, "光源の数が上限を超えています: ", desc.lights.size());
+    }
+    m_animation.OnInit(desc, float(width) / float(height));
+
+    // 背景
+    LoadBackground(backend, desc.background);
+
+    // アクター
+    m_instances.clear();
+    std::fill(std::begin(m_targetInstances), std::end(m_targetInstances), -1);
+    for (const auto& actorDesc : desc.actors)
+    {
+        auto geometry = LoadModel(backend, actorDesc.model);
+        // 演出で動かすアクターはインスタンスが1つのもののみ (SceneAnimationと同じ)
+        if (actorDesc.instances.size() == 1)
+        {
+            for (uint32_t i = 0; i < SceneAnimation::TargetCount; ++i)
+            {
+                if (actorDesc.name == SceneAnimation::GetTargetName(SceneAnimation::Target(i)))
+                {
+                    m_targetInstances[i] = int(m_instances.size());
+                }
+            }
+        }
+        for (const auto& transform : actorDesc.instances)
+        {
+            RenderBackend::InstanceDesc instance{};
+            instance.geometry = geometry;
+            XMStoreFloat3x4(&instance.transform, SceneAnimation::MakeTransform(transform).worldMtx);
+            m_instances.push_back(instance);
+        }
+    }
+    backend.BuildScene(m_instances);
+
+    WriteFrameParam(m_animation.GetState(), param);
+}
+
+/// <summary>
+/// フレームの更新
+/// 演出で動かすアクターの姿勢が変化した場合のみTLASを更新する
+/// </summary>
+void BackendSceneDesc::Update(RenderBackend& backend, int frame, int maxFrame, RenderBackend::FrameParam& param)
+{
+    const auto& state = m_animation.Seek(frame, maxFrame);
+    bool isMoved = false;
+    for (uint32_t i = 0; i < SceneAnimation::TargetCount; ++i)
+    {
+        if (m_targetInstances[i] < 0 || !state.targets[i])
+        {
+            continue;
+        }
+        Mtx3x4 transform;
+        XMStoreFloat3x4(&transform, state.targets[i]->worldMtx);
+        auto& instance = m_instances[m_targetInstances[i]];
+        if (memcmp(&transform, &instance.transform, sizeof(Mtx3x4)) != 0)
+        {
+            instance.transform = transform;
+            isMoved = true;
+        }
+    }
+    if (isMoved)
+    {
+        backend.UpdateScene(m_instances);
+    }
+
+    WriteFrameParam(state, param);
+}
+
+void BackendSceneDesc::WriteFrameParam(const SceneAnimation::State& state, RenderBackend::FrameParam& param) const
+{
+    XMStoreFloat4x4(&param.invViewMtx, XMMatrixInverse(nullptr, state.camera.GetViewMatrix()));
+    XMStoreFloat4x4(&param.invProjMtx, XMMatrixInverse(nullptr, state.camera.GetProjMatrix()));
+    for (uint32_t i = 0; i < uint32_t(state.lights.size()); ++i)
+    {
+        const auto& light = state.lights[i];
+        param.lights[i] = { light.center, light.radius, light.color, light.intensity };
+    }
+    param.lightCount = uint32_t(state.lights.size());
+}
@@ -0,0 +1,77 @@
+#include "backend_scene_file.hpp"
+
+BackendSceneFile::BackendSceneFile(const std::wstring& sceneFile) :
+    m_sceneFile(sceneFile)
+{
+}
+
+void BackendSceneFile::LoadDesc(SceneDesc& desc)
+{
+    if (!LoadSceneDesc(m_sceneFile, desc))
+    {
+        std::wstring err = L"シーンファイルの読み込みに失敗しました: " + m_sceneFile;
+        Error(PrintInfoType::RTCAMP10, err);
+    }
+}
+
+void BackendSceneFile::LoadBackground(RenderBackend& backend, const std::wstring& fileName)
+{
+    if (!m_envMap.Load(fileName))
+    {
+        std::wstring err = L"HDRテクスチャのロードに失敗しました: " + fileName;
+        Error(PrintInfoType::RTCAMP10, err);
+    }
+    backend.SetEnvironment([this](const Float3& dir) { return m_envMap.Evaluate(dir); });
+}
+
+void BackendSceneFile::Unload(RenderBackend& backend)
+{
+    for (auto buffer : m_buffers)
+    {
+        backend.DestroyBuffer(buffer);
+    }
+    m_buffers.clear();
+    m_geometries.clear();
+    m_envMap.Close();
+}
+
+RenderBackend::GeometryHandle BackendSceneFile::LoadModel(RenderBackend& backend, const std::wstring& fileName)
+{
+    auto geometryItr = m_geometries.find(fileName);
+    if (geometryItr != m_geometries.end())
+    {
+        return geometryItr->second;
+    }
+
+    auto model = m_modelCache.LoadWithoutUpload(fileName);
+    auto positions = model->GetPositions();
+    auto indices = model->GetIndices();
+    auto positionBuffer = backend.CreateBuffer(RenderBackend::BufferUsage::Vertex, positions.size_bytes());
+    m_buffers.push_back(positionBuffer);
+    backend.WriteBuffer(positionBuffer, 0, positions.data(), positions.size_bytes());
+    auto indexBuffer = backend.CreateBuffer(RenderBackend::BufferUsage::Index, indices.size_bytes());
+    m_buffers.push_back(indexBuffer);
+    backend.WriteBuffer(indexBuffer, 0, indices.data(), indices.size_bytes());
+
+    // スキンを持つモデルはバインドポーズのまま描画する
+    std::vector<Model::PrimitiveInfo> primitives;
+    model->GetPrimitiveInfos(primitives);
+    std::vector<RenderBackend::GeometryDesc> geometryDescs;
+    geometryDescs.reserve(primitives.size());
+    for (const auto& primitive : primitives)
+    {
+        RenderBackend::GeometryDesc desc{};
+        desc.positions = positionBuffer;
+        desc.vertexOffset = primitive.vertexStart;
+        desc.vertexCount = primitive.vertexCount;
+        desc.indices = indexBuffer;
+        desc.indexOffset = primitive.indexStart;
+        desc.indexCount = primitive.indexCount;
+        desc.transform = primitive.nodeMtx;
+        desc.diffuse = primitive.diffuse;
+        geometryDescs.push_back(desc);
+    }
+    auto geometry = backend.BuildGeometry(geometryDescs);
+    m_geometries[fileName] = geometry;
+    return geometry;
+}
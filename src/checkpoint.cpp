@@ -0,0 +1,232 @@
+#include "checkpoint.hpp"
+
+namespace
+{
+    const size_t HeaderAlignment = 256;
+}
+
+Checkpoint::Checkpoint(std::unique_ptr<Device>& device, const std::wstring& path, UINT width, UINT height) :
+    m_pDevice(device),
+    m_path(path),
+    m_width(width),
+    m_height(height),
+    m_hFile(INVALID_HANDLE_VALUE),
+    m_hMapping(nullptr),
+    m_waitEvent(nullptr),
+    m_pMapped(nullptr)
+{
+}
+
+Checkpoint::~Checkpoint()
+{
+    Wait();
+    Close();
+}
+
+/// <summary>
+/// チェックポイントファイルのオープン
+/// </summary>
+/// <param name="resume">既存のファイルを読み込むか</param>
+/// <returns>resume時は有効なチェックポイントが存在する場合にtrue</returns>
+bool Checkpoint::Open(bool resume)
+{
+    Close();
+    m_hFile = CreateFileW(
+        m_path.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        resume ? OPEN_ALWAYS : CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (m_hFile == INVALID_HANDLE_VALUE)
+    {
+        Error(PrintInfoType::RTCAMP10, L"チェックポイントファイルを開けません: " + m_path);
+        return false;
+    }
+
+    // 既存のファイルと解像度が異なる場合は作り直す
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(m_hFile, &fileSize);
+    bool isNewFile = UINT64(fileSize.QuadPart) != GetFileSize();
+
+    auto mappingSize = UINT64(GetFileSize());
+    m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READWRITE, DWORD(mappingSize >> 32), DWORD(mappingSize & 0xFFFFFFFF), nullptr);
+    if (m_hMapping == nullptr)
+    {
+        Error(PrintInfoType::RTCAMP10, L"チェックポイントファイルのマッピングに失敗しました: " + m_path);
+        return false;
+    }
+    m_pMapped = MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (m_pMapped == nullptr)
+    {
+        Error(PrintInfoType::RTCAMP10, L"チェックポイントファイルのマッピングに失敗しました: " + m_path);
+        return false;
+    }
+    m_waitEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+
+    auto header = GetHeader();
+    bool isValid = !isNewFile &&
+        header->magic == Magic &&
+        header->version == Version &&
+        header->width == m_width &&
+        header->height == m_height &&
+        header->activeSlot < 2 &&
+        header->slots[header->activeSlot].sequence > 0;
+    if (!isValid)
+    {
+        memset(header, 0, sizeof(Header));
+        header->magic = Magic;
+        header->version = Version;
+        header->width = m_width;
+        header->height = m_height;
+        header->slots[0].frame = -1;
+        header->slots[1].frame = -1;
+        FlushViewOfFile(header, sizeof(Header));
+    }
+    return resume && isValid;
+}
+
+bool Checkpoint::GetLatest(State& state) const
+{
+    auto header = GetHeader();
+    if (header == nullptr)
+    {
+        return false;
+    }
+    const auto& slot = header->slots[header->activeSlot];
+    if (slot.sequence == 0)
+    {
+        return false;
+    }
+    auto data = GetSlotData(header->activeSlot);
+    state.frame = slot.frame;
+    state.sampleCount = slot.sampleCount;
+    state.accum = reinterpret_cast<const Float4*>(data);
+    state.seed = reinterpret_cast<const uint32_t*>(data + sizeof(Float4) * m_width * m_height);
+    return true;
+}
+
+bool Checkpoint::IsBusy() const
+{
+    return m_writeTask.valid() && m_writeTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void Checkpoint::WriteAsync(
+    ComPtr<ID3D12Resource> readback,
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& accumFootprint,
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& seedFootprint,
+    ComPtr<ID3D12Fence> fence,
+    UINT64 fenceValue,
+    int frame,
+    UINT sampleCount)
+{
+    Wait();
+    m_writeTask = std::async(std::launch::async, &Checkpoint::Write, this, readback, accumFootprint, seedFootprint, fence, fenceValue, frame, sampleCount);
+}
+
+void Checkpoint::Wait()
+{
+    if (m_writeTask.valid())
+    {
+        m_writeTask.get();
+    }
+}
+
+/// <summary>
+/// チェックポイントの書き込み (ワーカースレッド)
+/// </summary>
+void Checkpoint::Write(
+    ComPtr<ID3D12Resource> readback,
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT accumFootprint,
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT seedFootprint,
+    ComPtr<ID3D12Fence> fence,
+    UINT64 fenceValue,
+    int frame,
+    UINT sampleCount)
+{
+    // GPU側のコピー完了を待機
+    if (fence->GetCompletedValue() < fenceValue)
+    {
+        fence->SetEventOnCompletion(fenceValue, m_waitEvent);
+        WaitForSingleObject(m_waitEvent, INFINITE);
+    }
+
+    auto header = GetHeader();
+    auto slot = 1 - header->activeSlot;
+    auto dst = GetSlotData(slot);
+
+    // 行ピッチを詰めてコピー
+    D3D12_RANGE readRange{ 0, size_t(readback->GetDesc().Width) };
+    auto src = static_cast<const uint8_t*>(m_pDevice->Map(readback, &readRange));
+    if (src == nullptr)
+    {
+        Error(PrintInfoType::RTCAMP10, L"チェックポイントの読み戻しに失敗しました: " + m_path);
+    }
+    auto copyRows = [&](const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint, size_t pixelSize)
+    {
+        auto rowBytes = pixelSize * m_width;
+        for (UINT y = 0; y < m_height; ++y)
+        {
+            memcpy(dst, src + footprint.Offset + size_t(footprint.Footprint.RowPitch) * y, rowBytes);
+            dst += rowBytes;
+        }
+    };
+    copyRows(accumFootprint, sizeof(Float4));
+    copyRows(seedFootprint, sizeof(uint32_t));
+    D3D12_RANGE writeRange{ 0, 0 };
+    m_pDevice->Unmap(readback, &writeRange);
+    FlushViewOfFile(GetSlotData(slot), GetSlotSize());
+
+    // データの書き込み完了後にアクティブスロットを切り替える
+    auto& slotInfo = header->slots[slot];
+    slotInfo.frame = frame;
+    slotInfo.sampleCount = sampleCount;
+    slotInfo.sequence = header->slots[header->activeSlot].sequence + 1;
+    FlushViewOfFile(header, sizeof(Header));
+    header->activeSlot = slot;
+    FlushViewOfFile(header, sizeof(Header));
+    FlushFileBuffers(m_hFile);
+}
+
+uint8_t* Checkpoint::GetSlotData(uint32_t slot) const
+{
+    auto base = static_cast<uint8_t*>(m_pMapped);
+    return base + ROUND_UP(sizeof(Header), HeaderAlignment) + GetSlotSize() * slot;
+}
+
+size_t Checkpoint::GetSlotSize() const
+{
+    return (sizeof(Float4) + sizeof(uint32_t)) * size_t(m_width) * m_height;
+}
+
+size_t Checkpoint::GetFileSize() const
+{
+    return ROUND_UP(sizeof(Header), HeaderAlignment) + GetSlotSize() * 2;
+}
+
+void Checkpoint::Close()
+{
+    if (m_pMapped)
+    {
+        FlushViewOfFile(m_pMapped, 0);
+        UnmapViewOfFile(m_pMapped);
+        m_pMapped = nullptr;
+    }
+    if (m_hMapping)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    if (m_waitEvent)
+    {
+        CloseHandle(m_waitEvent);
+        m_waitEvent = nullptr;
+    }
+}
@@ -1,11 +1,12 @@
 #include "device.hpp"
 
+#include <algorithm>
+
 Device::Device() :
     m_fenceValueArr(),
     m_rtvDescSize(0),
     m_dsvDescSize(0),
     m_heapDescSize(0),
-    m_heapAllocateIndex(0),
     m_viewport(), 
     m_scissorRect()
 {
@@ -86,6 +87,9 @@ bool Device::OnInit()
         return false;
     }
     
+    // バッファのサブアロケーター
+    m_pAllocator = std::make_shared<GpuAllocator>(m_pD3D12Device5);
+
     // DXRに対応しているかの確認
     D3D12_FEATURE_DATA_D3D12_OPTIONS5 options5{};
     hr = m_pD3D12Device5->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS5, &options5, UINT(sizeof(options5)));
@@ -138,6 +142,7 @@ bool Device::OnInit()
         return false;
     }
     m_heapDescSize = m_pD3D12Device5->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    m_descriptorAllocator.Reset(ShaderResourceViewMax);
     // コマンドアロケーターの準備
     for (UINT i = 0; i < BackBufferCount; ++i)
     {
@@ -153,17 +158,56 @@ bool Device::OnInit()
     auto cmd = CreateCommandList();
     cmd->Close();
 
+    // フレームバッファの数だけフェンスを作成 (スワップチェインがない場合もフレームの切り替えに使用)
+    for (UINT i = 0; i < BackBufferCount; ++i)
+    {
+        m_fenceValueArr[i] = 0;
+        hr = m_pD3D12Device5->CreateFence(
+            m_fenceValueArr[i],
+            D3D12_FENCE_FLAG_NONE,
+            IID_PPV_ARGS(m_pFrameFence1Arr[i].ReleaseAndGetAddressOf())
+        );
+        if (FAILED(hr))
+        {
+            Error(PrintInfoType::D3D12, L"フレームバッファのフェンス作成に失敗しました");
+            return false;
+        }
+    }
+
     // フェンスの作成
-    CreateFence();
+    m_pQueueFence = CreateFence();
+    m_queueFenceValue = 0;
 
     m_fenceEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
     m_waitEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+
+    // ステージングリングの作成 (永続的にマップしておく)
+    m_pUploadRing = CreateBuffer(
+        size_t(UploadRingSize),
+        D3D12_RESOURCE_FLAG_NONE,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        D3D12_HEAP_TYPE_UPLOAD,
+        L"UploadRing"
+    );
+    D3D12_RANGE readRange{ 0, 0 };
+    void* mapped = Map(m_pUploadRing, &readRange);
+    if (mapped == nullptr)
+    {
+        Error(PrintInfoType::D3D12, L"ステージングリングのマップに失敗しました");
+        return false;
+    }
+    m_pUploadRingMapped = static_cast<uint8_t*>(mapped);
+    m_uploadRing.Reset(UploadRingSize);
     return true;
 }
 
 void Device::OnDestroy()
 {
     WaitForGpu();
+    m_retiredUploads.clear();
+    m_pUploadRingMapped = nullptr;
+    m_pUploadRing.Reset();
+    m_pQueueFence.Reset();
     CloseHandle(m_fenceEvent);
     m_fenceEvent = 0;
     CloseHandle(m_waitEvent);
@@ -174,6 +218,8 @@ void Device::OnDestroy()
     m_pDepthStencil.Reset();
     m_pSwapChain3.Reset();
     m_pCmdQueue.Reset();
+    // 残っているリソースがヒープを参照しているため、アロケーター自体はリソースと共に破棄される
+    m_pAllocator.reset();
     m_pD3D12Device5.Reset();
 }
 
@@ -215,22 +261,6 @@ bool Device::CreateSwapChain(UINT width, UINT height, HWND hwnd)
         }
         // スワップチェインの変換
         swapChain.As(&m_pSwapChain3);
-
-        // フレームバッファの数だけフェンスを作成
-        for (UINT i = 0; i < BackBufferCount; ++i)
-        {
-            m_fenceValueArr[i] = 0;
-            hr = m_pD3D12Device5->CreateFence(
-                m_fenceValueArr[i], 
-                D3D12_FENCE_FLAG_NONE,
-                IID_PPV_ARGS(m_pFrameFence1Arr[i].ReleaseAndGetAddressOf())
-            );
-            if (FAILED(hr))
-            {
-                Error(PrintInfoType::D3D12, L"フレームバッファのフェンス作成に失敗しました");
-                return false;
-            }
-        }
     }
     
     // RTVの作成
@@ -317,9 +347,13 @@ bool Device::CreateSwapChain(UINT width, UINT height, HWND hwnd)
 }
 
 ComPtr<ID3D12GraphicsCommandList4> Device::CreateCommandList()
+{
+    return CreateCommandList(GetCurrentCommandAllocator());
+}
+
+ComPtr<ID3D12GraphicsCommandList4> Device::CreateCommandList(ComPtr<ID3D12CommandAllocator> allocator)
 {
     ComPtr<ID3D12GraphicsCommandList4> cmdList4;
-    auto allocator = GetCurrentCommandAllocator();
     m_pD3D12Device5->CreateCommandList(
         0,
         D3D12_COMMAND_LIST_TYPE_DIRECT,
@@ -327,9 +361,40 @@ ComPtr<ID3D12GraphicsCommandList4> Device::CreateCommandList()
         nullptr,
         IID_PPV_ARGS(cmdList4.ReleaseAndGetAddressOf())
     );
+    m_recorder.OnCreate();
     return cmdList4;
 }
 
+ComPtr<ID3D12CommandAllocator> Device::CreateCommandAllocator()
+{
+    ComPtr<ID3D12CommandAllocator> allocator;
+    HRESULT hr = m_pD3D12Device5->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(allocator.ReleaseAndGetAddressOf())
+    );
+    if (FAILED(hr))
+    {
+        Error(PrintInfoType::D3D12, L"コマンドアロケータの作成に失敗しました");
+    }
+    m_recorder.OnCreate();
+    return allocator;
+}
+
+void Device::ResetCommandAllocator(ComPtr<ID3D12CommandAllocator> allocator)
+{
+    allocator->Reset();
+}
+
+void Device::ResetCommandList(ComPtr<ID3D12GraphicsCommandList4> cmdList, ComPtr<ID3D12CommandAllocator> allocator)
+{
+    cmdList->Reset(allocator.Get(), nullptr);
+}
+
+void Device::CloseCommandList(ComPtr<ID3D12GraphicsCommandList4> cmdList)
+{
+    cmdList->Close();
+}
+
 ComPtr<ID3D12Fence1> Device::CreateFence()
 {
     ComPtr<ID3D12Fence1> fence1;
@@ -338,6 +403,7 @@ ComPtr<ID3D12Fence1> Device::CreateFence()
         D3D12_FENCE_FLAG_NONE,
         IID_PPV_ARGS(fence1.ReleaseAndGetAddressOf())
     );
+    m_recorder.OnCreate();
     return fence1;
 }
 
@@ -365,16 +431,24 @@ ComPtr<ID3D12Resource> Device::CreateBuffer(size_t size, D3D12_RESOURCE_FLAGS fl
     resDesc.Flags = flags;
 
     // リソースの生成
-    HRESULT hr;
+    // 小さなバッファは共有ヒープから切り出し、収まらない場合はコミットリソースで作成
+    HRESULT hr = S_OK;
     ComPtr<ID3D12Resource> resource;
-    hr = m_pD3D12Device5->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &resDesc,
-        initialState,
-        nullptr,
-        IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
-    );
+    if (m_pAllocator && size <= PlacedBufferMaxSize)
+    {
+        resource = m_pAllocator->CreateBuffer(resDesc, heapType, initialState);
+    }
+    if (resource == nullptr)
+    {
+        hr = m_pD3D12Device5->CreateCommittedResource(
+            &heapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &resDesc,
+            initialState,
+            nullptr,
+            IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
+        );
+    }
 
     if (FAILED(hr))
     {
@@ -385,6 +459,7 @@ ComPtr<ID3D12Resource> Device::CreateBuffer(size_t size, D3D12_RESOURCE_FLAGS fl
     {
         resource->SetName(name);
     }
+    m_recorder.OnCreate(size);
     return resource;
 }
 
@@ -428,131 +503,10 @@ ComPtr<ID3D12Resource> Device::CreateTexture2D(UINT width, UINT height, DXGI_FOR
     {
         Error(PrintInfoType::D3D12, L"Texture2Dの作成に失敗しました");
     }
+    m_recorder.OnCreate();
     return resource;
 }
 
-ComPtr<ID3D12Resource> Device::CreateImageBuffer(ComPtr<ID3D12Resource> pSource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState)
-{
-    auto srcDesc = pSource->GetDesc();
-    UINT numRows = 0;
-    UINT64 rowSizeInBytes = 0;
-    UINT64 totalBytes = 0;
-    m_pD3D12Device5->GetCopyableFootprints(
-        &srcDesc,
-        0,
-        1,
-        0,
-        nullptr,
-        &numRows,
-        &rowSizeInBytes,
-        &totalBytes
-    );
-    UINT64 srcPitch = (rowSizeInBytes + 255) & ~0xFFu;
-
-    // Readback用バッファの設定
-    const CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_READBACK);
-    D3D12_RESOURCE_DESC bufferDesc = {};
-    bufferDesc.DepthOrArraySize = 1;
-    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    bufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-    bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
-    bufferDesc.Height = 1;
-    bufferDesc.Width = srcPitch * srcDesc.Height;
-    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    bufferDesc.MipLevels = 1;
-    bufferDesc.SampleDesc.Count = 1;
-
-
-    // Readback用バッファの作成
-    ComPtr<ID3D12Resource> imageBuffer;
-    HRESULT hr;
-    hr = m_pD3D12Device5->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &bufferDesc,
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        nullptr,
-        IID_PPV_ARGS(imageBuffer.ReleaseAndGetAddressOf())
-    );
-    if (FAILED(hr))
-    {
-        Error(PrintInfoType::D3D12, L"画像バッファの作成に失敗しました");
-    }
-    if (imageBuffer != nullptr)
-    {
-        imageBuffer->SetName(L"Image Buffer");
-    }
-
-    // コマンドリストの作成
-    ComPtr<ID3D12CommandAllocator> pCmdAllocator;
-    hr = m_pD3D12Device5->CreateCommandAllocator(
-        D3D12_COMMAND_LIST_TYPE_DIRECT, 
-        IID_PPV_ARGS(pCmdAllocator.GetAddressOf())
-    );
-    if (FAILED(hr))
-    {
-        Error(PrintInfoType::D3D12, L"コマンドアロケータの作成に失敗しました");
-    }
-    if (pCmdAllocator != nullptr)
-    {
-        pCmdAllocator->SetName(L"Image Buffer - CommandAllocator");
-    }
-    ComPtr<ID3D12GraphicsCommandList4> pCmdList4;
-    m_pD3D12Device5->CreateCommandList(
-        0,
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-        pCmdAllocator.Get(),
-        nullptr,
-        IID_PPV_ARGS(pCmdList4.ReleaseAndGetAddressOf())
-    );
-    if (FAILED(hr))
-    {
-        Error(PrintInfoType::D3D12, L"コマンドリストの作成に失敗しました");
-    }
-    if (pCmdList4 != nullptr)
-    {
-        pCmdList4->SetName(L"Image Buffer - CommandList");
-    }
-    auto barrierToCopySrc = CD3DX12_RESOURCE_BARRIER::Transition(
-        pSource.Get(),
-        beforeState,
-        D3D12_RESOURCE_STATE_COPY_SOURCE
-    );
-    pCmdList4->ResourceBarrier(1, &barrierToCopySrc);
-
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT bufferFootprint = {};
-    bufferFootprint.Footprint.Width = static_cast<UINT>(srcDesc.Width);
-    bufferFootprint.Footprint.Height = srcDesc.Height;
-    bufferFootprint.Footprint.Depth = 1;
-    bufferFootprint.Footprint.RowPitch = static_cast<UINT>(srcPitch);
-    bufferFootprint.Footprint.Format = srcDesc.Format;
-
-    // 画像バッファにテクスチャコピー
-    const CD3DX12_TEXTURE_COPY_LOCATION copyDest(imageBuffer.Get(), bufferFootprint);
-    const CD3DX12_TEXTURE_COPY_LOCATION copySrc(pSource.Get(), 0);
-    pCmdList4->CopyTextureRegion(&copyDest, 0, 0, 0, &copySrc, nullptr);
-
-    auto barrierToAfterState = CD3DX12_RESOURCE_BARRIER::Transition(
-        pSource.Get(),
-        D3D12_RESOURCE_STATE_COPY_SOURCE,
-        afterState
-    );
-    pCmdList4->ResourceBarrier(1, &barrierToAfterState);
-    // コマンド終了
-    pCmdList4->Close();
-    // コマンド実行
-    ExecuteCommandList(pCmdList4);
-
-    // GPU待機
-    auto waitFence = CreateFence();
-    UINT64 fenceValue = 1;
-    waitFence->SetEventOnCompletion(fenceValue, m_waitEvent);
-    m_pCmdQueue->Signal(waitFence.Get(), fenceValue);
-    WaitForSingleObject(m_waitEvent, INFINITE);
-
-    return imageBuffer;
-}
-
 ComPtr<ID3D12Resource> Device::InitializeBuffer(size_t size, const void* initData, D3D12_RESOURCE_FLAGS flags, D3D12_HEAP_TYPE heapType, const wchar_t* name)
 {
     if (size <= 0)
@@ -634,129 +588,184 @@ void Device::WriteBuffer(ComPtr<ID3D12Resource> resource, const void* pData, siz
     {
         return;
     }
-    void* mapped = nullptr;
     D3D12_RANGE range{ 0, dataSize };
-    HRESULT hr = resource->Map(0, &range, &mapped);
-    if (SUCCEEDED(hr))
+    void* mapped = Map(resource, &range);
+    if (mapped != nullptr)
     {
         memcpy(mapped, pData, dataSize);
-        resource->Unmap(0, &range);
+        m_recorder.Add(DeviceRecorder::Counter::UploadBytes, dataSize);
+        Unmap(resource, &range);
     }
 }
 
+void* Device::Map(ComPtr<ID3D12Resource> resource, const D3D12_RANGE* readRange)
+{
+    void* mapped = nullptr;
+    if (FAILED(resource->Map(0, readRange, &mapped)))
+    {
+        return nullptr;
+    }
+    m_recorder.Add(DeviceRecorder::Counter::Map);
+    return mapped;
+}
+
+void Device::Unmap(ComPtr<ID3D12Resource> resource, const D3D12_RANGE* writtenRange)
+{
+    resource->Unmap(0, writtenRange);
+    m_recorder.Add(DeviceRecorder::Counter::Unmap);
+}
+
 void Device::WriteResource(ComPtr<ID3D12Resource> resource, const void* pData, size_t dataSize)
 {
     if (resource == nullptr)
     {
         return;
     }
-    ComPtr<ID3D12Resource> stagingBuffer;
-    HRESULT hr;
-    const CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-    // リソースの設定
-    D3D12_RESOURCE_DESC resDesc{};
-    resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    resDesc.Width = dataSize;
-    resDesc.Height = 1;
-    resDesc.DepthOrArraySize = 1;
-    resDesc.MipLevels = 1;
-    resDesc.SampleDesc = { 1, 0 };
-    resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    hr = m_pD3D12Device5->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &resDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(stagingBuffer.ReleaseAndGetAddressOf())
-    );
-    if (FAILED(hr))
+    BeginUploadBatch();
+
+    // データをステージングリングへコピー
+    ComPtr<ID3D12Resource> page;
+    UINT64 offset = 0;
+    auto dst = AllocateUpload(dataSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, page, offset);
+    memcpy(dst, pData, dataSize);
+
+    // ステージングリングの内容をリソースにコピー
+    m_uploadBatch.cmdList->CopyBufferRegion(resource.Get(), 0, page.Get(), offset, dataSize);
+    auto& pending = m_uploadBatch.pendingBuffers;
+    if (std::find(pending.begin(), pending.end(), resource) == pending.end())
     {
-        Error(PrintInfoType::D3D12, L"ステージングバッファの作成に失敗しました");
+        pending.push_back(resource);
     }
-    if (stagingBuffer != nullptr)
+
+    EndUploadBatch();
+}
+
+void Device::WriteResource(ComPtr<ID3D12GraphicsCommandList4> cmdList, ComPtr<ID3D12Resource> resource, UINT64 dstOffset, const void* pData, size_t dataSize)
+{
+    if (resource == nullptr || dataSize == 0)
     {
-        stagingBuffer->SetName(L"Staging Buffer");
+        return;
     }
-    // データをステージングバッファへコピー
-    WriteBuffer(stagingBuffer, pData, dataSize);
+    ComPtr<ID3D12Resource> page;
+    UINT64 offset = 0;
+    auto dst = AllocateUpload(dataSize, 4, page, offset);
+    memcpy(dst, pData, dataSize);
+    cmdList->CopyBufferRegion(resource.Get(), dstOffset, page.Get(), offset, dataSize);
+}
 
-    // ステージングバッファの内容をリソースにコピー
-    auto cmd = CreateCommandList();
-    ComPtr<ID3D12Fence> fence = CreateFence();
-    cmd->CopyResource(resource.Get(), stagingBuffer.Get());
-    cmd->Close();
+DynamicBuffer Device::AllocateDynamic(UINT64 size, UINT64 alignment)
+{
+    DynamicBuffer buffer{};
+    buffer.pCpu = AllocateUpload(size, alignment, buffer.resource, buffer.offset);
+    buffer.gpuAddress = buffer.resource->GetGPUVirtualAddress() + buffer.offset;
+    return buffer;
+}
 
-    ExecuteCommandList(cmd);
-    WaitForGpu();
+D3D12_GPU_VIRTUAL_ADDRESS Device::WriteDynamic(const void* pData, size_t dataSize, UINT64 alignment)
+{
+    auto buffer = AllocateDynamic(dataSize, alignment);
+    memcpy(buffer.pCpu, pData, dataSize);
+    return buffer.gpuAddress;
 }
 
-bool Device::CreateConstantBuffer(std::vector<ComPtr<ID3D12Resource>>& resources, UINT size, const wchar_t* name)
+/// <summary>
+/// テクスチャへのサブリソースの書き込み
+/// </summary>
+/// <param name="resource">COPY_DEST状態のテクスチャ</param>
+/// <param name="subresources"></param>
+/// <param name="afterState">コピー後の状態</param>
+void Device::WriteTexture(ComPtr<ID3D12Resource> resource, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources, D3D12_RESOURCE_STATES afterState)
 {
-    size = ROUND_UP(size, 256);
-    resources.resize(BackBufferCount);
-    for (auto& resource : resources)
+    if (resource == nullptr || subresources.empty())
     {
-        resource = CreateBuffer(
-            size,
-            D3D12_RESOURCE_FLAG_NONE,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            D3D12_HEAP_TYPE_UPLOAD
-        );
-        if (resource)
-        {
-            resource->SetName(name);
-        }
-        else
-        {
-            Error(PrintInfoType::D3D12, L"定数バッファの作成に失敗しました");
-            return false;
-        }
+        return;
     }
-    return true;
-}
+    BeginUploadBatch();
 
-DescriptorHeap Device::AllocateDescriptorHeap()
-{
-    DescriptorHeap descriptorHeap{};
-    auto it = m_heapDescMap.find(1);
-    if (it != m_heapDescMap.end())
+    auto numSubresources = UINT(subresources.size());
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresources);
+    std::vector<UINT> numRows(numSubresources);
+    std::vector<UINT64> rowSizes(numSubresources);
+    UINT64 totalBytes = 0;
+    auto resDesc = resource->GetDesc();
+    m_pD3D12Device5->GetCopyableFootprints(&resDesc, 0, numSubresources, 0, layouts.data(), numRows.data(), rowSizes.data(), &totalBytes);
+
+    ComPtr<ID3D12Resource> page;
+    UINT64 offset = 0;
+    auto dst = AllocateUpload(totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, page, offset);
+    for (UINT i = 0; i < numSubresources; ++i)
     {
-        if (!it->second.empty())
+        // 行ピッチをフットプリントに合わせてコピー
+        const auto& layout = layouts[i];
+        const auto& src = subresources[i];
+        for (UINT z = 0; z < layout.Footprint.Depth; ++z)
         {
-            descriptorHeap = it->second.front();
-            it->second.pop_front();
-            return descriptorHeap;
+            auto dstSlice = dst + layout.Offset + UINT64(layout.Footprint.RowPitch) * numRows[i] * z;
+            auto srcSlice = static_cast<const uint8_t*>(src.pData) + src.SlicePitch * z;
+            for (UINT row = 0; row < numRows[i]; ++row)
+            {
+                memcpy(dstSlice + UINT64(layout.Footprint.RowPitch) * row, srcSlice + src.RowPitch * row, size_t(rowSizes[i]));
+            }
         }
+
+        auto placed = layout;
+        placed.Offset += offset;
+        CD3DX12_TEXTURE_COPY_LOCATION dstLocation(resource.Get(), i);
+        CD3DX12_TEXTURE_COPY_LOCATION srcLocation(page.Get(), placed);
+        m_uploadBatch.cmdList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
     }
-    auto cpuHandle = m_pHeap->GetCPUDescriptorHandleForHeapStart();
-    auto gpuHandle = m_pHeap->GetGPUDescriptorHandleForHeapStart();
+    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, afterState);
+    m_uploadBatch.cmdList->ResourceBarrier(1, &barrier);
+
+    EndUploadBatch();
+}
 
-    descriptorHeap = {};
-    auto heapDesc = m_pHeap->GetDesc();
-    if (m_heapAllocateIndex < heapDesc.NumDescriptors)
+DescriptorHeap Device::AllocateDescriptorHeap(UINT count)
+{
+    auto index = m_descriptorAllocator.Allocate(count);
+    if (index == DescriptorAllocator::InvalidIndex)
     {
-        auto offset = m_heapDescSize * m_heapAllocateIndex;
-        cpuHandle.ptr += offset;
-        gpuHandle.ptr += offset;
-        descriptorHeap.heapBaseOffset = offset;
-        descriptorHeap.cpuHandle = cpuHandle;
-        descriptorHeap.gpuHandle = gpuHandle;
-        descriptorHeap.heapType = heapDesc.Type;
-        m_heapAllocateIndex++;
+        Error(PrintInfoType::D3D12, L"ディスクリプタヒープが不足しています: " +
+            std::to_wstring(m_descriptorAllocator.GetAllocatedCount()) + L" / " + std::to_wstring(ShaderResourceViewMax) +
+            L" (要求数: " + std::to_wstring(count) + L")");
     }
+
+    DescriptorHeap descriptorHeap{};
+    auto offset = m_heapDescSize * index;
+    descriptorHeap.heapBaseOffset = offset;
+    descriptorHeap.count = count;
+    descriptorHeap.cpuHandle = m_pHeap->GetCPUDescriptorHandleForHeapStart();
+    descriptorHeap.cpuHandle.ptr += offset;
+    descriptorHeap.gpuHandle = m_pHeap->GetGPUDescriptorHandleForHeapStart();
+    descriptorHeap.gpuHandle.ptr += offset;
+    descriptorHeap.heapType = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     return descriptorHeap;
 }
 
 void Device::DeallocateDescriptorHeap(DescriptorHeap& hescHeap)
 {
-    auto it = m_heapDescMap.find(1);
-    if (it == m_heapDescMap.end())
+    // 未確保または解放済みのディスクリプタは無視する
+    if (!hescHeap.IsValid())
     {
-        m_heapDescMap.insert(std::make_pair(1, std::list<DescriptorHeap>()));
-        it = m_heapDescMap.find(1);
+        return;
     }
-    it->second.push_front(hescHeap);
+    m_descriptorAllocator.Free(hescHeap.heapBaseOffset / m_heapDescSize, hescHeap.count);
+    hescHeap = DescriptorHeap();
+}
+
+DescriptorHeap Device::GetDescriptorInRange(const DescriptorHeap& range, UINT index) const
+{
+    if (index >= range.count)
+    {
+        Error(PrintInfoType::D3D12, L"ディスクリプタの範囲外を参照しています");
+    }
+    auto descriptor = range;
+    auto offset = m_heapDescSize * index;
+    descriptor.heapBaseOffset += offset;
+    descriptor.count = 1;
+    descriptor.cpuHandle.ptr += offset;
+    descriptor.gpuHandle.ptr += offset;
+    return descriptor;
 }
 
 DescriptorHeap Device::CreateSRV(ComPtr<ID3D12Resource> resource, UINT numElements, UINT firstElement, DXGI_FORMAT format)
@@ -811,32 +820,208 @@ D3D12_CPU_DESCRIPTOR_HANDLE  Device::GetCurrentRTVDesc()
     return rtvCPUHandle;
 }
 
+/// <summary>
+/// アップロードバッチの開始
+/// </summary>
+void Device::BeginUploadBatch()
+{
+    if (m_uploadBatch.depth++ > 0)
+    {
+        return;
+    }
+    m_uploadBatch.cmdList = CreateCommandList();
+}
+
+/// <summary>
+/// アップロードバッチの終了
+/// 最も外側の呼び出しでのみコマンドを実行し、完了を待つ (ステージング領域はWaitForGpuで解放される)
+/// </summary>
+void Device::EndUploadBatch()
+{
+    if (m_uploadBatch.depth == 0)
+    {
+        Error(PrintInfoType::D3D12, L"アップロードバッチが開始されていません");
+    }
+    if (--m_uploadBatch.depth > 0)
+    {
+        return;
+    }
+    m_uploadBatch.cmdList->Close();
+    ExecuteCommandList(m_uploadBatch.cmdList);
+    WaitForGpu();
+
+    // バッファは実行完了後にCOMMONへ戻るため、バリアの発行は不要
+    m_uploadBatch = UploadBatch();
+}
+
+void Device::FlushUploadBatch()
+{
+    auto& batch = m_uploadBatch;
+    batch.cmdList->Close();
+    ExecuteCommandList(batch.cmdList);
+    WaitForGpu();
+    batch.pendingBuffers.clear();
+    batch.keepAlive.clear();
+    // アロケーターは記録中のフレームと共有しているため、リセットせずに続きを積む
+    batch.cmdList->Reset(GetCurrentCommandAllocator().Get(), nullptr);
+}
+
+ComPtr<ID3D12GraphicsCommandList4> Device::GetUploadCommandList()
+{
+    if (m_uploadBatch.depth == 0)
+    {
+        Error(PrintInfoType::D3D12, L"アップロードバッチが開始されていません");
+    }
+    // コピー先のバッファは暗黙的にCOPY_DESTへ昇格しているので、読み取り可能な状態へ遷移
+    auto& pending = m_uploadBatch.pendingBuffers;
+    if (!pending.empty())
+    {
+        std::vector<D3D12_RESOURCE_BARRIER> barriers;
+        barriers.reserve(pending.size());
+        for (auto& buffer : pending)
+        {
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+                buffer.Get(),
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+            ));
+        }
+        m_uploadBatch.cmdList->ResourceBarrier(UINT(barriers.size()), barriers.data());
+        pending.clear();
+    }
+    return m_uploadBatch.cmdList;
+}
+
+void Device::KeepUntilUploaded(ComPtr<ID3D12Resource> resource)
+{
+    if (m_uploadBatch.depth == 0)
+    {
+        Error(PrintInfoType::D3D12, L"アップロードバッチが開始されていません");
+    }
+    m_uploadBatch.keepAlive.push_back(resource);
+}
+
+uint8_t* Device::AllocateUpload(UINT64 size, UINT64 alignment, ComPtr<ID3D12Resource>& page, UINT64& offset)
+{
+    std::lock_guard<std::mutex> lock(m_uploadMutex);
+    // リングに収まらない大きさの場合は専用のバッファを確保し、次のシグナルの完了まで保持する
+    if (size + alignment > UploadRingSize)
+    {
+        page = CreateBuffer(
+            size_t(size),
+            D3D12_RESOURCE_FLAG_NONE,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            D3D12_HEAP_TYPE_UPLOAD,
+            L"UploadPage"
+        );
+        D3D12_RANGE readRange{ 0, 0 };
+        void* mapped = Map(page, &readRange);
+        if (mapped == nullptr)
+        {
+            Error(PrintInfoType::D3D12, L"ステージングバッファのマップに失敗しました");
+        }
+        m_retiredUploads.emplace_back(m_queueFenceValue + 1, page);
+        m_recorder.Add(DeviceRecorder::Counter::UploadBytes, size);
+        offset = 0;
+        return static_cast<uint8_t*>(mapped);
+    }
+
+    while (true)
+    {
+        offset = m_uploadRing.Allocate(size, alignment);
+        if (offset != RingAllocator::InvalidOffset)
+        {
+            break;
+        }
+        // 完了済みの領域を解放し、それでも足りなければ最も古いフレームの完了を待つ
+        RetireUploads();
+        offset = m_uploadRing.Allocate(size, alignment);
+        if (offset != RingAllocator::InvalidOffset)
+        {
+            break;
+        }
+        auto oldest = m_uploadRing.GetOldestPendingFence();
+        if (oldest > 0)
+        {
+            WaitForFence(oldest);
+            continue;
+        }
+        // 未実行のバッチがリング全体を使用している場合は途中まで実行する
+        if (IsUploadBatching())
+        {
+            FlushUploadBatch();
+            continue;
+        }
+        Error(PrintInfoType::D3D12, L"ステージングリングが不足しています");
+    }
+    page = m_pUploadRing;
+    m_recorder.Add(DeviceRecorder::Counter::UploadBytes, size);
+    return m_pUploadRingMapped + offset;
+}
+
+void Device::RetireUploads()
+{
+    auto completed = m_pQueueFence->GetCompletedValue();
+    m_uploadRing.Retire(completed);
+    while (!m_retiredUploads.empty() && m_retiredUploads.front().first <= completed)
+    {
+        m_retiredUploads.pop_front();
+    }
+}
+
 void Device::ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList4> command)
 {
     ID3D12CommandList* cmdLists[] = {
         command.Get(),
     };
     m_pCmdQueue->ExecuteCommandLists(1, cmdLists);
+    m_recorder.Add(DeviceRecorder::Counter::Submit);
 }
 
+void Device::ExecuteCommandLists(const std::vector<ComPtr<ID3D12GraphicsCommandList4>>& commands)
+{
+    std::vector<ID3D12CommandList*> cmdLists;
+    cmdLists.reserve(commands.size());
+    for (const auto& command : commands)
+    {
+        cmdLists.push_back(command.Get());
+    }
+    m_pCmdQueue->ExecuteCommandLists(UINT(cmdLists.size()), cmdLists.data());
+    m_recorder.Add(DeviceRecorder::Counter::Submit);
+}
+
+void Device::Signal(ComPtr<ID3D12Fence1> fence, UINT64 fenceValue)
+{
+    m_pCmdQueue->Signal(fence.Get(), fenceValue);
+}
+
+/// <summary>
+/// フレームの終了
+/// スワップチェインがない場合 (ヘッドレス) は表示を行わず、フレームの切り替えのみ行う
+/// </summary>
 void Device::Present(UINT syncInterval)
 {
     if (m_pSwapChain3)
     {
         m_pSwapChain3->Present(syncInterval, 0);
-        auto fence1 = m_pFrameFence1Arr[m_frameIndex];
-        auto value = ++m_fenceValueArr[m_frameIndex];
-        m_pCmdQueue->Signal(fence1.Get(), value);
-
-        m_frameIndex = m_pSwapChain3->GetCurrentBackBufferIndex();
-        fence1 = m_pFrameFence1Arr[m_frameIndex];
-        auto endValue = m_fenceValueArr[m_frameIndex];
-        if (fence1->GetCompletedValue() < endValue)
-        {
-            fence1->SetEventOnCompletion(endValue, m_fenceEvent);
-            WaitForSingleObject(m_fenceEvent, INFINITE);
-        }
     }
+    auto fence1 = m_pFrameFence1Arr[m_frameIndex];
+    auto value = ++m_fenceValueArr[m_frameIndex];
+    m_pCmdQueue->Signal(fence1.Get(), value);
+    // このフレームのステージング領域は完了後に再利用する
+    SignalQueue();
+
+    m_frameIndex = m_pSwapChain3 ? m_pSwapChain3->GetCurrentBackBufferIndex() : (m_frameIndex + 1) % BackBufferCount;
+    fence1 = m_pFrameFence1Arr[m_frameIndex];
+    auto endValue = m_fenceValueArr[m_frameIndex];
+    if (fence1->GetCompletedValue() < endValue)
+    {
+        fence1->SetEventOnCompletion(endValue, m_fenceEvent);
+        WaitForSingleObject(m_fenceEvent, INFINITE);
+        m_recorder.Add(DeviceRecorder::Counter::FrameWait);
+    }
+    RetireUploads();
+    m_recorder.EndFrame(m_presentCount++);
 }
 
 /// <summary>
@@ -844,13 +1029,37 @@ void Device::Present(UINT syncInterval)
 /// </summary>
 void Device::WaitForGpu() noexcept
 {
-    if (m_pCmdQueue)
+    if (m_pCmdQueue && m_pQueueFence)
+    {
+        WaitForFence(SignalQueue());
+        RetireUploads();
+    }
+    // GPUの処理が完了したので、破棄されたバッファの領域を再利用可能にする
+    if (m_pAllocator)
+    {
+        m_pAllocator->ReleasePending();
+    }
+}
+
+UINT64 Device::SignalQueue()
+{
+    ++m_queueFenceValue;
+    m_pCmdQueue->Signal(m_pQueueFence.Get(), m_queueFenceValue);
+    m_uploadRing.FinishFrame(m_queueFenceValue);
+    return m_queueFenceValue;
+}
+
+void Device::WaitForFence(UINT64 fenceValue)
+{
+    WaitForFence(m_pQueueFence, fenceValue);
+}
+
+void Device::WaitForFence(ComPtr<ID3D12Fence1> fence, UINT64 fenceValue)
+{
+    if (fence->GetCompletedValue() < fenceValue)
     {
-        auto cmdList = CreateCommandList();
-        auto waitFence = CreateFence();
-        UINT64 fenceValue = 1;
-        waitFence->SetEventOnCompletion(fenceValue, m_waitEvent);
-        m_pCmdQueue->Signal(waitFence.Get(), fenceValue);
+        fence->SetEventOnCompletion(fenceValue, m_waitEvent);
         WaitForSingleObject(m_waitEvent, INFINITE);
+        m_recorder.Add(DeviceRecorder::Counter::Wait);
     }
 }
@@ -0,0 +1,195 @@
+#include "gpu_allocator.hpp"
+
+#include <atomic>
+
+#include "utils/print_util.h"
+
+namespace
+{
+    // リソースに領域の所有者を関連付けるためのGUID
+    // {5B0E6A2C-7C4B-4E0F-9F51-3A8D2C6E1B47}
+    const GUID AllocationOwnerGuid = { 0x5b0e6a2c, 0x7c4b, 0x4e0f, { 0x9f, 0x51, 0x3a, 0x8d, 0x2c, 0x6e, 0x1b, 0x47 } };
+}
+
+/// <summary>
+/// Placed Resourceが使用する領域の所有者
+/// リソースのプライベートデータとして保持され、リソースの破棄と同時に領域を解放待ちにする
+/// </summary>
+class GpuAllocator::AllocationOwner : public IUnknown
+{
+public:
+    AllocationOwner(std::shared_ptr<GpuAllocator> allocator, UINT heapIndex, const TLSFAllocator::Allocation& allocation) :
+        m_refCount(1),
+        m_pAllocator(std::move(allocator)),
+        m_heapIndex(heapIndex),
+        m_allocation(allocation)
+    {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (ppvObject == nullptr)
+        {
+            return E_POINTER;
+        }
+        if (riid == __uuidof(IUnknown))
+        {
+            *ppvObject = static_cast<IUnknown*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++m_refCount;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        auto count = --m_refCount;
+        if (count == 0)
+        {
+            m_pAllocator->DeferFree(m_heapIndex, m_allocation);
+            delete this;
+        }
+        return count;
+    }
+
+private:
+    std::atomic<ULONG> m_refCount;
+    std::shared_ptr<GpuAllocator> m_pAllocator;
+    UINT m_heapIndex;
+    TLSFAllocator::Allocation m_allocation;
+};
+
+GpuAllocator::GpuAllocator(ComPtr<ID3D12Device5> device) :
+    m_pDevice(device)
+{
+}
+
+GpuAllocator::~GpuAllocator()
+{
+}
+
+ComPtr<ID3D12Resource> GpuAllocator::CreateBuffer(const D3D12_RESOURCE_DESC& resDesc, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES initialState)
+{
+    auto allocInfo = m_pDevice->GetResourceAllocationInfo(0, 1, &resDesc);
+    if (allocInfo.SizeInBytes == UINT64_MAX || allocInfo.SizeInBytes > HeapSize)
+    {
+        return nullptr;
+    }
+
+    UINT heapIndex = 0;
+    TLSFAllocator::Allocation allocation;
+    if (!Allocate(heapType, allocInfo.SizeInBytes, allocInfo.Alignment, heapIndex, allocation))
+    {
+        return nullptr;
+    }
+    ID3D12Heap* pHeap = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pHeap = m_heaps[heapIndex]->heap.Get();
+    }
+
+    ComPtr<ID3D12Resource> resource;
+    HRESULT hr = m_pDevice->CreatePlacedResource(
+        pHeap,
+        allocation.offset,
+        &resDesc,
+        initialState,
+        nullptr,
+        IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
+    );
+    if (FAILED(hr))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_heaps[heapIndex]->allocator.Free(allocation);
+        return nullptr;
+    }
+
+    // リソースに所有者を持たせ、リソースの破棄時に領域を返す
+    auto owner = new AllocationOwner(shared_from_this(), heapIndex, allocation);
+    hr = resource->SetPrivateDataInterface(AllocationOwnerGuid, owner);
+    owner->Release();
+    if (FAILED(hr))
+    {
+        // 所有者が破棄されるため、領域は解放待ちになっている
+        resource.Reset();
+        return nullptr;
+    }
+    return resource;
+}
+
+void GpuAllocator::ReleasePending()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& pending : m_pendingFrees)
+    {
+        m_heaps[pending.heapIndex]->allocator.Free(pending.allocation);
+    }
+    m_pendingFrees.clear();
+}
+
+GpuAllocator::Stats GpuAllocator::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    for (auto& heap : m_heaps)
+    {
+        ++stats.heapCount;
+        stats.heapSize += heap->allocator.GetSize();
+        stats.usedSize += heap->allocator.GetUsedSize();
+        stats.allocationCount += heap->allocator.GetAllocationCount();
+    }
+    return stats;
+}
+
+bool GpuAllocator::Allocate(D3D12_HEAP_TYPE heapType, UINT64 size, UINT64 alignment, UINT& heapIndex, TLSFAllocator::Allocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (UINT i = 0; i < UINT(m_heaps.size()); ++i)
+    {
+        auto& heap = m_heaps[i];
+        if (heap->type == heapType && heap->allocator.Allocate(size, alignment, allocation))
+        {
+            heapIndex = i;
+            return true;
+        }
+    }
+
+    // 空きがなければヒープを追加
+    D3D12_HEAP_DESC heapDesc{};
+    heapDesc.SizeInBytes = HeapSize;
+    heapDesc.Properties.Type = heapType;
+    heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapDesc.Properties.CreationNodeMask = 1;
+    heapDesc.Properties.VisibleNodeMask = 1;
+    heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+    auto heap = std::make_unique<Heap>();
+    heap->type = heapType;
+    heap->allocator.Reset(HeapSize);
+    if (FAILED(m_pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(heap->heap.ReleaseAndGetAddressOf()))))
+    {
+        Print(PrintInfoType::D3D12, L"バッファ用ヒープの作成に失敗しました");
+        return false;
+    }
+    if (!heap->allocator.Allocate(size, alignment, allocation))
+    {
+        return false;
+    }
+    heapIndex = UINT(m_heaps.size());
+    m_heaps.push_back(std::move(heap));
+    return true;
+}
+
+void GpuAllocator::DeferFree(UINT heapIndex, const TLSFAllocator::Allocation& allocation)
+{
+    // GPUが使用中の可能性があるため、ReleasePendingまで再利用しない
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingFrees.push_back({ heapIndex, allocation });
+}
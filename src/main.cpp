@@ -1,17 +1,200 @@
 #include "renderer.hpp"
+#include "backend_renderer.hpp"
+#include "backend_scene_file.hpp"
 #include "window.hpp"
+#include "render_farm.hpp"
+#include "scene/model_cache.hpp"
+#include "utils/image_util.h"
 
 int main(int argc, char *argv[])
 {
     int maxFrame = -1;
+    int startFrame = 0;
+    int endFrame = -1;
+    int farmWorkerCount = 0;
+    int farmChunkSize = 10;
+    int farmWorkerIndex = -1;
+    std::wstring sceneFile = L"default.json";
+    std::wstring checkpointFile;
+    bool resume = false;
+    double checkpointInterval = 60.0;
+    int samplesPerPass = 0;
+    std::vector<std::wstring> bakeFiles;
+    bool bakeBVH = false;
+    bool headless = false;
+    RenderBackendType backendType = RenderBackendType::D3D12;
     // コマンドライン入力形式
-    // ./[renderer].exe --frame {max_frame}
-    if (argc == 3)
+    // ./[renderer].exe --frame {max_frame} --frame-range {start}:{end} --scene {scene_file}
+    // --frame-range は [start, end) の半開区間
+    // レンダーファーム: --farm {worker_count} --chunk {chunk_size}
+    // チェックポイント: --checkpoint {file} (または --resume {file}) --checkpoint-interval {sec} --samples-per-pass {spp}
+    // モデルのベイク: --bake {model_file} (複数指定可) --bake-bvh {0|1}
+    // ヘッドレス描画 (ウィンドウ, スワップチェインなし): --headless {0|1}
+    // 描画バックエンド: --backend {d3d12|cpu|null} (cpu, nullはDeviceを使用せずヘッドレスで描画する)
+    //   cpu, nullはシーン記述ファイルの初期配置のみを描画するため、--frame-range, ファームとは併用できない
+    for (int i = 1; i + 1 < argc; i += 2)
     {
-        if (strcmp(argv[1], "--frame") == 0) {
-            maxFrame = atoi(argv[2]);
+        if (strcmp(argv[i], "--frame") == 0) {
+            maxFrame = atoi(argv[i + 1]);
         }
+        else if (strcmp(argv[i], "--frame-range") == 0) {
+            if (sscanf_s(argv[i + 1], "%d:%d", &startFrame, &endFrame) != 2 || startFrame < 0 || endFrame <= startFrame) {
+                Print(PrintInfoType::RTCAMP10, "フレーム範囲の指定が不正です: ", argv[i + 1]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--scene") == 0) {
+            sceneFile = StrToWStr(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--farm") == 0) {
+            farmWorkerCount = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--chunk") == 0) {
+            farmChunkSize = (std::max)(1, atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--farm-worker") == 0) {
+            farmWorkerIndex = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0) {
+            checkpointFile = StrToWStr(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--resume") == 0) {
+            checkpointFile = StrToWStr(argv[i + 1]);
+            resume = true;
+        }
+        else if (strcmp(argv[i], "--checkpoint-interval") == 0) {
+            checkpointInterval = atof(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--samples-per-pass") == 0) {
+            samplesPerPass = (std::max)(0, atoi(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--bake") == 0) {
+            bakeFiles.push_back(StrToWStr(argv[i + 1]));
+        }
+        else if (strcmp(argv[i], "--bake-bvh") == 0) {
+            bakeBVH = atoi(argv[i + 1]) != 0;
+        }
+        else if (strcmp(argv[i], "--headless") == 0) {
+            headless = atoi(argv[i + 1]) != 0;
+        }
+        else if (strcmp(argv[i], "--backend") == 0) {
+            if (!ParseRenderBackendType(argv[i + 1], backendType)) {
+                Print(PrintInfoType::RTCAMP10, "描画バックエンドの指定が不正です: ", argv[i + 1]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // ベイクのみ行う (デバイスは使用しない)
+    if (!bakeFiles.empty())
+    {
+        ModelCache modelCache;
+        bool result = true;
+        try
+        {
+            for (const auto& fileName : bakeFiles)
+            {
+                result &= modelCache.Bake(fileName, bakeBVH);
+            }
+        }
+        catch (std::exception& e)
+        {
+            Print(PrintInfoType::RTCAMP10, "ベイクのエラー終了: ", e.what());
+            return EXIT_FAILURE;
+        }
+        return result ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Deviceを使用しないバックエンドはアニメーションを進めないため、フレーム範囲を分割して描画できない
+    if (backendType != RenderBackendType::D3D12 && (endFrame > 0 || farmWorkerCount > 0 || farmWorkerIndex >= 0))
+    {
+        Print(PrintInfoType::RTCAMP10, "CPU, Nullバックエンドは --frame-range, --farm, --farm-worker と併用できません");
+        return EXIT_FAILURE;
+    }
+
+    // コーディネーター (描画は行わない)
+    if (farmWorkerCount > 0)
+    {
+        RenderFarm::Config config{};
+        config.workerCount = farmWorkerCount;
+        config.startFrame = endFrame > 0 ? startFrame : 0;
+        config.endFrame = endFrame > 0 ? endFrame : maxFrame;
+        config.chunkSize = farmChunkSize;
+        config.maxFrame = maxFrame > 0 ? maxFrame : config.endFrame;
+        config.sceneFile = sceneFile;
+        config.headless = headless;
+        if (config.endFrame <= config.startFrame)
+        {
+            Print(PrintInfoType::RTCAMP10, "ファームの実行には --frame または --frame-range の指定が必要です");
+            return EXIT_FAILURE;
+        }
+        try
+        {
+            return RenderFarm::RunCoordinator(config);
+        }
+        catch (std::exception& e)
+        {
+            Print(PrintInfoType::RTCAMP10, "ファームのエラー終了: ", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Deviceを使用しないバックエンド
+    // ウィンドウを持たないため、終了フレームの指定が必要
+    if (backendType != RenderBackendType::D3D12)
+    {
+        if (maxFrame <= 0)
+        {
+            Print(PrintInfoType::RTCAMP10, "CPU, Nullバックエンドには --frame の指定が必要です");
+            return EXIT_FAILURE;
+        }
+        BackendRenderer backendRenderer(1024, 1024, CreateRenderBackend(backendType), std::make_unique<BackendSceneFile>(sceneFile), maxFrame);
+        backendRenderer.SetSamplesPerPass(uint32_t(samplesPerPass));
+        // Nullバックエンドの描画結果は常に黒のため出力しない
+        if (backendType != RenderBackendType::Null)
+        {
+            fpng::fpng_init();
+            backendRenderer.SetFrameOutput([](int frame, const uint8_t* pixels, uint32_t width, uint32_t height)
+            {
+                WriteFrameImage(frame, pixels, width, height, width * 4);
+            });
+        }
+        return backendRenderer.Run();
+    }
+
+    Renderer renderer(1024, 1024, L"rtcamp10", maxFrame, sceneFile);
+
+    // ワーカー: キューから取得した範囲を順に描画する
+    std::unique_ptr<RenderFarmWorker> farmWorker;
+    if (farmWorkerIndex >= 0)
+    {
+        farmWorker = std::make_unique<RenderFarmWorker>(farmWorkerIndex);
+        if (!farmWorker->NextRange(startFrame, endFrame))
+        {
+            return EXIT_SUCCESS;
+        }
+        renderer.SetFrameRangeProvider([&farmWorker](int& start, int& end) { return farmWorker->NextRange(start, end); });
+    }
+
+    if (endFrame > 0)
+    {
+        renderer.SetFrameRange(startFrame, endFrame);
+    }
+    // チェックポイントはパス単位で作成するため、パス分割の指定がなければ16サンプルごとに分割
+    if (!checkpointFile.empty())
+    {
+        renderer.SetCheckpoint(checkpointFile, resume, checkpointInterval);
+        if (samplesPerPass == 0)
+        {
+            samplesPerPass = 16;
+        }
+    }
+    renderer.SetSamplesPerPass(UINT(samplesPerPass));
+    // 終了フレームの指定がない場合は描画し続けるため、ヘッドレスでは実行しない
+    if (headless && endFrame <= 0 && maxFrame <= 0)
+    {
+        Print(PrintInfoType::RTCAMP10, "ヘッドレス描画には --frame または --frame-range の指定が必要です");
+        return EXIT_FAILURE;
     }
-    Renderer renderer(1024, 1024, L"rtcamp10", maxFrame);
-    return Window::Run(&renderer, 0);
+    return headless ? Window::RunHeadless(&renderer) : Window::Run(&renderer, 0);
 }
@@ -0,0 +1,401 @@
+#include "render_farm.hpp"
+#include "utils/print_util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct ChunkInfo
+    {
+        int startFrame = 0;
+        int endFrame = 0;
+        int retry = 0;
+    };
+
+    bool ReadChunk(const fs::path& path, ChunkInfo& chunk)
+    {
+        std::ifstream file(path);
+        return bool(file >> chunk.startFrame >> chunk.endFrame >> chunk.retry);
+    }
+
+    void WriteChunk(const fs::path& path, const ChunkInfo& chunk)
+    {
+        // 書き込み途中のファイルを取得されないよう一時ファイル経由で配置する
+        auto tmpPath = path;
+        tmpPath += L".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::trunc);
+            file << chunk.startFrame << " " << chunk.endFrame << " " << chunk.retry;
+        }
+        fs::rename(tmpPath, path);
+    }
+
+    std::vector<fs::path> ListChunks(const fs::path& dir)
+    {
+        std::vector<fs::path> chunks;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(dir, ec))
+        {
+            if (entry.path().extension() == L".chunk")
+            {
+                chunks.push_back(entry.path());
+            }
+        }
+        std::sort(chunks.begin(), chunks.end());
+        return chunks;
+    }
+
+    // running/{id}.{worker}.chunk, done/{id}.{worker}.chunk から id と worker を取り出す
+    void SplitRunningName(const fs::path& path, std::wstring& id, std::wstring& worker)
+    {
+        auto stem = path.stem().wstring();
+        auto dot = stem.find(L'.');
+        id = stem.substr(0, dot);
+        worker = dot == std::wstring::npos ? L"" : stem.substr(dot + 1);
+    }
+
+    std::wstring WorkerName(int workerIndex)
+    {
+        return L"w" + std::to_wstring(workerIndex);
+    }
+
+    // {id}.{worker}.chunk のうち、workerのもの
+    std::vector<fs::path> ListOwnedChunks(const fs::path& dir, const std::wstring& workerName)
+    {
+        std::vector<fs::path> owned;
+        for (const auto& path : ListChunks(dir))
+        {
+            std::wstring id, owner;
+            SplitRunningName(path, id, owner);
+            if (owner == workerName)
+            {
+                owned.push_back(path);
+            }
+        }
+        return owned;
+    }
+
+    std::wstring OutputImageName(int frame)
+    {
+        std::wostringstream sout;
+        sout << std::setw(3) << std::setfill(L'0') << frame << L".png";
+        return sout.str();
+    }
+
+    /// <summary>
+    /// ワーカープロセス
+    /// </summary>
+    class WorkerProcess
+    {
+    public:
+        bool Spawn(int workerIndex, const RenderFarm::Config& config)
+        {
+            m_workerIndex = workerIndex;
+            std::vector<std::wstring> args = {
+                L"--frame", std::to_wstring(config.maxFrame),
+                L"--scene", config.sceneFile,
+                L"--farm-worker", std::to_wstring(workerIndex),
+                L"--headless", config.headless ? L"1" : L"0",
+            };
+#ifdef _WIN32
+            wchar_t exePath[MAX_PATH]{};
+            GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+            const std::wstring exeFile = config.workerExecutable.empty() ? std::wstring(exePath) : config.workerExecutable.wstring();
+            std::wstring cmdLine = L"\"" + exeFile + L"\"";
+            for (const auto& arg : args)
+            {
+                cmdLine += L" \"" + arg + L"\"";
+            }
+            STARTUPINFOW startupInfo{};
+            startupInfo.cb = sizeof(startupInfo);
+            PROCESS_INFORMATION procInfo{};
+            if (!CreateProcessW(exeFile.c_str(), cmdLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &procInfo))
+            {
+                return false;
+            }
+            CloseHandle(procInfo.hThread);
+            m_hProcess = procInfo.hProcess;
+#else
+            const std::string exeFile = config.workerExecutable.empty() ? std::string("/proc/self/exe") : config.workerExecutable.string();
+            std::vector<std::string> argStrs = { exeFile };
+            for (const auto& arg : args)
+            {
+                argStrs.push_back(WStrToStr(arg));
+            }
+            m_pid = fork();
+            if (m_pid < 0)
+            {
+                return false;
+            }
+            if (m_pid == 0)
+            {
+                std::vector<char*> argv;
+                for (auto& arg : argStrs)
+                {
+                    argv.push_back(arg.data());
+                }
+                argv.push_back(nullptr);
+                execv(exeFile.c_str(), argv.data());
+                _exit(EXIT_FAILURE);
+            }
+#endif
+            m_isRunning = true;
+            return true;
+        }
+
+        // 終了していればtrue
+        bool Poll(int& exitCode)
+        {
+            if (!m_isRunning)
+            {
+                return true;
+            }
+#ifdef _WIN32
+            if (WaitForSingleObject(m_hProcess, 0) != WAIT_OBJECT_0)
+            {
+                return false;
+            }
+            DWORD code = 0;
+            GetExitCodeProcess(m_hProcess, &code);
+            CloseHandle(m_hProcess);
+            m_hProcess = nullptr;
+            exitCode = int(code);
+#else
+            int status = 0;
+            if (waitpid(m_pid, &status, WNOHANG) == 0)
+            {
+                return false;
+            }
+            exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+#endif
+            m_isRunning = false;
+            return true;
+        }
+
+        bool IsRunning() const { return m_isRunning; }
+        int GetWorkerIndex() const { return m_workerIndex; }
+
+    private:
+        int m_workerIndex = -1;
+        bool m_isRunning = false;
+#ifdef _WIN32
+        HANDLE m_hProcess = nullptr;
+#else
+        pid_t m_pid = -1;
+#endif
+    };
+}
+
+fs::path RenderFarm::GetQueueDir()
+{
+    return fs::path(OUTPUT_DIR) / L"farm_queue";
+}
+
+/// <summary>
+/// コーディネーターの実行
+/// </summary>
+/// <param name="config"></param>
+/// <returns></returns>
+int RenderFarm::RunCoordinator(const Config& config)
+{
+    const auto queueDir = GetQueueDir();
+    const auto pendingDir = queueDir / L"pending";
+    const auto runningDir = queueDir / L"running";
+    const auto doneDir = queueDir / L"done";
+    const auto failedDir = queueDir / L"failed";
+
+    // キューの初期化
+    fs::remove_all(queueDir);
+    for (const auto& dir : { pendingDir, runningDir, doneDir, failedDir })
+    {
+        fs::create_directories(dir);
+    }
+    int chunkCount = 0;
+    for (int start = config.startFrame; start < config.endFrame; start += config.chunkSize)
+    {
+        ChunkInfo chunk{ start, (std::min)(start + config.chunkSize, config.endFrame), 0 };
+        std::wostringstream id;
+        id << std::setw(6) << std::setfill(L'0') << chunkCount++;
+        WriteChunk(pendingDir / (id.str() + L".chunk"), chunk);
+    }
+    Print(PrintInfoType::RTCAMP10, "ファーム開始 チャンク数: ", chunkCount);
+
+    // ワーカーの起動
+    // チャンクを取得せずに終了したワーカー (起動直後のクラッシュなど) は再起動を続けない
+    struct WorkerSlot
+    {
+        WorkerProcess process;
+        // 起動時点の完了済みチャンク数
+        size_t doneCount = 0;
+        // チャンクを取得せずに続けて終了した回数
+        int idleExitCount = 0;
+        bool isRetired = false;
+    };
+    auto workerCount = (std::max)(1, (std::min)(config.workerCount, chunkCount));
+    std::vector<WorkerSlot> workers(workerCount);
+    for (int i = 0; i < workerCount; ++i)
+    {
+        if (!workers[i].process.Spawn(i, config))
+        {
+            Error(PrintInfoType::RTCAMP10, "ワーカーの起動に失敗しました: ", i);
+        }
+    }
+
+    // キューの監視
+    while (true)
+    {
+        for (auto& worker : workers)
+        {
+            if (worker.isRetired)
+            {
+                continue;
+            }
+            const int workerIndex = worker.process.GetWorkerIndex();
+            const auto workerName = WorkerName(workerIndex);
+            if (worker.process.IsRunning())
+            {
+                int exitCode = 0;
+                if (!worker.process.Poll(exitCode))
+                {
+                    continue;
+                }
+                if (exitCode != 0)
+                {
+                    Print(PrintInfoType::RTCAMP10, "ワーカーが異常終了しました: ", workerIndex);
+                }
+
+                // 終了したワーカーが処理中だったチャンクをキューに戻す
+                const auto runningChunks = ListOwnedChunks(runningDir, workerName);
+                for (const auto& path : runningChunks)
+                {
+                    std::wstring id, owner;
+                    SplitRunningName(path, id, owner);
+                    ChunkInfo chunk{};
+                    ReadChunk(path, chunk);
+                    chunk.retry++;
+                    auto dstDir = chunk.retry > config.maxRetry ? failedDir : pendingDir;
+                    WriteChunk(dstDir / (id + L".chunk"), chunk);
+                    fs::remove(path);
+                    Print(PrintInfoType::RTCAMP10, L"チャンクの再投入: " + id + L" retry: " + std::to_wstring(chunk.retry));
+                }
+
+                const bool hasClaimed = !runningChunks.empty() || ListOwnedChunks(doneDir, workerName).size() > worker.doneCount;
+                worker.idleExitCount = hasClaimed ? 0 : worker.idleExitCount + 1;
+                if (worker.idleExitCount > config.maxRetry)
+                {
+                    Print(PrintInfoType::RTCAMP10, "チャンクを取得せずに終了を繰り返すため、ワーカーを再起動しません: ", workerIndex);
+                    worker.isRetired = true;
+                    continue;
+                }
+            }
+
+            // 未処理のチャンクが残っていればワーカーを再起動
+            if (!ListChunks(pendingDir).empty())
+            {
+                worker.doneCount = ListOwnedChunks(doneDir, workerName).size();
+                if (!worker.process.Spawn(workerIndex, config))
+                {
+                    Error(PrintInfoType::RTCAMP10, "ワーカーの起動に失敗しました: ", workerIndex);
+                }
+            }
+        }
+
+        // 全てのワーカーを再起動しなくなった場合、残りのチャンクは失敗とする
+        bool isAllRetired = std::all_of(workers.begin(), workers.end(), [](const WorkerSlot& w) { return w.isRetired; });
+        if (isAllRetired)
+        {
+            for (const auto& path : ListChunks(pendingDir))
+            {
+                fs::rename(path, failedDir / path.filename());
+            }
+        }
+
+        bool isFinished = ListChunks(pendingDir).empty() && ListChunks(runningDir).empty();
+        bool isAnyRunning = std::any_of(workers.begin(), workers.end(), [](const WorkerSlot& w) { return w.process.IsRunning(); });
+        if (isFinished && !isAnyRunning)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    // 出力の収集
+    auto failedChunks = ListChunks(failedDir);
+    int missingCount = 0;
+    for (int frame = config.startFrame; frame < config.endFrame; ++frame)
+    {
+        if (!fs::exists(fs::path(OUTPUT_DIR) / OutputImageName(frame)))
+        {
+            missingCount++;
+        }
+    }
+    Print(PrintInfoType::RTCAMP10, "ファーム完了 失敗チャンク数: ", failedChunks.size());
+    if (missingCount > 0)
+    {
+        Print(PrintInfoType::RTCAMP10, "出力されていないフレーム数: ", missingCount);
+        return EXIT_FAILURE;
+    }
+    return failedChunks.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+RenderFarmWorker::RenderFarmWorker(int workerIndex) :
+    m_queueDir(RenderFarm::GetQueueDir()),
+    m_workerName(WorkerName(workerIndex))
+{
+}
+
+/// <summary>
+/// 次のチャンクの取得
+/// </summary>
+/// <param name="startFrame"></param>
+/// <param name="endFrame"></param>
+/// <returns></returns>
+bool RenderFarmWorker::NextRange(int& startFrame, int& endFrame)
+{
+    // 処理中のチャンクを完了扱いにする
+    if (!m_currentChunk.empty())
+    {
+        std::error_code ec;
+        fs::rename(m_currentChunk, m_queueDir / L"done" / (m_currentChunkId + L"." + m_workerName + L".chunk"), ec);
+        m_currentChunk.clear();
+        m_currentChunkId.clear();
+    }
+
+    // pendingからrunningへのrenameに成功したワーカーがチャンクを取得する
+    for (const auto& path : ListChunks(m_queueDir / L"pending"))
+    {
+        auto id = path.stem().wstring();
+        auto claimed = m_queueDir / L"running" / (id + L"." + m_workerName + L".chunk");
+        std::error_code ec;
+        fs::rename(path, claimed, ec);
+        if (ec)
+        {
+            // 他のワーカーが先に取得した
+            continue;
+        }
+        ChunkInfo chunk{};
+        if (!ReadChunk(claimed, chunk))
+        {
+            continue;
+        }
+        m_currentChunk = claimed;
+        m_currentChunkId = id;
+        startFrame = chunk.startFrame;
+        endFrame = chunk.endFrame;
+        Print(PrintInfoType::RTCAMP10, L"チャンク取得: " + id + L" (" + m_workerName + L")");
+        return true;
+    }
+    return false;
+}
@@ -4,6 +4,7 @@
 #include "utils/dxr_util.h"
 #include "utils/shader_compiler.h"
 #include "utils/math_util.h"
+#include "utils/image_util.h"
 
 #ifdef _DEBUG
 #include <imgui.h>
@@ -15,13 +16,27 @@
 using namespace DirectX;
 using namespace fpng;
 
-Renderer::Renderer(UINT width, UINT height, const std::wstring& title, int maxFrame) :
+Renderer::Renderer(UINT width, UINT height, const std::wstring& title, int maxFrame, const std::wstring& sceneFile) :
     m_isRunning(false),
+    m_isHeadless(false),
     m_width(width),
     m_height(height),
     m_currentFrame(0),
     m_maxFrame(maxFrame),
+    m_startFrame(0),
+    m_endFrame(maxFrame),
     m_title(title),
+    m_sceneFile(sceneFile),
+    m_samplesPerPass(0),
+    m_resumeSampleOffset(0),
+    m_isResume(false),
+    m_checkpointInterval(0.0),
+    m_accumFootprint(),
+    m_seedFootprint(),
+    m_passFenceValue(0),
+    m_readbackIndex(0),
+    m_outputFootprint(),
+    m_tlasVersion(0),
 #ifdef _DEBUG
     m_imGuiParam(),
 #endif // _DEBUG
@@ -29,6 +44,25 @@ Renderer::Renderer(UINT width, UINT height, const std::wstring& title, int maxFr
 {
 }
 
+void Renderer::SetFrameRange(int startFrame, int endFrame)
+{
+    m_startFrame = startFrame;
+    m_endFrame = endFrame;
+    m_currentFrame = startFrame;
+    // シーケンス長の指定がない場合は範囲の終端をシーケンス長とする
+    if (m_maxFrame < 0)
+    {
+        m_maxFrame = endFrame;
+    }
+}
+
+void Renderer::SetCheckpoint(const std::wstring& fileName, bool resume, double intervalSec)
+{
+    m_checkpointFile = fileName;
+    m_isResume = resume;
+    m_checkpointInterval = intervalSec;
+}
+
 void Renderer::OnInit()
 {
     Print(PrintInfoType::RTCAMP10, L"=======RTCAMP10=======");
@@ -37,12 +71,12 @@ void Renderer::OnInit()
     m_startTime = std::chrono::system_clock::now();
 
     // グラフィックデバイスの初期化
-    if (!InitGraphicDevice(Window::GetHWND())) return;
+    if (!InitGraphicDevice(m_isHeadless ? nullptr : Window::GetHWND())) return;
 
     // シーンの初期化
     // 初期化関数内でBLASの構築
     m_pScene = std::shared_ptr<Scene>(new Scene(m_pDevice));
-    m_pScene->OnInit(GetAspect());
+    m_pScene->OnInit(GetAspect(), m_sceneFile);
 
     // TLASの構築
     BuildTLAS();
@@ -62,35 +96,69 @@ void Renderer::OnInit()
     // シェーダーテーブルの作成
     CreateShaderTable();
 
+    // チェックポイントの準備と復元
+    if (!m_checkpointFile.empty())
+    {
+        CreateCheckpointResources();
+        RestoreCheckpoint();
+    }
+
+    // 画像出力の読み戻しリングの作成 (ウィンドウ表示の場合もフレームごとには作成しない)
+    CreateReadbackResources();
+
     // コマンドリストの用意
     m_pCmdList = m_pDevice->CreateCommandList();
     m_pCmdList->Close();
+    m_pCmdListPool = std::make_unique<CommandListPool<Device>>(*m_pDevice, Device::BackBufferCount);
 
 #ifdef _DEBUG
     // ImGuiの初期化
-    InitImGui();
+    if (!m_isHeadless)
+    {
+        InitImGui();
+    }
 #endif // _DEBUG
 
     // fpngの初期化
     fpng_init();
 
+    // 初期化の記録は除外し、描画ループのみを集計する
+    m_pDevice->GetRecorder().Reset();
 }
 
 void Renderer::OnUpdate()
 {
+    // 次の描画範囲があれば継続
+    if (m_endFrame > 0 && m_currentFrame >= m_endFrame && m_frameRangeProvider)
+    {
+        // 描画済みの範囲の画像を全て出力してから完了を報告する
+        FlushReadbacks();
+        int startFrame = 0;
+        int endFrame = 0;
+        if (m_frameRangeProvider(startFrame, endFrame))
+        {
+            SetFrameRange(startFrame, endFrame);
+        }
+    }
+
     // シーンの更新処理
     m_pScene->OnUpdate(m_currentFrame, m_maxFrame);
 
 #ifdef _DEBUG
-    UpdateImGui();
+    if (!m_isHeadless)
+    {
+        UpdateImGui();
+    }
 #endif // _DEBUG
 }
 
 void Renderer::OnRender()
 {
     // 最後のフレームが描画されたら終了
-    if (m_maxFrame > 0 && m_currentFrame >= m_maxFrame)
+    if (m_endFrame > 0 && m_currentFrame >= m_endFrame)
     {
+        // 読み戻し中のフレームを出力
+        FlushReadbacks();
         // アプリケーションの時間計測開始
         m_endTime = std::chrono::system_clock::now();
         // 経過時間の算出
@@ -98,15 +166,21 @@ void Renderer::OnRender()
         std::wstringstream timeWSS;
         timeWSS << L"Total time: " << elapsed * 0.001 << L"(sec)";
         Print(PrintInfoType::RTCAMP10, timeWSS.str());
+        // デバイス操作の集計 (最初のフレームはTLASの構築などを含むため定常状態から除く)
+        Print(PrintInfoType::D3D12, m_pDevice->GetRecorder().GetReport(1).c_str());
         // 終了処理
         Print(PrintInfoType::RTCAMP10, L"======================");
         OnDestroy();
+        // ヘッドレスの場合はm_isRunningで描画ループを抜ける
+        if (!m_isHeadless)
+        {
 #ifdef _DEBUG
-        auto hwnd = Window::GetHWND();
-        PostMessage(hwnd, WM_QUIT, 0, 0);
+            auto hwnd = Window::GetHWND();
+            PostMessage(hwnd, WM_QUIT, 0, 0);
 #else // _DEBUG
-        PostQuitMessage(0);
+            PostQuitMessage(0);
 #endif
+        }
         return;
     }
     // chrono変数
@@ -119,24 +193,21 @@ void Renderer::OnRender()
     auto allocator = m_pDevice->GetCurrentCommandAllocator();
     allocator->Reset();
     m_pCmdList->Reset(allocator.Get(), nullptr);
+    // このスロットの前回のフレームはPresentで完了を待機済み
+    m_pCmdListPool->BeginFrame(m_pDevice->GetCurrentFrameIndex());
 
     ID3D12DescriptorHeap* descriptorHeaps[] = {
         m_pDevice->GetDescriptorHeap().Get(),
     };
     m_pCmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
-    // BLASの更新
-    m_pScene->UpdateBLAS(m_pCmdList);
+    // BLASの更新 (アクターごとのリフィットを並列に記録)
+    m_pScene->UpdateBLAS(*m_pCmdListPool);
 
     // TLASの更新
     UpdateTLAS();
 
-    m_pCmdList->SetComputeRootSignature(m_pGlobalRootSignature.Get());
-    m_pCmdList->SetComputeRootDescriptorTable(0, m_tlasDescHeap.gpuHandle);
-    // 背景テクスチャ
-    m_pCmdList->SetComputeRootDescriptorTable(1, m_pScene->GetBackgroundTex().srv.gpuHandle);
-    // 定数バッファの設定
-    m_pCmdList->SetComputeRootConstantBufferView(2, m_pScene->GetConstantBuffer()->GetGPUVirtualAddress());
+    SetDispatchState();
 
     // レイトレース結果をUAVへ
     auto barrierToUAV = CD3DX12_RESOURCE_BARRIER::Transition(
@@ -147,78 +218,122 @@ void Renderer::OnRender()
     m_pCmdList->ResourceBarrier(1, &barrierToUAV);
 
     // レイトレース
-    m_pCmdList->SetPipelineState1(m_pRTStateObject.Get());
-    m_pCmdList->DispatchRays(&m_dispatchRayDesc);
+    // サンプルをパスに分割して蓄積バッファへ加算する (分割数によらず結果は同一)
+    auto maxSPP = UINT(m_pScene->GetMaxSPP());
+    auto samplesPerPass = m_samplesPerPass > 0 ? m_samplesPerPass : maxSPP;
+    auto sampleOffset = (std::min)(m_resumeSampleOffset, maxSPP);
+    m_resumeSampleOffset = 0;
+    do
+    {
+        UINT passParam[] = { sampleOffset, (std::min)(samplesPerPass, maxSPP - sampleOffset) };
+        m_pCmdList->SetComputeRoot32BitConstants(3, _countof(passParam), passParam, 0);
+        m_pCmdList->DispatchRays(&m_dispatchRayDesc);
+        D3D12_RESOURCE_BARRIER uavBarriers[] = {
+            CD3DX12_RESOURCE_BARRIER::UAV(m_pAccumBuffer.Get()),
+            CD3DX12_RESOURCE_BARRIER::UAV(m_pSeedBuffer.Get()),
+        };
+        m_pCmdList->ResourceBarrier(_countof(uavBarriers), uavBarriers);
+        sampleOffset += passParam[1];
+        if (m_pCheckpoint)
+        {
+            SubmitPass(sampleOffset);
+        }
+    } while (sampleOffset < maxSPP);
 
-    // レイトレース結果をバックバッファへコピー
-    D3D12_RESOURCE_BARRIER barriers[] = {
-        CD3DX12_RESOURCE_BARRIER::Transition(
+    if (m_isHeadless)
+    {
+        // 出力バッファから読み戻しリングへ直接コピー
+        auto barrierToCopySrc = CD3DX12_RESOURCE_BARRIER::Transition(
             m_pOutputBuffer.Get(),
             D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
             D3D12_RESOURCE_STATE_COPY_SOURCE
-        ),
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            renderTarget.Get(),
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_COPY_DEST
-        ),
-    };
-    m_pCmdList->ResourceBarrier(_countof(barriers), barriers);
-    m_pCmdList->CopyResource(renderTarget.Get(), m_pOutputBuffer.Get());
+        );
+        m_pCmdList->ResourceBarrier(1, &barrierToCopySrc);
+        RecordReadback();
+        m_pCmdList->Close();
+
+        // BLASの更新, レイトレースの順に実行
+        m_pCmdListPool->Submit(m_pCmdList);
+        CommitReadback(m_endFrame > 0 ? m_currentFrame : -1);
+        // 表示は行わず、次のフレームのコマンドアロケーターへ切り替える
+        m_pDevice->Present(0);
+    }
+    else
+    {
+        // レイトレース結果をバックバッファへコピー
+        D3D12_RESOURCE_BARRIER barriers[] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(
+                m_pOutputBuffer.Get(),
+                D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                D3D12_RESOURCE_STATE_COPY_SOURCE
+            ),
+            CD3DX12_RESOURCE_BARRIER::Transition(
+                renderTarget.Get(),
+                D3D12_RESOURCE_STATE_PRESENT,
+                D3D12_RESOURCE_STATE_COPY_DEST
+            ),
+        };
+        m_pCmdList->ResourceBarrier(_countof(barriers), barriers);
+        m_pCmdList->CopyResource(renderTarget.Get(), m_pOutputBuffer.Get());
+
+        // Release版ビルドかつ、最大フレーム指定がある場合にのみ画像出力
+        // バックバッファと同じ内容の出力バッファから読み戻しリングへコピーする
+#ifndef _DEBUG
+        bool isOutputFrame = m_endFrame > 0;
+        if (isOutputFrame)
+        {
+            RecordReadback();
+        }
+#endif
 
 #ifdef _DEBUG
-    // ImGui描画用の設定
-    auto barrierToRT = CD3DX12_RESOURCE_BARRIER::Transition(
-        renderTarget.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_RENDER_TARGET
-    );
-    m_pCmdList->ResourceBarrier(1, &barrierToRT);
+        // ImGui描画用の設定
+        auto barrierToRT = CD3DX12_RESOURCE_BARRIER::Transition(
+            renderTarget.Get(),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_RENDER_TARGET
+        );
+        m_pCmdList->ResourceBarrier(1, &barrierToRT);
 
-    // ImGuiの描画
-    RenderImGui();
+        // ImGuiの描画
+        RenderImGui();
 
-    // レンダーターゲットからPresentする
-    auto barrierToPresent = CD3DX12_RESOURCE_BARRIER::Transition(
-        renderTarget.Get(),
-        D3D12_RESOURCE_STATE_RENDER_TARGET,
-        D3D12_RESOURCE_STATE_PRESENT
-    );
+        // レンダーターゲットからPresentする
+        auto barrierToPresent = CD3DX12_RESOURCE_BARRIER::Transition(
+            renderTarget.Get(),
+            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            D3D12_RESOURCE_STATE_PRESENT
+        );
 #else // _DEBUG
-    // Present可能なようにバリアをセット
-    auto barrierToPresent = CD3DX12_RESOURCE_BARRIER::Transition(
-        renderTarget.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_PRESENT
-    );
+        // Present可能なようにバリアをセット
+        auto barrierToPresent = CD3DX12_RESOURCE_BARRIER::Transition(
+            renderTarget.Get(),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_PRESENT
+        );
 #endif
 
-    m_pCmdList->ResourceBarrier(1, &barrierToPresent);
-    m_pCmdList->Close();
-
-    m_pDevice->ExecuteCommandList(m_pCmdList);
-    m_pDevice->Present(1);
+        m_pCmdList->ResourceBarrier(1, &barrierToPresent);
+        m_pCmdList->Close();
 
-    // Release版ビルドかつ、最大フレーム指定がある場合にのみ画像出力
+        // BLASの更新, レイトレースの順に実行
+        m_pCmdListPool->Submit(m_pCmdList);
 #ifndef _DEBUG
-    if (m_maxFrame > 0)
-    {
-        // 画像用のバッファを作成
-        auto imageBuffer = m_pDevice->CreateImageBuffer(
-            renderTarget,
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_PRESENT
-        );
-        // 画像の出力
-        OutputImage(imageBuffer);
-    }
+        if (isOutputFrame)
+        {
+            CommitReadback(m_currentFrame);
+        }
 #endif
+        m_pDevice->Present(1);
+    }
+
     // 時間計測終了
     end = std::chrono::system_clock::now();
     // 経過時間の算出
     double elapsed = (double)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
     std::ostringstream timeOSS;
     timeOSS << "Frame: " << std::setw(3) << std::setfill('0') << m_currentFrame << " | " << elapsed * 0.001 << "(sec)";
+    timeOSS << " | Updated actors: " << m_pScene->GetUpdatedActorCount();
     Print(PrintInfoType::RTCAMP10, StrToWStr(timeOSS.str()).c_str());
     // フレームの更新
     m_currentFrame++;
@@ -227,17 +342,29 @@ void Renderer::OnRender()
 void Renderer::OnDestroy()
 {
 #ifdef _DEBUG
-    ImGui_ImplDX12_Shutdown();
-    m_pDevice->DeallocateDescriptorHeap(m_imguiDescHeap);
+    if (!m_isHeadless)
+    {
+        ImGui_ImplDX12_Shutdown();
+        m_pDevice->DeallocateDescriptorHeap(m_imguiDescHeap);
+    }
 #endif // _DEBUG
+    for (auto& slot : m_readbackSlots)
+    {
+        slot = ReadbackSlot();
+    }
     m_pScene->OnDestroy();
     m_pScene.reset();
+    // 書き込み中のチェックポイントの完了を待機
+    m_pCheckpoint.reset();
     if (m_pDevice)
     {
         m_pDevice->DeallocateDescriptorHeap(m_tlasDescHeap);
         m_pDevice->DeallocateDescriptorHeap(m_outputBufferDescHeap);
+        m_pDevice->DeallocateDescriptorHeap(m_accumBufferDescHeap);
+        m_pDevice->DeallocateDescriptorHeap(m_seedBufferDescHeap);
         m_pDevice->OnDestroy();
     }
+    m_pCmdListPool.reset();
     m_pDevice.reset();
     m_isRunning = false;
 }
@@ -251,8 +378,8 @@ bool Renderer::InitGraphicDevice(HWND hwnd)
         Error(PrintInfoType::RTCAMP10, L"グラフィックデバイスの初期化に失敗しました");
         return false;
     }
-    // スワップチェインの作成
-    if (!m_pDevice->CreateSwapChain(GetWidth(), GetHeight(), hwnd))
+    // スワップチェインの作成 (ヘッドレスの場合は作成しない)
+    if (!m_isHeadless && !m_pDevice->CreateSwapChain(GetWidth(), GetHeight(), hwnd))
     {
         Error(PrintInfoType::RTCAMP10, L"スワップチェインの作成に失敗しました");
         return false;
@@ -268,37 +395,25 @@ void Renderer::BuildTLAS()
 {
     auto d3d12Device = m_pDevice->GetDevice();
 
-    std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
-    m_pScene->CreateRTInstanceDesc(instanceDescs);
-
-    // インスタンス情報用のバッファを確保
-    m_pRTInstanceBuffers.resize(m_pDevice->BackBufferCount);
-    auto instanceDescSize = UINT(ROUND_UP(instanceDescs.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC), 256));
-    for (auto& rtInstanceBuff : m_pRTInstanceBuffers)
-    {
-        rtInstanceBuff = m_pDevice->CreateBuffer(
-            instanceDescSize,
-            D3D12_RESOURCE_FLAG_NONE,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            D3D12_HEAP_TYPE_UPLOAD,
-            L"RTInstanceDescBuffer"
-        );
-        m_pDevice->WriteBuffer(rtInstanceBuff, instanceDescs.data(), instanceDescSize);
-    }
+    // インスタンス情報はフレームの動的バッファに配置 (構築の完了まで待機するので再利用されない)
+    auto instanceCount = m_pScene->GetActorCount();
+    auto instanceDescs = m_pDevice->AllocateDynamic(instanceCount * sizeof(D3D12_RAYTRACING_INSTANCE_DESC), D3D12_RAYTRACING_INSTANCE_DESCS_BYTE_ALIGNMENT);
+    m_pScene->WriteRTInstanceDescs(reinterpret_cast<D3D12_RAYTRACING_INSTANCE_DESC*>(instanceDescs.pCpu));
 
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildASDesc{};
     auto& inputs = buildASDesc.Inputs;
     inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
     inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
     inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
-    inputs.NumDescs = UINT(instanceDescs.size());
-    inputs.InstanceDescs = m_pRTInstanceBuffers.front()->GetGPUVirtualAddress();
+    inputs.NumDescs = instanceCount;
+    inputs.InstanceDescs = instanceDescs.gpuAddress;
 
     // TLAS関連のバッファを確保
     auto tlas = CreateASBuffers(m_pDevice, buildASDesc, L"TLAS");
     auto tlasScratch = tlas.scratchBuffer;
     m_pTLAS = tlas.asBuffer;
     m_pTLASUpdate = tlas.updateBuffer;
+    m_tlasVersion = m_pScene->GetTransformVersion();
 
     // SRVの作成
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
@@ -329,15 +444,20 @@ void Renderer::BuildTLAS()
 
 void Renderer::UpdateTLAS()
 {
-    auto d3d12Device = m_pDevice->GetDevice();
-    auto frameIdx = m_pDevice->GetCurrentFrameIndex();
+    // 姿勢が変化したアクターがなければ更新不要
+    auto transformVersion = m_pScene->GetTransformVersion();
+    if (transformVersion == m_tlasVersion)
+    {
+        return;
+    }
+    m_tlasVersion = transformVersion;
 
-    std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
-    m_pScene->CreateRTInstanceDesc(instanceDescs);
+    auto d3d12Device = m_pDevice->GetDevice();
 
-    auto instanceDescSize = UINT(instanceDescs.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
-    auto rtInstanceBuff = m_pRTInstanceBuffers[frameIdx];
-    m_pDevice->WriteBuffer(rtInstanceBuff, instanceDescs.data(), instanceDescSize);
+    // インスタンス情報はこのフレームの動的バッファへ直接、並列に書き込む
+    auto instanceCount = m_pScene->GetActorCount();
+    auto instanceDescs = m_pDevice->AllocateDynamic(instanceCount * sizeof(D3D12_RAYTRACING_INSTANCE_DESC), D3D12_RAYTRACING_INSTANCE_DESCS_BYTE_ALIGNMENT);
+    m_pScene->WriteRTInstanceDescs(reinterpret_cast<D3D12_RAYTRACING_INSTANCE_DESC*>(instanceDescs.pCpu));
 
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC updateASDesc{};
     auto& inputs = updateASDesc.Inputs;
@@ -346,8 +466,8 @@ void Renderer::UpdateTLAS()
     inputs.Flags =
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE |
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
-    inputs.NumDescs = UINT(instanceDescs.size());
-    inputs.InstanceDescs = rtInstanceBuff->GetGPUVirtualAddress();
+    inputs.NumDescs = instanceCount;
+    inputs.InstanceDescs = instanceDescs.gpuAddress;
 
     // TLASを直接更新
     updateASDesc.SourceAccelerationStructureData = m_pTLAS->GetGPUVirtualAddress();
@@ -380,6 +500,9 @@ void Renderer::CreateGlobalRootSignature()
     // SceneCB: b0
     rootParam = CreateRootParam(D3D12_ROOT_PARAMETER_TYPE_CBV, 0);
     rootParams.push_back(rootParam);
+    // PassParam: b1 (sampleOffset, sampleCount)
+    rootParam = CreateRootConstants(2, 1);
+    rootParams.push_back(rootParam);
     // Sampler: s0
     samplerDesc = CreateStaticSamplerDesc(D3D12_FILTER_MIN_MAG_MIP_LINEAR, 0);
     samplerDescs.push_back(samplerDesc);
@@ -405,6 +528,12 @@ void Renderer::CreateLocalRootSignature()
     // OutputBuffer : u0
     rootParam = CreateRootParam(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0);
     rootParams.push_back(rootParam);
+    // AccumBuffer : u1
+    rootParam = CreateRootParam(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1);
+    rootParams.push_back(rootParam);
+    // SeedBuffer : u2
+    rootParam = CreateRootParam(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 2);
+    rootParams.push_back(rootParam);
     // ローカルルートシグネチャの作成
     m_pRayGenLocalRootSignature = m_pDevice->CreateRootSignature(rootParams, samplerDescs, L"LocalRootSignature:RayGen", /*isLocal*/ true);
     
@@ -451,21 +580,30 @@ void Renderer::CreateStateObject()
     CD3DX12_STATE_OBJECT_DESC stateObjDesc;
     stateObjDesc.SetStateObjectType(D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE);
 
-    // シェーダ登録
-    auto rayGenBin = SetupShader(L"raygen");
+    // 描画全体で固定の設定でシェーダーを特殊化
+    ShaderPermutation permutation{};
+    permutation.lightCount = m_pScene->GetLightCount();
+#ifndef _DEBUG
+    // デバッグ時はImGuiで変更できるため、最大反射回数は実行時に参照する
+    permutation.maxPathDepth = m_pScene->GetMaxPathDepth();
+#endif // _DEBUG
+
+    // シェーダ登録 (3つのライブラリは並列にセットアップ)
+    auto shaderBins = SetupShaders({ L"raygen", L"miss", L"closesthit" }, permutation);
+    const auto& rayGenBin = shaderBins[0];
     D3D12_SHADER_BYTECODE raygenShader{ rayGenBin.data(), rayGenBin.size() };
     auto rayGenDXIL = stateObjDesc.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
     rayGenDXIL->SetDXILLibrary(&raygenShader);
     rayGenDXIL->DefineExport(L"RayGen");
 
-    auto missBin = SetupShader(L"miss");
+    const auto& missBin = shaderBins[1];
     D3D12_SHADER_BYTECODE missShader{ missBin.data(), missBin.size() };
     auto missDXIL = stateObjDesc.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
     missDXIL->SetDXILLibrary(&missShader);
     missDXIL->DefineExport(L"Miss");
     missDXIL->DefineExport(L"ShadowMiss");
 
-    auto closestHitBin = SetupShader(L"closesthit");
+    const auto& closestHitBin = shaderBins[2];
     D3D12_SHADER_BYTECODE closestHitShader{ closestHitBin.data(), closestHitBin.size() };
     auto closestHitDXIL = stateObjDesc.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
     closestHitDXIL->SetDXILLibrary(&closestHitShader);
@@ -543,6 +681,24 @@ void Renderer::CreateOutputBuffer()
     D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
     uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
     m_outputBufferDescHeap = m_pDevice->CreateUAV(m_pOutputBuffer.Get(), &uavDesc);
+
+    // サンプルの蓄積用バッファ (パス間で状態を引き継ぐ)
+    m_pAccumBuffer = m_pDevice->CreateTexture2D(
+        width, height,
+        DXGI_FORMAT_R32G32B32A32_FLOAT,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        D3D12_HEAP_TYPE_DEFAULT
+    );
+    m_accumBufferDescHeap = m_pDevice->CreateUAV(m_pAccumBuffer.Get(), &uavDesc);
+    m_pSeedBuffer = m_pDevice->CreateTexture2D(
+        width, height,
+        DXGI_FORMAT_R32_UINT,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        D3D12_HEAP_TYPE_DEFAULT
+    );
+    m_seedBufferDescHeap = m_pDevice->CreateUAV(m_pSeedBuffer.Get(), &uavDesc);
     Print(PrintInfoType::RTCAMP10, L"出力用バッファ(UAV)の作成 完了");
 }
 
@@ -555,6 +711,8 @@ void Renderer::CreateShaderTable()
     UINT rayGenRecordSize = 0;
     rayGenRecordSize += D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
     rayGenRecordSize += sizeof(D3D12_GPU_DESCRIPTOR_HANDLE); // OutputBuffer: u0
+    rayGenRecordSize += sizeof(D3D12_GPU_DESCRIPTOR_HANDLE); // AccumBuffer: u1
+    rayGenRecordSize += sizeof(D3D12_GPU_DESCRIPTOR_HANDLE); // SeedBuffer: u2
     rayGenRecordSize = ROUND_UP(rayGenRecordSize, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
 
     // Miss: ShaderId
@@ -604,8 +762,7 @@ void Renderer::CreateShaderTable()
     m_pRTStateObject.As(&pRTStateObjectProps);
 
     // 各シェーダーレコードの書き込み
-    void* mapped = nullptr;
-    m_pShaderTable->Map(0, nullptr, &mapped);
+    void* mapped = m_pDevice->Map(m_pShaderTable);
     uint8_t* pStart = static_cast<uint8_t*>(mapped);
     // RayGenシェーダー
     auto rayGenShaderStart = pStart;
@@ -621,6 +778,10 @@ void Renderer::CreateShaderTable()
         p += WriteShaderId(p, id);
         // OutputBuffer: u0
         p += WriteGPUDescriptorHeap(p, m_outputBufferDescHeap);
+        // AccumBuffer: u1
+        p += WriteGPUDescriptorHeap(p, m_accumBufferDescHeap);
+        // SeedBuffer: u2
+        p += WriteGPUDescriptorHeap(p, m_seedBufferDescHeap);
     }
 
     // Missシェーダー
@@ -654,7 +815,7 @@ void Renderer::CreateShaderTable()
         auto recordStart = hitGroupStart;
         recordStart = m_pScene->WriteHitGroupShaderRecord(recordStart, hitGroupRecordSize, m_pRTStateObject);
     }
-    m_pShaderTable->Unmap(0, nullptr);
+    m_pDevice->Unmap(m_pShaderTable);
     Print(PrintInfoType::RTCAMP10, L"シェーダーテーブル作成 完了");
 
     // DispatchRays用の情報をセット
@@ -683,16 +844,250 @@ void Renderer::CreateShaderTable()
     Print(PrintInfoType::RTCAMP10, L"DispatchRayDesc設定 完了");
 }
 
-void Renderer::OutputImage(ComPtr<ID3D12Resource> imageBuffer)
+/// <summary>
+/// レイトレース用のパイプライン状態の設定
+/// </summary>
+void Renderer::SetDispatchState()
+{
+    ID3D12DescriptorHeap* descriptorHeaps[] = {
+        m_pDevice->GetDescriptorHeap().Get(),
+    };
+    m_pCmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+    m_pCmdList->SetComputeRootSignature(m_pGlobalRootSignature.Get());
+    m_pCmdList->SetComputeRootDescriptorTable(0, m_tlasDescHeap.gpuHandle);
+    // 背景テクスチャ
+    m_pCmdList->SetComputeRootDescriptorTable(1, m_pScene->GetBackgroundTex().srv.gpuHandle);
+    // 定数バッファの設定
+    m_pCmdList->SetComputeRootConstantBufferView(2, m_pScene->GetConstantBufferAddress());
+    m_pCmdList->SetPipelineState1(m_pRTStateObject.Get());
+}
+
+/// <summary>
+/// チェックポイント用のリソースの作成
+/// </summary>
+void Renderer::CreateCheckpointResources()
+{
+    auto d3d12Device = m_pDevice->GetDevice();
+
+    // 蓄積バッファとシードバッファを1つのReadbackバッファに配置
+    UINT64 accumSize = 0;
+    UINT64 seedSize = 0;
+    auto accumDesc = m_pAccumBuffer->GetDesc();
+    auto seedDesc = m_pSeedBuffer->GetDesc();
+    d3d12Device->GetCopyableFootprints(&accumDesc, 0, 1, 0, &m_accumFootprint, nullptr, nullptr, &accumSize);
+    auto seedOffset = ROUND_UP(accumSize, UINT64(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+    d3d12Device->GetCopyableFootprints(&seedDesc, 0, 1, seedOffset, &m_seedFootprint, nullptr, nullptr, &seedSize);
+
+    m_pCheckpointReadback = m_pDevice->CreateBuffer(
+        seedOffset + seedSize,
+        D3D12_RESOURCE_FLAG_NONE,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_HEAP_TYPE_READBACK,
+        L"CheckpointReadback"
+    );
+    m_pPassFence = m_pDevice->CreateFence();
+    m_passFenceValue = 0;
+
+    m_pCheckpoint = std::make_unique<Checkpoint>(m_pDevice, m_checkpointFile, m_width, m_height);
+    m_lastCheckpointTime = std::chrono::system_clock::now();
+}
+
+/// <summary>
+/// チェックポイントからの蓄積状態の復元
+/// </summary>
+void Renderer::RestoreCheckpoint()
+{
+    Checkpoint::State state{};
+    if (!m_pCheckpoint->Open(m_isResume) || !m_pCheckpoint->GetLatest(state))
+    {
+        if (m_isResume)
+        {
+            Print(PrintInfoType::RTCAMP10, L"有効なチェックポイントがないため最初から描画します");
+        }
+        return;
+    }
+    if (state.frame < m_startFrame || (m_endFrame > 0 && state.frame >= m_endFrame))
+    {
+        Print(PrintInfoType::RTCAMP10, "チェックポイントが描画範囲外のため最初から描画します: ", state.frame);
+        return;
+    }
+
+    // 蓄積バッファとシードバッファへ書き戻す
+    auto readbackSize = m_pCheckpointReadback->GetDesc().Width;
+    auto uploadBuffer = m_pDevice->CreateBuffer(
+        readbackSize,
+        D3D12_RESOURCE_FLAG_NONE,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        D3D12_HEAP_TYPE_UPLOAD,
+        L"CheckpointUpload"
+    );
+    auto dst = static_cast<uint8_t*>(m_pDevice->Map(uploadBuffer));
+    auto src = reinterpret_cast<const uint8_t*>(state.accum);
+    auto copyRows = [&](const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint, size_t pixelSize)
+    {
+        auto rowBytes = pixelSize * m_width;
+        for (UINT y = 0; y < m_height; ++y)
+        {
+            memcpy(dst + footprint.Offset + size_t(footprint.Footprint.RowPitch) * y, src, rowBytes);
+            src += rowBytes;
+        }
+    };
+    copyRows(m_accumFootprint, sizeof(Float4));
+    copyRows(m_seedFootprint, sizeof(uint32_t));
+    m_pDevice->Unmap(uploadBuffer);
+
+    auto cmdList = m_pDevice->CreateCommandList();
+    D3D12_RESOURCE_BARRIER barriers[] = {
+        CD3DX12_RESOURCE_BARRIER::Transition(m_pAccumBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST),
+        CD3DX12_RESOURCE_BARRIER::Transition(m_pSeedBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST),
+    };
+    cmdList->ResourceBarrier(_countof(barriers), barriers);
+    CD3DX12_TEXTURE_COPY_LOCATION accumDst(m_pAccumBuffer.Get(), 0);
+    CD3DX12_TEXTURE_COPY_LOCATION accumSrc(uploadBuffer.Get(), m_accumFootprint);
+    cmdList->CopyTextureRegion(&accumDst, 0, 0, 0, &accumSrc, nullptr);
+    CD3DX12_TEXTURE_COPY_LOCATION seedDst(m_pSeedBuffer.Get(), 0);
+    CD3DX12_TEXTURE_COPY_LOCATION seedSrc(uploadBuffer.Get(), m_seedFootprint);
+    cmdList->CopyTextureRegion(&seedDst, 0, 0, 0, &seedSrc, nullptr);
+    for (auto& barrier : barriers)
+    {
+        std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+    }
+    cmdList->ResourceBarrier(_countof(barriers), barriers);
+    cmdList->Close();
+    m_pDevice->ExecuteCommandList(cmdList);
+    m_pDevice->WaitForGpu();
+
+    // チェックポイントのフレームから再開
+    m_currentFrame = state.frame;
+    m_resumeSampleOffset = state.sampleCount;
+    std::wstringstream resumeWSS;
+    resumeWSS << L"チェックポイントから再開: Frame " << state.frame << L" | " << state.sampleCount << L" samples";
+    Print(PrintInfoType::RTCAMP10, resumeWSS.str());
+}
+
+/// <summary>
+/// パス単位でのコマンドの実行
+/// </summary>
+/// <param name="sampleCount">このパスまでに蓄積したサンプル数</param>
+void Renderer::SubmitPass(UINT sampleCount)
+{
+    // 前回の書き込みが完了していて、指定間隔が経過していればチェックポイントを作成
+    auto now = std::chrono::system_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_lastCheckpointTime).count();
+    bool isCheckpoint = elapsed >= m_checkpointInterval && !m_pCheckpoint->IsBusy();
+    if (isCheckpoint)
+    {
+        D3D12_RESOURCE_BARRIER barriers[] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_pAccumBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_pSeedBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+        };
+        m_pCmdList->ResourceBarrier(_countof(barriers), barriers);
+        CD3DX12_TEXTURE_COPY_LOCATION accumDst(m_pCheckpointReadback.Get(), m_accumFootprint);
+        CD3DX12_TEXTURE_COPY_LOCATION accumSrc(m_pAccumBuffer.Get(), 0);
+        m_pCmdList->CopyTextureRegion(&accumDst, 0, 0, 0, &accumSrc, nullptr);
+        CD3DX12_TEXTURE_COPY_LOCATION seedDst(m_pCheckpointReadback.Get(), m_seedFootprint);
+        CD3DX12_TEXTURE_COPY_LOCATION seedSrc(m_pSeedBuffer.Get(), 0);
+        m_pCmdList->CopyTextureRegion(&seedDst, 0, 0, 0, &seedSrc, nullptr);
+        for (auto& barrier : barriers)
+        {
+            std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+        }
+        m_pCmdList->ResourceBarrier(_countof(barriers), barriers);
+    }
+
+    m_pCmdList->Close();
+    // 最初のパスではBLASの更新を先に実行する (以降のパスでは記録済みのリストはない)
+    m_pCmdListPool->Submit(m_pCmdList);
+    m_pDevice->Signal(m_pPassFence, ++m_passFenceValue);
+
+    // GPUの完了後に別スレッドでファイルへ書き込む
+    if (isCheckpoint)
+    {
+        // チェックポイントより前のフレームの画像は先に出力しておく (再開時に失われないよう)
+        FlushReadbacks();
+        m_pCheckpoint->WriteAsync(m_pCheckpointReadback, m_accumFootprint, m_seedFootprint, m_pPassFence, m_passFenceValue, m_currentFrame, sampleCount);
+        m_lastCheckpointTime = now;
+    }
+
+    // CPUが先行しすぎないよう1つ前のパスの完了を待機 (チェックポイントの間隔を実時間に合わせる)
+    m_pDevice->WaitForFence(m_pPassFence, m_passFenceValue - 1);
+
+    // 同じアロケーターで次のパスの記録を継続
+    m_pCmdList->Reset(m_pDevice->GetCurrentCommandAllocator().Get(), nullptr);
+    SetDispatchState();
+}
+
+/// <summary>
+/// 画像出力用の読み戻しリングの作成
+/// </summary>
+void Renderer::CreateReadbackResources()
+{
+    auto outputDesc = m_pOutputBuffer->GetDesc();
+    UINT64 totalBytes = 0;
+    m_pDevice->GetDevice()->GetCopyableFootprints(&outputDesc, 0, 1, 0, &m_outputFootprint, nullptr, nullptr, &totalBytes);
+    for (auto& slot : m_readbackSlots)
+    {
+        slot.buffer = m_pDevice->CreateBuffer(
+            size_t(totalBytes),
+            D3D12_RESOURCE_FLAG_NONE,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_HEAP_TYPE_READBACK,
+            L"OutputReadback"
+        );
+        slot.fenceValue = 0;
+        slot.frame = -1;
+    }
+    m_readbackIndex = 0;
+}
+
+/// <summary>
+/// 読み戻しのコピーの記録
+/// 同じスロットを使用した過去のフレームは先に出力しておく
+/// </summary>
+void Renderer::RecordReadback()
+{
+    FlushReadback(m_readbackIndex);
+    auto& slot = m_readbackSlots[m_readbackIndex];
+    CD3DX12_TEXTURE_COPY_LOCATION readbackDst(slot.buffer.Get(), m_outputFootprint);
+    CD3DX12_TEXTURE_COPY_LOCATION readbackSrc(m_pOutputBuffer.Get(), 0);
+    m_pCmdList->CopyTextureRegion(&readbackDst, 0, 0, 0, &readbackSrc, nullptr);
+}
+
+void Renderer::CommitReadback(int frame)
+{
+    auto& slot = m_readbackSlots[m_readbackIndex];
+    slot.fenceValue = m_pDevice->SignalQueue();
+    slot.frame = frame;
+    m_readbackIndex = (m_readbackIndex + 1) % UINT(m_readbackSlots.size());
+}
+
+void Renderer::FlushReadback(UINT slotIndex)
+{
+    auto& slot = m_readbackSlots[slotIndex];
+    if (slot.frame < 0)
+    {
+        return;
+    }
+    m_pDevice->WaitForFence(slot.fenceValue);
+    OutputImage(slot.buffer, slot.frame, m_outputFootprint.Footprint.RowPitch);
+    slot.frame = -1;
+}
+
+void Renderer::FlushReadbacks()
+{
+    for (UINT i = 0; i < UINT(m_readbackSlots.size()); ++i)
+    {
+        FlushReadback((m_readbackIndex + i) % UINT(m_readbackSlots.size()));
+    }
+}
+
+void Renderer::OutputImage(ComPtr<ID3D12Resource> imageBuffer, int frame, UINT rowPitch)
 {
     // CPU側で画像の出力
-    std::ostringstream sout;
-    sout << std::setw(3) << std::setfill('0') << m_currentFrame;
-    std::string filename = OUTPUT_DIR + sout.str() + ".png";
-    void* pixel = nullptr;
-    imageBuffer->Map(0, nullptr, &pixel);
-    fpng_encode_image_to_file(filename.c_str(), pixel, m_width, m_height, 4, 0);
-    imageBuffer->Unmap(0, nullptr);
+    void* pixel = m_pDevice->Map(imageBuffer);
+    WriteFrameImage(frame, pixel, m_width, m_height, rowPitch);
+    D3D12_RANGE writeRange{ 0, 0 };
+    m_pDevice->Unmap(imageBuffer, &writeRange);
 }
 
 #ifdef _DEBUG
@@ -1,43 +1,6 @@
 #include "scene/actor.hpp"
 #include "utils/dxr_util.h"
 
-Actor::ActorNode::ActorNode()
-{
-    m_trans = ZeroVector();
-    m_rot = IdentityQuat();
-    m_scale = ZeroVector();
-    m_localMtx = IdentityMtx();
-    m_worldMtx = IdentityMtx();
-}
-
-Actor::ActorNode::~ActorNode()
-{
-    m_children.clear();
-}
-
-void Actor::ActorNode::UpdateLocalMatrix()
-{
-    auto transMtx = XMMatrixTranslationFromVector(m_trans);
-    auto rotMtx = XMMatrixRotationQuaternion(m_rot);
-    auto scaleMtx = XMMatrixScalingFromVector(m_scale);
-    m_localMtx = scaleMtx * rotMtx * transMtx;
-}
-
-void Actor::ActorNode::UpdateWorldMatrix(Matrix parentMtx)
-{
-    m_worldMtx = m_localMtx * parentMtx;
-}
-
-void Actor::ActorNode::UpdateMatrix(Matrix parentMtx)
-{
-    UpdateLocalMatrix();
-    UpdateWorldMatrix(parentMtx);
-    for (auto& child : m_children)
-    {
-        child->UpdateMatrix(m_worldMtx);
-    }
-}
-
 Actor::ActorMaterial::ActorMaterial(std::unique_ptr<Device>& device, const Model::Material& srcMat) :
     m_pDevice(device)
 {
@@ -48,23 +11,21 @@ Actor::ActorMaterial::ActorMaterial(std::unique_ptr<Device>& device, const Model
     m_materialParam.diffuse.z = diffuse.z;
     m_materialParam.diffuse.w = 1.0f;
 
-    // バックバッファ枚数分作成
+    // 値は作成時に確定するため、フレームごとには複製しない
     auto cbSize = UINT(ROUND_UP(sizeof(MaterialParam), 256));
-    if (device->CreateConstantBuffer(m_pMatrialCB, cbSize, L"MaterialCB"))
-    {
-        auto backBufferCount = device->BackBufferCount;
-        m_cbv.resize(backBufferCount);
-        for (size_t i = 0; i < backBufferCount; i++)
-        {
-            auto matCB = m_pMatrialCB[i];
-            device->WriteBuffer(matCB, &m_materialParam, cbSize);
-            D3D12_CONSTANT_BUFFER_VIEW_DESC cbDesc{};
-            cbDesc.BufferLocation = matCB->GetGPUVirtualAddress();
-            cbDesc.SizeInBytes = cbSize;
-            m_cbv[i] = device->AllocateDescriptorHeap();
-            device->GetDevice()->CreateConstantBufferView(&cbDesc, m_cbv[i].cpuHandle);
-        }
-    }
+    m_pMatrialCB = device->CreateBuffer(
+        cbSize,
+        D3D12_RESOURCE_FLAG_NONE,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        D3D12_HEAP_TYPE_UPLOAD,
+        L"MaterialCB"
+    );
+    device->WriteBuffer(m_pMatrialCB, &m_materialParam, sizeof(MaterialParam));
+    D3D12_CONSTANT_BUFFER_VIEW_DESC cbDesc{};
+    cbDesc.BufferLocation = m_pMatrialCB->GetGPUVirtualAddress();
+    cbDesc.SizeInBytes = cbSize;
+    m_cbv = device->AllocateDescriptorHeap();
+    device->GetDevice()->CreateConstantBufferView(&cbDesc, m_cbv.cpuHandle);
 
 }
 
@@ -72,10 +33,7 @@ Actor::ActorMaterial::~ActorMaterial()
 {
     if (m_pDevice)
     {
-        for (auto& cbv : m_cbv)
-        {
-            m_pDevice->DeallocateDescriptorHeap(cbv);
-        }
+        m_pDevice->DeallocateDescriptorHeap(m_cbv);
     }
 }
 
@@ -84,57 +42,55 @@ void Actor::ActorMaterial::SetTexture(TextureResource& texRes)
     m_texture = texRes;
 }
 
-Actor::Actor(std::unique_ptr<Device>& device, const Model* model) :
+Actor::Actor(std::unique_ptr<Device>& device, std::shared_ptr<const Model> model) :
     m_pDevice(device),
     m_modelRef(model),
-    m_worldMtx(IdentityMtx()),
-    m_worldPos(Float3(0, 0, 0))
+    m_committedMtx(IdentityMtx())
 {
 }
 
 Actor::~Actor()
 {
-    m_nodes.clear();
+    if (m_pSkinning && m_pDevice)
+    {
+        for (auto& descriptor : m_pSkinning->descriptors)
+        {
+            m_pDevice->DeallocateDescriptorHeap(descriptor);
+        }
+    }
 }
 
+/// <summary>
+/// 姿勢の変更 (計算はActorTransformで行い、変更の追跡のみこちらで行う)
+/// </summary>
 void Actor::Translate(Float3 trans)
 {
-    auto transMtx = XMMatrixTranslation(trans.x, trans.y, trans.z);
-    m_worldMtx *= transMtx;
+    m_transform.Translate(trans);
+    m_isDirty = true;
 }
 
-/// <summary>
-/// 回転処理
-/// </summary>
 void Actor::Rotate(float angle, float startDeg, Float3 up)
 {
-    float theta = angle * XM_2PI + XMConvertToDegrees(startDeg);
-    auto rotMtx = XMMatrixRotationAxis(XMLoadFloat3(&up), theta);
-    auto transMtx = XMMatrixTranslation(m_worldPos.x, m_worldPos.y, m_worldPos.z);
-    m_worldMtx = rotMtx * transMtx;
+    m_transform.Rotate(angle, startDeg, up);
+    m_isDirty = true;
 }
 
 void Actor::MoveAnimInCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos)
 {
-    float t = (currentTime - startTime) / (endTime - startTime);
-    float s = EaseInCubic(t);
-    Float3 pos = Lerp(startPos, endPos, t);
-    SetWorldPos(pos);
+    m_transform.MoveAnimInCubic(currentTime, startTime, endTime, startPos, endPos);
+    m_isDirty = true;
 }
 
 void Actor::SetRotation(float degree, Float3 up)
 {
-    float radian = XMConvertToRadians(degree);
-    auto rotMtx = XMMatrixRotationAxis(XMLoadFloat3(&up), radian);
-    auto transMtx = XMMatrixTranslation(m_worldPos.x, m_worldPos.y, m_worldPos.z);
-    m_worldMtx = rotMtx * transMtx;
+    m_transform.SetRotation(degree, up);
+    m_isDirty = true;
 }
 
 void Actor::SetWorldPos(Float3 worldPos)
 {
-    m_worldPos = worldPos;
-    auto transMtx = XMMatrixTranslation(m_worldPos.x, m_worldPos.y, m_worldPos.z);
-    m_worldMtx = transMtx;
+    m_transform.SetWorldPos(worldPos);
+    m_isDirty = true;
 }
 
 void Actor::SetMaterialHitGroup(const std::wstring& hitGroupName)
@@ -145,72 +101,181 @@ void Actor::SetMaterialHitGroup(const std::wstring& hitGroupName)
     }
 }
 
-void Actor::UpdateMatrices()
+bool Actor::UpdateMatrices()
 {
-    for (auto& node : m_nodes)
+    // 初回 (version 0) は必ず更新
+    bool isWorldChanged = m_transformVersion == 0 || (m_isDirty && !MatrixEqual(m_transform.worldMtx, m_committedMtx));
+    m_isDirty = false;
+    // ノード階層はモデル空間で更新するため、アクターの移動では再計算しない
+    bool isPoseChanged = m_hierarchy.Update(IdentityMtx(), false);
+    m_isPoseDirty |= isPoseChanged;
+    bool isUpdated = isWorldChanged || isPoseChanged;
+    if (isUpdated)
     {
-        node->UpdateMatrix(m_worldMtx);
+        m_committedMtx = m_transform.worldMtx;
+        m_transformVersion++;
     }
+    return isUpdated;
+}
+
+/// <summary>
+/// 再生するアニメーションの設定
+/// </summary>
+/// <returns>モデルに指定のアニメーションがない場合はfalse</returns>
+bool Actor::SetAnimation(const std::wstring& name)
+{
+    m_animationIndex = m_modelRef->FindAnimation(name);
+    return m_animationIndex >= 0;
 }
 
-// BLASの更新
-// コマンドを積むまで
-void Actor::UpdateBLAS(ComPtr<ID3D12GraphicsCommandList4> cmdList)
+void Actor::SetAnimationTime(float time)
 {
-    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> rtGeoDesc;
-    CreateRTGeoDesc(rtGeoDesc);
+    if (m_animationIndex < 0)
+    {
+        return;
+    }
+    const auto& clip = m_modelRef->GetAnimations()[m_animationIndex];
+    if (clip.duration > 0.0f)
+    {
+        time = fmod(time, clip.duration);
+    }
+    clip.Apply(time, m_hierarchy);
+}
+
+/// <summary>
+/// スキニング用リソースの作成
+/// 頂点バッファとBLASをアクター固有に複製し、以降はリフィットで更新する
+/// </summary>
+void Actor::CreateSkinningResources()
+{
+    const auto& skinningData = m_modelRef->GetSkinningData();
+    m_pSkinning = std::make_unique<SkinningResources>();
+    auto& skinning = *m_pSkinning;
+    skinning.positions = skinningData.bindPositions;
+    skinning.normals = skinningData.bindNormals;
+    skinning.blasMatrices.resize(GetMeshGroupCount());
+    for (UINT group = 0; group < GetMeshGroupCount(); ++group)
+    {
+        // スキニングするグループの頂点はモデル空間に変換済み
+        auto nodeIndex = m_meshGroups[group].m_nodeIndex;
+        bool isIdentity = m_modelRef->IsSkinnedMeshGroup(group) || nodeIndex < 0;
+        XMStoreFloat3x4(&skinning.blasMatrices[group], isIdentity ? IdentityMtx() : m_hierarchy.GetWorldMatrix(nodeIndex));
+    }
+
+    auto name = m_modelRef->GetName();
+    auto posSize = sizeof(Float3) * skinning.positions.size();
+    auto mtxSize = sizeof(Mtx3x4) * skinning.blasMatrices.size();
+    auto flags = D3D12_RESOURCE_FLAG_NONE;
+    auto heapType = D3D12_HEAP_TYPE_DEFAULT;
+    m_pDevice->BeginUploadBatch();
+    skinning.position = m_pDevice->InitializeBuffer(posSize, skinning.positions.data(), flags, heapType, (name + L":SkinnedPosition").c_str());
+    skinning.normal = m_pDevice->InitializeBuffer(posSize, skinning.normals.data(), flags, heapType, (name + L":SkinnedNormal").c_str());
+    skinning.blasMatrixBuffer = m_pDevice->InitializeBuffer(mtxSize, skinning.blasMatrices.data(), flags, heapType, (name + L":SkinnedMatrixBuffer(BLAS)").c_str());
+
+    // 頂点属性のSRVをアクター固有のバッファに差し替え
+    for (auto& meshGroup : m_meshGroups)
+    {
+        for (auto& mesh : meshGroup.m_meshes)
+        {
+            mesh.m_vbAttrPos = m_pDevice->CreateSRV(skinning.position, mesh.m_vertexCount, mesh.m_vertexStart, DXGI_FORMAT_R32G32B32_FLOAT);
+            mesh.m_vbAttrNorm = m_pDevice->CreateSRV(skinning.normal, mesh.m_vertexCount, mesh.m_vertexStart, DXGI_FORMAT_R32G32B32_FLOAT);
+            skinning.descriptors.push_back(mesh.m_vbAttrPos);
+            skinning.descriptors.push_back(mesh.m_vbAttrNorm);
+        }
+    }
+    skinning.blasMatrixDescriptor = m_pDevice->CreateSRV(skinning.blasMatrixBuffer, GetMeshGroupCount() * 3, 0, UINT(sizeof(Float4)));
+    skinning.descriptors.push_back(skinning.blasMatrixDescriptor);
 
+    // リフィット可能なBLASの構築
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> rtGeoDesc;
+    m_modelRef->CreateRTGeoDesc(rtGeoDesc, skinning.position->GetGPUVirtualAddress(), skinning.blasMatrixBuffer->GetGPUVirtualAddress());
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildASDesc{};
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs = buildASDesc.Inputs;
+    auto& inputs = buildASDesc.Inputs;
     inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
     inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
     inputs.NumDescs = UINT(rtGeoDesc.size());
     inputs.pGeometryDescs = rtGeoDesc.data();
-    // BLAS更新のためフラグを設定
     inputs.Flags =
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE |
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+
+    auto blas = CreateASBuffers(m_pDevice, buildASDesc, name + L":SkinnedBLAS");
+    skinning.blas = blas.asBuffer;
+    skinning.blasUpdate = blas.updateBuffer;
+    buildASDesc.ScratchAccelerationStructureData = blas.scratchBuffer->GetGPUVirtualAddress();
+    buildASDesc.DestAccelerationStructureData = skinning.blas->GetGPUVirtualAddress();
 
-    auto frameIndex = m_pDevice->GetCurrentFrameIndex();
-    // BLASを直接更新
-    auto updateBuffer = m_pBLASUpdateBuffer;
-    buildASDesc.DestAccelerationStructureData = m_pBLAS->GetGPUVirtualAddress();
-    buildASDesc.SourceAccelerationStructureData = m_pBLAS->GetGPUVirtualAddress();
-    buildASDesc.ScratchAccelerationStructureData = updateBuffer->GetGPUVirtualAddress();
+    auto cmd = m_pDevice->GetUploadCommandList();
+    cmd->BuildRaytracingAccelerationStructure(&buildASDesc, 0, nullptr);
+    auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(skinning.blas.Get());
+    cmd->ResourceBarrier(1, &barrier);
+    m_pDevice->KeepUntilUploaded(blas.scratchBuffer);
+    m_pDevice->EndUploadBatch();
 
-    // BLAS再構築
-    cmdList->BuildRaytracingAccelerationStructure(&buildASDesc, 0, nullptr);
-    auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(m_pBLAS.Get());
-    cmdList->ResourceBarrier(1, &barrier);
+    m_isPoseDirty = true;
 }
 
-void Actor::UpdateTransform()
+/// <summary>
+/// CPUスキニングとBLASのリフィット
+/// </summary>
+/// <param name="cmdList"></param>
+void Actor::UpdateSkinning(ComPtr<ID3D12GraphicsCommandList4> cmdList)
 {
-    auto frameIndex = m_pDevice->GetCurrentFrameIndex();
-
-    std::vector<Mtx3x4> blasMatrices;
-    auto groupCount = UINT(m_meshGroups.size());
-    blasMatrices.resize(groupCount);
-    // TLASで設定した行列成分の打消し
-    for (UINT i = 0; i < groupCount; ++i)
+    if (!m_pSkinning || !m_isPoseDirty)
     {
-        auto node = m_meshGroups[i].m_node;
-        auto invRoot = XMMatrixInverse(nullptr, m_worldMtx);
-        XMStoreFloat3x4(&blasMatrices[i], node->GetWorldMatrix() * invRoot);
+        return;
     }
+    m_isPoseDirty = false;
+    auto& skinning = *m_pSkinning;
 
-    auto bufferBytes = UINT(sizeof(Mtx3x4) * groupCount);
-    void* mapped = nullptr;
-    D3D12_RANGE range;
-    range.Begin = bufferBytes * frameIndex;
-    range.End = range.Begin + bufferBytes;
-    m_pBLASMatrices->Map(0, &range, &mapped);
-    if (mapped)
+    // 頂点の変形 (並列)
+    SkinVertices(m_modelRef->GetSkinningData(), m_modelRef->GetSkins(), m_hierarchy, skinning.positions.data(), skinning.normals.data());
+    for (UINT group = 0; group < GetMeshGroupCount(); ++group)
     {
-        auto p = static_cast<uint8_t*>(mapped) + range.Begin;
-        memcpy(p, blasMatrices.data(), bufferBytes);
-        m_pBLASMatrices->Unmap(0, & range);
+        auto nodeIndex = m_meshGroups[group].m_nodeIndex;
+        if (!m_modelRef->IsSkinnedMeshGroup(group) && nodeIndex >= 0)
+        {
+            XMStoreFloat3x4(&skinning.blasMatrices[group], m_hierarchy.GetWorldMatrix(nodeIndex));
+        }
     }
+
+    // フレームの動的バッファへ書き込み (頂点, 法線, 行列の順)
+    auto posSize = sizeof(Float3) * skinning.positions.size();
+    auto mtxSize = sizeof(Mtx3x4) * skinning.blasMatrices.size();
+    auto upload = m_pDevice->AllocateDynamic(posSize * 2 + mtxSize, sizeof(Float4));
+    memcpy(upload.pCpu, skinning.positions.data(), posSize);
+    memcpy(upload.pCpu + posSize, skinning.normals.data(), posSize);
+    memcpy(upload.pCpu + posSize * 2, skinning.blasMatrices.data(), mtxSize);
+
+    cmdList->CopyBufferRegion(skinning.position.Get(), 0, upload.resource.Get(), upload.offset, posSize);
+    cmdList->CopyBufferRegion(skinning.normal.Get(), 0, upload.resource.Get(), upload.offset + posSize, posSize);
+    cmdList->CopyBufferRegion(skinning.blasMatrixBuffer.Get(), 0, upload.resource.Get(), upload.offset + posSize * 2, mtxSize);
+    D3D12_RESOURCE_BARRIER barriers[] = {
+        CD3DX12_RESOURCE_BARRIER::Transition(skinning.position.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+        CD3DX12_RESOURCE_BARRIER::Transition(skinning.normal.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+        CD3DX12_RESOURCE_BARRIER::Transition(skinning.blasMatrixBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+    };
+    cmdList->ResourceBarrier(_countof(barriers), barriers);
+
+    // BLASのリフィット (トポロジーは不変のため再構築は不要)
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> rtGeoDesc;
+    m_modelRef->CreateRTGeoDesc(rtGeoDesc, skinning.position->GetGPUVirtualAddress(), skinning.blasMatrixBuffer->GetGPUVirtualAddress());
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC updateASDesc{};
+    auto& inputs = updateASDesc.Inputs;
+    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+    inputs.NumDescs = UINT(rtGeoDesc.size());
+    inputs.pGeometryDescs = rtGeoDesc.data();
+    inputs.Flags =
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE |
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE |
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+    updateASDesc.SourceAccelerationStructureData = skinning.blas->GetGPUVirtualAddress();
+    updateASDesc.DestAccelerationStructureData = skinning.blas->GetGPUVirtualAddress();
+    updateASDesc.ScratchAccelerationStructureData = skinning.blasUpdate->GetGPUVirtualAddress();
+    cmdList->BuildRaytracingAccelerationStructure(&updateASDesc, 0, nullptr);
+    auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(skinning.blas.Get());
+    cmdList->ResourceBarrier(1, &barrier);
 }
 
 uint8_t* Actor::WriteHitGroupShaderRecord(uint8_t* dst, UINT hitGroupRecordSize, ComPtr<ID3D12StateObjectProperties> rtStateObjectProps)
@@ -277,99 +342,3 @@ std::shared_ptr<Actor::ActorMaterial> Actor::GetMaterial(UINT idx) const
 {
     return m_materials[idx];
 }
-
-void Actor::CreateMatrixBufferBLAS(UINT mtxCount)
-{
-    const auto mtxStride = UINT(sizeof(Mtx3x4));
-    const auto mtxCountAll = mtxCount * m_pDevice->BackBufferCount;
-    auto buffSize = mtxStride * mtxCountAll;
-
-    // BLAS用の行列バッファを確保
-    m_pBLASMatrices = m_pDevice->CreateBuffer(
-        buffSize,
-        D3D12_RESOURCE_FLAG_NONE,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        D3D12_HEAP_TYPE_UPLOAD,
-        L"MatrixBuffer(BLAS)"
-    );
-    
-    auto numElements = mtxCountAll * 3;
-    // SRVの作成
-    m_blasMatrixDescriptor = m_pDevice->CreateSRV(m_pBLASMatrices.Get(), numElements, 0, sizeof(Float4));
-}
-
-void Actor::CreateBLAS()
-{
-    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> rtGeoDesc;
-    CreateRTGeoDesc(rtGeoDesc);
-
-    // 動的に更新を行うBLAS
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildASDesc{};
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs = buildASDesc.Inputs;
-    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
-    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-    inputs.NumDescs = UINT(rtGeoDesc.size());
-    inputs.pGeometryDescs = rtGeoDesc.data();
-    inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
-
-    auto cmd = m_pDevice->CreateCommandList();
-
-    // BLAS関連のバッファを作成
-    auto blas = CreateASBuffers(m_pDevice, buildASDesc, m_modelRef->GetName());
-    m_pBLAS = blas.asBuffer;
-    m_pBLASUpdateBuffer = blas.updateBuffer;
-
-    buildASDesc.ScratchAccelerationStructureData = blas.scratchBuffer->GetGPUVirtualAddress();
-    buildASDesc.DestAccelerationStructureData = blas.asBuffer->GetGPUVirtualAddress();
-
-    // BLAS構築
-    cmd->BuildRaytracingAccelerationStructure(&buildASDesc, 0, nullptr);
-    auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(m_pBLAS.Get());
-    cmd->ResourceBarrier(1, &barrier);
-    cmd->Close();
-    m_pDevice->ExecuteCommandList(cmd);
-
-    // 構築の完了を待機
-    m_pDevice->WaitForGpu();
-}
-
-void Actor::CreateRTGeoDesc(std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& rtGeoDesc)
-{
-    // 書き込み開始位置の調整
-    auto frameIndex = m_pDevice->GetCurrentFrameIndex();
-    const auto mtxSize = sizeof(Mtx3x4);
-    const auto mtxBuffSize = m_meshGroups.size() * mtxSize;
-    auto addressBase = m_pBLASMatrices->GetGPUVirtualAddress();
-    addressBase += mtxBuffSize * frameIndex;
-
-    ComPtr<ID3D12Resource> posBuffer;
-    posBuffer = m_modelRef->GetPositionBuffer();
-
-    UINT mtxIndex = 0;
-    for (const auto& meshGroup : m_meshGroups)
-    {
-        auto indexBuffer = m_modelRef->GetIndexBuffer();
-        for (const auto& mesh : meshGroup.m_meshes)
-        {
-            rtGeoDesc.emplace_back(D3D12_RAYTRACING_GEOMETRY_DESC{});
-            auto& desc = rtGeoDesc.back();
-            desc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-            desc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
-            auto& triangles = desc.Triangles;
-            // マトリックス情報
-            triangles.Transform3x4 = addressBase + mtxIndex * mtxSize;
-            // 頂点情報
-            triangles.VertexBuffer.StrideInBytes = sizeof(Float3);
-            triangles.VertexBuffer.StartAddress = posBuffer->GetGPUVirtualAddress();
-            triangles.VertexBuffer.StartAddress += mesh.GetVertexStart() * sizeof(Float3);
-            triangles.VertexCount = mesh.GetVertexCount();
-            triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-            // インデックス情報
-            triangles.IndexBuffer = indexBuffer->GetGPUVirtualAddress();
-            triangles.IndexBuffer += mesh.GetIndexStart() * sizeof(UINT);
-            triangles.IndexCount = mesh.GetIndexCount();
-            triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
-        }
-        mtxIndex++;
-    }
-}
@@ -0,0 +1,42 @@
+#include "scene/actor_transform.hpp"
+
+/// <summary>
+/// 平行移動
+/// </summary>
+void ActorTransform::Translate(Float3 trans)
+{
+    auto transMtx = XMMatrixTranslation(trans.x, trans.y, trans.z);
+    worldMtx *= transMtx;
+}
+
+/// <summary>
+/// 回転処理
+/// </summary>
+void ActorTransform::Rotate(float angle, float startDeg, Float3 up)
+{
+    float theta = angle * XM_2PI + XMConvertToDegrees(startDeg);
+    auto rotMtx = XMMatrixRotationAxis(XMLoadFloat3(&up), theta);
+    auto transMtx = XMMatrixTranslation(worldPos.x, worldPos.y, worldPos.z);
+    worldMtx = rotMtx * transMtx;
+}
+
+void ActorTransform::MoveAnimInCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos)
+{
+    float t = (currentTime - startTime) / (endTime - startTime);
+    Float3 pos = Lerp(startPos, endPos, t);
+    SetWorldPos(pos);
+}
+
+void ActorTransform::SetRotation(float degree, Float3 up)
+{
+    float radian = XMConvertToRadians(degree);
+    auto rotMtx = XMMatrixRotationAxis(XMLoadFloat3(&up), radian);
+    auto transMtx = XMMatrixTranslation(worldPos.x, worldPos.y, worldPos.z);
+    worldMtx = rotMtx * transMtx;
+}
+
+void ActorTransform::SetWorldPos(Float3 pos)
+{
+    worldPos = pos;
+    worldMtx = XMMatrixTranslation(worldPos.x, worldPos.y, worldPos.z);
+}
@@ -0,0 +1,130 @@
+#include "scene/animation.hpp"
+#include "utils/parallel_util.h"
+
+namespace
+{
+    // 1バッチあたりの頂点数
+    const size_t SkinningBatchSize = 4096;
+}
+
+/// <summary>
+/// 指定時刻の値をサンプリング
+/// </summary>
+/// <param name="time">時刻 (秒)</param>
+/// <param name="isRotation">クォータニオンとして補間するか</param>
+Vector AnimationSampler::Sample(float time, bool isRotation) const
+{
+    auto keyCount = times.size();
+    if (keyCount == 0)
+    {
+        return isRotation ? IdentityQuat() : ZeroVector();
+    }
+    bool isCubic = interpolation == Interpolation::CubicSpline;
+    auto value = [&](size_t key) { return XMLoadFloat4(&values[isCubic ? key * 3 + 1 : key]); };
+    if (time <= times.front())
+    {
+        return value(0);
+    }
+    if (time >= times.back())
+    {
+        return value(keyCount - 1);
+    }
+
+    size_t key = size_t(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+    float deltaTime = times[key + 1] - times[key];
+    float t = (time - times[key]) / deltaTime;
+    switch (interpolation)
+    {
+    case Interpolation::Step:
+        return value(key);
+    case Interpolation::CubicSpline:
+    {
+        auto outTangent = XMVectorScale(XMLoadFloat4(&values[key * 3 + 2]), deltaTime);
+        auto inTangent = XMVectorScale(XMLoadFloat4(&values[(key + 1) * 3 + 0]), deltaTime);
+        auto result = XMVectorHermite(value(key), outTangent, value(key + 1), inTangent, t);
+        return isRotation ? XMQuaternionNormalize(result) : result;
+    }
+    default:
+        return isRotation ? XMQuaternionSlerp(value(key), value(key + 1), t) : XMVectorLerp(value(key), value(key + 1), t);
+    }
+}
+
+void AnimationClip::Apply(float time, TransformHierarchy& hierarchy) const
+{
+    for (const auto& channel : channels)
+    {
+        const auto& sampler = samplers[channel.samplerIndex];
+        switch (channel.path)
+        {
+        case AnimationChannel::Path::Translation:
+            hierarchy.SetTranslation(channel.nodeIndex, sampler.Sample(time, false));
+            break;
+        case AnimationChannel::Path::Rotation:
+            hierarchy.SetRotation(channel.nodeIndex, sampler.Sample(time, true));
+            break;
+        case AnimationChannel::Path::Scale:
+            hierarchy.SetScale(channel.nodeIndex, sampler.Sample(time, false));
+            break;
+        }
+    }
+}
+
+/// <summary>
+/// 線形ブレンドスキニング
+/// </summary>
+void SkinVertices(
+    const SkinningData& data,
+    const std::vector<Skin>& skins,
+    const TransformHierarchy& hierarchy,
+    Float3* dstPositions,
+    Float3* dstNormals)
+{
+    // スキン行列 = 逆バインド行列 * ジョイントの行列 (モデル空間)
+    std::vector<std::vector<Matrix>> skinMatrices(skins.size());
+    for (size_t s = 0; s < skins.size(); ++s)
+    {
+        const auto& skin = skins[s];
+        auto& matrices = skinMatrices[s];
+        matrices.resize(skin.joints.size());
+        for (size_t j = 0; j < skin.joints.size(); ++j)
+        {
+            auto jointMtx = skin.joints[j] < 0 ? IdentityMtx() : hierarchy.GetWorldMatrix(skin.joints[j]);
+            matrices[j] = XMMatrixMultiply(skin.inverseBindMatrices[j], jointMtx);
+        }
+    }
+
+    for (const auto& range : data.ranges)
+    {
+        const auto& matrices = skinMatrices[range.skinIndex];
+        auto jointCount = uint16_t(matrices.size());
+        ParallelFor(range.vertexCount, SkinningBatchSize, [&](size_t begin, size_t end)
+        {
+            for (size_t i = range.vertexStart + begin; i < range.vertexStart + end; ++i)
+            {
+                // 4ジョイントの行列をウェイトで合成
+                auto weights = XMLoadFloat4(&data.weights[i]);
+                const auto& joints = data.joints[i];
+                Vector splat[4] = {
+                    XMVectorSplatX(weights),
+                    XMVectorSplatY(weights),
+                    XMVectorSplatZ(weights),
+                    XMVectorSplatW(weights),
+                };
+                Matrix skinMtx;
+                skinMtx.r[0] = skinMtx.r[1] = skinMtx.r[2] = skinMtx.r[3] = XMVectorZero();
+                for (int k = 0; k < 4; ++k)
+                {
+                    const auto& jointMtx = matrices[joints[k] < jointCount ? joints[k] : 0];
+                    skinMtx.r[0] = XMVectorMultiplyAdd(jointMtx.r[0], splat[k], skinMtx.r[0]);
+                    skinMtx.r[1] = XMVectorMultiplyAdd(jointMtx.r[1], splat[k], skinMtx.r[1]);
+                    skinMtx.r[2] = XMVectorMultiplyAdd(jointMtx.r[2], splat[k], skinMtx.r[2]);
+                    skinMtx.r[3] = XMVectorMultiplyAdd(jointMtx.r[3], splat[k], skinMtx.r[3]);
+                }
+                auto pos = XMVector3Transform(XMLoadFloat3(&data.bindPositions[i]), skinMtx);
+                auto norm = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&data.bindNormals[i]), skinMtx));
+                XMStoreFloat3(&dstPositions[i], pos);
+                XMStoreFloat3(&dstNormals[i], norm);
+            }
+        });
+    }
+}
@@ -0,0 +1,120 @@
+#include "scene/baked_model.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+BakedModel::~BakedModel()
+{
+    Close();
+}
+
+/// <summary>
+/// ベイク済みファイルを読み取り専用でマップ
+/// </summary>
+/// <param name="path"></param>
+/// <returns>ファイルが存在し、形式が正しい場合にtrue</returns>
+bool BakedModel::Open(const std::wstring& path)
+{
+    Close();
+    if (!m_file.Open(path) || m_file.GetSize() < sizeof(Header))
+    {
+        Close();
+        return false;
+    }
+    m_pMapped = m_file.GetData();
+    const UINT64 fileSize = m_file.GetSize();
+
+    // ヘッダーとセクション範囲の検証
+    auto header = GetHeader();
+    bool isValid =
+        header->magic == Magic &&
+        header->version == Version &&
+        header->sectionCount == UINT(Section::Count);
+    for (UINT i = 0; isValid && i < UINT(Section::Count); ++i)
+    {
+        const auto& section = header->sections[i];
+        isValid =
+            section.offset % SectionAlignment == 0 &&
+            section.offset <= fileSize &&
+            section.size <= fileSize - section.offset;
+    }
+    if (!isValid)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void BakedModel::Close()
+{
+    m_pMapped = nullptr;
+    m_file.Close();
+}
+
+std::wstring BakedModel::GetString(const StringRef& ref) const
+{
+    auto strings = GetSection<wchar_t>(Section::String);
+    if (size_t(ref.offset) + ref.length > strings.size())
+    {
+        return std::wstring();
+    }
+    return std::wstring(strings.data() + ref.offset, ref.length);
+}
+
+/// <summary>
+/// ベイク済みファイルの書き込み
+/// 一時ファイルに書き込んでから置き換えるため、途中で失敗しても既存のファイルは壊れない
+/// </summary>
+/// <param name="path"></param>
+/// <param name="source">変換元のファイル情報</param>
+/// <param name="sections">Section順に並んだ各セクションの内容</param>
+/// <returns></returns>
+bool BakedModel::Write(const std::wstring& path, const SourceInfo& source, const std::array<std::span<const uint8_t>, size_t(Section::Count)>& sections)
+{
+    namespace fs = std::filesystem;
+    Header header{};
+    header.magic = Magic;
+    header.version = Version;
+    header.source = source;
+    header.sectionCount = UINT(Section::Count);
+    uint64_t offset = ROUND_UP(uint64_t(sizeof(Header)), SectionAlignment);
+    for (UINT i = 0; i < UINT(Section::Count); ++i)
+    {
+        header.sections[i].offset = offset;
+        header.sections[i].size = sections[i].size();
+        offset = ROUND_UP(offset + sections[i].size(), SectionAlignment);
+    }
+
+    const fs::path dstPath{ path };
+    auto tmpPath = dstPath;
+    tmpPath += L".tmp";
+    {
+        std::ofstream dst(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!dst)
+        {
+            return false;
+        }
+        const char padding[SectionAlignment] = {};
+        dst.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        uint64_t written = sizeof(Header);
+        for (UINT i = 0; i < UINT(Section::Count); ++i)
+        {
+            dst.write(padding, std::streamsize(header.sections[i].offset - written));
+            dst.write(reinterpret_cast<const char*>(sections[i].data()), std::streamsize(sections[i].size()));
+            written = header.sections[i].offset + sections[i].size();
+        }
+        if (!dst)
+        {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, dstPath, ec);
+    return !ec;
+}
+
+std::wstring BakedModel::GetBakedPath(const std::wstring& fileName)
+{
+    return RESOURCE_DIR L"/scene/" + fileName + L".bake";
+}
@@ -19,8 +19,8 @@ void Camera::Rotate(float deltaTime)
     float radius = 5.0f;
     float speed = 1.0f;
     float theta = deltaTime * speed * XM_2PI;
-    float posX = radius * std::cosf(theta);
-    float posZ = radius * std::sinf(theta);
+    float posX = radius * std::cos(theta);
+    float posZ = radius * std::sin(theta);
     Float3 origin(posX, 0.0f, posZ);
     UpdateLookAt(origin, m_param.Target, m_param.Up);
 }
@@ -31,7 +31,6 @@ void Camera::Rotate(float deltaTime)
 void Camera::MoveAnimInCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos)
 {
     float t = (currentTime - startTime) / (endTime - startTime);
-    float s = EaseInCubic(t);
     Float3 pos = Lerp(startPos, endPos, t);
     SetPosition(pos);
 }
@@ -42,7 +41,6 @@ void Camera::MoveAnimInCubic(float currentTime, float startTime, float endTime,
 void Camera::MoveAnimInOutCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos)
 {
     float t = (currentTime - startTime) / (endTime - startTime);
-    float s = EaseInOutCubic(t);
     Float3 pos = Lerp(startPos, endPos, t);
     SetPosition(pos);
 }
@@ -53,7 +51,6 @@ void Camera::MoveAnimInOutCubic(float currentTime, float startTime, float endTim
 void Camera::MoveAnimOutCubic(float currentTime, float startTime, float endTime, Float3 startPos, Float3 endPos)
 {
     float t = (currentTime - startTime) / (endTime - startTime);
-    float s = EaseOutCubic(t);
     Float3 pos = Lerp(startPos, endPos, t);
     SetPosition(pos);
 }
@@ -61,7 +58,6 @@ void Camera::MoveAnimOutCubic(float currentTime, float startTime, float endTime,
 void Camera::ChangeFovYInCubic(float currentTime, float startTime, float endTime, float startFovY, float endFovY)
 {
     float t = (currentTime - startTime) / (endTime - startTime);
-    float s = EaseInCubic(t);
     float fovY = std::lerp(startFovY, endFovY, t);
     SetFovY(fovY);
 }
@@ -0,0 +1,464 @@
+#include "scene/environment_map.hpp"
+#include "utils/parallel_util.h"
+
+#include <DirectXPackedVector.h>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    // 方向 -> [0,1]^2 (シェーダーのCalcOctahedralUVと同じ対応)
+    Float2 DirToOctahedral(const Float3& dir)
+    {
+        float l1 = fabsf(dir.x) + fabsf(dir.y) + fabsf(dir.z);
+        float px = dir.x / l1;
+        float pz = dir.z / l1;
+        if (dir.y < 0.0f)
+        {
+            float fx = (1.0f - fabsf(pz)) * (px >= 0.0f ? 1.0f : -1.0f);
+            float fz = (1.0f - fabsf(px)) * (pz >= 0.0f ? 1.0f : -1.0f);
+            px = fx;
+            pz = fz;
+        }
+        return Float2(px * 0.5f + 0.5f, pz * 0.5f + 0.5f);
+    }
+
+    // [0,1]^2 -> 八面体上の点 (L1ノルムが1, 正規化前)
+    // 八面体上の面積要素と立体角の関係は dω = 4 / |p|^3 dudv
+    Float3 OctahedralToPoint(float u, float v)
+    {
+        float px = u * 2.0f - 1.0f;
+        float pz = v * 2.0f - 1.0f;
+        float py = 1.0f - fabsf(px) - fabsf(pz);
+        if (py < 0.0f)
+        {
+            float fx = (1.0f - fabsf(pz)) * (px >= 0.0f ? 1.0f : -1.0f);
+            float fz = (1.0f - fabsf(px)) * (pz >= 0.0f ? 1.0f : -1.0f);
+            px = fx;
+            pz = fz;
+        }
+        return Float3(px, py, pz);
+    }
+
+    float Length(const Float3& p)
+    {
+        return sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+    }
+
+    // 正距円筒図法の画像のバイリニアサンプリング (u: atan2(z, x), v: acos(y))
+    XMVECTOR SampleEquirect(const DirectX::Image& src, const Float3& dir)
+    {
+        float theta = atan2f(dir.z, dir.x);
+        float phi = acosf((std::max)(-1.0f, (std::min)(1.0f, dir.y)));
+        float x = (theta + XM_PI) * XM_1DIV2PI * float(src.width) - 0.5f;
+        float y = phi * XM_1DIVPI * float(src.height) - 0.5f;
+        float fx = floorf(x);
+        float fy = floorf(y);
+        float tx = x - fx;
+        float ty = y - fy;
+        auto fetch = [&](int ix, int iy)
+        {
+            // 横方向は周期的, 縦方向は端でクランプ
+            ix = (ix % int(src.width) + int(src.width)) % int(src.width);
+            iy = (std::max)(0, (std::min)(int(src.height) - 1, iy));
+            auto row = reinterpret_cast<const XMFLOAT4*>(src.pixels + src.rowPitch * size_t(iy));
+            return XMLoadFloat4(&row[ix]);
+        };
+        int x0 = int(fx);
+        int y0 = int(fy);
+        XMVECTOR top = XMVectorLerp(fetch(x0, y0), fetch(x0 + 1, y0), tx);
+        XMVECTOR bottom = XMVectorLerp(fetch(x0, y0 + 1), fetch(x0 + 1, y0 + 1), tx);
+        return XMVectorLerp(top, bottom, ty);
+    }
+
+    // 累積分布からuを含む区間を探す
+    UINT FindInterval(std::span<const float> cdf, float u)
+    {
+        auto itr = std::upper_bound(cdf.begin(), cdf.end(), u);
+        auto index = ptrdiff_t(itr - cdf.begin()) - 1;
+        return UINT((std::max)(ptrdiff_t(0), (std::min)(index, ptrdiff_t(cdf.size()) - 2)));
+    }
+
+    // 重みの列から累積分布を作成 (合計が0の場合は一様分布)
+    void BuildCDF(std::span<const double> weights, float* cdf)
+    {
+        double total = 0.0;
+        for (auto w : weights)
+        {
+            total += w;
+        }
+        const size_t count = weights.size();
+        double sum = 0.0;
+        cdf[0] = 0.0f;
+        for (size_t i = 0; i < count; ++i)
+        {
+            sum += total > 0.0 ? weights[i] : 1.0;
+            cdf[i + 1] = float(sum / (total > 0.0 ? total : double(count)));
+        }
+        cdf[count] = 1.0f;
+    }
+}
+
+EnvironmentMap::~EnvironmentMap()
+{
+    Close();
+}
+
+/// <summary>
+/// キャッシュを開く
+/// キャッシュが存在しないか変換元が更新されている場合は変換してから開く
+/// </summary>
+/// <param name="fileName">変換元のHDRファイル (RESOURCE_DIR/texture/からの相対パス)</param>
+/// <returns></returns>
+bool EnvironmentMap::Load(const std::wstring& fileName)
+{
+    const auto path = GetCachePath(fileName);
+    SourceInfo source{};
+    const bool hasSource = GetSourceStat(fileName, source);
+    if (Open(path))
+    {
+        // 変換元がない場合はキャッシュのみで動作させる
+        const auto& cached = GetHeader()->source;
+        if (!hasSource || (cached.size == source.size && cached.writeTime == source.writeTime))
+        {
+            return true;
+        }
+        Close();
+    }
+    return hasSource && Build(fileName, path) && Open(path);
+}
+
+/// <summary>
+/// キャッシュファイルを読み取り専用でマップ
+/// </summary>
+/// <param name="path"></param>
+/// <returns>ファイルが存在し、形式が正しい場合にtrue</returns>
+bool EnvironmentMap::Open(const std::wstring& path)
+{
+    Close();
+    if (!m_file.Open(path) || m_file.GetSize() < sizeof(Header))
+    {
+        Close();
+        return false;
+    }
+    m_pMapped = m_file.GetData();
+    const uint64_t fileSize = m_file.GetSize();
+
+    // ヘッダーと各領域の範囲の検証
+    auto contains = [fileSize](uint64_t offset, uint64_t size)
+    {
+        return offset % SectionAlignment == 0 && offset <= fileSize && size <= fileSize - offset;
+    };
+    auto header = GetHeader();
+    const uint64_t res = header->resolution;
+    bool isValid =
+        header->magic == Magic &&
+        header->version == Version &&
+        res > 0 && res <= 16384 &&
+        header->mipLevels > 0 && header->mipLevels <= MaxMipLevels &&
+        contains(header->marginalOffset, (res + 1) * sizeof(float)) &&
+        contains(header->conditionalOffset, res * (res + 1) * sizeof(float));
+    for (UINT i = 0; isValid && i < header->mipLevels; ++i)
+    {
+        const auto& mip = header->mips[i];
+        isValid =
+            mip.resolution == (std::max)(uint32_t(res >> i), 1u) &&
+            contains(mip.offset, uint64_t(mip.resolution) * mip.resolution * sizeof(uint32_t));
+    }
+    if (!isValid)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void EnvironmentMap::Close()
+{
+    m_pMapped = nullptr;
+    m_file.Close();
+}
+
+/// <summary>
+/// テクスチャの作成 (マップした領域から直接転送する)
+/// </summary>
+/// <param name="device"></param>
+/// <returns></returns>
+TextureResource EnvironmentMap::Upload(std::unique_ptr<Device>& device) const
+{
+    auto header = GetHeader();
+    DirectX::TexMetadata metadata{};
+    metadata.width = header->resolution;
+    metadata.height = header->resolution;
+    metadata.depth = 1;
+    metadata.arraySize = 1;
+    metadata.mipLevels = header->mipLevels;
+    metadata.format = DXGI_FORMAT_R9G9B9E5_SHAREDEXP;
+    metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(header->mipLevels);
+    for (UINT i = 0; i < header->mipLevels; ++i)
+    {
+        const auto& mip = header->mips[i];
+        subresources[i].pData = m_pMapped + mip.offset;
+        subresources[i].RowPitch = LONG_PTR(mip.resolution) * sizeof(uint32_t);
+        subresources[i].SlicePitch = subresources[i].RowPitch * mip.resolution;
+    }
+    return CreateTextureResource(metadata, subresources, device);
+}
+
+Float3 EnvironmentMap::Evaluate(const Float3& dir) const
+{
+    const UINT res = GetResolution();
+    auto uv = DirToOctahedral(dir);
+    UINT x = (std::min)(UINT(uv.x * res), res - 1);
+    UINT y = (std::min)(UINT(uv.y * res), res - 1);
+    auto texels = reinterpret_cast<const PackedVector::XMFLOAT3SE*>(m_pMapped + GetHeader()->mips[0].offset);
+    Float3 radiance;
+    XMStoreFloat3(&radiance, PackedVector::XMLoadFloat3SE(&texels[size_t(y) * res + x]));
+    return radiance;
+}
+
+/// <summary>
+/// 輝度に比例した方向のサンプリング
+/// 行 (周辺分布) と列 (条件付き分布) の順にテクセルを選び、テクセル内は一様に選ぶ
+/// </summary>
+/// <param name="u1">[0, 1)の乱数</param>
+/// <param name="u2">[0, 1)の乱数</param>
+/// <param name="pdf">立体角あたりの確率密度</param>
+/// <returns>正規化された方向</returns>
+Float3 EnvironmentMap::Sample(float u1, float u2, float& pdf) const
+{
+    const UINT res = GetResolution();
+    auto marginal = GetMarginalCDF();
+    UINT row = FindInterval(marginal, u1);
+    float rowWidth = marginal[row + 1] - marginal[row];
+    float fv = rowWidth > 0.0f ? (u1 - marginal[row]) / rowWidth : 0.5f;
+
+    auto conditional = GetConditionalCDF(row);
+    UINT column = FindInterval(conditional, u2);
+    float columnWidth = conditional[column + 1] - conditional[column];
+    float fu = columnWidth > 0.0f ? (u2 - conditional[column]) / columnWidth : 0.5f;
+
+    float u = (float(column) + (std::min)(fu, 1.0f)) / float(res);
+    float v = (float(row) + (std::min)(fv, 1.0f)) / float(res);
+    auto p = OctahedralToPoint(u, v);
+    float len = Length(p);
+    pdf = rowWidth * columnWidth * float(res) * float(res) * len * len * len * 0.25f;
+    return Float3(p.x / len, p.y / len, p.z / len);
+}
+
+float EnvironmentMap::Pdf(const Float3& dir) const
+{
+    const UINT res = GetResolution();
+    auto uv = DirToOctahedral(dir);
+    UINT column = (std::min)(UINT(uv.x * res), res - 1);
+    UINT row = (std::min)(UINT(uv.y * res), res - 1);
+    float len = Length(OctahedralToPoint(uv.x, uv.y));
+    return GetTexelPdf(row, column) * float(res) * float(res) * len * len * len * 0.25f;
+}
+
+std::span<const float> EnvironmentMap::GetMarginalCDF() const
+{
+    auto header = GetHeader();
+    return std::span<const float>(reinterpret_cast<const float*>(m_pMapped + header->marginalOffset), size_t(header->resolution) + 1);
+}
+
+std::span<const float> EnvironmentMap::GetConditionalCDF(UINT row) const
+{
+    auto header = GetHeader();
+    const size_t stride = size_t(header->resolution) + 1;
+    return std::span<const float>(reinterpret_cast<const float*>(m_pMapped + header->conditionalOffset) + stride * row, stride);
+}
+
+float EnvironmentMap::GetTexelPdf(UINT row, UINT column) const
+{
+    auto marginal = GetMarginalCDF();
+    auto conditional = GetConditionalCDF(row);
+    return (marginal[row + 1] - marginal[row]) * (conditional[column + 1] - conditional[column]);
+}
+
+/// <summary>
+/// キャッシュの作成
+/// 一時ファイルに書き込んでから置き換えるため、途中で失敗しても既存のファイルは壊れない
+/// </summary>
+/// <param name="fileName">変換元のHDRファイル</param>
+/// <param name="path">キャッシュファイル</param>
+/// <returns></returns>
+bool EnvironmentMap::Build(const std::wstring& fileName, const std::wstring& path)
+{
+    namespace fs = std::filesystem;
+    using namespace DirectX;
+    SourceInfo source{};
+    DecodedImage decoded;
+    if (!GetSourceStat(fileName, source) || !DecodeHDRImage(fileName, decoded))
+    {
+        return false;
+    }
+    ScratchImage converted;
+    const Image* src = decoded.image.GetImage(0, 0, 0);
+    if (decoded.metadata.format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+    {
+        if (FAILED(Convert(*src, DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, converted)))
+        {
+            return false;
+        }
+        src = converted.GetImage(0, 0, 0);
+    }
+
+    // 解像度は元画像の高さを2のべき乗に切り上げたもの (4K: 2048)
+    UINT resolution = 1;
+    while (resolution < src->height && resolution < 8192)
+    {
+        resolution <<= 1;
+    }
+
+    // ミップ0: テクセル内を2x2でスーパーサンプリング
+    std::vector<std::vector<XMFLOAT3>> levels(1);
+    levels[0].resize(size_t(resolution) * resolution);
+    ParallelFor(resolution, 16, [&](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            for (UINT x = 0; x < resolution; ++x)
+            {
+                XMVECTOR sum = XMVectorZero();
+                for (UINT s = 0; s < 4; ++s)
+                {
+                    float u = (float(x) + 0.25f + 0.5f * float(s & 1)) / float(resolution);
+                    float v = (float(y) + 0.25f + 0.5f * float(s >> 1)) / float(resolution);
+                    auto p = OctahedralToPoint(u, v);
+                    float len = Length(p);
+                    sum = XMVectorAdd(sum, SampleEquirect(*src, Float3(p.x / len, p.y / len, p.z / len)));
+                }
+                XMStoreFloat3(&levels[0][y * resolution + x], XMVectorMax(XMVectorScale(sum, 0.25f), XMVectorZero()));
+            }
+        }
+    });
+    // 以降のミップは2x2の平均
+    for (UINT res = resolution / 2; res > 0 && levels.size() < MaxMipLevels; res /= 2)
+    {
+        const auto& upper = levels.back();
+        std::vector<XMFLOAT3> level(size_t(res) * res);
+        for (UINT y = 0; y < res; ++y)
+        {
+            for (UINT x = 0; x < res; ++x)
+            {
+                auto at = [&](UINT ux, UINT uy) { return XMLoadFloat3(&upper[size_t(uy) * res * 2 + ux]); };
+                XMVECTOR sum = XMVectorAdd(XMVectorAdd(at(x * 2, y * 2), at(x * 2 + 1, y * 2)), XMVectorAdd(at(x * 2, y * 2 + 1), at(x * 2 + 1, y * 2 + 1)));
+                XMStoreFloat3(&level[size_t(y) * res + x], XMVectorScale(sum, 0.25f));
+            }
+        }
+        levels.push_back(std::move(level));
+    }
+
+    // 重点サンプリング用の分布 (輝度 x テクセルの立体角)
+    const size_t stride = size_t(resolution) + 1;
+    std::vector<float> marginal(stride);
+    std::vector<float> conditional(stride * resolution);
+    std::vector<double> rowWeights(resolution);
+    ParallelFor(resolution, 16, [&](size_t begin, size_t end)
+    {
+        std::vector<double> weights(resolution);
+        for (size_t y = begin; y < end; ++y)
+        {
+            double rowSum = 0.0;
+            for (UINT x = 0; x < resolution; ++x)
+            {
+                const auto& c = levels[0][y * resolution + x];
+                auto p = OctahedralToPoint((float(x) + 0.5f) / float(resolution), (float(y) + 0.5f) / float(resolution));
+                float len = Length(p);
+                double luminance = 0.2126 * c.x + 0.7152 * c.y + 0.0722 * c.z;
+                weights[x] = luminance / (double(len) * len * len);
+                rowSum += weights[x];
+            }
+            BuildCDF(weights, conditional.data() + stride * y);
+            rowWeights[y] = rowSum;
+        }
+    });
+    BuildCDF(rowWeights, marginal.data());
+
+    // RGB9E5へ変換
+    std::vector<std::vector<uint32_t>> packed(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        packed[i].resize(levels[i].size());
+        for (size_t t = 0; t < levels[i].size(); ++t)
+        {
+            PackedVector::XMFLOAT3SE texel;
+            PackedVector::XMStoreFloat3SE(&texel, XMLoadFloat3(&levels[i][t]));
+            packed[i][t] = texel.v;
+        }
+    }
+
+    Header header{};
+    header.magic = Magic;
+    header.version = Version;
+    header.source = source;
+    header.resolution = resolution;
+    header.mipLevels = UINT(levels.size());
+    std::vector<std::pair<uint64_t, std::span<const uint8_t>>> sections;
+    uint64_t offset = ROUND_UP(uint64_t(sizeof(Header)), SectionAlignment);
+    auto addSection = [&](const auto& values)
+    {
+        std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(values.data()), values.size() * sizeof(values[0]));
+        sections.emplace_back(offset, bytes);
+        auto sectionOffset = offset;
+        offset = ROUND_UP(offset + bytes.size(), SectionAlignment);
+        return sectionOffset;
+    };
+    for (UINT i = 0; i < header.mipLevels; ++i)
+    {
+        header.mips[i].resolution = (std::max)(resolution >> i, 1u);
+        header.mips[i].offset = addSection(packed[i]);
+    }
+    header.marginalOffset = addSection(marginal);
+    header.conditionalOffset = addSection(conditional);
+
+    std::error_code ec;
+    const fs::path dstPath{ path };
+    fs::create_directories(dstPath.parent_path(), ec);
+    auto tmpPath = dstPath;
+    tmpPath += L".tmp";
+    {
+        std::ofstream dst(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!dst)
+        {
+            return false;
+        }
+        const char padding[SectionAlignment] = {};
+        dst.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        uint64_t written = sizeof(Header);
+        for (const auto& [sectionOffset, bytes] : sections)
+        {
+            dst.write(padding, std::streamsize(sectionOffset - written));
+            dst.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+            written = sectionOffset + bytes.size();
+        }
+        if (!dst)
+        {
+            return false;
+        }
+    }
+    fs::rename(tmpPath, dstPath, ec);
+    return !ec;
+}
+
+std::wstring EnvironmentMap::GetCachePath(const std::wstring& fileName)
+{
+    return RESOURCE_DIR L"/texture/cache/" + fileName + L".env";
+}
+
+bool EnvironmentMap::GetSourceStat(const std::wstring& fileName, SourceInfo& source)
+{
+    namespace fs = std::filesystem;
+    const fs::path path{ RESOURCE_DIR L"/texture/" + fileName };
+    std::error_code ec;
+    source.size = uint64_t(fs::file_size(path, ec));
+    if (ec)
+    {
+        return false;
+    }
+    source.writeTime = uint64_t(fs::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
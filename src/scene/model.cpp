@@ -1,76 +1,276 @@
 #include "scene/model.hpp"
 #include "scene/actor.hpp"
 #include "utils/gltf_loader.h"
+#include "utils/gltf_accessor.h"
+#include "utils/dxr_util.h"
+#include "utils/parallel_util.h"
 
-Model::Model()
+namespace
 {
-}
+    // 量子化されたまま保持する場合の形式 (UNKNOWNの場合はfloatへ変換する)
+    struct PackedFormat
+    {
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        UINT stride = 0;
+    };
 
-Model::~Model()
-{
+    // 正規化整数の成分型に対応する型付きバッファの形式
+    // 法線はVEC3のため4成分の形式に詰め、4番目の成分は0で埋める
+    PackedFormat GetPackedFormat(int componentType, bool isNormal)
+    {
+        switch (componentType)
+        {
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+            return isNormal ? PackedFormat{ DXGI_FORMAT_R8G8B8A8_SNORM, 4 } : PackedFormat{ DXGI_FORMAT_R8G8_SNORM, 2 };
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+            return isNormal ? PackedFormat{ DXGI_FORMAT_R16G16B16A16_SNORM, 8 } : PackedFormat{ DXGI_FORMAT_R16G16_SNORM, 4 };
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return isNormal ? PackedFormat() : PackedFormat{ DXGI_FORMAT_R8G8_UNORM, 2 };
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            return isNormal ? PackedFormat() : PackedFormat{ DXGI_FORMAT_R16G16_UNORM, 4 };
+        default:
+            return PackedFormat();
+        }
+    }
+
+    /// <summary>
+    /// 全プリミティブの属性が同じ正規化整数型の場合のみ、量子化されたままの形式を返す
+    /// 1つでもfloat, 非正規化整数, スパース, 属性なしのプリミティブがあればfloatへ変換する
+    /// </summary>
+    PackedFormat SelectPackedFormat(const tinygltf::Model& srcModel, const char* attrName, bool isNormal)
+    {
+        PackedFormat result;
+        for (const auto& srcMesh : srcModel.meshes)
+        {
+            for (const auto& srcPrimitive : srcMesh.primitives)
+            {
+                auto posAttr = srcPrimitive.attributes.find("POSITION");
+                if (posAttr == srcPrimitive.attributes.end())
+                {
+                    continue;
+                }
+                auto attr = srcPrimitive.attributes.find(attrName);
+                if (attr == srcPrimitive.attributes.end())
+                {
+                    return PackedFormat();
+                }
+                const auto& acc = srcModel.accessors[attr->second];
+                if (acc.count != srcModel.accessors[posAttr->second].count ||
+                    !acc.normalized || acc.bufferView < 0 || acc.sparse.isSparse ||
+                    acc.type != (isNormal ? TINYGLTF_TYPE_VEC3 : TINYGLTF_TYPE_VEC2))
+                {
+                    return PackedFormat();
+                }
+                auto format = GetPackedFormat(acc.componentType, isNormal);
+                if (format.format == DXGI_FORMAT_UNKNOWN ||
+                    (result.format != DXGI_FORMAT_UNKNOWN && result.format != format.format))
+                {
+                    return PackedFormat();
+                }
+                result = format;
+            }
+        }
+        return result;
+    }
+
+    // 頂点属性をバイト列の末尾に追加 (isPackedの場合は要素をそのままコピー、それ以外はfloatへ変換)
+    bool AppendVertexAttribute(const GLTFDocument& src, const tinygltf::Accessor& acc, std::vector<uint8_t>& dst, bool isPacked, UINT stride, int components)
+    {
+        const size_t start = dst.size();
+        dst.resize(start + size_t(acc.count) * stride);
+        if (isPacked)
+        {
+            return CopyAccessorElements(src, acc, dst.data() + start, stride);
+        }
+        return ReadAccessor(src, acc, reinterpret_cast<float*>(dst.data() + start), components);
+    }
+
+    template<typename T>
+    void AppendRepeated(std::vector<uint8_t>& dst, const T& value, size_t count)
+    {
+        const size_t start = dst.size();
+        dst.resize(start + sizeof(T) * count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            memcpy(dst.data() + start + sizeof(T) * i, &value, sizeof(T));
+        }
+    }
 }
 
-Model::Node::Node() :
-m_name(L""),
-m_trans(ZeroVector()),
-m_scale(Vector4(1.0f, 1.0f, 1.0f, 0.0f)),
-m_rot(IdentityQuat()),
-m_localMtx(IdentityMtx()),
-m_worldMtx(IdentityMtx()),
-m_parent(nullptr)
+Model::Model()
 {
 }
 
-Model::Node::~Node()
+Model::~Model()
 {
 }
 
-Model::Model(const std::wstring& name, std::unique_ptr<Device>& device) :
-    m_name(name)
+Model::Model(const std::wstring& name, std::shared_ptr<const MappedFile> file) :
+    m_name(name),
+    m_pSrcModel(std::make_unique<GLTFDocument>()),
+    m_pVisitor(std::make_unique<VertexAttributeVisitor>())
 {
-    tinygltf::Model srcModel{};
-    if (!LoadGLTF(name, srcModel))
+    if (!LoadGLTF(name, file, *m_pSrcModel))
     {
         std::wstring err = L"glTFファイルの読み込みに失敗しました: " + name;
         Error(PrintInfoType::RTCAMP10, err);
     }
-    if (!LoadModel(srcModel, device))
+    if (!ParseModel(*m_pSrcModel))
     {
         std::wstring err = L"モデルのロードに失敗しました: " + name;
         Error(PrintInfoType::RTCAMP10, err);
     }
+    const auto& visitor = *m_pVisitor;
+    m_geometry = { visitor.indexBuffer, visitor.positionBuffer, visitor.normalBuffer, visitor.texcoordBuffer };
 }
 
-std::shared_ptr<Actor> Model::InstantiateActor(std::unique_ptr<Device>& device)
+Model::Model(const std::wstring& name, std::shared_ptr<const BakedModel> baked) :
+    m_name(name),
+    m_pBaked(baked)
 {
-     std::shared_ptr<Actor> actor(new Actor(device, this));
-     std::vector<std::shared_ptr<Actor::ActorNode>> nodes;
-     nodes.resize(m_nodes.size());
+    using Section = BakedModel::Section;
+    auto invalid = [&name]() {
+        std::wstring err = L"ベイク済みファイルが不正です: " + name;
+        Error(PrintInfoType::RTCAMP10, err);
+    };
 
-     // ノード設定
-     for (UINT i = 0; i < UINT(m_nodes.size()); ++i)
-     {
-         const auto srcNode = m_nodes[i];
-         auto& node = nodes[i];
-         node = std::make_shared<Actor::ActorNode>();
-         node->m_trans = srcNode->m_trans;
-         node->m_rot = srcNode->m_rot;
-         node->m_scale = srcNode->m_scale;
-         node->m_name = srcNode->m_name;
-
-         // 親子解決
-         for (auto idx : srcNode->m_childIndices)
-         {
-             auto child = nodes[idx];
-             node->m_children.push_back(child);
-             child->m_parent = node;
-         }
-     }
-     for (auto rootNodeIdx : m_rootNodeIndices)
+    // 頂点属性はマップされた領域をそのまま参照
+    auto vertexFormats = baked->GetSection<BakedModel::VertexFormatRecord>(Section::VertexFormat);
+    if (vertexFormats.size() != 1 || vertexFormats[0].normalStride == 0 || vertexFormats[0].texcoordStride == 0)
+    {
+        invalid();
+    }
+    const auto& vertexFormat = vertexFormats[0];
+    m_vertexFormat.normal = DXGI_FORMAT(vertexFormat.normalFormat);
+    m_vertexFormat.normalStride = vertexFormat.normalStride;
+    m_vertexFormat.texcoord = DXGI_FORMAT(vertexFormat.texcoordFormat);
+    m_vertexFormat.texcoordStride = vertexFormat.texcoordStride;
+    m_geometry.indices = baked->GetSection<UINT>(Section::Index);
+    m_geometry.positions = baked->GetSection<Float3>(Section::Position);
+    m_geometry.normals = baked->GetSection<uint8_t>(Section::Normal);
+    m_geometry.texcoords = baked->GetSection<uint8_t>(Section::Texcoord);
+    if (m_geometry.positions.empty() || m_geometry.indices.empty() ||
+        m_geometry.normals.size() != m_geometry.positions.size() * m_vertexFormat.normalStride ||
+        m_geometry.texcoords.size() != m_geometry.positions.size() * m_vertexFormat.texcoordStride)
+    {
+        invalid();
+    }
+
+    // ノード (親が子より前に並んでいる)
+    auto nodes = baked->GetSection<BakedModel::NodeRecord>(Section::Node);
+    m_hierarchy.Reserve(UINT(nodes.size()));
+    for (const auto& node : nodes)
+    {
+        if (node.parent >= int(m_hierarchy.GetNodeCount()))
+        {
+            invalid();
+        }
+        m_hierarchy.AddNode(
+            baked->GetString(node.name),
+            node.parent,
+            XMLoadFloat4(&node.translation),
+            XMLoadFloat4(&node.rotation),
+            XMLoadFloat4(&node.scale)
+        );
+    }
+
+    // マテリアル
+    for (const auto& srcMat : baked->GetSection<BakedModel::MaterialRecord>(Section::Material))
+    {
+        m_materials.emplace_back(Material());
+        auto& mat = m_materials.back();
+        mat.m_name = baked->GetString(srcMat.name);
+        mat.m_textureIndex = srcMat.textureIndex;
+        mat.m_diffuseColor = srcMat.diffuse;
+    }
+
+    // メッシュ
+    auto primitives = baked->GetSection<BakedModel::PrimitiveRecord>(Section::Primitive);
+    for (const auto& srcMesh : baked->GetSection<BakedModel::MeshRecord>(Section::Mesh))
+    {
+        if (size_t(srcMesh.primitiveStart) + srcMesh.primitiveCount > primitives.size() ||
+            srcMesh.nodeIndex >= int(m_hierarchy.GetNodeCount()))
+        {
+            invalid();
+        }
+        m_meshes.emplace_back(Mesh());
+        auto& mesh = m_meshes.back();
+        mesh.m_nodeIndex = srcMesh.nodeIndex;
+        for (const auto& srcPrimitive : primitives.subspan(srcMesh.primitiveStart, srcMesh.primitiveCount))
+        {
+            if (size_t(srcPrimitive.indexStart) + srcPrimitive.indexCount > m_geometry.indices.size() ||
+                size_t(srcPrimitive.vertexStart) + srcPrimitive.vertexCount > m_geometry.positions.size() ||
+                srcPrimitive.materialIndex >= m_materials.size())
+            {
+                invalid();
+            }
+            mesh.m_primitives.emplace_back(Primitive());
+            auto& primitive = mesh.m_primitives.back();
+            primitive.m_indexStart = srcPrimitive.indexStart;
+            primitive.m_vertexStart = srcPrimitive.vertexStart;
+            primitive.m_indexCount = srcPrimitive.indexCount;
+            primitive.m_vertexCount = srcPrimitive.vertexCount;
+            primitive.m_materialIndex = srcPrimitive.materialIndex;
+        }
+    }
+
+    // テクスチャ (1テクスチャにつき1画像)
+    auto imageData = baked->GetSection<uint8_t>(Section::ImageData);
+    for (const auto& srcTex : baked->GetSection<BakedModel::TextureRecord>(Section::Texture))
+    {
+        if (srcTex.dataOffset > imageData.size() || srcTex.dataSize > imageData.size() - srcTex.dataOffset)
+        {
+            invalid();
+        }
+        m_textureImages.push_back(int(m_encodedImages.size()));
+        m_textureNames.push_back(baked->GetString(srcTex.name));
+        m_encodedImages.push_back(imageData.subspan(size_t(srcTex.dataOffset), size_t(srcTex.dataSize)));
+    }
+    for (const auto& mat : m_materials)
+    {
+        if (mat.m_textureIndex >= int(m_textureImages.size()))
+        {
+            invalid();
+        }
+    }
+
+    // ノード行列の計算 (モデル空間)
+    m_hierarchy.Update(IdentityMtx(), true);
+}
+
+/// <summary>
+/// GPUリソースの作成
+/// </summary>
+/// <param name="device"></param>
+void Model::Upload(std::unique_ptr<Device>& device)
+{
+    if (IsUploaded())
+    {
+        return;
+    }
+    // 転送とBLAS構築は1回の実行にまとめる (呼び出し側のバッチ内であればそちらに統合される)
+    device->BeginUploadBatch();
+    CreateResources(device);
+    device->EndUploadBatch();
+    // 解析結果は不要になるので解放
+    m_geometry = GeometryView();
+    m_encodedImages.clear();
+    m_decodedImages.clear();
+    m_dummyImage = DecodedImage();
+    m_pSrcModel.reset();
+    m_pVisitor.reset();
+}
+
+std::shared_ptr<Actor> Model::InstantiateActor(std::unique_ptr<Device>& device)
+{
+     if (!IsUploaded())
      {
-         auto rootNode = nodes[rootNodeIdx];
-         actor->m_nodes.push_back(rootNode);
+         Error(PrintInfoType::RTCAMP10, L"GPUリソースが未作成のモデルです: " + m_name);
      }
+     std::shared_ptr<Actor> actor(new Actor(device, shared_from_this()));
+
+     // ノード設定 (モデルの階層を複製)
+     actor->m_hierarchy = m_hierarchy;
 
      // マテリアル生成
      for (auto srcMat : m_materials)
@@ -92,156 +292,259 @@ std::shared_ptr<Actor> Model::InstantiateActor(std::unique_ptr<Device>& device)
      actor->SetWorldMatrix(IdentityMtx());
      actor->UpdateMatrices();
 
-     // 行列バッファの確保
-     actor->CreateMatrixBufferBLAS(UINT(m_meshes.size()));
-
-     // 頂点属性ごとのSRVを生成
+     // メッシュ情報の設定
+     // GPUリソースはモデル側で生成済みのものを参照する
      for (UINT i = 0; i < UINT(m_meshes.size()); ++i)
      {
          actor->m_meshGroups.emplace_back(Actor::ActorMeshGroup());
          auto& meshGroup = actor->m_meshGroups.back();
-         meshGroup.m_node = nodes[m_meshes[i].m_nodeIndex];
-         for (auto& srcMesh : m_meshes[i].m_primitives)
+         meshGroup.m_nodeIndex = m_meshes[i].m_nodeIndex;
+         for (const auto& srcMesh : m_meshes[i].m_primitives)
          {
              meshGroup.m_meshes.emplace_back(Actor::ActorMesh());
              auto& mesh = meshGroup.m_meshes.back();
-
-             auto vertexStart = srcMesh.m_vertexStart;
-             auto vertexCount = srcMesh.m_vertexCount;
-             auto indexStart = srcMesh.m_indexStart;
-             auto indexCount = srcMesh.m_indexCount;
-             mesh.m_vertexStart = vertexStart;
-             mesh.m_vertexCount = vertexCount;
-             mesh.m_indexStart = indexStart;
-             mesh.m_indexCount = indexCount;
-
-             mesh.m_vbAttrPos = device->CreateSRV(m_vertexAtrrib.position, vertexCount, vertexStart, DXGI_FORMAT_R32G32B32_FLOAT);
-             mesh.m_vbAttrNorm = device->CreateSRV(m_vertexAtrrib.normal, vertexCount, vertexStart, DXGI_FORMAT_R32G32B32_FLOAT);
-             mesh.m_vbAttrTexCoord = device->CreateSRV(m_vertexAtrrib.texcoord, vertexCount, vertexStart, DXGI_FORMAT_R32G32_FLOAT);
-             mesh.m_indexBuffer = device->CreateSRV(m_pIndexBuffer, indexCount, indexStart, DXGI_FORMAT_R32_UINT);
+             mesh.m_vertexStart = srcMesh.m_vertexStart;
+             mesh.m_vertexCount = srcMesh.m_vertexCount;
+             mesh.m_indexStart = srcMesh.m_indexStart;
+             mesh.m_indexCount = srcMesh.m_indexCount;
+             mesh.m_vbAttrPos = srcMesh.m_vbAttrPos;
+             mesh.m_vbAttrNorm = srcMesh.m_vbAttrNorm;
+             mesh.m_vbAttrTexCoord = srcMesh.m_vbAttrTexCoord;
+             mesh.m_indexBuffer = srcMesh.m_indexBuffer;
+             mesh.m_pMeshParamCB = srcMesh.m_pMeshParamCB;
              mesh.m_material = actor->m_materials[srcMesh.m_materialIndex];
-
-             auto diffuse = m_materials[srcMesh.m_materialIndex].GetDiffuseColor();
-             Actor::ActorMesh::MeshParam meshParam{};
-             meshParam.diffuse = Float4{ diffuse.x, diffuse.y ,diffuse.z, 1 };
-             meshParam.meshGroupIndex = i;
-             meshParam.matrixBuffStride = UINT(m_meshes.size() * device->BackBufferCount);
-             std::wstring meshParamCBName = m_name + L":MeshParam";
-             mesh.m_pMeshParamCB = device->InitializeBuffer(
-                 sizeof(meshParam),
-                 &meshParam,
-                 D3D12_RESOURCE_FLAG_NONE,
-                 D3D12_HEAP_TYPE_DEFAULT,
-                 meshParamCBName.c_str()
-             );
          }
      }
 
-     // 行列用のバッファを更新
-     actor->UpdateTransform();
-     
-     // BLAS構築
-     actor->CreateBLAS();
+     // スキンを持つモデルはアクターごとに変形するため、頂点バッファとBLASを複製
+     if (HasSkin())
+     {
+         actor->CreateSkinningResources();
+     }
      return actor;
 }
 
 void Model::Destroy(std::unique_ptr<Device>& device)
 {
+    if (device)
+    {
+        for (auto& mesh : m_meshes)
+        {
+            for (auto& primitive : mesh.m_primitives)
+            {
+                device->DeallocateDescriptorHeap(primitive.m_vbAttrPos);
+                device->DeallocateDescriptorHeap(primitive.m_vbAttrNorm);
+                device->DeallocateDescriptorHeap(primitive.m_vbAttrTexCoord);
+                device->DeallocateDescriptorHeap(primitive.m_indexBuffer);
+            }
+        }
+        for (auto& texture : m_textures)
+        {
+            device->DeallocateDescriptorHeap(texture.srv);
+        }
+        device->DeallocateDescriptorHeap(m_dummyTexture.srv);
+        device->DeallocateDescriptorHeap(m_blasMatrixDescriptor);
+    }
     m_textures.clear();
     m_meshes.clear();
     m_materials.clear();
-    m_nodes.clear();
+    m_hierarchy = TransformHierarchy();
+    m_nodeRemap.clear();
+    m_skins.clear();
+    m_animations.clear();
+    m_skinningData = SkinningData();
+    m_pBLAS.Reset();
+    m_pBLASMatrices.Reset();
 }
 
-bool Model::LoadModel(const tinygltf::Model& srcModel, std::unique_ptr<Device>& device)
+bool Model::ParseModel(const GLTFDocument& src)
 {
-    VertexAttributeVisitor visitor;
-    const auto& scene = srcModel.scenes[0];
-    for (const auto& nodeIndex : scene.nodes) {
-        m_rootNodeIndices.push_back(nodeIndex);
+    const auto& srcModel = src.model;
+    if (srcModel.scenes.empty())
+    {
+        return false;
     }
-
     LoadNode(srcModel);
-    LoadMesh(srcModel, visitor);
+    LoadSkin(src);
+    LoadMesh(src, *m_pVisitor);
     LoadMaterial(srcModel);
+    LoadAnimation(src);
+    LoadTextureSource(src);
+
+    // ノード行列の計算 (モデル空間)
+    m_hierarchy.Update(IdentityMtx(), true);
 
+    // スキニング用にバインドポーズの頂点を保持
+    if (HasSkin())
+    {
+        m_skinningData.bindPositions = m_pVisitor->positionBuffer;
+        // スキンを持つモデルの法線は常にfloat
+        const auto& normalBuffer = m_pVisitor->normalBuffer;
+        auto normals = reinterpret_cast<const Float3*>(normalBuffer.data());
+        m_skinningData.bindNormals.assign(normals, normals + normalBuffer.size() / sizeof(Float3));
+        m_skinningData.bindNormals.resize(m_skinningData.bindPositions.size(), Float3(0.0f, 1.0f, 0.0f));
+    }
+    else
+    {
+        m_skinningData = SkinningData();
+    }
+    return true;
+}
+
+void Model::CreateResources(std::unique_ptr<Device>& device)
+{
+    const auto& geometry = m_geometry;
     auto flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
     auto heapType = D3D12_HEAP_TYPE_DEFAULT;
 
     // 頂点バッファの作成
-    auto posSize = sizeof(Float3) * visitor.positionBuffer.size();
-    auto normSize = sizeof(Float3) * visitor.normalBuffer.size();
-    auto texSize = sizeof(Float2) * visitor.texcoordBuffer.size();
-    m_vertexAtrrib.position = device->InitializeBuffer(posSize, visitor.positionBuffer.data(), flags, heapType, L"PositionBuffer");
-    m_vertexAtrrib.normal = device->InitializeBuffer(normSize, visitor.normalBuffer.data(), flags, heapType, L"NormalBuffer");
-    m_vertexAtrrib.texcoord = device->InitializeBuffer(texSize, visitor.texcoordBuffer.data(), flags, heapType, L"TexcoordBuffer");
+    auto posSize = geometry.positions.size_bytes();
+    auto normSize = geometry.normals.size_bytes();
+    auto texSize = geometry.texcoords.size_bytes();
+    m_vertexAtrrib.position = device->InitializeBuffer(posSize, geometry.positions.data(), flags, heapType, L"PositionBuffer");
+    m_vertexAtrrib.normal = device->InitializeBuffer(normSize, geometry.normals.data(), flags, heapType, L"NormalBuffer");
+    m_vertexAtrrib.texcoord = device->InitializeBuffer(texSize, geometry.texcoords.data(), flags, heapType, L"TexcoordBuffer");
 
 
     // インデックスバッファの作成
-    auto idxSize = sizeof(UINT) * visitor.indexBuffer.size();
-    m_pIndexBuffer = device->InitializeBuffer(idxSize, visitor.indexBuffer.data(), flags, heapType, L"IndexBuffer");
+    auto idxSize = geometry.indices.size_bytes();
+    m_pIndexBuffer = device->InitializeBuffer(idxSize, geometry.indices.data(), flags, heapType, L"IndexBuffer");
 
-    // テクスチャ割り当て
-    for (auto& texture : srcModel.textures)
+    // テクスチャ割り当て (デコードは解析時に完了済み)
+    for (UINT i = 0; i < UINT(m_textureImages.size()); ++i)
     {
-        auto image = srcModel.images[texture.source];
-        auto fileName = StrToWStr(image.name + ": " + image.uri);
-        TextureResource tex;
-        if (image.bufferView >= 0)
-        {
-            auto bufferView = srcModel.bufferViews[image.bufferView];
-            auto offsetBytes = bufferView.byteOffset;
-            const void* imageData = &srcModel.buffers[bufferView.buffer].data[offsetBytes];
-            UINT64 byteLength = bufferView.byteLength;
-            tex = LoadTexture(imageData, byteLength, device);
-        }
-        else
-        {
-            // FIXME: CreateDecoderFromStream で失敗している
-            tex = LoadTexture(image.image.data(), image.image.size(), device);
-        }
-
-        tex.resource->SetName(fileName.c_str());
+        TextureResource tex = UploadTexture(m_decodedImages[m_textureImages[i]], device);
+        tex.resource->SetName(m_textureNames[i].c_str());
         m_textures.emplace_back(tex);
     }
-    m_dummyTexture = LoadTexture(L"dummy.png", device);
+    m_dummyTexture = UploadTexture(m_dummyImage, device);
 
-    return true;
+    // メッシュごとのSRV, 定数バッファの作成
+    CreatePrimitiveResources(device);
+
+    // BLAS構築
+    CreateMatrixBufferBLAS(device);
+    CreateBLAS(device);
 }
 
+/// <summary>
+/// ノードの読み込み
+/// 親が子より前に並ぶよう深さ優先で並べ替えて格納する
+/// </summary>
+/// <param name="srcModel"></param>
 void Model::LoadNode(const tinygltf::Model& srcModel)
 {
-    for (auto& srcNode : srcModel.nodes)
+    auto nodeCount = int(srcModel.nodes.size());
+
+    // 親子解決
+    std::vector<int> parents(nodeCount, -1);
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        for (auto child : srcModel.nodes[i].children)
+        {
+            parents[child] = i;
+        }
+    }
+
+    m_nodeRemap.assign(nodeCount, -1);
+    m_hierarchy.Reserve(UINT(nodeCount));
+    std::vector<int> stack;
+    for (int i = nodeCount - 1; i >= 0; --i)
     {
-        m_nodes.emplace_back(new Node());
-        auto node = m_nodes.back();
-        node->m_name = StrToWStr(srcNode.name);
+        if (parents[i] < 0)
+        {
+            stack.push_back(i);
+        }
+    }
+    while (!stack.empty())
+    {
+        auto nodeIndex = stack.back();
+        stack.pop_back();
+        const auto& srcNode = srcModel.nodes[nodeIndex];
+        auto trans = ZeroVector();
+        auto rot = IdentityQuat();
+        auto scale = Vector4(1.0f, 1.0f, 1.0f, 0.0f);
         if (!srcNode.translation.empty())
         {
-            node->m_trans = DoubleToVector3(srcNode.translation.data());
+            trans = DoubleToVector3(srcNode.translation.data());
         }
         if (!srcNode.scale.empty())
         {
-            node->m_scale = DoubleToVector3(srcNode.scale.data());
+            scale = DoubleToVector3(srcNode.scale.data());
         }
         if (!srcNode.rotation.empty())
         {
-            node->m_rot = DoubleToVector4(srcNode.rotation.data());
+            rot = DoubleToVector4(srcNode.rotation.data());
         }
-        for (auto& child : srcNode.children)
+        auto parent = parents[nodeIndex];
+        m_nodeRemap[nodeIndex] = m_hierarchy.AddNode(
+            StrToWStr(srcNode.name),
+            parent < 0 ? -1 : m_nodeRemap[parent],
+            trans, rot, scale
+        );
+        for (auto itr = srcNode.children.rbegin(); itr != srcNode.children.rend(); ++itr)
         {
-            node->m_childIndices.push_back(child);
+            stack.push_back(*itr);
         }
-        node->m_meshIndex = srcNode.mesh;
     }
 }
 
-void Model::LoadMesh(const tinygltf::Model& srcModel, VertexAttributeVisitor& visitor)
+void Model::LoadMesh(const GLTFDocument& src, VertexAttributeVisitor& visitor)
 {
+    const auto& srcModel = src.model;
     auto& indexBuffer = visitor.indexBuffer;
     auto& positionBuffer = visitor.positionBuffer;
     auto& normalBuffer = visitor.normalBuffer;
     auto& texcoordBuffer = visitor.texcoordBuffer;
+    auto& skinJoints = m_skinningData.joints;
+    auto& skinWeights = m_skinningData.weights;
+
+    auto invalid = [this](const char* attrName) {
+        std::wstring err = L"アクセサーの読み込みに失敗しました: " + m_name + L" " + StrToWStr(attrName);
+        Error(PrintInfoType::RTCAMP10, err);
+    };
+
+    // 量子化された法線とUV (KHR_mesh_quantization) は全プリミティブで形式が揃っている場合のみそのまま保持する
+    // スキニングは法線をfloatで変換するため、スキンを持つモデルの法線は対象外
+    auto packedNormal = srcModel.skins.empty() ? SelectPackedFormat(srcModel, "NORMAL", true) : PackedFormat();
+    auto packedTexcoord = SelectPackedFormat(srcModel, "TEXCOORD_0", false);
+    const bool isNormalPacked = packedNormal.format != DXGI_FORMAT_UNKNOWN;
+    const bool isTexcoordPacked = packedTexcoord.format != DXGI_FORMAT_UNKNOWN;
+    m_vertexFormat = VertexFormat();
+    if (isNormalPacked)
+    {
+        m_vertexFormat.normal = packedNormal.format;
+        m_vertexFormat.normalStride = packedNormal.stride;
+    }
+    if (isTexcoordPacked)
+    {
+        m_vertexFormat.texcoord = packedTexcoord.format;
+        m_vertexFormat.texcoordStride = packedTexcoord.stride;
+    }
+
+    // 全プリミティブの頂点数とインデックス数を先に数え、必要な分だけ確保する
+    size_t totalVertexCount = 0;
+    size_t totalIndexCount = 0;
+    for (const auto& srcMesh : srcModel.meshes)
+    {
+        for (const auto& srcPrimitive : srcMesh.primitives)
+        {
+            auto attr = srcPrimitive.attributes.find("POSITION");
+            if (attr == srcPrimitive.attributes.end())
+            {
+                continue;
+            }
+            auto vertexCount = size_t(srcModel.accessors[attr->second].count);
+            totalVertexCount += vertexCount;
+            totalIndexCount += srcPrimitive.indices >= 0 ? size_t(srcModel.accessors[srcPrimitive.indices].count) : vertexCount;
+        }
+    }
+    indexBuffer.reserve(totalIndexCount);
+    positionBuffer.reserve(totalVertexCount);
+    normalBuffer.reserve(totalVertexCount * m_vertexFormat.normalStride);
+    texcoordBuffer.reserve(totalVertexCount * m_vertexFormat.texcoordStride);
+    skinJoints.reserve(totalVertexCount);
+    skinWeights.reserve(totalVertexCount);
 
     for (auto& srcMesh : srcModel.meshes)
     {
@@ -250,76 +553,90 @@ void Model::LoadMesh(const tinygltf::Model& srcModel, VertexAttributeVisitor& vi
 
         for (auto& srcPrimitive : srcMesh.primitives)
         {
+            const auto& attributes = srcPrimitive.attributes;
+            auto posAttr = attributes.find("POSITION");
+            if (posAttr == attributes.end())
+            {
+                continue;
+            }
             auto indexStart = static_cast<UINT>(indexBuffer.size());
             auto vertexStart = static_cast<UINT>(positionBuffer.size());
+            auto vertexCount = UINT(srcModel.accessors[posAttr->second].count);
             UINT indexCount = 0;
-            UINT vertexCount = 0;
-
-            // 頂点
-            const auto& empty = srcPrimitive.attributes.end();
-            if (auto attr = srcPrimitive.attributes.find("POSITION"); attr != empty) {
-                auto& acc = srcModel.accessors[attr->second];
-                auto& view = srcModel.bufferViews[acc.bufferView];
-                auto offsetBytes = acc.byteOffset + view.byteOffset;
-                const auto* src = reinterpret_cast<const Float3*>(&(srcModel.buffers[view.buffer].data[offsetBytes]));
-                vertexCount = UINT(acc.count);
-                for (UINT i = 0; i < vertexCount; ++i) {
-                    positionBuffer.push_back(src[i]);
-                }
+
+            // 頂点 (量子化された整数型はfloatへ変換)
+            if (!AppendAccessor<Float3, float>(src, srcModel.accessors[posAttr->second], positionBuffer, 3))
+            {
+                invalid("POSITION");
             }
 
-            // 法線
-            if (auto attr = srcPrimitive.attributes.find("NORMAL"); attr != empty) {
-                auto& acc = srcModel.accessors[attr->second];
-                auto& view = srcModel.bufferViews[acc.bufferView];
-                auto offsetBytes = acc.byteOffset + view.byteOffset;
-                const auto* src = reinterpret_cast<const Float3*>(&(srcModel.buffers[view.buffer].data[offsetBytes]));
-                vertexCount = UINT(acc.count);
-                for (UINT i = 0; i < vertexCount; ++i) {
-                    normalBuffer.push_back(src[i]);
+            // 法線 (ない場合は上向きで埋める、量子化された形式では全プリミティブが法線を持つ)
+            auto normAttr = attributes.find("NORMAL");
+            if (normAttr != attributes.end() && srcModel.accessors[normAttr->second].count == vertexCount)
+            {
+                if (!AppendVertexAttribute(src, srcModel.accessors[normAttr->second], normalBuffer, isNormalPacked, m_vertexFormat.normalStride, 3))
+                {
+                    invalid("NORMAL");
                 }
             }
+            else
+            {
+                AppendRepeated(normalBuffer, Float3(0.0f, 1.0f, 0.0f), vertexCount);
+            }
 
-            // UV0
-            if (auto attr = srcPrimitive.attributes.find("TEXCOORD_0"); attr != empty) {
-                auto& acc = srcModel.accessors[attr->second];
-                auto& view = srcModel.bufferViews[acc.bufferView];
-                auto offsetBytes = acc.byteOffset + view.byteOffset;
-                const auto* src = reinterpret_cast<const Float2*>(&(srcModel.buffers[view.buffer].data[offsetBytes]));
-                for (UINT i = 0; i < vertexCount; ++i) {
-                    texcoordBuffer.push_back(src[i]);
+            // UV0 (ない場合はゼロ埋め)
+            auto uvAttr = attributes.find("TEXCOORD_0");
+            if (uvAttr != attributes.end() && srcModel.accessors[uvAttr->second].count == vertexCount)
+            {
+                if (!AppendVertexAttribute(src, srcModel.accessors[uvAttr->second], texcoordBuffer, isTexcoordPacked, m_vertexFormat.texcoordStride, 2))
+                {
+                    invalid("TEXCOORD_0");
                 }
             }
             else
             {
-                // UVがない場合のゼロ埋め
-                for (UINT i = 0; i < vertexCount; ++i) {
-                    texcoordBuffer.push_back(Float2(0.0f, 0.0f));
+                AppendRepeated(texcoordBuffer, Float2(0.0f, 0.0f), vertexCount);
+            }
+
+            // ジョイントとウェイト (スキニングしない頂点は0で埋める)
+            auto jointAttr = attributes.find("JOINTS_0");
+            auto weightAttr = attributes.find("WEIGHTS_0");
+            if (jointAttr != attributes.end() && weightAttr != attributes.end() &&
+                srcModel.accessors[jointAttr->second].count == vertexCount &&
+                srcModel.accessors[weightAttr->second].count == vertexCount)
+            {
+                if (!AppendAccessor<std::array<uint16_t, 4>, uint16_t>(src, srcModel.accessors[jointAttr->second], skinJoints, 4))
+                {
+                    invalid("JOINTS_0");
+                }
+                if (!AppendAccessor<Float4, float>(src, srcModel.accessors[weightAttr->second], skinWeights, 4))
+                {
+                    invalid("WEIGHTS_0");
                 }
             }
+            else
+            {
+                skinJoints.resize(vertexStart + vertexCount, { 0, 0, 0, 0 });
+                skinWeights.resize(vertexStart + vertexCount, Float4(0.0f, 0.0f, 0.0f, 0.0f));
+            }
 
-            // インデクスバッファ
+            // インデクスバッファ (インデックスを持たない場合は頂点順)
+            if (srcPrimitive.indices >= 0)
             {
-                auto& acc = srcModel.accessors[srcPrimitive.indices];
-                const auto& view = srcModel.bufferViews[acc.bufferView];
-                const auto& buffer = srcModel.buffers[view.buffer];
+                const auto& acc = srcModel.accessors[srcPrimitive.indices];
                 indexCount = UINT(acc.count);
-                auto offsetBytes = acc.byteOffset + view.byteOffset;
-                if (acc.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+                if (!AppendAccessor<UINT, UINT>(src, acc, indexBuffer, 1))
                 {
-                    auto src = reinterpret_cast<const uint32_t*>(&(buffer.data[offsetBytes]));
-                    for (size_t idx = 0; idx < acc.count; idx++)
-                    {
-                        indexBuffer.push_back(src[idx]);
-                    }
+                    invalid("indices");
                 }
-                if (acc.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+            }
+            else
+            {
+                indexCount = vertexCount;
+                indexBuffer.resize(indexStart + indexCount);
+                for (UINT i = 0; i < indexCount; ++i)
                 {
-                    auto src = reinterpret_cast<const uint16_t*>(&(buffer.data[offsetBytes]));
-                    for (size_t idx = 0; idx < acc.count; idx++)
-                    {
-                        indexBuffer.push_back(src[idx]);
-                    }
+                    indexBuffer[indexStart + i] = i;
                 }
             }
 
@@ -339,10 +656,149 @@ void Model::LoadMesh(const tinygltf::Model& srcModel, VertexAttributeVisitor& vi
         if (meshIndex < 0) {
             continue;
         }
-        m_meshes[meshIndex].m_nodeIndex = nodeIndex;
+        auto& mesh = m_meshes[meshIndex];
+        mesh.m_nodeIndex = m_nodeRemap[nodeIndex];
+        // スキンを持つメッシュはジョイントで変形する (ノードの行列は使用しない)
+        auto skinIndex = srcModel.nodes[nodeIndex].skin;
+        if (skinIndex >= 0 && skinIndex < int(m_skins.size()))
+        {
+            mesh.m_skinIndex = skinIndex;
+            for (const auto& primitive : mesh.m_primitives)
+            {
+                m_skinningData.ranges.push_back({ primitive.m_vertexStart, primitive.m_vertexCount, skinIndex });
+            }
+        }
+    }
+}
+
+/// <summary>
+/// スキンの読み込み
+/// </summary>
+/// <param name="src"></param>
+void Model::LoadSkin(const GLTFDocument& src)
+{
+    const auto& srcModel = src.model;
+    for (const auto& srcSkin : srcModel.skins)
+    {
+        m_skins.emplace_back(Skin());
+        auto& skin = m_skins.back();
+        for (auto joint : srcSkin.joints)
+        {
+            skin.joints.push_back(m_nodeRemap[joint]);
+        }
+        skin.inverseBindMatrices.resize(skin.joints.size(), IdentityMtx());
+        if (srcSkin.inverseBindMatrices < 0)
+        {
+            continue;
+        }
+        // glTFは列優先のため、そのまま読み込むと行ベクトル形式の行列になる
+        const auto& acc = srcModel.accessors[srcSkin.inverseBindMatrices];
+        std::vector<Mtx4x4> matrices(acc.count);
+        if (!ReadAccessor(src, acc, reinterpret_cast<float*>(matrices.data()), 16))
+        {
+            Error(PrintInfoType::RTCAMP10, L"逆バインド行列の読み込みに失敗しました: " + m_name);
+        }
+        auto count = (std::min)(matrices.size(), skin.joints.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            skin.inverseBindMatrices[i] = XMLoadFloat4x4(&matrices[i]);
+        }
     }
 }
 
+/// <summary>
+/// アニメーションの読み込み
+/// ノードのTRSのみ対応 (モーフターゲットのweightsは無視)
+/// </summary>
+/// <param name="src"></param>
+void Model::LoadAnimation(const GLTFDocument& src)
+{
+    const auto& srcModel = src.model;
+    for (const auto& srcAnim : srcModel.animations)
+    {
+        m_animations.emplace_back(AnimationClip());
+        auto& clip = m_animations.back();
+        clip.name = StrToWStr(srcAnim.name);
+
+        for (const auto& srcSampler : srcAnim.samplers)
+        {
+            clip.samplers.emplace_back(AnimationSampler());
+            auto& sampler = clip.samplers.back();
+            if (srcSampler.interpolation == "STEP")
+            {
+                sampler.interpolation = AnimationSampler::Interpolation::Step;
+            }
+            else if (srcSampler.interpolation == "CUBICSPLINE")
+            {
+                sampler.interpolation = AnimationSampler::Interpolation::CubicSpline;
+            }
+
+            // キーフレームの時刻
+            const auto& inputAcc = srcModel.accessors[srcSampler.input];
+            bool isValid = AppendAccessor<float, float>(src, inputAcc, sampler.times, 1);
+            if (!sampler.times.empty())
+            {
+                clip.duration = (std::max)(clip.duration, sampler.times.back());
+            }
+
+            // キーフレームの値 (VEC3/VEC4、VEC3の場合はwを0で埋める)
+            const auto& outputAcc = srcModel.accessors[srcSampler.output];
+            isValid &= AppendAccessor<Float4, float>(src, outputAcc, sampler.values, 4);
+            if (!isValid)
+            {
+                Error(PrintInfoType::RTCAMP10, L"アニメーションの読み込みに失敗しました: " + clip.name);
+            }
+        }
+
+        for (const auto& srcChannel : srcAnim.channels)
+        {
+            AnimationChannel channel;
+            if (srcChannel.target_path == "translation")
+            {
+                channel.path = AnimationChannel::Path::Translation;
+            }
+            else if (srcChannel.target_path == "rotation")
+            {
+                channel.path = AnimationChannel::Path::Rotation;
+            }
+            else if (srcChannel.target_path == "scale")
+            {
+                channel.path = AnimationChannel::Path::Scale;
+            }
+            else
+            {
+                continue;
+            }
+            if (srcChannel.target_node < 0 || srcChannel.sampler < 0)
+            {
+                continue;
+            }
+            channel.nodeIndex = m_nodeRemap[srcChannel.target_node];
+            channel.samplerIndex = srcChannel.sampler;
+            if (channel.nodeIndex >= 0)
+            {
+                clip.channels.push_back(channel);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// 名前からアニメーションを検索
+/// </summary>
+/// <returns>見つからない場合は-1</returns>
+int Model::FindAnimation(const std::wstring& name) const
+{
+    for (UINT i = 0; i < UINT(m_animations.size()); ++i)
+    {
+        if (m_animations[i].name == name)
+        {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
 void Model::LoadMaterial(const tinygltf::Model& srcModel)
 {
     for (const auto& srcMat: srcModel.materials)
@@ -370,3 +826,365 @@ void Model::LoadMaterial(const tinygltf::Model& srcModel)
         }
     }
 }
+
+/// <summary>
+/// 頂点属性ごとのSRVとMeshParamの作成
+/// </summary>
+/// <param name="device"></param>
+void Model::CreatePrimitiveResources(std::unique_ptr<Device>& device)
+{
+    for (UINT i = 0; i < UINT(m_meshes.size()); ++i)
+    {
+        for (auto& primitive : m_meshes[i].m_primitives)
+        {
+            auto vertexStart = primitive.m_vertexStart;
+            auto vertexCount = primitive.m_vertexCount;
+            auto indexStart = primitive.m_indexStart;
+            auto indexCount = primitive.m_indexCount;
+            primitive.m_vbAttrPos = device->CreateSRV(m_vertexAtrrib.position, vertexCount, vertexStart, DXGI_FORMAT_R32G32B32_FLOAT);
+            primitive.m_vbAttrNorm = device->CreateSRV(m_vertexAtrrib.normal, vertexCount, vertexStart, m_vertexFormat.normal);
+            primitive.m_vbAttrTexCoord = device->CreateSRV(m_vertexAtrrib.texcoord, vertexCount, vertexStart, m_vertexFormat.texcoord);
+            primitive.m_indexBuffer = device->CreateSRV(m_pIndexBuffer, indexCount, indexStart, DXGI_FORMAT_R32_UINT);
+
+            auto diffuse = m_materials[primitive.m_materialIndex].GetDiffuseColor();
+            MeshParam meshParam{};
+            meshParam.diffuse = Float4{ diffuse.x, diffuse.y ,diffuse.z, 1 };
+            meshParam.meshGroupIndex = i;
+            // 行列バッファは静的なため、フレームごとのオフセットは不要
+            meshParam.matrixBuffStride = 0;
+            std::wstring meshParamCBName = m_name + L":MeshParam";
+            primitive.m_pMeshParamCB = device->InitializeBuffer(
+                sizeof(meshParam),
+                &meshParam,
+                D3D12_RESOURCE_FLAG_NONE,
+                D3D12_HEAP_TYPE_DEFAULT,
+                meshParamCBName.c_str()
+            );
+        }
+    }
+}
+
+/// <summary>
+/// BLAS用の行列バッファの作成
+/// </summary>
+/// <param name="device"></param>
+void Model::CreateMatrixBufferBLAS(std::unique_ptr<Device>& device)
+{
+    // メッシュグループごとのノード行列 (モデル空間)
+    // アクターの姿勢はTLAS側で設定するため、全アクターで共有できる
+    auto groupCount = UINT(m_meshes.size());
+    std::vector<Mtx3x4> blasMatrices(groupCount);
+    for (UINT i = 0; i < groupCount; ++i)
+    {
+        auto nodeIndex = m_meshes[i].m_nodeIndex;
+        auto nodeMtx = nodeIndex < 0 ? IdentityMtx() : m_hierarchy.GetWorldMatrix(nodeIndex);
+        XMStoreFloat3x4(&blasMatrices[i], nodeMtx);
+    }
+
+    auto buffSize = sizeof(Mtx3x4) * groupCount;
+    std::wstring name = m_name + L":MatrixBuffer(BLAS)";
+    m_pBLASMatrices = device->InitializeBuffer(
+        buffSize,
+        blasMatrices.data(),
+        D3D12_RESOURCE_FLAG_NONE,
+        D3D12_HEAP_TYPE_DEFAULT,
+        name.c_str()
+    );
+
+    // SRVの作成
+    auto numElements = groupCount * 3;
+    m_blasMatrixDescriptor = device->CreateSRV(m_pBLASMatrices, numElements, 0, UINT(sizeof(Float4)));
+}
+
+/// <summary>
+/// BLASの構築
+/// </summary>
+/// <param name="device"></param>
+void Model::CreateBLAS(std::unique_ptr<Device>& device)
+{
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> rtGeoDesc;
+    CreateRTGeoDesc(rtGeoDesc);
+
+    // 静的なBLAS
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildASDesc{};
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs = buildASDesc.Inputs;
+    inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+    inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+    inputs.NumDescs = UINT(rtGeoDesc.size());
+    inputs.pGeometryDescs = rtGeoDesc.data();
+    inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+
+    // BLAS関連のバッファを作成
+    auto blas = CreateASBuffers(device, buildASDesc, m_name);
+    m_pBLAS = blas.asBuffer;
+
+    buildASDesc.ScratchAccelerationStructureData = blas.scratchBuffer->GetGPUVirtualAddress();
+    buildASDesc.DestAccelerationStructureData = blas.asBuffer->GetGPUVirtualAddress();
+
+    // BLAS構築 (頂点バッファの転送と同じバッチで実行)
+    auto cmd = device->GetUploadCommandList();
+    cmd->BuildRaytracingAccelerationStructure(&buildASDesc, 0, nullptr);
+    auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(m_pBLAS.Get());
+    cmd->ResourceBarrier(1, &barrier);
+    device->KeepUntilUploaded(blas.scratchBuffer);
+}
+
+void Model::CreateRTGeoDesc(std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& rtGeoDesc) const
+{
+    CreateRTGeoDesc(rtGeoDesc, m_vertexAtrrib.position->GetGPUVirtualAddress(), m_pBLASMatrices->GetGPUVirtualAddress());
+}
+
+void Model::CreateRTGeoDesc(
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& rtGeoDesc,
+    D3D12_GPU_VIRTUAL_ADDRESS positionAddress,
+    D3D12_GPU_VIRTUAL_ADDRESS matrixAddress) const
+{
+    const auto mtxSize = sizeof(Mtx3x4);
+    auto addressBase = matrixAddress;
+
+    UINT mtxIndex = 0;
+    for (const auto& mesh : m_meshes)
+    {
+        for (const auto& primitive : mesh.m_primitives)
+        {
+            rtGeoDesc.emplace_back(D3D12_RAYTRACING_GEOMETRY_DESC{});
+            auto& desc = rtGeoDesc.back();
+            desc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+            desc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+            auto& triangles = desc.Triangles;
+            // マトリックス情報
+            triangles.Transform3x4 = addressBase + mtxIndex * mtxSize;
+            // 頂点情報
+            triangles.VertexBuffer.StrideInBytes = sizeof(Float3);
+            triangles.VertexBuffer.StartAddress = positionAddress;
+            triangles.VertexBuffer.StartAddress += primitive.m_vertexStart * sizeof(Float3);
+            triangles.VertexCount = primitive.m_vertexCount;
+            triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+            // インデックス情報
+            triangles.IndexBuffer = m_pIndexBuffer->GetGPUVirtualAddress();
+            triangles.IndexBuffer += primitive.m_indexStart * sizeof(UINT);
+            triangles.IndexCount = primitive.m_indexCount;
+            triangles.IndexFormat = DXGI_FORMAT_R32_UINT;
+        }
+        mtxIndex++;
+    }
+}
+
+/// <summary>
+/// テクスチャが参照する画像の列挙
+/// 画像はエンコードされたまま、メモリマップしたファイルまたは展開済みのデータを参照する
+/// </summary>
+/// <param name="src"></param>
+void Model::LoadTextureSource(const GLTFDocument& src)
+{
+    const auto& srcModel = src.model;
+    m_encodedImages.assign(src.images.begin(), src.images.end());
+    for (const auto& texture : srcModel.textures)
+    {
+        const auto& image = srcModel.images[texture.source];
+        m_textureImages.push_back(texture.source);
+        m_textureNames.push_back(StrToWStr(image.name + ": " + image.uri));
+    }
+}
+
+/// <summary>
+/// 画像のデコード (ミップマップ生成とBC圧縮を含む, 結果はキャッシュされる)
+/// デバイスを使用しないため、解析スレッド上でさらに画像単位で並列に行う
+/// </summary>
+void Model::DecodeImages()
+{
+    m_decodedImages.resize(m_encodedImages.size());
+    std::vector<uint8_t> results(m_encodedImages.size(), 0);
+    ParallelFor(m_encodedImages.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const auto& encoded = m_encodedImages[i];
+            results[i] = PrepareTexture(encoded.data(), encoded.size(), m_decodedImages[i]) ? 1 : 0;
+        }
+    });
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (!results[i])
+        {
+            std::wstring err = L"テクスチャのデコードに失敗しました: " + m_name + L" image[" + std::to_wstring(i) + L"]";
+            Error(PrintInfoType::RTCAMP10, err);
+        }
+    }
+    if (!DecodeImage(L"dummy.png", m_dummyImage))
+    {
+        Error(PrintInfoType::RTCAMP10, L"テクスチャのロードに失敗しました: dummy.png");
+    }
+}
+
+/// <summary>
+/// プリミティブごとの範囲と行列, 拡散色の取得
+/// </summary>
+/// <param name="infos"></param>
+void Model::GetPrimitiveInfos(std::vector<PrimitiveInfo>& infos) const
+{
+    for (const auto& mesh : m_meshes)
+    {
+        auto nodeMtx = mesh.m_nodeIndex < 0 ? IdentityMtx() : m_hierarchy.GetWorldMatrix(mesh.m_nodeIndex);
+        for (const auto& primitive : mesh.m_primitives)
+        {
+            PrimitiveInfo info{};
+            info.indexStart = primitive.m_indexStart;
+            info.indexCount = primitive.m_indexCount;
+            info.vertexStart = primitive.m_vertexStart;
+            info.vertexCount = primitive.m_vertexCount;
+            XMStoreFloat3x4(&info.nodeMtx, nodeMtx);
+            info.diffuse = m_materials[primitive.m_materialIndex].GetDiffuseColor();
+            infos.push_back(info);
+        }
+    }
+}
+
+std::span<const BVHNode> Model::GetBVHNodes() const
+{
+    return m_pBaked ? m_pBaked->GetSection<BVHNode>(BakedModel::Section::BVHNode) : std::span<const BVHNode>();
+}
+
+std::span<const uint32_t> Model::GetBVHTriangles() const
+{
+    return m_pBaked ? m_pBaked->GetSection<uint32_t>(BakedModel::Section::BVHTriangle) : std::span<const uint32_t>();
+}
+
+/// <summary>
+/// ベイク済みファイルの書き出し
+/// スキンとアニメーションを持つモデルは対象外
+/// </summary>
+/// <param name="path">出力先</param>
+/// <param name="source">変換元のファイル情報</param>
+/// <param name="buildBVH">CPU用のBVHを含めるか</param>
+/// <returns></returns>
+bool Model::Bake(const std::wstring& path, const BakedModel::SourceInfo& source, bool buildBVH) const
+{
+    using Section = BakedModel::Section;
+    if (IsUploaded() || m_geometry.positions.empty())
+    {
+        Print(PrintInfoType::RTCAMP10, L"展開済みの頂点データがないためベイクできません: " + m_name);
+        return false;
+    }
+    if (!m_skins.empty() || !m_animations.empty())
+    {
+        Print(PrintInfoType::RTCAMP10, L"スキンまたはアニメーションを持つモデルはベイクに対応していません: " + m_name);
+        return false;
+    }
+
+    std::vector<wchar_t> strings;
+    auto addString = [&strings](const std::wstring& str)
+    {
+        BakedModel::StringRef ref{ uint32_t(strings.size()), uint32_t(str.size()) };
+        strings.insert(strings.end(), str.begin(), str.end());
+        return ref;
+    };
+
+    std::vector<BakedModel::NodeRecord> nodes(m_hierarchy.GetNodeCount());
+    for (UINT i = 0; i < UINT(nodes.size()); ++i)
+    {
+        auto& node = nodes[i];
+        node.name = addString(m_hierarchy.GetName(int(i)));
+        node.parent = m_hierarchy.GetParent(int(i));
+        XMStoreFloat4(&node.translation, m_hierarchy.GetTranslation(int(i)));
+        XMStoreFloat4(&node.rotation, m_hierarchy.GetRotation(int(i)));
+        XMStoreFloat4(&node.scale, m_hierarchy.GetScale(int(i)));
+    }
+
+    std::vector<BakedModel::MeshRecord> meshes;
+    std::vector<BakedModel::PrimitiveRecord> primitives;
+    for (const auto& mesh : m_meshes)
+    {
+        meshes.push_back({ mesh.m_nodeIndex, uint32_t(primitives.size()), uint32_t(mesh.m_primitives.size()), 0 });
+        for (const auto& primitive : mesh.m_primitives)
+        {
+            BakedModel::PrimitiveRecord record{};
+            record.indexStart = primitive.m_indexStart;
+            record.vertexStart = primitive.m_vertexStart;
+            record.indexCount = primitive.m_indexCount;
+            record.vertexCount = primitive.m_vertexCount;
+            record.materialIndex = primitive.m_materialIndex;
+            primitives.push_back(record);
+        }
+    }
+
+    std::vector<BakedModel::MaterialRecord> materials;
+    for (const auto& mat : m_materials)
+    {
+        materials.push_back({ addString(mat.m_name), mat.m_textureIndex, mat.m_diffuseColor });
+    }
+
+    // 画像は共有されていても1度だけ格納する
+    std::vector<BakedModel::TextureRecord> textures;
+    std::vector<uint8_t> imageData;
+    std::vector<std::pair<uint64_t, uint64_t>> imageRanges(m_encodedImages.size(), { 0, 0 });
+    std::vector<bool> isImageWritten(m_encodedImages.size(), false);
+    for (UINT i = 0; i < UINT(m_textureImages.size()); ++i)
+    {
+        auto imageIndex = m_textureImages[i];
+        if (!isImageWritten[imageIndex])
+        {
+            const auto& encoded = m_encodedImages[imageIndex];
+            imageRanges[imageIndex] = { imageData.size(), encoded.size() };
+            imageData.insert(imageData.end(), encoded.begin(), encoded.end());
+            isImageWritten[imageIndex] = true;
+        }
+        textures.push_back({ addString(m_textureNames[i]), imageRanges[imageIndex].first, imageRanges[imageIndex].second });
+    }
+
+    // CPU用のBVH (三角形はインデックスバッファ上の番号で参照する)
+    std::vector<BVHNode> bvhNodes;
+    std::vector<uint32_t> bvhTriangles;
+    if (buildBVH)
+    {
+        std::vector<BVHBounds> triBounds(m_geometry.indices.size() / 3);
+        for (const auto& mesh : m_meshes)
+        {
+            auto nodeMtx = mesh.m_nodeIndex < 0 ? IdentityMtx() : m_hierarchy.GetWorldMatrix(mesh.m_nodeIndex);
+            for (const auto& primitive : mesh.m_primitives)
+            {
+                for (UINT idx = 0; idx + 2 < primitive.m_indexCount; idx += 3)
+                {
+                    auto& bounds = triBounds[(primitive.m_indexStart + idx) / 3];
+                    for (UINT k = 0; k < 3; ++k)
+                    {
+                        auto vertex = primitive.m_vertexStart + m_geometry.indices[primitive.m_indexStart + idx + k];
+                        Float3 pos;
+                        XMStoreFloat3(&pos, XMVector3TransformCoord(XMLoadFloat3(&m_geometry.positions[vertex]), nodeMtx));
+                        bounds.Grow(pos);
+                    }
+                }
+            }
+        }
+        BuildBVH(triBounds, bvhNodes, bvhTriangles);
+    }
+
+    auto asBytes = [](const auto& values)
+    {
+        return std::as_bytes(std::span(values.data(), values.size()));
+    };
+    const BakedModel::VertexFormatRecord vertexFormat{
+        uint32_t(m_vertexFormat.normal), m_vertexFormat.normalStride,
+        uint32_t(m_vertexFormat.texcoord), m_vertexFormat.texcoordStride
+    };
+    std::array<std::span<const uint8_t>, size_t(Section::Count)> sections{};
+    auto setSection = [&](Section section, std::span<const std::byte> bytes)
+    {
+        sections[size_t(section)] = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    };
+    setSection(Section::Index, asBytes(m_geometry.indices));
+    setSection(Section::Position, asBytes(m_geometry.positions));
+    setSection(Section::Normal, asBytes(m_geometry.normals));
+    setSection(Section::Texcoord, asBytes(m_geometry.texcoords));
+    setSection(Section::Mesh, asBytes(meshes));
+    setSection(Section::Primitive, asBytes(primitives));
+    setSection(Section::Node, asBytes(nodes));
+    setSection(Section::Material, asBytes(materials));
+    setSection(Section::Texture, asBytes(textures));
+    setSection(Section::ImageData, asBytes(imageData));
+    setSection(Section::String, asBytes(strings));
+    setSection(Section::BVHNode, asBytes(bvhNodes));
+    setSection(Section::BVHTriangle, asBytes(bvhTriangles));
+    setSection(Section::VertexFormat, std::as_bytes(std::span(&vertexFormat, 1)));
+    return BakedModel::Write(path, source, sections);
+}
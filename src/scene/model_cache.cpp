@@ -0,0 +1,283 @@
+#include "scene/model_cache.hpp"
+#include "utils/hash_util.h"
+
+#include <filesystem>
+#include <future>
+#include <unordered_set>
+
+ModelCache::~ModelCache()
+{
+    m_pathToHash.clear();
+    m_models.clear();
+}
+
+/// <summary>
+/// モデルの取得
+/// 未ロードの場合のみファイルを読み込んで構築する
+/// </summary>
+/// <param name="fileName"></param>
+/// <param name="device"></param>
+/// <returns></returns>
+std::shared_ptr<Model> ModelCache::Load(const std::wstring& fileName, std::unique_ptr<Device>& device)
+{
+    // 同一パスは読み込み自体を省略
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto pathItr = m_pathToHash.find(fileName);
+        if (pathItr != m_pathToHash.end())
+        {
+            return m_models[pathItr->second];
+        }
+    }
+    auto parsed = Parse(fileName);
+    return Register(parsed, device);
+}
+
+/// <summary>
+/// 複数モデルの先行読み込み
+/// </summary>
+/// <param name="fileNames"></param>
+/// <param name="device"></param>
+void ModelCache::Preload(const std::vector<std::wstring>& fileNames, std::unique_ptr<Device>& device)
+{
+    // 未ロードのファイルを重複なく抽出
+    std::vector<std::wstring> targets;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::unordered_set<std::wstring> visited;
+        for (const auto& fileName : fileNames)
+        {
+            if (m_pathToHash.contains(fileName) || !visited.insert(fileName).second)
+            {
+                continue;
+            }
+            targets.push_back(fileName);
+        }
+    }
+
+    // ファイル読み込みとglTF解析はCPUのみで完結するので並列に行う
+    std::vector<std::future<ParsedModel>> tasks;
+    tasks.reserve(targets.size());
+    for (const auto& fileName : targets)
+    {
+        tasks.emplace_back(std::async(std::launch::async, [this, fileName]() { return Parse(fileName); }));
+    }
+
+    // GPUリソースの作成はデバイスがスレッドセーフでないため直列に行う
+    // 転送は全モデル分を1回の実行にまとめる
+    device->BeginUploadBatch();
+    for (auto& task : tasks)
+    {
+        auto parsed = task.get();
+        Register(parsed, device);
+    }
+    device->EndUploadBatch();
+}
+
+/// <summary>
+/// キャッシュの破棄
+/// </summary>
+/// <param name="device"></param>
+void ModelCache::Clear(std::unique_ptr<Device>& device)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& [hash, model] : m_models)
+    {
+        model->Destroy(device);
+    }
+    m_models.clear();
+    m_pathToHash.clear();
+}
+
+/// <summary>
+/// GPUリソースを作成しないモデルの取得
+/// 頂点属性はUploadまで保持されるため、Model::GetPositionsなどで参照できる
+/// </summary>
+/// <param name="fileName"></param>
+/// <returns></returns>
+std::shared_ptr<Model> ModelCache::LoadWithoutUpload(const std::wstring& fileName)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto pathItr = m_pathToHash.find(fileName);
+        if (pathItr != m_pathToHash.end())
+        {
+            return m_models[pathItr->second];
+        }
+    }
+    auto parsed = Parse(fileName);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pathToHash[parsed.fileName] = parsed.hash;
+    auto modelItr = m_models.find(parsed.hash);
+    if (modelItr != m_models.end())
+    {
+        return modelItr->second;
+    }
+    m_models[parsed.hash] = parsed.model;
+    Print(PrintInfoType::RTCAMP10, L"モデルロード (CPU): " + parsed.fileName);
+    return parsed.model;
+}
+
+/// <summary>
+/// ファイルの読み込みと解析 (CPUのみ)
+/// </summary>
+/// <param name="fileName"></param>
+/// <returns></returns>
+ModelCache::ParsedModel ModelCache::Parse(const std::wstring& fileName) const
+{
+    ParsedModel parsed{};
+    parsed.fileName = fileName;
+
+    // ベイク済みファイルがあればglTFの解析を省略
+    if (auto baked = OpenBaked(fileName))
+    {
+        parsed.hash = baked->GetSourceInfo().hash;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_models.contains(parsed.hash))
+            {
+                return parsed;
+            }
+        }
+        parsed.model = std::make_shared<Model>(fileName, baked);
+        parsed.model->DecodeImages();
+        return parsed;
+    }
+
+    auto file = MapFile(fileName);
+    if (!file)
+    {
+        std::wstring err = L"glTFファイルの読み込みに失敗しました: " + fileName;
+        Error(PrintInfoType::RTCAMP10, err);
+    }
+
+    // 別名でも内容が同じであれば共有
+    // 外部バッファを参照する.gltfはファイル名も含めてハッシュ化する
+    parsed.hash = ComputeHash(fileName, file->GetSpan());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_models.contains(parsed.hash))
+        {
+            return parsed;
+        }
+    }
+    parsed.model = std::make_shared<Model>(fileName, file);
+    parsed.model->DecodeImages();
+    return parsed;
+}
+
+/// <summary>
+/// 解析済みモデルのGPUリソース作成と登録
+/// </summary>
+/// <param name="parsed"></param>
+/// <param name="device"></param>
+/// <returns></returns>
+std::shared_ptr<Model> ModelCache::Register(ParsedModel& parsed, std::unique_ptr<Device>& device)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pathToHash[parsed.fileName] = parsed.hash;
+    auto modelItr = m_models.find(parsed.hash);
+    if (modelItr != m_models.end())
+    {
+        return modelItr->second;
+    }
+    parsed.model->Upload(device);
+    m_models[parsed.hash] = parsed.model;
+    Print(PrintInfoType::RTCAMP10, L"モデルロード: " + parsed.fileName);
+    return parsed.model;
+}
+
+/// <summary>
+/// ファイルを読み取り専用でメモリマップ (内容はコピーしない)
+/// </summary>
+/// <param name="fileName"></param>
+/// <returns>開けない場合はnullptr</returns>
+std::shared_ptr<const MappedFile> ModelCache::MapFile(const std::wstring& fileName) const
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(RESOURCE_DIR L"/scene/" + fileName))
+    {
+        return nullptr;
+    }
+    return file;
+}
+
+uint64_t ModelCache::ComputeHash(const std::wstring& fileName, std::span<const uint8_t> data) const
+{
+    // 別名でも内容が同じであれば共有
+    // 外部バッファを参照する.gltfはファイル名も含めてハッシュ化する
+    auto hash = HashFNV1a64(data.data(), data.size());
+    if (std::filesystem::path(fileName).extension() == L".gltf")
+    {
+        hash = HashFNV1a64(fileName, hash);
+    }
+    return hash;
+}
+
+bool ModelCache::GetSourceStat(const std::wstring& fileName, uint64_t& size, uint64_t& writeTime) const
+{
+    namespace fs = std::filesystem;
+    const fs::path path{ RESOURCE_DIR L"/scene/" + fileName };
+    std::error_code ec;
+    size = uint64_t(fs::file_size(path, ec));
+    if (ec)
+    {
+        return false;
+    }
+    writeTime = uint64_t(fs::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+/// <summary>
+/// ベイク済みファイルのオープン
+/// 変換元のglTFが更新されている場合は使用しない
+/// </summary>
+/// <param name="fileName"></param>
+/// <returns>使用できない場合はnullptr</returns>
+std::shared_ptr<BakedModel> ModelCache::OpenBaked(const std::wstring& fileName) const
+{
+    auto baked = std::make_shared<BakedModel>();
+    if (!baked->Open(BakedModel::GetBakedPath(fileName)))
+    {
+        return nullptr;
+    }
+    // 変換元がない場合はベイク済みファイルのみで動作させる
+    uint64_t size = 0;
+    uint64_t writeTime = 0;
+    const auto& source = baked->GetSourceInfo();
+    if (GetSourceStat(fileName, size, writeTime) && (source.size != size || source.writeTime != writeTime))
+    {
+        Print(PrintInfoType::RTCAMP10, L"ベイク済みファイルが古いため使用しません: " + fileName);
+        return nullptr;
+    }
+    return baked;
+}
+
+/// <summary>
+/// ベイク済みファイルの作成
+/// </summary>
+/// <param name="fileName">変換元のglTFファイル</param>
+/// <param name="buildBVH">CPU用のBVHを含めるか</param>
+/// <returns></returns>
+bool ModelCache::Bake(const std::wstring& fileName, bool buildBVH) const
+{
+    auto file = MapFile(fileName);
+    BakedModel::SourceInfo source{};
+    if (!file || !GetSourceStat(fileName, source.size, source.writeTime))
+    {
+        std::wstring err = L"glTFファイルの読み込みに失敗しました: " + fileName;
+        Error(PrintInfoType::RTCAMP10, err);
+    }
+    source.hash = ComputeHash(fileName, file->GetSpan());
+
+    // 画像はエンコードされたまま格納するのでデコードは不要
+    Model model(fileName, file);
+    auto bakedPath = BakedModel::GetBakedPath(fileName);
+    if (!model.Bake(bakedPath, source, buildBVH))
+    {
+        return false;
+    }
+    Print(PrintInfoType::RTCAMP10, L"ベイク完了: " + bakedPath);
+    return true;
+}
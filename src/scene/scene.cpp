@@ -1,5 +1,7 @@
 #include "scene/scene.hpp"
-#include "utils/color_util.h"
+#include "utils/parallel_util.h"
+
+#include <future>
 
 Scene::Scene(std::unique_ptr<Device>& device) :
     m_pDevice(device),
@@ -7,7 +9,9 @@ Scene::Scene(std::unique_ptr<Device>& device) :
     m_param(),
     m_maxPathDepth(8),
     m_maxSPP(80),
-    m_totalHitGroupCount(0)
+    m_totalHitGroupCount(0),
+    m_updatedActorCount(0),
+    m_transformVersion(0)
 {
 }
 
@@ -15,263 +19,86 @@ Scene::~Scene()
 {
 }
 
-void Scene::OnInit(float aspect)
+void Scene::OnInit(float aspect, const std::wstring& sceneFile)
 {
-    // カメラの初期設定
-    float fovY = XM_PIDIV4;
-    float nearZ = 0.1f;
-    float farZ = 100.0f;
-    Float3 startPos(-9.0, 0.36, 5.8);
-    Float3 target(0.0f, 5.0f, 0.0f);
-    m_camera = std::shared_ptr<Camera>(new Camera(fovY, aspect, nearZ, farZ, startPos, target));
-    if (m_pDevice->CreateConstantBuffer(m_pConstantBuffers, sizeof(SceneParam), L"SceneCB"))
+    // シーン記述ファイルの読み込み
+    SceneDesc desc{};
+    if (!LoadSceneDesc(sceneFile, desc))
     {
-        UpdateSceneParam(0);
+        std::wstring err = L"シーンファイルの読み込みに失敗しました: " + sceneFile;
+        Error(PrintInfoType::RTCAMP10, err);
     }
 
+    // 演出の初期状態 (カメラ, 光源, 演出で動かすアクターの初期配置)
+    m_animation.OnInit(desc, aspect);
+    m_camera = std::make_shared<Camera>(m_animation.GetState().camera);
+    UpdateSceneParam(0);
+
+    // 背景の環境マップはモデルの読み込みと並行して開く (キャッシュがない場合は変換する)
+    auto bgLoad = std::async(std::launch::async, [&]() { return m_envMap.Load(desc.background); });
+
+    // GPUへの転送とBLAS構築はシーン全体で1回の実行にまとめる
+    m_pDevice->BeginUploadBatch();
+
     // モデルの初期設定
-    InitializeActors();
+    InitializeActors(desc);
 
     // 背景テクスチャのロード
-    m_bgTex = LoadHDRTexture(L"rogland_clear_night_4k.hdr", m_pDevice);
+    if (!bgLoad.get())
+    {
+        std::wstring err = L"HDRテクスチャのロードに失敗しました: " + desc.background;
+        Error(PrintInfoType::RTCAMP10, err);
+    }
+    m_bgTex = m_envMap.Upload(m_pDevice);
+
+    m_pDevice->EndUploadBatch();
+
+    // 光源のパラメーターは演出の状態から設定する
+    ApplyAnimationState(m_animation.GetState());
 
     Print(PrintInfoType::RTCAMP10, L"シーン構築 完了");
 }
 
 void Scene::OnUpdate(int currentFrame, int maxFrame)
 {
-    // アニメーション処理はこちらで行う
-    // 本番提出想定設定
-    // MAX_FRAME: 600
-    // FPS: 60
-    // MAX_SEC: 10
-    // TODO: 後ほど削除
-    maxFrame = 600;
-    int fps = 60;
-    float maxSec = 10;
-    float deltaTime = float(currentFrame % fps) / float(fps);
-    float currentTime = float(currentFrame) * maxSec / float(maxFrame);
-
-    /// カメラ演出
-    {
-        float startTime = 0.0f;
-        float action1Time = 2.0f;
-        float action2Time = 2.5f;
-        float action3Time = 5.5f;
-        float action4Time = 8.0;
-        float action5Time = 10.0f;
-        Float3 camStartPos(-9.0, 0.36, 5.8);
-        Float3 camAction1Pos(3.0, 5.5, 3.1);
-        Float3 camAction2Pos(6.6, 9.5, 3.6);
-        Float3 camAction3Pos(8.0, 10.0, -6);
-        float camStartFovY = XM_PIDIV4;
-        float camAction3FovY = XM_PIDIV4 * 0.5;
-
-        ////// ACTION 1 ///////
-        // TIME: 0.0 - 2.0 (sec)
-        if (startTime <= currentTime && currentTime < action1Time)
-        {
-            // カメラ移動
-            m_camera->MoveAnimInCubic(currentTime, startTime, action1Time, camStartPos, camAction1Pos);
-        }
-        ////// ACTION 2 //////
-        // TIME: 2.0 - 2.5 (sec)
-        else if (action1Time <= currentTime && currentTime < action2Time)
-        {
-            // カメラ移動
-            m_camera->MoveAnimOutCubic(currentTime, action1Time, action2Time, camAction1Pos, camAction2Pos);
-        }
-        ////// ACTION 3 - READY //////
-        // TIME: 2.5 - 5.5 (sec)
-        else if (action2Time <= currentTime && currentTime < action3Time)
-        {
-            // カメラ移動
-            m_camera->MoveAnimInCubic(currentTime, action2Time, action3Time, camAction2Pos, camAction3Pos);
-            // カメラ画角調整
-            m_camera->ChangeFovYInCubic(currentTime, action2Time, action3Time, camStartFovY, camAction3FovY);
-        }
-        ////// ACTION 4 - STAY //////
-        // TIME: 5.5 - 8.0 (sec)
-        ////// ACTION 6 - FLY //////
-        // TIME: 8.0 - 10.0 (sec)
-        else if (action4Time <= currentTime && currentTime < action5Time)
-        {
-            // カメラ画角調整
-            m_camera->ChangeFovYInCubic(currentTime, action4Time, (action4Time + 0.5f), camAction3FovY, camStartFovY);
-            // カメラ追従
-            if (currentTime < (action4Time + 1.2f))
-            {
-                auto actorPos = m_modelActor->GetWorldPos();
-                m_camera->SetTarget(actorPos);
-            }
-            // モデル移動
-            Float3 modelStartPos(0, 5, 0);
-            Float3 modelEndPos(0, 100, 0);
-            m_modelActor->MoveAnimInCubic(currentTime, action4Time, action5Time, modelStartPos, modelEndPos);
-        }
-    }
+    // 演出は直前の状態を引き継ぐため、巻き戻しや途中のフレームの再生はSceneAnimationで行う
+    ApplyAnimationState(m_animation.Seek(currentFrame, maxFrame));
 
-    /// 背景展開
+    // glTFアニメーションは時刻のみで決まるため、途中のフレームを再生せず直接適用
+    float animationTime = float(currentFrame) / AnimationFrameRate;
+    for (auto& actor : m_animatedActors)
     {
-        float startTime = 7.9f;
-        float endTime = 8.1f;
-        if (startTime <= currentTime && currentTime < endTime)
-        {
-            // ハッチオープン
-            // 天板移動
-            Float3 topStartPos(0, 10, 0);
-            Float3 topEndPos(0, 10, -10);
-            m_planeTop->MoveAnimInCubic(currentTime, startTime, endTime, topStartPos, topEndPos);
-            m_planeTop->SetRotation(180, Float3(1, 0, 0));
-            // 後壁
-            float t = (currentTime - startTime) / (endTime - startTime);
-            float startDeg = -90;
-            float endDeg = 0;
-            float degree = std::lerp(startDeg, endDeg, t);
-            m_planeBack->SetRotation(degree, Float3(1, 0, 0));
-            m_planeBack->Translate(Float3(0, -5, 0));
-            // 左壁
-            m_planeLeft->SetRotation(degree, Float3(0, 0, 1));
-            m_planeLeft->Translate(Float3(0, -5, 0));
-        }
+        actor->SetAnimationTime(animationTime);
     }
 
-    /// モデル回転挙動
+    // シーンパラメータの更新
+    UpdateSceneParam(currentFrame);
+
+    // シーンバッファの書き込み (フレームの動的バッファに配置)
+    m_sceneCBAddress = m_pDevice->WriteDynamic(&m_param, sizeof(SceneParam));
+}
+
+/// <summary>
+/// 演出の状態の反映
+/// 姿勢が変化していないアクターはUpdateBLASでスキップされる
+/// </summary>
+/// <param name="state"></param>
+void Scene::ApplyAnimationState(const SceneAnimation::State& state)
+{
+    *m_camera = state.camera;
+    for (UINT i = 0; i < GetLightCount(); ++i)
     {
-        float rotTime1 = 2.0f; // 予備動作 (右回転)
-        float rotTime2 = 5.0f; // 予備動作 (左回転)
-        float rotTime3 = 5.5f; // 停止開始
-        float rotTime4 = 6.0f; // 停止解除
-        float rotTime5 = 8.0f; // フルスロットル
-        float modelReadyDeg1 = -60.0f;
-        float modelReadyDeg2 = 130.0f;
-        float modelSpeedUpDeg = 2000.0f;
-        float modelFinalDeg = 0.0f;
-        float modelFinalRot = 10.0f;
-        // 回転の予備動作1
-        // TIME: 2.0 - 5.0
-        if (rotTime1 <= currentTime && currentTime < rotTime2)
-        {
-            // モデルの回転
-            float t = (currentTime - rotTime1) / (rotTime2 - rotTime1);
-            float s = EaseInCubic(t);
-            float degree = std::lerp(0.0, modelReadyDeg1, s);
-            m_modelActor->SetRotation(degree, Float3(0, 1, 0));
-        }
-        // 回転の予備動作2
-        // TIME: 5.0 - 5.5
-        else if (rotTime2 <= currentTime && currentTime < rotTime3)
-        {
-            // モデルの回転
-            float t = (currentTime - rotTime2) / (rotTime3 - rotTime2);
-            float s = EaseOutCubic(t);
-            float degree = std::lerp(modelReadyDeg1, modelReadyDeg2, s);
-            m_modelActor->SetRotation(degree, Float3(0, 1, 0));
-        }
-        // 一時停止
-        // TIME: 5.5 - 6.0
-        // 回転の予備動作2
-        // TIME: 6.0 - 8.0
-        else if (rotTime4 <= currentTime && currentTime < rotTime5)
-        {
-            // モデルの回転
-            float t = (currentTime - rotTime4) / (rotTime5 - rotTime4);
-            float s = EaseInCubic(t);
-            float degree = std::lerp(modelReadyDeg2, modelSpeedUpDeg, s);
-            // モデルの回転
-            m_modelActor->SetRotation(degree, Float3(0, 1, 0));
-        }
-        // 最終回転動作
-        // TIME: 8.0 - 10.0
-        else if (rotTime5 <= currentTime)
-        {
-            // モデルの回転
-            m_modelActor->Rotate(modelFinalRot * deltaTime, modelSpeedUpDeg, Float3(0, 1, 0));
-        }
+        const auto& light = state.lights[i];
+        GetLightParam(i) = { light.center, light.radius, light.color, light.intensity };
+        m_lightActors[i]->SetWorldPos(light.center);
     }
-
-    /// ライト演出
+    for (UINT i = 0; i < SceneAnimation::TargetCount; ++i)
     {
-        float lightEnd = 5.7f;
-        float boxOpenTime = 6.7f;
-        if (currentTime <= lightEnd)
-        {
-            float a = 3.5f;
-            float b = 3.5f / 3.0f;
-            int cycleFrame = (int)(lightEnd * 60);
-            float deltaTime = float(currentFrame % cycleFrame) / float(cycleFrame);
-            // 移動挙動
-            float theta = XM_2PI * deltaTime;
-            Float2 pos = Hypocycloid(a, b, theta);
-            m_sphereLight1->SetWorldPos(Float3(pos.x, 7, pos.y));
-            theta += (2.0f * XM_PI) / 3.0f;
-            theta += XM_2PI * deltaTime;
-            pos = Hypocycloid(a, b, theta);
-            m_sphereLight2->SetWorldPos(Float3(pos.x, 7, pos.y));
-            theta += (2.0f * XM_PI) / 3.0f;
-            pos = Hypocycloid(a, b, theta);
-            m_sphereLight3->SetWorldPos(Float3(pos.x, 7, pos.y));
-
-            float t = EaseInOutQuad(deltaTime);
-
-            // 強度の変化
-            float initialIntensity = 50;
-            float additionalIntensity = 5;
-            m_param.light1.intensity = initialIntensity + (t * additionalIntensity);
-            m_param.light2.intensity = initialIntensity + (t * additionalIntensity);
-            m_param.light3.intensity = initialIntensity + (t * additionalIntensity);
-
-            // カラー変化
-            if (0 <= currentFrame && currentFrame < (int)(cycleFrame / 3))
-            {
-                float s = ((float)currentFrame) / ((float)cycleFrame / 3.0f);
-                float t = EaseInOutQuad(s);
-                m_param.light1.color = Lerp(COL_LIGHT_SKY_BLUE, COL_MEDIUM_ORCHID, t);
-                m_param.light2.color = Lerp(COL_MEDIUM_ORCHID, COL_ROYAL_BLUE, t);
-                m_param.light3.color = Lerp(COL_ROYAL_BLUE, COL_LIGHT_SKY_BLUE, t);
-            }
-            else if ((int)(cycleFrame / 3) <= currentFrame && currentFrame < (int)(2 * cycleFrame / 3))
-            {
-                float s = (((float)currentFrame) - ((float)cycleFrame / 3.0f)) / ((float)cycleFrame / 3.0f);
-                float t = EaseInOutQuad(s);
-                m_param.light1.color = Lerp(COL_MEDIUM_ORCHID, COL_ROYAL_BLUE, t);
-                m_param.light2.color = Lerp(COL_ROYAL_BLUE, COL_LIGHT_SKY_BLUE, t);
-                m_param.light3.color = Lerp(COL_LIGHT_SKY_BLUE, COL_MEDIUM_ORCHID, t);
-            }
-            else if ((int)(2 * cycleFrame / 3) <= currentFrame)
-            {
-                float s = (((float)currentFrame) - ((float)2.0f * cycleFrame / 3.0f)) / ((float)cycleFrame / 3.0f);
-                float t = EaseInOutQuad(s);
-                m_param.light1.color = Lerp(COL_ROYAL_BLUE, COL_LIGHT_SKY_BLUE, t);
-                m_param.light2.color = Lerp(COL_LIGHT_SKY_BLUE, COL_MEDIUM_ORCHID, t);
-                m_param.light3.color = Lerp(COL_MEDIUM_ORCHID, COL_ROYAL_BLUE, t);
-            }
-        }
-        else if (lightEnd < currentTime && currentTime <= boxOpenTime)
+        if (m_targetActors[i] && state.targets[i])
         {
-            float s = (currentTime - lightEnd) / (boxOpenTime - lightEnd);
-            float t = EaseInCubic(s);
-            m_param.light1.color = Lerp(COL_LIGHT_SKY_BLUE, COL_VIOLET, t);
-            m_param.light2.color = Lerp(COL_MEDIUM_ORCHID, COL_VIOLET, t);
-            m_param.light3.color = Lerp(COL_ROYAL_BLUE, COL_VIOLET, t);
-            m_param.light1.intensity = std::lerp(50, 65, t);
-            m_param.light2.intensity = std::lerp(50, 65, t);
-            m_param.light3.intensity = std::lerp(50, 65, t);
+            m_targetActors[i]->SetTransformState(*state.targets[i]);
         }
-
-        // ライトパラメータの更新
-        m_param.light1.center = m_sphereLight1->GetWorldPos();
-        m_param.light2.center = m_sphereLight2->GetWorldPos();
-        m_param.light3.center = m_sphereLight3->GetWorldPos();
     }
-
-    // シーンバッファの書き込み
-    UINT frameIndex = m_pDevice->GetCurrentFrameIndex();
-    auto cb = m_pConstantBuffers[frameIndex];
-    m_pDevice->WriteBuffer(cb, &m_param, sizeof(SceneParam));
-
-    // シーンパラメータの更新
-    UpdateSceneParam(currentFrame);
 }
 
 void Scene::OnDestroy()
@@ -281,87 +108,33 @@ void Scene::OnDestroy()
     {
         actor.reset();
     }
-    for (auto& sceneCB : m_pConstantBuffers)
-    {
-        sceneCB.Reset();
-    }
+    m_actors.clear();
+    m_animatedActors.clear();
+    m_actorMap.clear();
+    m_lightActors.clear();
+    m_modelCache.Clear(m_pDevice);
+    m_sceneCBAddress = 0;
 }
 
-void Scene::CreateRTInstanceDesc(std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs)
+void Scene::WriteRTInstanceDescs(D3D12_RAYTRACING_INSTANCE_DESC* dst) const
 {
-    UINT instanceHitGroupOffset = 0;
-    // ライト
+    // HitGroupのオフセットはシェーダーテーブルの書き込み順 (m_actors) と一致させる
+    ParallelFor(m_actors.size(), ActorBatchSize, [&](size_t begin, size_t end)
     {
-        auto lights =
-        {
-            m_sphereLight1,
-            m_sphereLight2,
-            m_sphereLight3
-        };
-        UINT lightInstanceID = 1;
-        for (auto& light : lights)
+        for (size_t i = begin; i < end; ++i)
         {
+            const auto& actor = m_actors[i];
             D3D12_RAYTRACING_INSTANCE_DESC desc{};
-            auto mtxTrans = light->GetWorldMatrix();
+            auto mtxTrans = actor->GetWorldMatrix();
             XMStoreFloat3x4(reinterpret_cast<Mtx3x4*>(&desc.Transform), mtxTrans);
-            desc.InstanceID = lightInstanceID;
-            desc.InstanceMask = 0x08; // ライト用のマスク
-            desc.InstanceContributionToHitGroupIndex = instanceHitGroupOffset;
+            desc.InstanceID = actor->GetInstanceID();
+            desc.InstanceMask = actor->GetInstanceMask();
+            desc.InstanceContributionToHitGroupIndex = m_hitGroupOffsets[i];
             desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-            desc.AccelerationStructure = light->GetBLAS()->GetGPUVirtualAddress();
-            instanceDescs.push_back(desc);
-            instanceHitGroupOffset += light->GetTotalMeshCount();
-            lightInstanceID++;
+            desc.AccelerationStructure = actor->GetBLAS()->GetGPUVirtualAddress();
+            dst[i] = desc;
         }
-    }
-    // 背景
-    {
-        auto planes =
-        { 
-            m_planeBottom, m_planeTop,
-            m_planeRight, m_planeLeft,
-            m_planeFront, m_planeBack
-        };
-        for (auto& plane : planes)
-        {
-            D3D12_RAYTRACING_INSTANCE_DESC desc{};
-            auto mtxTrans = plane->GetWorldMatrix();
-            XMStoreFloat3x4(reinterpret_cast<Mtx3x4*>(&desc.Transform), mtxTrans);
-            desc.InstanceID = 0;
-            desc.InstanceMask = 0xFF;
-            desc.InstanceContributionToHitGroupIndex = instanceHitGroupOffset;
-            desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-            desc.AccelerationStructure = plane->GetBLAS()->GetGPUVirtualAddress();
-            instanceDescs.push_back(desc);
-            instanceHitGroupOffset += plane->GetTotalMeshCount();
-        }
-    }
-    // テーブル
-    {
-        D3D12_RAYTRACING_INSTANCE_DESC desc{};
-        auto mtxTrans = m_tableActor->GetWorldMatrix();
-        XMStoreFloat3x4(reinterpret_cast<Mtx3x4*>(&desc.Transform), mtxTrans);
-        desc.InstanceID = 0;
-        desc.InstanceMask = 0xFF;
-        desc.InstanceContributionToHitGroupIndex = instanceHitGroupOffset;
-        desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-        desc.AccelerationStructure = m_tableActor->GetBLAS()->GetGPUVirtualAddress();
-        instanceDescs.push_back(desc);
-        instanceHitGroupOffset += m_tableActor->GetTotalMeshCount();
-    }
-    // オブジェクト
-    {
-        D3D12_RAYTRACING_INSTANCE_DESC desc{};
-        auto mtxTrans = m_modelActor->GetWorldMatrix();
-        XMStoreFloat3x4(reinterpret_cast<Mtx3x4*>(&desc.Transform), mtxTrans);
-        desc.InstanceID = 0;
-        desc.InstanceMask = 0xFF;
-        desc.InstanceContributionToHitGroupIndex = instanceHitGroupOffset;
-        desc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-        desc.AccelerationStructure = m_modelActor->GetBLAS()->GetGPUVirtualAddress();
-        instanceDescs.push_back(desc);
-        instanceHitGroupOffset += m_modelActor->GetTotalMeshCount();
-    }
+    });
 }
 
 /// <summary>
@@ -377,6 +150,7 @@ void Scene::UpdateSceneParam(UINT currentFrame)
     m_param.currentFrameNum = currentFrame;
     m_param.maxPathDepth = m_maxPathDepth;
     m_param.maxSPP = m_maxSPP;
+    m_param.lightCount = GetLightCount();
 }
 
 /// <summary>
@@ -399,81 +173,107 @@ uint8_t* Scene::WriteHitGroupShaderRecord(uint8_t* dst, UINT hitGroupRecordSize,
 
 /// <summary>
 /// BLASの更新
+/// BLASはモデル間で共有した静的なものなので、アクターの行列更新のみ行う
+/// 姿勢が変化していないアクターはスキップ
+/// アクターは互いに独立しているため、範囲ごとに別のコマンドリストへ並列に記録する
 /// </summary>
-/// <param name="cmdList"></param>
-void Scene::UpdateBLAS(ComPtr<ID3D12GraphicsCommandList4> cmdList)
+/// <param name="cmdListPool">フレームを開始済みのプール</param>
+void Scene::UpdateBLAS(CommandListPool<Device>& cmdListPool)
 {
-    for (auto& actor : m_actors )
+    std::atomic<UINT> updatedActorCount{ 0 };
+    cmdListPool.RecordParallel(m_actors.size(), ActorBatchSize, [&](ComPtr<ID3D12GraphicsCommandList4> cmdList, size_t begin, size_t end)
+    {
+        UINT updatedCount = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& actor = m_actors[i];
+            if (actor->UpdateMatrices())
+            {
+                updatedCount++;
+            }
+            // スキニングするアクターは姿勢の変化に合わせてBLASをリフィット
+            actor->UpdateSkinning(cmdList);
+        }
+        updatedActorCount += updatedCount;
+    });
+    m_updatedActorCount = updatedActorCount;
+    if (m_updatedActorCount > 0)
     {
-        actor->UpdateMatrices();
-        actor->UpdateTransform();
-        actor->UpdateBLAS(cmdList);
+        m_transformVersion++;
     }
 }
 
-/// <summary>
-/// シーン用定数バッファの取得
-/// </summary>
-/// <returns></returns>
-ComPtr<ID3D12Resource> Scene::GetConstantBuffer()
-{
-    UINT frameIndex = m_pDevice->GetCurrentFrameIndex();
-    return m_pConstantBuffers[frameIndex];
-}
-
 /// <summary>
 /// オブジェクトのセットアップ
 /// </summary>
-void Scene::InitializeActors()
+/// <param name="desc">シーン記述</param>
+void Scene::InitializeActors(const SceneDesc& desc)
 {
-    float initialIntensity = 50.0;
-    // ライト1
-    Float3 light1Pos = Float3(0, 1, 2);
-    Float3 light1Color = COL_LIGHT_SKY_BLUE;
-    SphereLightParam light1Param(light1Pos, 0.2, light1Color, initialIntensity);
-    m_param.light1 = light1Param;
-    InstantiateActor(m_sphereLight1, L"sphere.glb", L"Actor", light1Pos);
-    m_actors.push_back(m_sphereLight1);
-    // ライト2
-    Float3 light2Pos = Float3(sqrt(3), 1, -1);
-    Float3 light2Color = COL_MEDIUM_ORCHID;
-    SphereLightParam light2Param(light2Pos, 0.2, light2Color, initialIntensity);
-    m_param.light2 = light2Param;
-    InstantiateActor(m_sphereLight2, L"sphere.glb", L"Actor", light2Pos);
-    m_actors.push_back(m_sphereLight2);
-    // ライト3
-    Float3 light3Pos = Float3(-sqrt(3), 1, -1);
-    Float3 light3Color = COL_ROYAL_BLUE;
-    SphereLightParam light3Param(light3Pos, 0.2, light3Color, initialIntensity);
-    m_param.light3 = light3Param;
-    InstantiateActor(m_sphereLight3, L"sphere.glb", L"Actor", light3Pos);
-    m_actors.push_back(m_sphereLight3);
-
-    // 背景
-    InstantiateActor(m_planeBottom, L"plane.glb", L"Actor", Float3(0, 0, 0));
-    m_actors.push_back(m_planeBottom);
-    InstantiateActor(m_planeTop, L"plane.glb", L"Actor", Float3(0, 10, 0));
-    m_planeTop->SetRotation(180, Float3(1, 0, 0));
-    m_actors.push_back(m_planeTop);
-    InstantiateActor(m_planeRight, L"plane.glb", L"Actor", Float3(5, 5, 0));
-    m_planeRight->SetRotation(90, Float3(0, 0, 1));
-    m_actors.push_back(m_planeRight);
-    InstantiateActor(m_planeLeft, L"plane.glb", L"Actor", Float3(-5, 5, 0));
-    m_planeLeft->SetRotation(-90, Float3(0, 0, 1));
-    m_actors.push_back(m_planeLeft);
-    InstantiateActor(m_planeFront, L"plane.glb", L"Actor", Float3(0, 5, -5));
-    m_planeFront->SetRotation(90, Float3(1, 0, 0));
-    m_actors.push_back(m_planeFront);
-    InstantiateActor(m_planeBack, L"plane.glb", L"Actor", Float3(0, 5, 5));
-    m_planeBack->SetRotation(-90, Float3(1, 0, 0));
-    m_actors.push_back(m_planeBack);
-
-    // テーブル
-    InstantiateActor(m_tableActor, L"round_table.glb", L"Actor", Float3(0, 0, 0));
-    m_actors.push_back(m_tableActor);
-    // キャラクター
-    InstantiateActor(m_modelActor, L"model.glb", L"Actor", Float3(0, 5, 0));
-    m_actors.push_back(m_modelActor);
+    if (desc.lights.size() > MaxLightCount)
+    {
+        Error(PrintInfoType::RTCAMP10, "ライトの数が上限を超えています: ", desc.lights.size());
+    }
+
+    // 使用するモデルを並列に先行ロード
+    std::vector<std::wstring> modelFiles;
+    for (const auto& light : desc.lights)
+    {
+        modelFiles.push_back(light.model);
+    }
+    for (const auto& actorDesc : desc.actors)
+    {
+        modelFiles.push_back(actorDesc.model);
+    }
+    m_modelCache.Preload(modelFiles, m_pDevice);
+
+    // ライト
+    // InstanceIDはシェーダー側の光源判定と対応 (1始まり)
+    for (UINT i = 0; i < UINT(desc.lights.size()); ++i)
+    {
+        const auto& lightDesc = desc.lights[i];
+        std::shared_ptr<Actor> light;
+        InstantiateActor(light, lightDesc.model, L"Actor", lightDesc.position);
+        light->SetInstanceID(i + 1);
+        light->SetInstanceMask(0x08); // ライト用のマスク
+        m_lightActors.push_back(light);
+        RegisterActor(lightDesc.name, light);
+    }
+
+    // アクター
+    for (const auto& actorDesc : desc.actors)
+    {
+        for (UINT i = 0; i < UINT(actorDesc.instances.size()); ++i)
+        {
+            const auto& transform = actorDesc.instances[i];
+            std::shared_ptr<Actor> actor;
+            InstantiateActor(actor, actorDesc.model, actorDesc.hitGroup, transform.position);
+            actor->SetTransformState(SceneAnimation::MakeTransform(transform));
+            auto name = actorDesc.name;
+            if (actorDesc.instances.size() > 1)
+            {
+                name += L"[" + std::to_wstring(i) + L"]";
+            }
+            if (!actorDesc.animation.empty())
+            {
+                if (!actor->SetAnimation(actorDesc.animation))
+                {
+                    Error(PrintInfoType::RTCAMP10, L"アニメーションが見つかりません: " + actorDesc.animation);
+                }
+                m_animatedActors.push_back(actor);
+            }
+            RegisterActor(name, actor);
+        }
+    }
+
+    // 演出で参照するアクター
+    for (UINT i = 0; i < SceneAnimation::TargetCount; ++i)
+    {
+        m_targetActors[i] = FindActor(SceneAnimation::GetTargetName(SceneAnimation::Target(i)));
+    }
+    m_planeBottom = FindActor(L"planeBottom");
+    m_planeRight = FindActor(L"planeRight");
+    m_planeFront = FindActor(L"planeFront");
+    m_tableActor = FindActor(L"table");
 
     // HitGroup合計の設定
     SetTotalHitGroupCount();
@@ -488,8 +288,8 @@ void Scene::InitializeActors()
 /// <param name="pos"></param>
 void Scene::InstantiateActor(std::shared_ptr<Actor>& actor, const std::wstring fileName, const std::wstring hitGroup, Float3 pos)
 {
-    // モデルのロード
-    auto model = new Model(fileName, m_pDevice);
+    // モデルのロード (ロード済みであれば共有)
+    auto model = m_modelCache.Load(fileName, m_pDevice);
     actor = model->InstantiateActor(m_pDevice);
     actor->SetMaterialHitGroup(hitGroup);
     // 初期位置設定
@@ -500,8 +300,10 @@ void Scene::InstantiateActor(std::shared_ptr<Actor>& actor, const std::wstring f
 void Scene::SetTotalHitGroupCount()
 {
     UINT hitGroupCount = 0;
+    m_hitGroupOffsets.clear();
     for (const auto& actor : m_actors )
     {
+        m_hitGroupOffsets.push_back(hitGroupCount);
         for (UINT groupIdx = 0; groupIdx < actor->GetMeshGroupCount(); ++groupIdx)
         {
             hitGroupCount += actor->GetMeshCount(groupIdx);
@@ -509,3 +311,42 @@ void Scene::SetTotalHitGroupCount()
     }
     m_totalHitGroupCount = hitGroupCount;
 }
+
+/// <summary>
+/// アクターの登録
+/// </summary>
+/// <param name="name"></param>
+/// <param name="actor"></param>
+void Scene::RegisterActor(const std::wstring& name, std::shared_ptr<Actor>& actor)
+{
+    actor->UpdateMatrices();
+    m_actors.push_back(actor);
+    if (!name.empty())
+    {
+        if (m_actorMap.contains(name))
+        {
+            Error(PrintInfoType::RTCAMP10, L"アクター名が重複しています: " + name);
+        }
+        m_actorMap[name] = actor;
+    }
+}
+
+/// <summary>
+/// 名前からアクターを検索
+/// </summary>
+/// <param name="name"></param>
+/// <returns>見つからない場合はnullptr</returns>
+std::shared_ptr<Actor> Scene::FindActor(const std::wstring& name) const
+{
+    auto itr = m_actorMap.find(name);
+    if (itr == m_actorMap.end())
+    {
+        return nullptr;
+    }
+    return itr->second;
+}
+
+Scene::SphereLightParam& Scene::GetLightParam(UINT index)
+{
+    return m_param.lights[(std::min)(index, MaxLightCount - 1)];
+}
@@ -0,0 +1,321 @@
+#include "scene/scene_animation.hpp"
+#include "utils/color_util.h"
+
+#include <cmath>
+
+/// <summary>
+/// 初期状態の作成
+/// 演出で動かすアクターはインスタンスが1つのもののみを名前で対応付ける (Scene::FindActorと同じ)
+/// </summary>
+/// <param name="desc">シーン記述</param>
+/// <param name="aspect"></param>
+void SceneAnimation::OnInit(const SceneDesc& desc, float aspect)
+{
+    State state{};
+    const auto& cam = desc.camera;
+    state.camera = Camera(cam.fovY, aspect, cam.nearZ, cam.farZ, cam.position, cam.target);
+    for (const auto& lightDesc : desc.lights)
+    {
+        state.lights.push_back({ lightDesc.position, lightDesc.radius, lightDesc.color, lightDesc.intensity });
+    }
+    for (uint32_t i = 0; i < TargetCount; ++i)
+    {
+        for (const auto& actorDesc : desc.actors)
+        {
+            if (actorDesc.instances.size() == 1 && actorDesc.name == GetTargetName(Target(i)))
+            {
+                state.targets[i] = MakeTransform(actorDesc.instances[0]);
+            }
+        }
+    }
+    m_initialState = state;
+    m_state = state;
+    m_lastAnimatedFrame = -1;
+}
+
+const SceneAnimation::State& SceneAnimation::Seek(int currentFrame, int maxFrame)
+{
+    if (currentFrame <= m_lastAnimatedFrame)
+    {
+        m_state = m_initialState;
+        m_lastAnimatedFrame = -1;
+    }
+    for (int frame = m_lastAnimatedFrame + 1; frame <= currentFrame; ++frame)
+    {
+        Animate(frame, maxFrame);
+    }
+    m_lastAnimatedFrame = currentFrame;
+    return m_state;
+}
+
+const wchar_t* SceneAnimation::GetTargetName(Target target)
+{
+    switch (target)
+    {
+    case Target::Model:
+        return L"model";
+    case Target::PlaneTop:
+        return L"planeTop";
+    case Target::PlaneBack:
+        return L"planeBack";
+    case Target::PlaneLeft:
+        return L"planeLeft";
+    default:
+        return L"";
+    }
+}
+
+ActorTransform SceneAnimation::MakeTransform(const SceneDesc::TransformDesc& desc)
+{
+    ActorTransform transform;
+    transform.SetWorldPos(desc.position);
+    if (desc.rotationDeg != 0.0f)
+    {
+        transform.SetRotation(desc.rotationDeg, desc.rotationAxis);
+    }
+    return transform;
+}
+
+ActorTransform* SceneAnimation::GetTarget(Target target)
+{
+    auto& transform = m_state.targets[uint32_t(target)];
+    return transform ? &*transform : nullptr;
+}
+
+/// <summary>
+/// アニメーション処理
+/// 結果は直前のフレームの状態と currentFrame のみで決まる
+/// </summary>
+/// <param name="currentFrame"></param>
+/// <param name="maxFrame"></param>
+void SceneAnimation::Animate(int currentFrame, int maxFrame)
+{
+    auto& camera = m_state.camera;
+    auto& lights = m_state.lights;
+    auto* model = GetTarget(Target::Model);
+    auto* planeTop = GetTarget(Target::PlaneTop);
+    auto* planeBack = GetTarget(Target::PlaneBack);
+    auto* planeLeft = GetTarget(Target::PlaneLeft);
+
+    // アニメーション処理はこちらで行う
+    // 本番提出想定設定
+    // MAX_FRAME: 600
+    // FPS: 60
+    // MAX_SEC: 10
+    // TODO: 後ほど削除
+    maxFrame = 600;
+    int fps = 60;
+    float maxSec = 10;
+    float deltaTime = float(currentFrame % fps) / float(fps);
+    float currentTime = float(currentFrame) * maxSec / float(maxFrame);
+
+    /// カメラ演出
+    {
+        float startTime = 0.0f;
+        float action1Time = 2.0f;
+        float action2Time = 2.5f;
+        float action3Time = 5.5f;
+        float action4Time = 8.0;
+        float action5Time = 10.0f;
+        Float3 camStartPos(-9.0, 0.36, 5.8);
+        Float3 camAction1Pos(3.0, 5.5, 3.1);
+        Float3 camAction2Pos(6.6, 9.5, 3.6);
+        Float3 camAction3Pos(8.0, 10.0, -6);
+        float camStartFovY = XM_PIDIV4;
+        float camAction3FovY = XM_PIDIV4 * 0.5;
+
+        ////// ACTION 1 ///////
+        // TIME: 0.0 - 2.0 (sec)
+        if (startTime <= currentTime && currentTime < action1Time)
+        {
+            // カメラ移動
+            camera.MoveAnimInCubic(currentTime, startTime, action1Time, camStartPos, camAction1Pos);
+        }
+        ////// ACTION 2 //////
+        // TIME: 2.0 - 2.5 (sec)
+        else if (action1Time <= currentTime && currentTime < action2Time)
+        {
+            // カメラ移動
+            camera.MoveAnimOutCubic(currentTime, action1Time, action2Time, camAction1Pos, camAction2Pos);
+        }
+        ////// ACTION 3 - READY //////
+        // TIME: 2.5 - 5.5 (sec)
+        else if (action2Time <= currentTime && currentTime < action3Time)
+        {
+            // カメラ移動
+            camera.MoveAnimInCubic(currentTime, action2Time, action3Time, camAction2Pos, camAction3Pos);
+            // カメラ画角調整
+            camera.ChangeFovYInCubic(currentTime, action2Time, action3Time, camStartFovY, camAction3FovY);
+        }
+        ////// ACTION 4 - STAY //////
+        // TIME: 5.5 - 8.0 (sec)
+        ////// ACTION 6 - FLY //////
+        // TIME: 8.0 - 10.0 (sec)
+        else if (action4Time <= currentTime && currentTime < action5Time && model)
+        {
+            // カメラ画角調整
+            camera.ChangeFovYInCubic(currentTime, action4Time, (action4Time + 0.5f), camAction3FovY, camStartFovY);
+            // カメラ追従
+            if (currentTime < (action4Time + 1.2f))
+            {
+                auto actorPos = model->worldPos;
+                camera.SetTarget(actorPos);
+            }
+            // モデル移動
+            Float3 modelStartPos(0, 5, 0);
+            Float3 modelEndPos(0, 100, 0);
+            model->MoveAnimInCubic(currentTime, action4Time, action5Time, modelStartPos, modelEndPos);
+        }
+    }
+
+    /// 背景展開
+    {
+        float startTime = 7.9f;
+        float endTime = 8.1f;
+        bool hasBox = planeTop && planeBack && planeLeft;
+        if (hasBox && startTime <= currentTime && currentTime < endTime)
+        {
+            // ハッチオープン
+            // 天板移動
+            Float3 topStartPos(0, 10, 0);
+            Float3 topEndPos(0, 10, -10);
+            planeTop->MoveAnimInCubic(currentTime, startTime, endTime, topStartPos, topEndPos);
+            planeTop->SetRotation(180, Float3(1, 0, 0));
+            // 後壁
+            float t = (currentTime - startTime) / (endTime - startTime);
+            float startDeg = -90;
+            float endDeg = 0;
+            float degree = std::lerp(startDeg, endDeg, t);
+            planeBack->SetRotation(degree, Float3(1, 0, 0));
+            planeBack->Translate(Float3(0, -5, 0));
+            // 左壁
+            planeLeft->SetRotation(degree, Float3(0, 0, 1));
+            planeLeft->Translate(Float3(0, -5, 0));
+        }
+    }
+
+    /// モデル回転挙動
+    if (model)
+    {
+        float rotTime1 = 2.0f; // 予備動作 (右回転)
+        float rotTime2 = 5.0f; // 予備動作 (左回転)
+        float rotTime3 = 5.5f; // 停止開始
+        float rotTime4 = 6.0f; // 停止解除
+        float rotTime5 = 8.0f; // フルスロットル
+        float modelReadyDeg1 = -60.0f;
+        float modelReadyDeg2 = 130.0f;
+        float modelSpeedUpDeg = 2000.0f;
+        float modelFinalRot = 10.0f;
+        // 回転の予備動作1
+        // TIME: 2.0 - 5.0
+        if (rotTime1 <= currentTime && currentTime < rotTime2)
+        {
+            // モデルの回転
+            float t = (currentTime - rotTime1) / (rotTime2 - rotTime1);
+            float s = EaseInCubic(t);
+            float degree = std::lerp(0.0, modelReadyDeg1, s);
+            model->SetRotation(degree, Float3(0, 1, 0));
+        }
+        // 回転の予備動作2
+        // TIME: 5.0 - 5.5
+        else if (rotTime2 <= currentTime && currentTime < rotTime3)
+        {
+            // モデルの回転
+            float t = (currentTime - rotTime2) / (rotTime3 - rotTime2);
+            float s = EaseOutCubic(t);
+            float degree = std::lerp(modelReadyDeg1, modelReadyDeg2, s);
+            model->SetRotation(degree, Float3(0, 1, 0));
+        }
+        // 一時停止
+        // TIME: 5.5 - 6.0
+        // 回転の予備動作2
+        // TIME: 6.0 - 8.0
+        else if (rotTime4 <= currentTime && currentTime < rotTime5)
+        {
+            // モデルの回転
+            float t = (currentTime - rotTime4) / (rotTime5 - rotTime4);
+            float s = EaseInCubic(t);
+            float degree = std::lerp(modelReadyDeg2, modelSpeedUpDeg, s);
+            // モデルの回転
+            model->SetRotation(degree, Float3(0, 1, 0));
+        }
+        // 最終回転動作
+        // TIME: 8.0 - 10.0
+        else if (rotTime5 <= currentTime)
+        {
+            // モデルの回転
+            model->Rotate(modelFinalRot * deltaTime, modelSpeedUpDeg, Float3(0, 1, 0));
+        }
+    }
+
+    /// ライト演出
+    if (lights.size() == AnimatedLightCount)
+    {
+        float lightEnd = 5.7f;
+        float boxOpenTime = 6.7f;
+        if (currentTime <= lightEnd)
+        {
+            float a = 3.5f;
+            float b = 3.5f / 3.0f;
+            int cycleFrame = (int)(lightEnd * 60);
+            float deltaTime = float(currentFrame % cycleFrame) / float(cycleFrame);
+            // 移動挙動
+            float theta = XM_2PI * deltaTime;
+            Float2 pos = Hypocycloid(a, b, theta);
+            lights[0].center = Float3(pos.x, 7, pos.y);
+            theta += (2.0f * XM_PI) / 3.0f;
+            theta += XM_2PI * deltaTime;
+            pos = Hypocycloid(a, b, theta);
+            lights[1].center = Float3(pos.x, 7, pos.y);
+            theta += (2.0f * XM_PI) / 3.0f;
+            pos = Hypocycloid(a, b, theta);
+            lights[2].center = Float3(pos.x, 7, pos.y);
+
+            float t = EaseInOutQuad(deltaTime);
+
+            // 強度の変化
+            float initialIntensity = 50;
+            float additionalIntensity = 5;
+            lights[0].intensity = initialIntensity + (t * additionalIntensity);
+            lights[1].intensity = initialIntensity + (t * additionalIntensity);
+            lights[2].intensity = initialIntensity + (t * additionalIntensity);
+
+            // カラー変化
+            if (0 <= currentFrame && currentFrame < (int)(cycleFrame / 3))
+            {
+                float s = ((float)currentFrame) / ((float)cycleFrame / 3.0f);
+                float t = EaseInOutQuad(s);
+                lights[0].color = Lerp(COL_LIGHT_SKY_BLUE, COL_MEDIUM_ORCHID, t);
+                lights[1].color = Lerp(COL_MEDIUM_ORCHID, COL_ROYAL_BLUE, t);
+                lights[2].color = Lerp(COL_ROYAL_BLUE, COL_LIGHT_SKY_BLUE, t);
+            }
+            else if ((int)(cycleFrame / 3) <= currentFrame && currentFrame < (int)(2 * cycleFrame / 3))
+            {
+                float s = (((float)currentFrame) - ((float)cycleFrame / 3.0f)) / ((float)cycleFrame / 3.0f);
+                float t = EaseInOutQuad(s);
+                lights[0].color = Lerp(COL_MEDIUM_ORCHID, COL_ROYAL_BLUE, t);
+                lights[1].color = Lerp(COL_ROYAL_BLUE, COL_LIGHT_SKY_BLUE, t);
+                lights[2].color = Lerp(COL_LIGHT_SKY_BLUE, COL_MEDIUM_ORCHID, t);
+            }
+            else if ((int)(2 * cycleFrame / 3) <= currentFrame)
+            {
+                float s = (((float)currentFrame) - ((float)2.0f * cycleFrame / 3.0f)) / ((float)cycleFrame / 3.0f);
+                float t = EaseInOutQuad(s);
+                lights[0].color = Lerp(COL_ROYAL_BLUE, COL_LIGHT_SKY_BLUE, t);
+                lights[1].color = Lerp(COL_LIGHT_SKY_BLUE, COL_MEDIUM_ORCHID, t);
+                lights[2].color = Lerp(COL_MEDIUM_ORCHID, COL_ROYAL_BLUE, t);
+            }
+        }
+        else if (lightEnd < currentTime && currentTime <= boxOpenTime)
+        {
+            float s = (currentTime - lightEnd) / (boxOpenTime - lightEnd);
+            float t = EaseInCubic(s);
+            lights[0].color = Lerp(COL_LIGHT_SKY_BLUE, COL_VIOLET, t);
+            lights[1].color = Lerp(COL_MEDIUM_ORCHID, COL_VIOLET, t);
+            lights[2].color = Lerp(COL_ROYAL_BLUE, COL_VIOLET, t);
+            lights[0].intensity = std::lerp(50, 65, t);
+            lights[1].intensity = std::lerp(50, 65, t);
+            lights[2].intensity = std::lerp(50, 65, t);
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#include "scene/scene_desc.hpp"
+#include "utils/print_util.h"
+
+#include <filesystem>
+#include <fstream>
+
+// tinygltfに同梱されているnlohmann/json
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+namespace
+{
+    Float3 ReadFloat3(const json& j, const char* key, Float3 defaultValue)
+    {
+        if (!j.contains(key))
+        {
+            return defaultValue;
+        }
+        const auto& v = j.at(key);
+        if (!v.is_array() || v.size() != 3)
+        {
+            Error(PrintInfoType::RTCAMP10, "シーンファイルの値が不正です (float3): ", key);
+        }
+        return Float3(v[0].get<float>(), v[1].get<float>(), v[2].get<float>());
+    }
+
+    std::wstring ReadWString(const json& j, const char* key, const std::wstring& defaultValue)
+    {
+        if (!j.contains(key))
+        {
+            return defaultValue;
+        }
+        return StrToWStr(j.at(key).get<std::string>());
+    }
+
+    SceneDesc::TransformDesc ReadTransform(const json& j)
+    {
+        SceneDesc::TransformDesc transform{};
+        transform.position = ReadFloat3(j, "position", transform.position);
+        if (j.contains("rotation"))
+        {
+            const auto& rot = j.at("rotation");
+            transform.rotationDeg = rot.value("degree", transform.rotationDeg);
+            transform.rotationAxis = ReadFloat3(rot, "axis", transform.rotationAxis);
+        }
+        return transform;
+    }
+}
+
+/// <summary>
+/// シーン記述ファイルの読み込み
+/// </summary>
+/// <param name="fileName">resources/scene/以下のファイル名</param>
+/// <param name="desc">読み込み先</param>
+/// <returns></returns>
+bool LoadSceneDesc(const std::wstring& fileName, SceneDesc& desc)
+{
+    namespace fs = std::filesystem;
+    const fs::path path{ RESOURCE_DIR L"/scene/" + fileName };
+    std::ifstream srcFile(path);
+    if (!srcFile)
+    {
+        return false;
+    }
+
+    json root;
+    try
+    {
+        root = json::parse(srcFile);
+
+        // カメラ
+        if (root.contains("camera"))
+        {
+            const auto& cam = root.at("camera");
+            desc.camera.position = ReadFloat3(cam, "position", desc.camera.position);
+            desc.camera.target = ReadFloat3(cam, "target", desc.camera.target);
+            if (cam.contains("fovY"))
+            {
+                desc.camera.fovY = XMConvertToRadians(cam.at("fovY").get<float>());
+            }
+            desc.camera.nearZ = cam.value("near", desc.camera.nearZ);
+            desc.camera.farZ = cam.value("far", desc.camera.farZ);
+        }
+
+        // 環境
+        if (root.contains("environment"))
+        {
+            desc.background = ReadWString(root.at("environment"), "hdr", desc.background);
+        }
+
+        // ライト
+        if (root.contains("lights"))
+        {
+            for (const auto& src : root.at("lights"))
+            {
+                SceneDesc::LightDesc light{};
+                light.name = ReadWString(src, "name", L"light" + std::to_wstring(desc.lights.size() + 1));
+                light.model = ReadWString(src, "model", light.model);
+                light.position = ReadFloat3(src, "position", light.position);
+                light.radius = src.value("radius", light.radius);
+                light.color = ReadFloat3(src, "color", light.color);
+                light.intensity = src.value("intensity", light.intensity);
+                desc.lights.push_back(light);
+            }
+        }
+
+        // アクター
+        if (root.contains("actors"))
+        {
+            for (const auto& src : root.at("actors"))
+            {
+                SceneDesc::ActorDesc actor{};
+                actor.name = ReadWString(src, "name", L"");
+                actor.model = ReadWString(src, "model", L"");
+                actor.hitGroup = ReadWString(src, "hitGroup", actor.hitGroup);
+                actor.animation = ReadWString(src, "animation", L"");
+                if (actor.model.empty())
+                {
+                    Error(PrintInfoType::RTCAMP10, L"モデルが指定されていないアクターがあります: " + actor.name);
+                }
+                if (src.contains("instances"))
+                {
+                    for (const auto& inst : src.at("instances"))
+                    {
+                        actor.instances.push_back(ReadTransform(inst));
+                    }
+                }
+                else
+                {
+                    actor.instances.push_back(ReadTransform(src));
+                }
+                desc.actors.push_back(actor);
+            }
+        }
+    }
+    catch (const json::exception& e)
+    {
+        Error(PrintInfoType::RTCAMP10, L"シーンファイルの解析に失敗しました: " + path.wstring() + L" ", e.what());
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#include "scene/transform_hierarchy.hpp"
+
+void TransformHierarchy::Reserve(UINT nodeCount)
+{
+    m_names.reserve(nodeCount);
+    m_parents.reserve(nodeCount);
+    m_translations.reserve(nodeCount);
+    m_rotations.reserve(nodeCount);
+    m_scales.reserve(nodeCount);
+    m_localMtx.reserve(nodeCount);
+    m_worldMtx.reserve(nodeCount);
+    m_flags.reserve(nodeCount);
+}
+
+/// <summary>
+/// ノードの追加
+/// </summary>
+/// <returns>追加したノードのインデックス</returns>
+int TransformHierarchy::AddNode(const std::wstring& name, int parentIndex, Vector trans, Vector rot, Vector scale)
+{
+    int index = int(m_parents.size());
+    if (parentIndex >= index)
+    {
+        Error(PrintInfoType::RTCAMP10, L"親ノードが子ノードより後に追加されています: " + name);
+    }
+    m_names.push_back(name);
+    m_parents.push_back(parentIndex);
+    m_translations.push_back(trans);
+    m_rotations.push_back(rot);
+    m_scales.push_back(scale);
+    m_localMtx.push_back(IdentityMtx());
+    m_worldMtx.push_back(IdentityMtx());
+    m_flags.push_back(LocalDirty);
+    m_isDirty = true;
+    return index;
+}
+
+/// <summary>
+/// ワールド行列の一括更新
+/// 親は必ず子より前にあるため、親の結果は常に計算済み
+/// </summary>
+/// <param name="rootMtx">ルートノードの親行列</param>
+/// <param name="isRootDirty">ルートの親行列が変化したか</param>
+bool TransformHierarchy::Update(Matrix rootMtx, bool isRootDirty)
+{
+    // 変更がなければ走査も不要
+    if (!m_isDirty && !isRootDirty)
+    {
+        return false;
+    }
+    m_isDirty = false;
+
+    bool isUpdated = false;
+    auto nodeCount = GetNodeCount();
+    for (UINT i = 0; i < nodeCount; ++i)
+    {
+        bool isLocalDirty = (m_flags[i] & LocalDirty) != 0;
+        if (isLocalDirty)
+        {
+            // S * R * T
+            m_localMtx[i] = XMMatrixAffineTransformation(m_scales[i], XMVectorZero(), m_rotations[i], m_translations[i]);
+        }
+        int parent = m_parents[i];
+        bool isParentChanged = parent < 0 ? isRootDirty : (m_flags[parent] & WorldChanged) != 0;
+        bool isWorldChanged = isLocalDirty || isParentChanged;
+        if (isWorldChanged)
+        {
+            m_worldMtx[i] = XMMatrixMultiply(m_localMtx[i], parent < 0 ? rootMtx : m_worldMtx[parent]);
+        }
+        m_flags[i] = isWorldChanged ? WorldChanged : 0;
+        isUpdated |= isWorldChanged;
+    }
+    return isUpdated;
+}
+
+/// <summary>
+/// 名前からノードを検索
+/// </summary>
+/// <returns>見つからない場合は-1</returns>
+int TransformHierarchy::FindNode(const std::wstring& name) const
+{
+    for (UINT i = 0; i < GetNodeCount(); ++i)
+    {
+        if (m_names[i] == name)
+        {
+            return int(i);
+        }
+    }
+    return -1;
+}
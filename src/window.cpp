@@ -98,6 +98,35 @@ int Window::Run(Renderer* renderer, HINSTANCE hInstance)
     }
 }
 
+int Window::RunHeadless(Renderer* renderer)
+{
+    if (!renderer) return EXIT_FAILURE;
+
+    try
+    {
+        renderer->SetHeadless(true);
+        renderer->OnInit();
+
+        // 最後のフレームの描画後にOnRender内で終了処理が行われる
+        while (renderer->GetIsRunning())
+        {
+            renderer->OnUpdate();
+            renderer->OnRender();
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception& e)
+    {
+        if (renderer->GetIsRunning())
+        {
+            renderer->OnDestroy();
+        }
+        std::wstring err = L"エラー終了: " + StrToWStr(std::string(e.what()));
+        Error(PrintInfoType::RTCAMP10, err);
+        return EXIT_FAILURE;
+    }
+}
+
 LRESULT CALLBACK Window::WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
     auto* renderer = (Renderer*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
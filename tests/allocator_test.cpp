@@ -0,0 +1,437 @@
+#include "test_util.h"
+
+#include "utils/descriptor_allocator.h"
+#include "utils/ring_allocator.h"
+#include "utils/tlsf_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <random>
+#include <vector>
+
+// 割り当てが範囲内に収まり、互いに重ならないか
+static bool IsDisjoint(std::vector<TLSFAllocator::Allocation> allocations, uint64_t size)
+{
+    std::sort(allocations.begin(), allocations.end(), [](const auto& a, const auto& b) { return a.offset < b.offset; });
+    for (size_t i = 0; i < allocations.size(); ++i)
+    {
+        const auto& a = allocations[i];
+        if (a.offset + a.size > size || (i + 1 < allocations.size() && a.offset + a.size > allocations[i + 1].offset))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestTLSFAllocateFree()
+{
+    TLSFAllocator allocator(4096);
+    TLSFAllocator::Allocation a, b;
+    TEST_CHECK(allocator.Allocate(100, 1, a));
+    TEST_CHECK(a.IsValid() && a.offset == 0 && a.size >= 100);
+    TEST_CHECK(allocator.Allocate(200, 1, b));
+    TEST_CHECK(b.offset >= a.offset + a.size);
+    TEST_CHECK(allocator.GetAllocationCount() == 2);
+    TEST_CHECK(allocator.GetUsedSize() == a.size + b.size);
+
+    allocator.Free(a);
+    allocator.Free(b);
+    TEST_CHECK(allocator.IsEmpty());
+    TEST_CHECK(allocator.GetUsedSize() == 0);
+
+    // 二重解放は無視する
+    allocator.Free(b);
+    TEST_CHECK(allocator.IsEmpty());
+
+    // サイズ0と範囲を超える要求は失敗する
+    TLSFAllocator::Allocation c;
+    TEST_CHECK(!allocator.Allocate(0, 1, c));
+    TEST_CHECK(!allocator.Allocate(4097, 1, c));
+    TEST_CHECK(!TLSFAllocator().Allocate(1, 1, c));
+}
+
+static void TestTLSFCoalescing()
+{
+    const uint64_t size = 1 << 16;
+    TLSFAllocator allocator(size);
+    TLSFAllocator::Allocation blocks[4];
+    for (auto& block : blocks)
+    {
+        TEST_CHECK(allocator.Allocate(size / 4, 1, block));
+    }
+    TLSFAllocator::Allocation full;
+    TEST_CHECK(!allocator.Allocate(1, 1, full));
+
+    // 前方, 後方, 両側の結合を順に発生させる
+    allocator.Free(blocks[0]);
+    allocator.Free(blocks[2]);
+    TEST_CHECK(!allocator.Allocate(size / 2, 1, full));
+    allocator.Free(blocks[1]);
+    TEST_CHECK(allocator.Allocate(size * 3 / 4, 1, full));
+    TEST_CHECK(full.offset == 0);
+    allocator.Free(full);
+    allocator.Free(blocks[3]);
+
+    // 全て解放すると範囲全体を1つのブロックとして確保できる
+    TEST_CHECK(allocator.IsEmpty());
+    TEST_CHECK(allocator.Allocate(size, 1, full));
+    TEST_CHECK(full.offset == 0 && full.size == size);
+    allocator.Free(full);
+}
+
+static void TestTLSFAlignment()
+{
+    const uint64_t size = 1 << 22;
+    TLSFAllocator allocator(size);
+    std::vector<TLSFAllocator::Allocation> allocations;
+    // 小さい区分から大きい区分まで、アライメントの余白を挟みながら確保する
+    for (uint64_t alignment = 1; alignment <= 65536; alignment *= 2)
+    {
+        for (uint64_t requested : { uint64_t(1), uint64_t(17), uint64_t(255), uint64_t(256), uint64_t(1000), uint64_t(4097) })
+        {
+            TLSFAllocator::Allocation allocation;
+            TEST_CHECK(allocator.Allocate(requested, alignment, allocation));
+            TEST_CHECK(allocation.offset % alignment == 0);
+            TEST_CHECK(allocation.size >= requested);
+            allocations.push_back(allocation);
+        }
+    }
+    TEST_CHECK(IsDisjoint(allocations, size));
+    for (const auto& allocation : allocations)
+    {
+        allocator.Free(allocation);
+    }
+    TEST_CHECK(allocator.IsEmpty());
+    TLSFAllocator::Allocation full;
+    TEST_CHECK(allocator.Allocate(size, 1, full));
+}
+
+static void TestTLSFFragmentation()
+{
+    // 同じサイズの穴は再利用され、範囲が不足しない
+    const uint64_t blockSize = 4096;
+    const uint32_t blockCount = 64;
+    TLSFAllocator allocator(blockSize * blockCount);
+    std::vector<TLSFAllocator::Allocation> allocations(blockCount);
+    for (auto& allocation : allocations)
+    {
+        TEST_CHECK(allocator.Allocate(blockSize, blockSize, allocation));
+    }
+    for (uint32_t i = 1; i < blockCount; i += 2)
+    {
+        allocator.Free(allocations[i]);
+    }
+    // 空きの合計は足りても連続した領域がなければ失敗する
+    TLSFAllocator::Allocation large;
+    TEST_CHECK(!allocator.Allocate(blockSize * 2, 1, large));
+    for (uint32_t i = 1; i < blockCount; i += 2)
+    {
+        TEST_CHECK(allocator.Allocate(blockSize, blockSize, allocations[i]));
+    }
+    TEST_CHECK(allocator.GetUsedSize() == allocator.GetSize());
+    TEST_CHECK(IsDisjoint(allocations, allocator.GetSize()));
+
+    // ランダムな確保と解放を繰り返しても重ならず、全て解放すると元に戻る
+    const uint64_t size = 1 << 24;
+    allocator.Reset(size);
+    allocations.clear();
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint64_t> sizeDist(1, 65536);
+    std::uniform_int_distribution<uint32_t> alignDist(0, 8);
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        if (!allocations.empty() && (rng() % 3 == 0 || allocator.GetUsedSize() > size / 2))
+        {
+            size_t index = rng() % allocations.size();
+            allocator.Free(allocations[index]);
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+            continue;
+        }
+        TLSFAllocator::Allocation allocation;
+        uint64_t alignment = uint64_t(1) << alignDist(rng);
+        if (allocator.Allocate(sizeDist(rng), alignment, allocation))
+        {
+            TEST_CHECK(allocation.offset % alignment == 0);
+            allocations.push_back(allocation);
+        }
+    }
+    TEST_CHECK(IsDisjoint(allocations, size));
+    TEST_CHECK(allocator.GetAllocationCount() == allocations.size());
+    for (const auto& allocation : allocations)
+    {
+        allocator.Free(allocation);
+    }
+    TEST_CHECK(allocator.IsEmpty());
+    TLSFAllocator::Allocation full;
+    TEST_CHECK(allocator.Allocate(size, 1, full));
+}
+
+static void TestRingAllocate()
+{
+    RingAllocator ring(1024);
+    TEST_CHECK(ring.Allocate(100, 1) == 0);
+    TEST_CHECK(ring.Allocate(100, 256) == 256);
+    TEST_CHECK(ring.GetUsedSize() == 356);
+    TEST_CHECK(ring.Allocate(0, 1) == RingAllocator::InvalidOffset);
+    TEST_CHECK(ring.Allocate(1025, 1) == RingAllocator::InvalidOffset);
+    TEST_CHECK(RingAllocator().Allocate(1, 1) == RingAllocator::InvalidOffset);
+}
+
+static void TestRingWrapAround()
+{
+    RingAllocator ring(1024);
+    TEST_CHECK(ring.Allocate(600, 1) == 0);
+    ring.FinishFrame(1);
+    TEST_CHECK(ring.Allocate(300, 1) == 600);
+    ring.FinishFrame(2);
+    TEST_CHECK(ring.GetOldestPendingFence() == 1);
+
+    // 末尾に収まらず、先頭はフレーム1が使用中
+    TEST_CHECK(ring.Allocate(200, 1) == RingAllocator::InvalidOffset);
+    ring.Retire(0);
+    TEST_CHECK(ring.Allocate(200, 1) == RingAllocator::InvalidOffset);
+
+    // フレーム1の完了後は先頭に折り返し、末尾の余りも使用中として数える
+    ring.Retire(1);
+    TEST_CHECK(ring.GetOldestPendingFence() == 2);
+    TEST_CHECK(ring.Allocate(200, 1) == 0);
+    TEST_CHECK(ring.GetUsedSize() == 300 + 124 + 200);
+    ring.FinishFrame(3);
+
+    // 確保のないフレームは解放待ちに追加しない
+    ring.FinishFrame(4);
+    ring.Retire(3);
+    TEST_CHECK(ring.GetOldestPendingFence() == 0);
+    TEST_CHECK(ring.GetUsedSize() == 0);
+    ring.FinishFrame(5);
+    TEST_CHECK(ring.GetOldestPendingFence() == 0);
+    TEST_CHECK(ring.Allocate(824, 1) == 200);
+}
+
+static void TestRingSimulatedFence()
+{
+    // GPUが2フレーム遅れでフェンスに到達する場合に、実行中のフレームの領域と重ならないか
+    struct Range
+    {
+        uint64_t fenceValue;
+        uint64_t offset;
+        uint64_t size;
+    };
+    const uint64_t capacity = 1 << 16;
+    const uint64_t framesInFlight = 2;
+    RingAllocator ring(capacity);
+    std::deque<Range> pending;
+    uint64_t completed = 0;
+    uint32_t waitCount = 0;
+    std::mt19937 rng(5678);
+    std::uniform_int_distribution<uint64_t> sizeDist(1, 8192);
+    std::uniform_int_distribution<uint32_t> countDist(0, 6);
+
+    for (uint64_t frame = 1; frame <= 2000; ++frame)
+    {
+        // 前のフレームまでの完了 (フレームの切り替えでの待機)
+        if (frame > framesInFlight)
+        {
+            completed = (std::max)(completed, frame - framesInFlight);
+        }
+        ring.Retire(completed);
+        while (!pending.empty() && pending.front().fenceValue <= completed)
+        {
+            pending.pop_front();
+        }
+
+        uint32_t count = countDist(rng);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t size = sizeDist(rng);
+            uint64_t alignment = uint64_t(1) << (rng() % 9);
+            uint64_t offset = ring.Allocate(size, alignment);
+            while (offset == RingAllocator::InvalidOffset && ring.GetOldestPendingFence() != 0)
+            {
+                // 空きがなければ最も古いフレームの完了を待つ
+                completed = ring.GetOldestPendingFence();
+                ring.Retire(completed);
+                while (!pending.empty() && pending.front().fenceValue <= completed)
+                {
+                    pending.pop_front();
+                }
+                ++waitCount;
+                offset = ring.Allocate(size, alignment);
+            }
+            TEST_CHECK(offset != RingAllocator::InvalidOffset);
+            if (offset == RingAllocator::InvalidOffset)
+            {
+                continue;
+            }
+            TEST_CHECK(offset % alignment == 0 && offset + size <= capacity);
+            for (const auto& range : pending)
+            {
+                TEST_CHECK(offset + size <= range.offset || range.offset + range.size <= offset);
+            }
+            pending.push_back({ frame, offset, size });
+        }
+        ring.FinishFrame(frame);
+        TEST_CHECK(ring.GetUsedSize() <= capacity);
+        TEST_CHECK(pending.empty() || ring.GetOldestPendingFence() == pending.front().fenceValue);
+    }
+    TEST_CHECK(waitCount > 0);
+
+    ring.Retire(UINT64_MAX);
+    TEST_CHECK(ring.GetUsedSize() == 0);
+    TEST_CHECK(ring.GetOldestPendingFence() == 0);
+}
+
+static void TestDescriptorSingle()
+{
+    // 容量が64の倍数でない場合も範囲外のインデックスは返さない
+    const uint32_t capacity = 130;
+    DescriptorAllocator allocator(capacity);
+    std::vector<bool> used(capacity, false);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        uint32_t index = allocator.Allocate();
+        TEST_CHECK(index < capacity && !used[index]);
+        if (index < capacity)
+        {
+            used[index] = true;
+        }
+    }
+    TEST_CHECK(allocator.Allocate() == DescriptorAllocator::InvalidIndex);
+    TEST_CHECK(allocator.GetAllocatedCount() == capacity);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        allocator.Free(i);
+    }
+    TEST_CHECK(allocator.GetAllocatedCount() == 0);
+    TEST_CHECK(allocator.Allocate(0) == DescriptorAllocator::InvalidIndex);
+    TEST_CHECK(allocator.Allocate(capacity + 1) == DescriptorAllocator::InvalidIndex);
+    TEST_CHECK(DescriptorAllocator().Allocate() == DescriptorAllocator::InvalidIndex);
+}
+
+static void TestDescriptorRange()
+{
+    const uint32_t capacity = 130;
+    DescriptorAllocator allocator(capacity);
+
+    // 64個以下の範囲は1つのワードに収める
+    uint32_t a = allocator.Allocate(40);
+    uint32_t b = allocator.Allocate(40);
+    TEST_CHECK(a != DescriptorAllocator::InvalidIndex && a % 64 + 40 <= 64);
+    TEST_CHECK(b != DescriptorAllocator::InvalidIndex && b % 64 + 40 <= 64);
+    TEST_CHECK(a / 64 != b / 64);
+    allocator.Free(a, 40);
+    allocator.Free(b, 40);
+
+    // 64個を超える範囲はワード単位で確保し、末尾の端数のワードは使用しない
+    uint32_t large = allocator.Allocate(100);
+    TEST_CHECK(large == 0);
+    TEST_CHECK(allocator.Allocate(64) == DescriptorAllocator::InvalidIndex);
+    TEST_CHECK(allocator.Allocate(2) == 128);
+    TEST_CHECK(allocator.Allocate() == DescriptorAllocator::InvalidIndex);
+    allocator.Free(large, 100);
+    TEST_CHECK(allocator.Allocate(64) != DescriptorAllocator::InvalidIndex);
+    TEST_CHECK(allocator.Allocate(130) == DescriptorAllocator::InvalidIndex);
+
+    // 複数のワードの確保が途中で失敗した場合は巻き戻す
+    allocator.Reset(256);
+    TEST_CHECK(allocator.Allocate(64) == 0);
+    TEST_CHECK(allocator.Allocate(1) == 64);
+    allocator.Free(0, 64);
+    TEST_CHECK(allocator.Allocate(128) == 128);
+    TEST_CHECK(allocator.Allocate(64) == 0);
+    TEST_CHECK(allocator.Allocate(128) == DescriptorAllocator::InvalidIndex);
+    TEST_CHECK(allocator.GetAllocatedCount() == 64 + 1 + 128);
+}
+
+static void TestDescriptorThreaded()
+{
+    // 複数のスレッドで確保と解放を繰り返しても範囲が重ならない
+    const uint32_t capacity = 1000;
+    const uint32_t threadCount = 4;
+    DescriptorAllocator allocator(capacity);
+    std::vector<std::atomic<uint32_t>> owners(capacity);
+    std::atomic<uint32_t> overlapCount{ 0 };
+    std::atomic<uint32_t> outOfRangeCount{ 0 };
+
+    auto worker = [&](uint32_t threadIndex)
+    {
+        std::mt19937 rng(threadIndex + 1);
+        std::vector<std::pair<uint32_t, uint32_t>> held;
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            if (!held.empty() && (rng() % 2 == 0 || held.size() > 8))
+            {
+                size_t pick = rng() % held.size();
+                auto [index, count] = held[pick];
+                for (uint32_t j = index; j < index + count; ++j)
+                {
+                    owners[j].store(0);
+                }
+                allocator.Free(index, count);
+                held[pick] = held.back();
+                held.pop_back();
+                continue;
+            }
+            uint32_t count = rng() % 8 == 0 ? 65 + rng() % 64 : 1 + rng() % 16;
+            uint32_t index = allocator.Allocate(count);
+            if (index == DescriptorAllocator::InvalidIndex)
+            {
+                continue;
+            }
+            if (index + count > capacity)
+            {
+                outOfRangeCount.fetch_add(1);
+                continue;
+            }
+            for (uint32_t j = index; j < index + count; ++j)
+            {
+                uint32_t expected = 0;
+                if (!owners[j].compare_exchange_strong(expected, threadIndex + 1))
+                {
+                    overlapCount.fetch_add(1);
+                }
+            }
+            held.push_back({ index, count });
+        }
+        for (auto [index, count] : held)
+        {
+            for (uint32_t j = index; j < index + count; ++j)
+            {
+                owners[j].store(0);
+            }
+            allocator.Free(index, count);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    TEST_CHECK(overlapCount.load() == 0);
+    TEST_CHECK(outOfRangeCount.load() == 0);
+    TEST_CHECK(allocator.GetAllocatedCount() == 0);
+    TEST_CHECK(allocator.Allocate(capacity / 64 * 64) == 0);
+}
+
+int main()
+{
+    RunTest("TLSFAllocateFree", TestTLSFAllocateFree);
+    RunTest("TLSFCoalescing", TestTLSFCoalescing);
+    RunTest("TLSFAlignment", TestTLSFAlignment);
+    RunTest("TLSFFragmentation", TestTLSFFragmentation);
+    RunTest("RingAllocate", TestRingAllocate);
+    RunTest("RingWrapAround", TestRingWrapAround);
+    RunTest("RingSimulatedFence", TestRingSimulatedFence);
+    RunTest("DescriptorSingle", TestDescriptorSingle);
+    RunTest("DescriptorRange", TestDescriptorRange);
+    RunTest("DescriptorThreaded", TestDescriptorThreaded);
+    return TestResult();
+}
@@ -0,0 +1,206 @@
+#include "test_util.h"
+
+#include "backend/null_backend.hpp"
+#include "backend_renderer.hpp"
+#include "backend_scene_desc.hpp"
+
+#include <cstring>
+
+// 演出で動かすアクター (model, planeTop, planeBack, planeLeft) と3灯の球光源を含むシーン
+// ジオメトリは全て三角形1つで、シーン記述はファイルから読まずにコード上で作成する
+class TestScene : public BackendSceneDesc
+{
+public:
+    static const uint32_t InstanceCount = 6;
+
+    void Unload(RenderBackend& backend) override
+    {
+        for (auto buffer : m_buffers)
+        {
+            backend.DestroyBuffer(buffer);
+        }
+        m_buffers.clear();
+        m_geometry = RenderBackend::InvalidHandle;
+    }
+
+protected:
+    void LoadDesc(SceneDesc& desc) override
+    {
+        desc.lights.resize(SceneAnimation::AnimatedLightCount);
+        for (uint32_t i = 0; i < SceneAnimation::AnimatedLightCount; ++i)
+        {
+            desc.lights[i].position = Float3(float(i), 7.0f, 0.0f);
+        }
+        auto addActor = [&](const wchar_t* name, std::vector<SceneDesc::TransformDesc> instances) {
+            SceneDesc::ActorDesc actor{};
+            actor.name = name;
+            actor.model = L"triangle.glb";
+            actor.instances = instances;
+            desc.actors.push_back(actor);
+        };
+        addActor(L"model", { { Float3(0.0f, 5.0f, 0.0f) } });
+        addActor(L"planeTop", { { Float3(0.0f, 10.0f, 0.0f) } });
+        addActor(L"planeBack", { { Float3(0.0f, 5.0f, -5.0f), -90.0f, Float3(1.0f, 0.0f, 0.0f) } });
+        addActor(L"planeLeft", { { Float3(-5.0f, 5.0f, 0.0f), -90.0f, Float3(0.0f, 0.0f, 1.0f) } });
+        // 複数インスタンスのアクターは演出の対象にしない
+        addActor(L"table", { { Float3(1.0f, 0.0f, 0.0f) }, { Float3(-1.0f, 0.0f, 0.0f) } });
+    }
+
+    RenderBackend::GeometryHandle LoadModel(RenderBackend& backend, const std::wstring&) override
+    {
+        if (m_geometry != RenderBackend::InvalidHandle)
+        {
+            return m_geometry;
+        }
+        const Float3 positions[] = { { -1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+        const uint32_t indices[] = { 0, 1, 2 };
+        m_buffers.push_back(backend.CreateBuffer(RenderBackend::BufferUsage::Vertex, sizeof(positions)));
+        backend.WriteBuffer(m_buffers.back(), 0, positions, sizeof(positions));
+        m_buffers.push_back(backend.CreateBuffer(RenderBackend::BufferUsage::Index, sizeof(indices)));
+        backend.WriteBuffer(m_buffers.back(), 0, indices, sizeof(indices));
+
+        RenderBackend::GeometryDesc geometry{};
+        geometry.positions = m_buffers[0];
+        geometry.vertexCount = 3;
+        geometry.indices = m_buffers[1];
+        geometry.indexCount = 3;
+        XMStoreFloat3x4(&geometry.transform, XMMatrixIdentity());
+        m_geometry = backend.BuildGeometry({ &geometry, 1 });
+        return m_geometry;
+    }
+
+    void LoadBackground(RenderBackend& backend, const std::wstring&) override
+    {
+        backend.SetEnvironment([](const Float3&) { return Float3(0.5f, 0.5f, 0.5f); });
+    }
+
+private:
+    RenderBackend::GeometryHandle m_geometry = RenderBackend::InvalidHandle;
+    std::vector<RenderBackend::BufferHandle> m_buffers;
+};
+
+// フレームごとに最初のパスの描画パラメーターを保持する
+class CaptureBackend : public NullBackend
+{
+public:
+    void Dispatch(const FrameParam& param) override
+    {
+        NullBackend::Dispatch(param);
+        if (param.sampleOffset == 0)
+        {
+            m_frameParams.push_back(param);
+        }
+    }
+
+    const std::vector<FrameParam>& GetFrameParams() const { return m_frameParams; }
+
+private:
+    std::vector<FrameParam> m_frameParams;
+};
+
+static bool IsSameState(const SceneAnimation::State& a, const SceneAnimation::State& b)
+{
+    bool isSame = MatrixEqual(a.camera.GetViewMatrix(), b.camera.GetViewMatrix()) &&
+        MatrixEqual(a.camera.GetProjMatrix(), b.camera.GetProjMatrix()) &&
+        a.lights.size() == b.lights.size();
+    for (size_t i = 0; isSame && i < a.lights.size(); ++i)
+    {
+        isSame = memcmp(&a.lights[i], &b.lights[i], sizeof(SceneAnimation::SphereLight)) == 0;
+    }
+    for (uint32_t i = 0; isSame && i < SceneAnimation::TargetCount; ++i)
+    {
+        isSame = a.targets[i].has_value() == b.targets[i].has_value() &&
+            (!a.targets[i] || MatrixEqual(a.targets[i]->worldMtx, b.targets[i]->worldMtx));
+    }
+    return isSame;
+}
+
+static void TestAnimationSeek()
+{
+    // 演出の状態は0フレーム目から順に再生した結果として決まる
+    // 途中のフレームへ直接移動した場合, 巻き戻した場合も同じ状態になること
+    const int maxFrame = 600;
+    SceneDesc desc{};
+    desc.lights.resize(SceneAnimation::AnimatedLightCount);
+    SceneDesc::ActorDesc model{};
+    model.name = L"model";
+    model.instances.push_back({ Float3(0.0f, 5.0f, 0.0f) });
+    desc.actors.push_back(model);
+
+    SceneAnimation sequential;
+    sequential.OnInit(desc, 1.0f);
+    const auto initialState = sequential.GetState();
+    for (int frame = 0; frame <= 500; ++frame)
+    {
+        sequential.Seek(frame, maxFrame);
+    }
+    SceneAnimation direct;
+    direct.OnInit(desc, 1.0f);
+    TEST_CHECK(IsSameState(direct.Seek(500, maxFrame), sequential.GetState()));
+    TEST_CHECK(!IsSameState(initialState, sequential.GetState()));
+
+    // 巻き戻し
+    sequential.Seek(550, maxFrame);
+    TEST_CHECK(IsSameState(sequential.Seek(500, maxFrame), direct.GetState()));
+    TEST_CHECK(sequential.GetState().targets[uint32_t(SceneAnimation::Target::Model)].has_value());
+    TEST_CHECK(!sequential.GetState().targets[uint32_t(SceneAnimation::Target::PlaneTop)].has_value());
+}
+
+static void TestAnimatedSteadyState()
+{
+    // 定常状態ではフレームごとにリソースの作成や待機が発生しないこと
+    // 演出による姿勢の変化はTLASの更新 (転送と実行) のみで反映する
+    // モデルの回転は2秒 (120フレーム) から始まる
+    const int frameCount = 128;
+    const int firstMovedFrame = 121;
+    const uint32_t warmupFrames = 1;
+    const uint32_t width = 64;
+    const uint32_t height = 32;
+    BackendRenderer renderer(width, height, std::make_unique<CaptureBackend>(), std::make_unique<TestScene>(), frameCount);
+    renderer.SetSamplesPerPass(16);
+    int outputCount = 0;
+    renderer.SetFrameOutput([&](int frame, const uint8_t* pixels, uint32_t w, uint32_t h)
+    {
+        TEST_CHECK(frame == outputCount && pixels != nullptr && w == width && h == height);
+        ++outputCount;
+    });
+    TEST_CHECK(renderer.Run() == EXIT_SUCCESS);
+    TEST_CHECK(outputCount == frameCount);
+
+    auto backend = static_cast<CaptureBackend*>(renderer.GetBackend());
+    const auto& recorder = *backend->GetRecorder();
+    const auto& frames = recorder.GetFrames();
+    TEST_CHECK(frames.size() == size_t(frameCount));
+    TEST_CHECK(recorder.GetStallFrameCount(warmupFrames) == 0);
+    for (const auto& stats : frames)
+    {
+        // 80サンプルを16サンプルずつ5回に分けて実行し、1回読み戻す
+        bool isMoved = stats.frame >= firstMovedFrame;
+        uint64_t instanceBytes = TestScene::InstanceCount * sizeof(RenderBackend::InstanceDesc);
+        TEST_CHECK(stats[DeviceRecorder::Counter::Submit] == (isMoved ? 6 : 5));
+        TEST_CHECK(stats[DeviceRecorder::Counter::Map] == 1);
+        TEST_CHECK(stats[DeviceRecorder::Counter::UploadBytes] == (isMoved ? instanceBytes : 0));
+    }
+    TEST_CHECK(backend->GetDispatchedSampleCount() == uint64_t(frameCount) * 80 * width * height);
+
+    // カメラと光源はフレームごとに描画パラメーターへ反映される
+    const auto& params = backend->GetFrameParams();
+    TEST_CHECK(params.size() == size_t(frameCount));
+    if (params.size() == size_t(frameCount))
+    {
+        TEST_CHECK(params[0].lightCount == SceneAnimation::AnimatedLightCount);
+        TEST_CHECK(memcmp(&params[0].invViewMtx, &params[60].invViewMtx, sizeof(Mtx4x4)) != 0);
+        TEST_CHECK(memcmp(&params[0].lights[0].center, &params[60].lights[0].center, sizeof(Float3)) != 0);
+        TEST_CHECK(params[60].frame == 60);
+    }
+
+    // シーンのリソースは全て破棄される
+    TEST_CHECK(backend->GetCalls().back().name == "OnDestroy");
+}
+
+int main()
+{
+    RunTest("AnimationSeek", TestAnimationSeek);
+    RunTest("AnimatedSteadyState", TestAnimatedSteadyState);
+    return TestResult();
+}
@@ -0,0 +1,264 @@
+#include "test_util.h"
+
+#include "utils/command_list_pool.h"
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+// コマンドアロケーターとコマンドリストを番号で表し、状態の遷移と提出を記録するデバイス
+class MockDevice
+{
+public:
+    using CommandAllocatorType = uint32_t;
+    using CommandListType = uint32_t;
+
+    struct ListState
+    {
+        uint32_t allocator = 0;
+        bool isOpen = false;
+        // 記録した範囲の先頭 (記録の順の検証用)
+        size_t begin = 0;
+    };
+
+    CommandAllocatorType CreateCommandAllocator()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_allocatorResets.push_back(0);
+        return uint32_t(m_allocatorResets.size() - 1);
+    }
+
+    CommandListType CreateCommandList(CommandAllocatorType allocator)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lists.push_back({ allocator, true });
+        return uint32_t(m_lists.size() - 1);
+    }
+
+    void ResetCommandAllocator(CommandAllocatorType allocator)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 記録中のリストが使用するアロケーターはリセットできない
+        for (const auto& list : m_lists)
+        {
+            TEST_CHECK(list.allocator != allocator || !list.isOpen);
+        }
+        ++m_allocatorResets[allocator];
+    }
+
+    void ResetCommandList(CommandListType list, CommandAllocatorType allocator)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        TEST_CHECK(!m_lists[list].isOpen);
+        TEST_CHECK(m_lists[list].allocator == allocator);
+        m_lists[list].isOpen = true;
+    }
+
+    void CloseCommandList(CommandListType list)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        TEST_CHECK(m_lists[list].isOpen);
+        m_lists[list].isOpen = false;
+    }
+
+    void ExecuteCommandLists(const std::vector<CommandListType>& lists)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto list : lists)
+        {
+            TEST_CHECK(!m_lists[list].isOpen);
+        }
+        m_submissions.push_back(lists);
+    }
+
+    // 記録用のコールバックから呼び出す
+    void SetBegin(CommandListType list, size_t begin)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        TEST_CHECK(m_lists[list].isOpen);
+        m_lists[list].begin = begin;
+    }
+
+    size_t GetAllocatorCount() const { return m_allocatorResets.size(); }
+    uint32_t GetResetCount(CommandAllocatorType allocator) const { return m_allocatorResets[allocator]; }
+    const ListState& GetList(CommandListType list) const { return m_lists[list]; }
+    bool HasOpenList() const
+    {
+        for (const auto& list : m_lists)
+        {
+            if (list.isOpen)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    const std::vector<std::vector<CommandListType>>& GetSubmissions() const { return m_submissions; }
+
+private:
+    std::mutex m_mutex;
+    std::vector<uint32_t> m_allocatorResets;
+    std::vector<ListState> m_lists;
+    std::vector<std::vector<CommandListType>> m_submissions;
+};
+
+static void TestAllocatorReusePerSlot()
+{
+    const uint32_t frameCount = 2;
+    const uint32_t threadCount = 4;
+    MockDevice device;
+    CommandListPool<MockDevice> pool(device, frameCount, threadCount);
+    std::map<uint32_t, std::vector<uint32_t>> slotLists;
+    for (uint32_t frame = 0; frame < 8; ++frame)
+    {
+        const uint32_t slot = frame % frameCount;
+        pool.BeginFrame(slot);
+        pool.RecordParallel(1000, 10, [&](uint32_t list, size_t begin, size_t) { device.SetBegin(list, begin); });
+        pool.Submit();
+        const auto& lists = device.GetSubmissions().back();
+        TEST_CHECK(lists.size() == threadCount);
+        TEST_CHECK(pool.GetContextCount(slot) == threadCount);
+
+        // 2回目以降は同じスロットのリストを再利用し、別のスロットのものは使用しない
+        if (frame < frameCount)
+        {
+            slotLists[slot] = lists;
+        }
+        else
+        {
+            TEST_CHECK(lists == slotLists[slot]);
+        }
+    }
+    // 作成はスロットごとに最初のフレームのみ
+    TEST_CHECK(device.GetAllocatorCount() == frameCount * threadCount);
+    for (const auto& [slot, lists] : slotLists)
+    {
+        for (auto list : lists)
+        {
+            // 8フレーム中、このスロットを使用した2回目以降の4回でリセットされる
+            TEST_CHECK(device.GetResetCount(device.GetList(list).allocator) == 8 / frameCount - 1);
+        }
+    }
+    for (auto list : slotLists[0])
+    {
+        TEST_CHECK(std::find(slotLists[1].begin(), slotLists[1].end(), list) == slotLists[1].end());
+    }
+
+    // 記録する範囲が小さいフレームでは使用するリストのみをリセットする
+    pool.BeginFrame(0);
+    pool.RecordParallel(5, 10, [&](uint32_t list, size_t begin, size_t) { device.SetBegin(list, begin); });
+    pool.Submit();
+    TEST_CHECK(device.GetSubmissions().back().size() == 1);
+    pool.BeginFrame(0);
+    TEST_CHECK(device.GetResetCount(device.GetList(slotLists[0][0]).allocator) == 8 / frameCount + 1);
+    TEST_CHECK(device.GetResetCount(device.GetList(slotLists[0][1]).allocator) == 8 / frameCount);
+    TEST_CHECK(device.GetAllocatorCount() == frameCount * threadCount);
+}
+
+static void TestSubmissionOrder()
+{
+    MockDevice device;
+    CommandListPool<MockDevice> pool(device, 3, 8);
+    auto last = device.CreateCommandList(device.CreateCommandAllocator());
+    device.CloseCommandList(last);
+
+    for (uint32_t frame = 0; frame < 6; ++frame)
+    {
+        pool.BeginFrame(frame);
+        // 範囲は連続したチャンクに分割され、チャンクの順, 呼び出しの順に提出される
+        std::vector<std::pair<size_t, size_t>> ranges(8);
+        std::mutex rangeMutex;
+        pool.RecordParallel(800, 1, [&](uint32_t list, size_t begin, size_t end)
+        {
+            device.SetBegin(list, begin);
+            std::lock_guard<std::mutex> lock(rangeMutex);
+            ranges[begin / 100] = { begin, end };
+        });
+        pool.RecordParallel(3, 1, [&](uint32_t list, size_t begin, size_t) { device.SetBegin(list, 1000 + begin); });
+        pool.Submit(last);
+
+        const auto& lists = device.GetSubmissions().back();
+        TEST_CHECK(lists.size() == 8 + 3 + 1);
+        for (size_t i = 0; i < 8; ++i)
+        {
+            TEST_CHECK(ranges[i].first == i * 100 && ranges[i].second == (i + 1) * 100);
+            TEST_CHECK(device.GetList(lists[i]).begin == i * 100);
+        }
+        for (size_t i = 0; i < 3; ++i)
+        {
+            TEST_CHECK(device.GetList(lists[8 + i]).begin == 1000 + i);
+        }
+        TEST_CHECK(lists.back() == last);
+    }
+    TEST_CHECK(device.GetSubmissions().size() == 6);
+
+    // 記録がなければSubmit()は何も提出しない
+    pool.BeginFrame(0);
+    pool.Submit();
+    TEST_CHECK(device.GetSubmissions().size() == 6);
+}
+
+static void TestRecordException()
+{
+    MockDevice device;
+    CommandListPool<MockDevice> pool(device, 1, 4);
+    pool.BeginFrame(0);
+    bool caught = false;
+    try
+    {
+        pool.RecordParallel(400, 1, [&](uint32_t, size_t begin, size_t)
+        {
+            if (begin == 200)
+            {
+                throw std::runtime_error("record failed");
+            }
+        });
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    TEST_CHECK(caught);
+    // 例外の場合も全てのリストを閉じ、次のフレームで再利用できる
+    TEST_CHECK(!device.HasOpenList());
+    pool.Submit();
+    pool.BeginFrame(0);
+    pool.RecordParallel(400, 1, [&](uint32_t, size_t, size_t) {});
+    pool.Submit();
+    TEST_CHECK(device.GetAllocatorCount() == 4);
+}
+
+static void TestNestedParallelFor()
+{
+    // 記録中のParallelForは記録するスレッドで実行され、全ての範囲を処理する
+    MockDevice device;
+    CommandListPool<MockDevice> pool(device, 1);
+    std::vector<std::atomic<uint32_t>> visited(10000);
+    pool.BeginFrame(0);
+    pool.RecordParallel(visited.size(), 64, [&](uint32_t, size_t begin, size_t end)
+    {
+        ParallelFor(end - begin, 16, [&](size_t b, size_t e)
+        {
+            for (size_t i = begin + b; i < begin + e; ++i)
+            {
+                visited[i].fetch_add(1);
+            }
+        });
+    });
+    pool.Submit();
+    bool allOnce = true;
+    for (const auto& count : visited)
+    {
+        allOnce &= count.load() == 1;
+    }
+    TEST_CHECK(allOnce);
+}
+
+int main()
+{
+    RunTest("AllocatorReusePerSlot", TestAllocatorReusePerSlot);
+    RunTest("SubmissionOrder", TestSubmissionOrder);
+    RunTest("RecordException", TestRecordException);
+    RunTest("NestedParallelFor", TestNestedParallelFor);
+    return TestResult();
+}
@@ -0,0 +1,56 @@
+// farm_testでコーディネーターから起動されるワーカーの代わり
+// --sceneで動作を切り替える
+//   render      チャンクを取得し続け、フレームごとに空の画像ファイルを出力する
+//   crash       チャンクを取得せずに異常終了する
+//   crash-claim チャンクを1つ取得してから異常終了する
+#include "render_farm.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    std::string mode;
+    int workerIndex = -1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--scene")
+        {
+            mode = argv[i + 1];
+        }
+        else if (arg == "--farm-worker")
+        {
+            workerIndex = std::atoi(argv[i + 1]);
+        }
+    }
+    if (workerIndex < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    RenderFarmWorker worker(workerIndex);
+    int startFrame = 0;
+    int endFrame = 0;
+    if (mode == "crash")
+    {
+        return EXIT_FAILURE;
+    }
+    if (mode == "crash-claim")
+    {
+        worker.NextRange(startFrame, endFrame);
+        return EXIT_FAILURE;
+    }
+    while (worker.NextRange(startFrame, endFrame))
+    {
+        for (int frame = startFrame; frame < endFrame; ++frame)
+        {
+            char name[16];
+            snprintf(name, sizeof(name), "%03d.png", frame);
+            std::ofstream(name, std::ios::binary);
+        }
+    }
+    return EXIT_SUCCESS;
+}
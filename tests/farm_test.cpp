@@ -0,0 +1,169 @@
+#include "test_util.h"
+
+#include "render_farm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// キューはカレントディレクトリ (OUTPUT_DIR) に作られるため、テストごとに空の一時ディレクトリへ移動する
+static void EnterEmptyDir(const fs::path& dir)
+{
+    fs::current_path(fs::temp_directory_path());
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::current_path(dir);
+}
+
+static size_t CountChunks(const fs::path& dir)
+{
+    size_t count = 0;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec))
+    {
+        count += entry.path().extension() == L".chunk" ? 1 : 0;
+    }
+    return count;
+}
+
+static std::vector<int> ReadRetries(const fs::path& dir)
+{
+    std::vector<int> retries;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec))
+    {
+        int start, end, retry;
+        std::ifstream file(entry.path());
+        if (file >> start >> end >> retry)
+        {
+            retries.push_back(retry);
+        }
+    }
+    return retries;
+}
+
+static RenderFarm::Config MakeConfig(const char* mode, int workerCount, int endFrame)
+{
+    RenderFarm::Config config{};
+    config.workerCount = workerCount;
+    config.startFrame = 0;
+    config.endFrame = endFrame;
+    config.chunkSize = 4;
+    config.maxRetry = 1;
+    config.maxFrame = endFrame;
+    config.sceneFile = std::wstring(mode, mode + strlen(mode));
+    config.workerExecutable = FARM_STUB_WORKER;
+    return config;
+}
+
+// 複数のワーカーが同じキューから取得しても、各チャンクはちょうど1回ずつ処理される
+static void TestWorkerClaims(const fs::path& baseDir)
+{
+    EnterEmptyDir(baseDir / "claims");
+    const auto queueDir = RenderFarm::GetQueueDir();
+    for (const char* dir : { "pending", "running", "done", "failed" })
+    {
+        fs::create_directories(queueDir / dir);
+    }
+    const int chunkCount = 40;
+    for (int i = 0; i < chunkCount; ++i)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%06d.chunk", i);
+        std::ofstream(queueDir / "pending" / name) << i * 2 << " " << i * 2 + 2 << " 0";
+    }
+
+    std::mutex mutex;
+    std::vector<std::pair<int, int>> claimed;
+    std::vector<std::thread> threads;
+    for (int workerIndex = 0; workerIndex < 4; ++workerIndex)
+    {
+        threads.emplace_back([&, workerIndex]() {
+            RenderFarmWorker worker(workerIndex);
+            int start, end;
+            while (worker.NextRange(start, end))
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                claimed.emplace_back(start, end);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::sort(claimed.begin(), claimed.end());
+    bool isExact = claimed.size() == size_t(chunkCount);
+    for (size_t i = 0; isExact && i < claimed.size(); ++i)
+    {
+        isExact = claimed[i] == std::make_pair(int(i) * 2, int(i) * 2 + 2);
+    }
+    TEST_CHECK(isExact);
+    // 最後のNextRangeで処理中のチャンクは全て完了へ移る
+    TEST_CHECK(CountChunks(queueDir / "pending") == 0);
+    TEST_CHECK(CountChunks(queueDir / "running") == 0);
+    TEST_CHECK(CountChunks(queueDir / "done") == size_t(chunkCount));
+}
+
+static void TestCoordinatorRender(const fs::path& baseDir)
+{
+    EnterEmptyDir(baseDir / "render");
+    const auto config = MakeConfig("render", 3, 26);
+    TEST_CHECK(RenderFarm::RunCoordinator(config) == EXIT_SUCCESS);
+    const auto queueDir = RenderFarm::GetQueueDir();
+    TEST_CHECK(CountChunks(queueDir / "done") == 7);
+    TEST_CHECK(CountChunks(queueDir / "failed") == 0);
+    TEST_CHECK(fs::exists("000.png") && fs::exists("025.png"));
+}
+
+// チャンクを取得してから異常終了するワーカー: 各チャンクはmaxRetryを超えたところで失敗になる
+static void TestCoordinatorRetry(const fs::path& baseDir)
+{
+    EnterEmptyDir(baseDir / "retry");
+    const auto config = MakeConfig("crash-claim", 2, 12);
+    TEST_CHECK(RenderFarm::RunCoordinator(config) == EXIT_FAILURE);
+    const auto queueDir = RenderFarm::GetQueueDir();
+    TEST_CHECK(CountChunks(queueDir / "pending") == 0);
+    TEST_CHECK(CountChunks(queueDir / "done") == 0);
+    auto retries = ReadRetries(queueDir / "failed");
+    TEST_CHECK(retries.size() == 3);
+    TEST_CHECK(std::all_of(retries.begin(), retries.end(), [&](int retry) { return retry == config.maxRetry + 1; }));
+}
+
+// チャンクを取得せずに異常終了するワーカー: 再起動を打ち切り、残りのチャンクを失敗とする
+static void TestCoordinatorIdleCrash(const fs::path& baseDir)
+{
+    EnterEmptyDir(baseDir / "idle");
+    const auto config = MakeConfig("crash", 2, 12);
+    const auto start = std::chrono::steady_clock::now();
+    TEST_CHECK(RenderFarm::RunCoordinator(config) == EXIT_FAILURE);
+    // 再起動はワーカーごとにmaxRetry回まで (監視の間隔は200ms)
+    TEST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    const auto queueDir = RenderFarm::GetQueueDir();
+    TEST_CHECK(CountChunks(queueDir / "pending") == 0);
+    TEST_CHECK(CountChunks(queueDir / "running") == 0);
+    auto retries = ReadRetries(queueDir / "failed");
+    TEST_CHECK(retries.size() == 3);
+    TEST_CHECK(std::all_of(retries.begin(), retries.end(), [](int retry) { return retry == 0; }));
+}
+
+int main()
+{
+    const auto baseDir = fs::temp_directory_path() / "rtcamp10_farm_test";
+    RunTest("WorkerClaims", [&]() { TestWorkerClaims(baseDir); });
+    RunTest("CoordinatorRender", [&]() { TestCoordinatorRender(baseDir); });
+    RunTest("CoordinatorRetry", [&]() { TestCoordinatorRetry(baseDir); });
+    RunTest("CoordinatorIdleCrash", [&]() { TestCoordinatorIdleCrash(baseDir); });
+    fs::current_path(fs::temp_directory_path());
+    fs::remove_all(baseDir);
+    return TestResult();
+}
@@ -0,0 +1,239 @@
+#include "test_util.h"
+
+#include "utils/gltf_loader.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// 3頂点の位置 (0,0,0), (1,0,0), (0,1,0)
+static const char* const PositionURI = "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAA";
+
+static const float Positions[9] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+
+// 読み込みに使わないプロパティ (extras, 未知の拡張) を含む三角形1つのglTF
+static std::string MakeTriangleJSON(const std::string& bufferJSON)
+{
+    return R"({
+        "asset": { "version": "2.0", "generator": "test \"gen\"" },
+        "extensionsUsed": ["EXT_unknown"],
+        "scene": 0,
+        "scenes": [{ "nodes": [0] }],
+        "nodes": [{ "name": "tri", "mesh": 0, "translation": [1, 2, 3], "extras": { "a": [{ "b": [[], {}] }, "}"] } }],
+        "meshes": [{ "primitives": [{ "attributes": { "POSITION": 0 }, "mode": 4, "extensions": { "EXT_unknown": { "x": [1, 2] } } }] }],
+        "accessors": [{ "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [0, 0, 0], "max": [1, 1, 0] }],
+        "bufferViews": [{ "buffer": 0, "byteLength": 36 }],
+        "buffers": [)" + bufferJSON + R"(]
+    })";
+}
+
+static std::span<const uint8_t> AsBytes(const std::string& str)
+{
+    return std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+}
+
+// JSONとBINチャンクからGLBを組み立てる
+static std::vector<uint8_t> MakeGLB(std::string json, const std::vector<uint8_t>& bin)
+{
+    json.resize(ROUND_UP(json.size(), size_t(4)), ' ');
+    const size_t binSize = ROUND_UP(bin.size(), size_t(4));
+    std::vector<uint8_t> glb;
+    auto append = [&glb](const void* src, size_t size) {
+        auto bytes = static_cast<const uint8_t*>(src);
+        glb.insert(glb.end(), bytes, bytes + size);
+    };
+    const uint32_t header[3] = { glb::Magic, 2, uint32_t(glb::HeaderSize + glb::ChunkHeaderSize * 2 + json.size() + binSize) };
+    const uint32_t jsonHeader[2] = { uint32_t(json.size()), glb::ChunkJSON };
+    const uint32_t binHeader[2] = { uint32_t(binSize), glb::ChunkBIN };
+    append(header, sizeof(header));
+    append(jsonHeader, sizeof(jsonHeader));
+    append(json.data(), json.size());
+    append(binHeader, sizeof(binHeader));
+    append(bin.data(), bin.size());
+    glb.resize(header[2], 0);
+    return glb;
+}
+
+static bool HasTrianglePositions(const GLTFDocument& doc)
+{
+    return doc.buffers.size() == 1 && doc.buffers[0].size() >= sizeof(Positions) &&
+        memcmp(doc.buffers[0].data(), Positions, sizeof(Positions)) == 0;
+}
+
+static void CheckTriangleModel(const GLTFDocument& doc)
+{
+    const auto& model = doc.model;
+    TEST_CHECK(model.defaultScene == 0);
+    TEST_CHECK(model.scenes.size() == 1 && model.scenes[0].nodes == std::vector<int>{ 0 });
+    TEST_CHECK(model.nodes.size() == 1);
+    if (model.nodes.size() == 1)
+    {
+        TEST_CHECK(model.nodes[0].name == "tri" && model.nodes[0].mesh == 0);
+        TEST_CHECK((model.nodes[0].translation == std::vector<double>{ 1.0, 2.0, 3.0 }));
+    }
+    TEST_CHECK(model.meshes.size() == 1 && model.meshes[0].primitives.size() == 1);
+    if (!model.meshes.empty() && !model.meshes[0].primitives.empty())
+    {
+        const auto& primitive = model.meshes[0].primitives[0];
+        TEST_CHECK(primitive.attributes.size() == 1 && primitive.attributes.at("POSITION") == 0);
+        TEST_CHECK(primitive.mode == TINYGLTF_MODE_TRIANGLES && primitive.indices == -1);
+    }
+    TEST_CHECK(model.accessors.size() == 1);
+    if (model.accessors.size() == 1)
+    {
+        const auto& acc = model.accessors[0];
+        TEST_CHECK(acc.bufferView == 0 && acc.count == 3);
+        TEST_CHECK(acc.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && acc.type == TINYGLTF_TYPE_VEC3);
+    }
+    TEST_CHECK(model.bufferViews.size() == 1 && model.bufferViews[0].byteLength == 36);
+    TEST_CHECK(HasTrianglePositions(doc));
+}
+
+static void TestParseGLTF()
+{
+    const auto json = MakeTriangleJSON(std::string(R"({ "byteLength": 36, "uri": ")") + PositionURI + R"(" })");
+    GLTFDocument doc;
+    TEST_CHECK(ParseGLTFStream("triangle.gltf", AsBytes(json), doc));
+    CheckTriangleModel(doc);
+}
+
+static void TestParseGLB()
+{
+    std::vector<uint8_t> bin(sizeof(Positions));
+    memcpy(bin.data(), Positions, sizeof(Positions));
+    const auto json = MakeTriangleJSON(R"({ "byteLength": 36 })");
+    const auto glbData = MakeGLB(json, bin);
+    GLTFDocument doc;
+    TEST_CHECK(ParseGLTFStream("triangle.glb", glbData, doc));
+    CheckTriangleModel(doc);
+    // BINチャンクはコピーせず参照する
+    const size_t binOffset = glb::HeaderSize + glb::ChunkHeaderSize * 2 + ROUND_UP(json.size(), size_t(4));
+    TEST_CHECK(!doc.buffers.empty() && doc.buffers[0].data() == glbData.data() + binOffset);
+
+    // 途中で切れたGLB (JSONチャンクが足りない)
+    std::vector<uint8_t> truncated(glbData.begin(), glbData.begin() + glb::HeaderSize + glb::ChunkHeaderSize + 4);
+    GLTFDocument truncatedDoc;
+    TEST_CHECK(!ParseGLTFStream("triangle.glb", truncated, truncatedDoc));
+}
+
+static void TestMalformed()
+{
+    const std::string buffer = std::string(R"({ "byteLength": 36, "uri": ")") + PositionURI + R"(" })";
+    const auto valid = MakeTriangleJSON(buffer);
+    auto rejects = [](const std::string& json) {
+        GLTFDocument doc;
+        return !ParseGLTFStream("malformed.gltf", AsBytes(json), doc);
+    };
+    // 途中で切れたJSON
+    TEST_CHECK(rejects(valid.substr(0, valid.size() / 2)));
+    TEST_CHECK(rejects(valid.substr(0, valid.size() - 1)));
+    // 範囲外のインデックス
+    auto outOfRange = valid;
+    outOfRange.replace(outOfRange.find(R"("mesh": 0)"), 9, R"("mesh": 5)");
+    TEST_CHECK(rejects(outOfRange));
+    // 未知のアクセサーの型
+    auto badType = valid;
+    badType.replace(badType.find(R"("VEC3")"), 6, R"("VEC5")");
+    TEST_CHECK(rejects(badType));
+    // 数値であるべきプロパティが文字列
+    auto badNumber = valid;
+    badNumber.replace(badNumber.find(R"("count": 3)"), 10, R"("count": "3")");
+    TEST_CHECK(rejects(badNumber));
+    // 不正なbase64
+    TEST_CHECK(rejects(MakeTriangleJSON(R"({ "byteLength": 36, "uri": "data:application/octet-stream;base64,AA*A" })")));
+    // 存在しない外部ファイル
+    TEST_CHECK(rejects(MakeTriangleJSON(R"({ "byteLength": 36, "uri": "missing.bin" })")));
+}
+
+// EXT_meshopt_compressionで圧縮されたインデックス (0 1 2 / 2 1 3 / 4 6 5 / 7 8 9)
+static std::string MakeMeshoptJSON()
+{
+    return R"({
+        "asset": { "version": "2.0" },
+        "extensionsUsed": ["EXT_meshopt_compression"],
+        "buffers": [
+            { "byteLength": 27, "uri": "data:application/octet-stream;base64,4PAQ/v/wDP8CAgIAdodWZ3iphmWJaJgBaQAA" },
+            { "byteLength": 48, "extensions": { "EXT_meshopt_compression": { "fallback": true } } }
+        ],
+        "bufferViews": [{
+            "buffer": 1, "byteLength": 48,
+            "extensions": { "EXT_meshopt_compression": { "buffer": 0, "byteLength": 27, "byteStride": 4, "count": 12, "mode": "TRIANGLES" } }
+        }],
+        "accessors": [{ "bufferView": 0, "componentType": 5125, "count": 12, "type": "SCALAR" }]
+    })";
+}
+
+static void CheckMeshoptIndices(GLTFDocument& doc)
+{
+    static const uint32_t expected[12] = { 0, 1, 2, 2, 1, 3, 4, 6, 5, 7, 8, 9 };
+    std::string err;
+    TEST_CHECK(DecodeMeshoptBufferViews(doc, err));
+    TEST_CHECK(err.empty());
+    if (doc.model.bufferViews.size() != 1)
+    {
+        TEST_CHECK(doc.model.bufferViews.size() == 1);
+        return;
+    }
+    const auto& view = doc.model.bufferViews[0];
+    TEST_CHECK(view.extensions.empty() && view.byteLength == sizeof(expected));
+    TEST_CHECK(size_t(view.buffer) < doc.buffers.size() &&
+        doc.buffers[view.buffer].size() == sizeof(expected) &&
+        memcmp(doc.buffers[view.buffer].data(), expected, sizeof(expected)) == 0);
+}
+
+static void TestMeshoptFallbackBuffer()
+{
+    // 軽量パーサーはフォールバック用バッファを解決せずに読み込む
+    const auto json = MakeMeshoptJSON();
+    GLTFDocument doc;
+    TEST_CHECK(ParseGLTFStream("meshopt.gltf", AsBytes(json), doc));
+    CheckMeshoptIndices(doc);
+
+    // tinygltfにはダミーのデータURIへ書き換えてから渡す
+    GLTFDocument tinyDoc;
+    std::string err, warn;
+    TEST_CHECK(gltf_loader_detail::LoadWithTinyGLTF("meshopt.gltf", AsBytes(json), tinyDoc, err, warn));
+    TEST_CHECK(err.empty() && warn.empty());
+    CheckMeshoptIndices(tinyDoc);
+}
+
+// 軽量パーサーが読めないファイル (UTF-8のBOM付き) はtinygltfで読み込まれる
+static void TestTinyGLTFFallback()
+{
+    const std::string json = "\xEF\xBB\xBF" + MakeTriangleJSON(std::string(R"({ "byteLength": 36, "uri": ")") + PositionURI + R"(" })");
+    GLTFDocument streamDoc;
+    TEST_CHECK(!ParseGLTFStream("bom.gltf", AsBytes(json), streamDoc));
+
+    const auto sceneDir = std::filesystem::path(RESOURCE_DIR) / "scene";
+    std::filesystem::create_directories(sceneDir);
+    {
+        std::ofstream out(sceneDir / "bom.gltf", std::ios::binary | std::ios::trunc);
+        out.write(json.data(), std::streamsize(json.size()));
+    }
+    auto file = std::make_shared<MappedFile>();
+    TEST_CHECK(file->Open((sceneDir / "bom.gltf").wstring()));
+    GLTFDocument doc;
+    bool loaded = false;
+    try
+    {
+        loaded = LoadGLTF(L"bom.gltf", file, doc);
+    }
+    catch (const std::exception&)
+    {
+        // 読み込みのエラーはErrorで例外になる
+    }
+    TEST_CHECK(loaded);
+    CheckTriangleModel(doc);
+}
+
+int main()
+{
+    RunTest("ParseGLTF", TestParseGLTF);
+    RunTest("ParseGLB", TestParseGLB);
+    RunTest("Malformed", TestMalformed);
+    RunTest("MeshoptFallbackBuffer", TestMeshoptFallbackBuffer);
+    RunTest("TinyGLTFFallback", TestTinyGLTFFallback);
+    return TestResult();
+}
@@ -0,0 +1,159 @@
+#include "test_util.h"
+
+#include "utils/json_reader.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 文字列リテラルか、呼び出し側で保持している文字列のみを渡す
+static JsonReader MakeReader(std::string_view json)
+{
+    return JsonReader(json.data(), json.data() + json.size());
+}
+
+static bool ReadStringFrom(const std::string& json, std::string& value)
+{
+    auto reader = MakeReader(json);
+    return reader.ReadString(value) && reader.IsValid();
+}
+
+static void TestEscapes()
+{
+    std::string value;
+    TEST_CHECK(ReadStringFrom(R"("a\"b\\c\/d\b\f\n\r\t")", value));
+    TEST_CHECK(value == "a\"b\\c/d\b\f\n\r\t");
+
+    // 1, 2, 3バイトのUTF-8とサロゲートペア (4バイト)
+    TEST_CHECK(ReadStringFrom(R"("\u0041\u00e9\u3042\ud83d\ude00")", value));
+    TEST_CHECK(value == "A\xC3\xA9\xE3\x81\x82\xF0\x9F\x98\x80");
+
+    // 16バイト単位の走査をまたぐエスケープと終端
+    TEST_CHECK(ReadStringFrom(R"("0123456789abcdef0123\"456789abcdef0123456789")", value));
+    TEST_CHECK(value == "0123456789abcdef0123\"456789abcdef0123456789");
+    TEST_CHECK(ReadStringFrom(R"("0123456789abcde")", value));
+    TEST_CHECK(value == "0123456789abcde");
+
+    TEST_CHECK(ReadStringFrom(R"("")", value));
+    TEST_CHECK(value.empty());
+}
+
+static void TestNumbers()
+{
+    auto reader = MakeReader("[0, -0.5, 1e3, 1.5E-2, 12345678901, 2147483647, -2147483648]");
+    std::vector<double> values;
+    TEST_CHECK(reader.ForEachElement([&](size_t) {
+        double value;
+        if (!reader.ReadNumber(value))
+        {
+            return false;
+        }
+        values.push_back(value);
+        return true;
+    }));
+    TEST_CHECK(reader.IsValid());
+    TEST_CHECK((values == std::vector<double>{ 0.0, -0.5, 1000.0, 0.015, 12345678901.0, 2147483647.0, -2147483648.0 }));
+
+    int i = 0;
+    auto intReader = MakeReader("-2147483648");
+    TEST_CHECK(intReader.ReadInt(i) && i == -2147483648);
+
+    // intの範囲外, 負のサイズ, 数値でない値
+    auto overflow = MakeReader("2147483648");
+    TEST_CHECK(!overflow.ReadInt(i) && !overflow.IsValid());
+    size_t size = 0;
+    auto negative = MakeReader("-1");
+    TEST_CHECK(!negative.ReadSize(size) && !negative.IsValid());
+    auto large = MakeReader("12345678901");
+    TEST_CHECK(large.ReadSize(size) && size == 12345678901ull);
+    double d = 0.0;
+    auto notNumber = MakeReader("\"1\"");
+    TEST_CHECK(!notNumber.ReadNumber(d) && !notNumber.IsValid());
+}
+
+static void TestSkipNested()
+{
+    // 読み飛ばす値の中の文字列に括弧やエスケープされた引用符を含める
+    const std::string json = R"({
+        "skip": { "a": [1, [2, {"b": "}]\"{["}], true, false, null], "c": { "d": {} } },
+        "array": [[], {}, "x\\", -1.5e-3],
+        "target": 42,
+        "tail": [null]
+    })";
+    auto reader = MakeReader(json);
+    int target = 0;
+    std::vector<std::string> keys;
+    TEST_CHECK(reader.ForEachMember([&](std::string_view key) {
+        keys.emplace_back(key);
+        if (key == "target")
+        {
+            return reader.ReadInt(target);
+        }
+        return reader.Skip();
+    }));
+    TEST_CHECK(reader.IsValid());
+    TEST_CHECK(target == 42);
+    TEST_CHECK((keys == std::vector<std::string>{ "skip", "array", "target", "tail" }));
+    TEST_CHECK(reader.Peek() == '\0');
+
+    // 上限ちょうどの深さは読み飛ばせる
+    auto deep = std::string(256, '[') + std::string(256, ']');
+    auto deepReader = MakeReader(deep);
+    TEST_CHECK(deepReader.Skip() && deepReader.IsValid());
+}
+
+// 読み飛ばしが失敗し、以降の読み出しも失敗するか
+static bool RejectsSkip(const std::string& json)
+{
+    auto reader = MakeReader(json);
+    if (reader.Skip() && reader.IsValid())
+    {
+        std::cerr << "accepted malformed input: " << json << std::endl;
+        return false;
+    }
+    double value;
+    return !reader.IsValid() && !reader.ReadNumber(value) && reader.Peek() == '\0';
+}
+
+static void TestMalformed()
+{
+    TEST_CHECK(RejectsSkip(R"({"a": 1,})"));
+    TEST_CHECK(RejectsSkip(R"({"a" 1})"));
+    TEST_CHECK(RejectsSkip(R"({"a": 1 "b": 2})"));
+    TEST_CHECK(RejectsSkip(R"({a: 1})"));
+    TEST_CHECK(RejectsSkip(R"([1, 2)"));
+    TEST_CHECK(RejectsSkip(R"([1,, 2])"));
+    TEST_CHECK(RejectsSkip(R"(["abc)"));
+    TEST_CHECK(RejectsSkip(R"(["abc\)"));
+    TEST_CHECK(RejectsSkip("[tru]"));
+    TEST_CHECK(RejectsSkip("[nul]"));
+    TEST_CHECK(RejectsSkip("[-]"));
+    TEST_CHECK(RejectsSkip(""));
+    // 深すぎる入れ子
+    TEST_CHECK(RejectsSkip(std::string(257, '[') + std::string(257, ']')));
+
+    // 不正なエスケープ
+    std::string value;
+    TEST_CHECK(!ReadStringFrom(R"("\x")", value));
+    TEST_CHECK(!ReadStringFrom(R"("\u12G4")", value));
+    TEST_CHECK(!ReadStringFrom(R"("\u12")", value));
+    TEST_CHECK(!ReadStringFrom(R"("\ud83d")", value));
+    TEST_CHECK(!ReadStringFrom(R"("\ud83dA")", value));
+
+    // メンバーの処理が失敗した場合
+    auto reader = MakeReader(R"({"a": "b"})");
+    TEST_CHECK(!reader.ForEachMember([&](std::string_view) {
+        int i;
+        return reader.ReadInt(i);
+    }));
+    TEST_CHECK(!reader.IsValid());
+}
+
+int main()
+{
+    RunTest("Escapes", TestEscapes);
+    RunTest("Numbers", TestNumbers);
+    RunTest("SkipNested", TestSkipNested);
+    RunTest("Malformed", TestMalformed);
+    return TestResult();
+}
@@ -0,0 +1,184 @@
+#include "test_util.h"
+
+#include "utils/meshopt_decoder.h"
+
+#include <vector>
+
+// meshoptimizerのテストで使われているエンコード済みデータ
+static const uint8_t IndexDataV0[] = {
+    0xe0, 0xf0, 0x10, 0xfe, 0xff, 0xf0, 0x0c, 0xff, 0x02, 0x02, 0x02, 0x00, 0x76, 0x87, 0x56, 0x67,
+    0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0x00, 0x00,
+};
+
+static const uint32_t IndexBuffer[] = { 0, 1, 2, 2, 1, 3, 4, 6, 5, 7, 8, 9 };
+
+// v1を仕様に沿って手で組み立てたもの
+// 自由インデックス (+10), 直前の自由インデックスからの+1/-1, リスタートを含む
+static const uint8_t IndexDataV1[] = {
+    0xe1, 0xf0, 0xfe, 0x0e, 0x0d, 0xfe, 0x0f, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint32_t IndexBufferV1[] = { 0, 1, 2, 3, 4, 10, 3, 10, 11, 3, 11, 10, 0, 1, 2 };
+
+static const uint8_t IndexSequence[] = {
+    0xd1, 0x00, 0x04, 0xcd, 0x01, 0x04, 0x07, 0x98, 0x1f, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint32_t IndexSequenceData[] = { 0, 1, 51, 2, 49, 1000 };
+
+// 4頂点 x 4バイトを仕様に沿って手で組み立てたもの
+// バイトごとに0bit, 2bit, 4bit, 8bitのグループを1つずつ使う
+static std::vector<uint8_t> MakeVertexData()
+{
+    std::vector<uint8_t> data = { 0xa0 };
+    // 0バイト目: 全レーン差分なし
+    data.insert(data.end(), { 0x00 });
+    // 1バイト目: 2bit (2, 3->0x07, 1, 0)
+    data.insert(data.end(), { 0x01, 0xb4, 0x00, 0x00, 0x00, 0x07 });
+    // 2バイト目: 4bit (4, 15->0x20, 3, 0)
+    data.insert(data.end(), { 0x02, 0x4f, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20 });
+    // 3バイト目: 8bit (そのままの値)
+    data.insert(data.end(), { 0x03, 0x01, 0x02, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+    // 末尾 (32バイト) の最後が基準となる頂点
+    data.insert(data.end(), 28, 0x00);
+    data.insert(data.end(), { 10, 20, 30, 40 });
+    return data;
+}
+
+static const uint8_t VertexBuffer[] = {
+    10, 21, 32, 39,
+    10, 17, 48, 40,
+    10, 16, 46, 104,
+    10, 16, 46, 104,
+};
+
+// 途中で切れたデータはすべて失敗する
+// (範囲外を読まないよう、長さちょうどの領域にコピーしてから渡す)
+template<typename F>
+static bool RejectsTruncated(const uint8_t* data, size_t size, F&& decode)
+{
+    for (size_t length = 0; length < size; ++length)
+    {
+        std::vector<uint8_t> truncated(data, data + length);
+        if (decode(truncated.data(), truncated.size()))
+        {
+            std::cerr << "accepted truncated input of " << length << " bytes" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<size_t N, size_t M>
+static void CheckIndexBuffer(const uint8_t (&encoded)[N], const uint32_t (&expected)[M])
+{
+    uint32_t decoded32[M] = {};
+    TEST_CHECK(MeshoptDecodeIndexBuffer(decoded32, M, 4, encoded, N));
+    TEST_CHECK(memcmp(decoded32, expected, sizeof(expected)) == 0);
+
+    uint16_t decoded16[M] = {};
+    TEST_CHECK(MeshoptDecodeIndexBuffer(decoded16, M, 2, encoded, N));
+    bool match = true;
+    for (size_t i = 0; i < M; ++i)
+    {
+        match &= decoded16[i] == expected[i];
+    }
+    TEST_CHECK(match);
+
+    TEST_CHECK(RejectsTruncated(encoded, N, [](const uint8_t* data, size_t size) {
+        uint32_t decoded[M];
+        return MeshoptDecodeIndexBuffer(decoded, M, 4, data, size);
+    }));
+}
+
+static void TestIndexBuffer()
+{
+    CheckIndexBuffer(IndexDataV0, IndexBuffer);
+    CheckIndexBuffer(IndexDataV1, IndexBufferV1);
+
+    // 不正なヘッダー, インデックスサイズ, 三角形でない個数
+    uint32_t decoded[12];
+    std::vector<uint8_t> badHeader(std::begin(IndexDataV0), std::end(IndexDataV0));
+    badHeader[0] = 0xe2;
+    TEST_CHECK(!MeshoptDecodeIndexBuffer(decoded, 12, 4, badHeader.data(), badHeader.size()));
+    TEST_CHECK(!MeshoptDecodeIndexBuffer(decoded, 12, 3, IndexDataV0, sizeof(IndexDataV0)));
+    TEST_CHECK(!MeshoptDecodeIndexBuffer(decoded, 11, 4, IndexDataV0, sizeof(IndexDataV0)));
+}
+
+static void TestIndexSequence()
+{
+    uint32_t decoded[6] = {};
+    TEST_CHECK(MeshoptDecodeIndexSequence(decoded, 6, 4, IndexSequence, sizeof(IndexSequence)));
+    TEST_CHECK(memcmp(decoded, IndexSequenceData, sizeof(IndexSequenceData)) == 0);
+
+    TEST_CHECK(RejectsTruncated(IndexSequence, sizeof(IndexSequence), [](const uint8_t* data, size_t size) {
+        uint32_t decoded[6];
+        return MeshoptDecodeIndexSequence(decoded, 6, 4, data, size);
+    }));
+
+    // 余分なデータがある場合も失敗する
+    std::vector<uint8_t> extra(std::begin(IndexSequence), std::end(IndexSequence));
+    extra.push_back(0);
+    TEST_CHECK(!MeshoptDecodeIndexSequence(decoded, 6, 4, extra.data(), extra.size()));
+}
+
+static void TestVertexBuffer()
+{
+    auto encoded = MakeVertexData();
+    uint8_t decoded[16] = {};
+    TEST_CHECK(MeshoptDecodeVertexBuffer(decoded, 4, 4, encoded.data(), encoded.size()));
+    TEST_CHECK(memcmp(decoded, VertexBuffer, sizeof(VertexBuffer)) == 0);
+
+    TEST_CHECK(RejectsTruncated(encoded.data(), encoded.size(), [](const uint8_t* data, size_t size) {
+        uint8_t decoded[16];
+        return MeshoptDecodeVertexBuffer(decoded, 4, 4, data, size);
+    }));
+
+    // 4の倍数でない頂点サイズ, 不正なヘッダー
+    TEST_CHECK(!MeshoptDecodeVertexBuffer(decoded, 4, 3, encoded.data(), encoded.size()));
+    encoded[0] = 0xa1;
+    TEST_CHECK(!MeshoptDecodeVertexBuffer(decoded, 4, 4, encoded.data(), encoded.size()));
+}
+
+static void TestFilters()
+{
+    // 指数フィルタ: SIMDの4要素と残りの1要素の両方を通す
+    auto packExp = [](int32_t mantissa, int32_t exponent) { return (uint32_t(exponent) << 24) | (uint32_t(mantissa) & 0xffffff); };
+    uint32_t exp[5] = { packExp(3, -1), packExp(-5, 2), packExp(1, 0), packExp(0, 10), packExp(7, -3) };
+    const float expected[5] = { 1.5f, -20.0f, 1.0f, 0.0f, 0.875f };
+    TEST_CHECK(MeshoptDecodeFilter("EXPONENTIAL", exp, 5, 4));
+    bool match = true;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        float value;
+        memcpy(&value, &exp[i], 4);
+        match &= value == expected[i];
+    }
+    TEST_CHECK(match);
+
+    // 八面体: z軸とx軸はそのまま
+    // (zには1.0に相当する値を格納する)
+    int8_t oct[8] = { 0, 0, 127, 0, 127, 0, 127, 0 };
+    TEST_CHECK(MeshoptDecodeFilter("OCTAHEDRAL", oct, 2, 4));
+    TEST_CHECK(oct[0] == 0 && oct[1] == 0 && oct[2] == 127);
+    TEST_CHECK(oct[4] == 127 && oct[5] == 0 && oct[6] == 0);
+
+    // 四元数: 省略された成分 (w) のみの単位四元数
+    int16_t quat[4] = { 0, 0, 0, int16_t((32767 & ~3) | 3) };
+    TEST_CHECK(MeshoptDecodeFilter("QUATERNION", quat, 1, 8));
+    TEST_CHECK(quat[0] == 0 && quat[1] == 0 && quat[2] == 0 && quat[3] == 32767);
+
+    TEST_CHECK(MeshoptDecodeFilter("NONE", exp, 5, 4));
+    TEST_CHECK(!MeshoptDecodeFilter("QUATERNION", quat, 1, 4));
+    TEST_CHECK(!MeshoptDecodeFilter("UNKNOWN", quat, 1, 8));
+}
+
+int main()
+{
+    RunTest("IndexBuffer", TestIndexBuffer);
+    RunTest("IndexSequence", TestIndexSequence);
+    RunTest("VertexBuffer", TestVertexBuffer);
+    RunTest("Filters", TestFilters);
+    return TestResult();
+}
@@ -0,0 +1,150 @@
+#include "test_util.h"
+
+#include "utils/parallel_util.h"
+
+#include <stdexcept>
+
+// 共有のプールはハードウェアスレッド数に依存するため、ワーカー数を固定したプールで並列の動作を検証する
+static const uint32_t WorkerCount = 3;
+
+static void TestWorkerPoolRun()
+{
+    WorkerPool pool(WorkerCount);
+    TEST_CHECK(pool.GetThreadCount() == WorkerCount + 1);
+    for (size_t taskCount : { size_t(0), size_t(1), size_t(3), size_t(1000) })
+    {
+        std::vector<std::atomic<uint32_t>> visited(taskCount);
+        pool.Run(taskCount, 0, [&](size_t i) { visited[i].fetch_add(1); });
+        for (const auto& count : visited)
+        {
+            TEST_CHECK(count.load() == 1);
+        }
+    }
+
+    // スレッド数の制限
+    std::mutex mutex;
+    std::vector<std::thread::id> threads;
+    pool.Run(200, 2, [&](size_t)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (std::find(threads.begin(), threads.end(), std::this_thread::get_id()) == threads.end())
+        {
+            threads.push_back(std::this_thread::get_id());
+        }
+    });
+    TEST_CHECK(threads.size() <= 2);
+}
+
+static void TestWorkerPoolNested()
+{
+    // 並列処理の中からの呼び出しは、呼び出したスレッドで実行される
+    WorkerPool pool(WorkerCount);
+    std::atomic<uint32_t> total{ 0 };
+    std::atomic<uint32_t> otherThread{ 0 };
+    pool.Run(64, 0, [&](size_t)
+    {
+        auto caller = std::this_thread::get_id();
+        pool.Run(8, 0, [&](size_t)
+        {
+            total.fetch_add(1);
+            otherThread.fetch_add(std::this_thread::get_id() != caller ? 1 : 0);
+        });
+    });
+    TEST_CHECK(total.load() == 64 * 8);
+    TEST_CHECK(otherThread.load() == 0);
+}
+
+static void TestWorkerPoolException()
+{
+    // 例外が発生しても全てのタスクを実行してから送出する (並列, 呼び出し元での実行とも)
+    for (uint32_t workerCount : { WorkerCount, 0u })
+    {
+        WorkerPool pool(workerCount);
+        std::atomic<uint32_t> executed{ 0 };
+        bool caught = false;
+        try
+        {
+            pool.Run(100, 0, [&](size_t i)
+            {
+                executed.fetch_add(1);
+                if (i % 10 == 3)
+                {
+                    throw std::runtime_error("task failed");
+                }
+            });
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+        TEST_CHECK(caught);
+        TEST_CHECK(executed.load() == 100);
+        // 例外の後も使用できる
+        executed = 0;
+        pool.Run(10, 0, [&](size_t) { executed.fetch_add(1); });
+        TEST_CHECK(executed.load() == 10);
+    }
+}
+
+static void TestWorkerPoolConcurrentCallers()
+{
+    // 別のスレッドが実行中の場合は待たずに呼び出したスレッドで実行する
+    WorkerPool pool(WorkerCount);
+    std::atomic<uint32_t> total{ 0 };
+    std::thread other([&]()
+    {
+        for (uint32_t i = 0; i < 200; ++i)
+        {
+            pool.Run(16, 0, [&](size_t) { total.fetch_add(1); });
+        }
+    });
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        pool.Run(16, 0, [&](size_t) { total.fetch_add(1); });
+    }
+    other.join();
+    TEST_CHECK(total.load() == 2 * 200 * 16);
+}
+
+static void TestParallelFor()
+{
+    std::vector<std::atomic<uint32_t>> visited(1001);
+    std::atomic<uint32_t> batchCount{ 0 };
+    ParallelFor(visited.size(), 10, [&](size_t begin, size_t end)
+    {
+        TEST_CHECK(end - begin <= 10);
+        batchCount.fetch_add(1);
+        for (size_t i = begin; i < end; ++i)
+        {
+            visited[i].fetch_add(1);
+        }
+    });
+    TEST_CHECK(batchCount.load() == 101);
+    bool allOnce = true;
+    for (const auto& count : visited)
+    {
+        allOnce &= count.load() == 1;
+    }
+    TEST_CHECK(allOnce);
+
+    bool caught = false;
+    try
+    {
+        ParallelFor(100, 1, [](size_t begin, size_t) { if (begin == 42) throw std::runtime_error("batch failed"); });
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    TEST_CHECK(caught);
+}
+
+int main()
+{
+    RunTest("WorkerPoolRun", TestWorkerPoolRun);
+    RunTest("WorkerPoolNested", TestWorkerPoolNested);
+    RunTest("WorkerPoolException", TestWorkerPoolException);
+    RunTest("WorkerPoolConcurrentCallers", TestWorkerPoolConcurrentCallers);
+    RunTest("ParallelFor", TestParallelFor);
+    return TestResult();
+}
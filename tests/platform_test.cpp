@@ -0,0 +1,78 @@
+#include "test_util.h"
+
+#include "utils/json_reader.h"
+#include "utils/mapped_file.h"
+#include "utils/print_util.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static void TestStringConversion()
+{
+    const std::wstring wstr = L"シーン scene é \U0001F600";
+    auto str = WStrToStr(wstr);
+    TEST_CHECK(!str.empty());
+    TEST_CHECK(StrToWStr(str) == wstr);
+    TEST_CHECK(WStrToStr(L"abc") == "abc");
+    TEST_CHECK(StrToWStr("").empty());
+}
+
+static void TestMappedFile()
+{
+    auto path = fs::temp_directory_path() / "rtcamp10_mapped_file_test.bin";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "mapped file contents";
+    }
+    MappedFile mapped;
+    TEST_CHECK(mapped.Open(path.wstring()));
+    TEST_CHECK(mapped.GetSize() == 20);
+    TEST_CHECK(mapped.GetData() != nullptr && std::string(reinterpret_cast<const char*>(mapped.GetData()), mapped.GetSize()) == "mapped file contents");
+    mapped.Close();
+    TEST_CHECK(mapped.GetSize() == 0);
+
+    // 空のファイルはマップせずに成功する
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    }
+    TEST_CHECK(mapped.Open(path.wstring()));
+    TEST_CHECK(mapped.GetSize() == 0);
+    mapped.Close();
+    fs::remove(path);
+
+    TEST_CHECK(!mapped.Open((fs::temp_directory_path() / "rtcamp10_missing_file.bin").wstring()));
+}
+
+static void TestJsonStringScan()
+{
+    // 16バイト単位の走査で引用符とエスケープの位置を検出する
+    const std::string json = R"({"name": "0123456789abcdef0123\"quoted\"", "long": "0123456789abcdefghijklmnopqrstuvwxyz"})";
+    JsonReader reader(json.data(), json.data() + json.size());
+    std::string name;
+    std::string longValue;
+    bool result = reader.ForEachMember([&](std::string_view key)
+    {
+        if (key == "name")
+        {
+            return reader.ReadString(name);
+        }
+        if (key == "long")
+        {
+            return reader.ReadString(longValue);
+        }
+        return reader.Skip();
+    });
+    TEST_CHECK(result && reader.IsValid());
+    TEST_CHECK(name == "0123456789abcdef0123\"quoted\"");
+    TEST_CHECK(longValue == "0123456789abcdefghijklmnopqrstuvwxyz");
+}
+
+int main()
+{
+    RunTest("StringConversion", TestStringConversion);
+    RunTest("MappedFile", TestMappedFile);
+    RunTest("JsonStringScan", TestJsonStringScan);
+    return TestResult();
+}
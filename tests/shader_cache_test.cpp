@@ -0,0 +1,128 @@
+#include "test_util.h"
+
+#include "utils/shader_cache.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static void WriteFile(const fs::path& path, const std::string& content)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+// テスト用のシェーダーのディレクトリ
+struct ShaderDir
+{
+    fs::path root = fs::temp_directory_path() / "rtcamp10_shader_cache_test";
+    fs::path source = root / "src" / "main.hlsl";
+    fs::path includeDir = root / "include";
+
+    ShaderDir()
+    {
+        fs::remove_all(root);
+        fs::create_directories(source.parent_path());
+        fs::create_directories(includeDir);
+        // 相対パス, インクルードパス, 相互のインクルード, 存在しないファイル
+        WriteFile(source, "#include \"local.hlsli\"\n  #include <common.hlsli>\n#include \"missing.hlsli\"\nvoid main() {}\n");
+        WriteFile(source.parent_path() / "local.hlsli", "#include \"common.hlsli\"\n#define LOCAL 1\n");
+        WriteFile(includeDir / "common.hlsli", "#include \"../src/local.hlsli\"\n#define COMMON 1\n");
+    }
+    ~ShaderDir() { fs::remove_all(root); }
+
+    uint64_t Hash(const ShaderCacheKey& key) const
+    {
+        std::string content;
+        ReadShaderFile(source, content);
+        return HashShaderSource(source, content, includeDir, key);
+    }
+};
+
+static ShaderCacheKey DefaultKey()
+{
+    ShaderCacheKey key;
+    key.target = L"lib_6_4";
+    key.args = { L"/0d" };
+    key.defines = { { L"LIGHT_COUNT", L"1" } };
+    key.compilerVersion = (uint64_t(1) << 32) | 7;
+    return key;
+}
+
+static void TestHashIncludes()
+{
+    ShaderDir dir;
+    const auto key = DefaultKey();
+    const uint64_t hash = dir.Hash(key);
+    TEST_CHECK(hash == dir.Hash(key));
+
+    // インクルードパスから解決したファイルの変更
+    WriteFile(dir.includeDir / "common.hlsli", "#include \"../src/local.hlsli\"\n#define COMMON 2\n");
+    const uint64_t changedCommon = dir.Hash(key);
+    TEST_CHECK(changedCommon != hash);
+
+    // インクルード元のディレクトリから解決したファイルの変更
+    WriteFile(dir.source.parent_path() / "local.hlsli", "#include \"common.hlsli\"\n#define LOCAL 2\n");
+    const uint64_t changedLocal = dir.Hash(key);
+    TEST_CHECK(changedLocal != changedCommon);
+
+    // 存在しなかったファイルの追加
+    WriteFile(dir.source.parent_path() / "missing.hlsli", "");
+    TEST_CHECK(dir.Hash(key) != changedLocal);
+}
+
+static void TestHashKey()
+{
+    ShaderDir dir;
+    const auto key = DefaultKey();
+    const uint64_t hash = dir.Hash(key);
+
+    auto changed = key;
+    changed.defines[0].second = L"2";
+    TEST_CHECK(dir.Hash(changed) != hash);
+    changed = key;
+    changed.args.push_back(L"-O3");
+    TEST_CHECK(dir.Hash(changed) != hash);
+    changed = key;
+    changed.target = L"lib_6_5";
+    TEST_CHECK(dir.Hash(changed) != hash);
+    changed = key;
+    changed.entryPoint = L"main";
+    TEST_CHECK(dir.Hash(changed) != hash);
+    changed = key;
+    changed.compilerVersion = (uint64_t(1) << 32) | 8;
+    TEST_CHECK(dir.Hash(changed) != hash);
+}
+
+static void TestCacheFile()
+{
+    ShaderDir dir;
+    const fs::path cacheDir = dir.root / "cache";
+    const uint64_t hash = 0x0123456789abcdefull;
+    const fs::path cachePath = GetShaderCachePath(cacheDir, dir.source, hash);
+    TEST_CHECK(cachePath.filename() == "main_0123456789abcdef.dxlib");
+    TEST_CHECK(cachePath.parent_path() == cacheDir);
+
+    std::vector<char> binary;
+    TEST_CHECK(!LoadShaderCache(cachePath, binary));
+
+    // ディレクトリがなければ作成し、一時ファイルを残さない
+    const std::vector<char> compiled = { 'D', 'X', 'I', 'L', '\0', '\x7f' };
+    TEST_CHECK(StoreShaderCache(cachePath, compiled));
+    TEST_CHECK(LoadShaderCache(cachePath, binary));
+    TEST_CHECK(binary == compiled);
+    TEST_CHECK(!fs::exists(fs::path(cachePath).concat(".tmp")));
+
+    // 空のキャッシュは使用しない
+    TEST_CHECK(StoreShaderCache(cachePath, {}));
+    TEST_CHECK(!LoadShaderCache(cachePath, binary));
+}
+
+int main()
+{
+    RunTest("HashIncludes", TestHashIncludes);
+    RunTest("HashKey", TestHashKey);
+    RunTest("CacheFile", TestCacheFile);
+    return TestResult();
+}
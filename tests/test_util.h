@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// 失敗した検証の数 (失敗しても以降の検証は続行する)
+inline int& TestFailureCount()
+{
+    static int count = 0;
+    return count;
+}
+
+#define TEST_CHECK(expr)                                                                    \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(expr))                                                                        \
+        {                                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #expr << std::endl; \
+            ++TestFailureCount();                                                           \
+        }                                                                                   \
+    } while (0)
+
+// テストケースの実行 (名前を出力してから呼び出す)
+template<typename F>
+inline void RunTest(const char* name, F&& test)
+{
+    std::cout << "[ RUN ] " << name << std::endl;
+    int before = TestFailureCount();
+    test();
+    std::cout << (TestFailureCount() == before ? "[  OK ] " : "[ FAIL] ") << name << std::endl;
+}
+
+// プロセスの終了コード
+inline int TestResult()
+{
+    return TestFailureCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
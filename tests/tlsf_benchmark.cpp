@@ -0,0 +1,65 @@
+#include "utils/tlsf_allocator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// TLSFAllocatorの確保と解放の速度の計測
+// 使用率を一定に保ちながらランダムなサイズとアライメントで確保と解放を繰り返す
+int main(int argc, char* argv[])
+{
+    const uint32_t iterations = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 2000000;
+    const uint64_t size = 256ull << 20;
+    TLSFAllocator allocator(size);
+    std::vector<TLSFAllocator::Allocation> live;
+    live.reserve(1 << 16);
+
+    // 乱数は計測の前に生成しておく
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint64_t> sizeDist(64, 256 * 1024);
+    std::vector<uint64_t> sizes(iterations);
+    std::vector<uint64_t> alignments(iterations);
+    std::vector<uint32_t> picks(iterations);
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        sizes[i] = sizeDist(rng);
+        alignments[i] = uint64_t(256) << (rng() % 9);
+        picks[i] = uint32_t(rng());
+    }
+
+    uint32_t allocCount = 0;
+    uint32_t freeCount = 0;
+    uint32_t failCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        if (!live.empty() && (allocator.GetUsedSize() > size * 3 / 4 || (picks[i] & 1)))
+        {
+            size_t index = picks[i] % live.size();
+            allocator.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+            ++freeCount;
+            continue;
+        }
+        TLSFAllocator::Allocation allocation;
+        if (allocator.Allocate(sizes[i], alignments[i], allocation))
+        {
+            live.push_back(allocation);
+            ++allocCount;
+        }
+        else
+        {
+            ++failCount;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    std::printf("TLSF: %u ops (alloc %u, free %u, failed %u), %.1f ns/op, live %zu, used %.1f%%\n",
+        iterations, allocCount, freeCount, failCount, ns / iterations, live.size(),
+        100.0 * double(allocator.GetUsedSize()) / double(size));
+    return 0;
+}